@@ -16,8 +16,11 @@
  * =====================================================================================
  */
 
+#include <cmath>
 #include <future>
 #include <thread>
+#include <vector>
+#include <algorithm>
 #include <cinttypes>
 
 #include "log.hpp"
@@ -35,12 +38,21 @@
 #include "processsync.hpp"
 #include "pngtexoffdb.hpp"
 #include "processlogin.hpp"
+#include "strf.hpp"
 #include "servermsg.hpp"
 #include "clientargparser.hpp"
 
 extern Log *g_log;
 extern XMLConf *g_XMLConf;
 extern SDLDevice *g_SDLDevice;
+extern PNGTexDB *g_progUseDB;
+extern PNGTexDB *g_mapDB;
+extern PNGTexOffDB *g_heroDB;
+extern PNGTexOffDB *g_monsterDB;
+extern PNGTexOffDB *g_weaponDB;
+extern PNGTexOffDB *g_magicDB;
+extern PNGTexOffDB *g_standNPCDB;
+extern FontexDB *g_fontexDB;
 extern NotifyBoard *g_notifyBoard;
 extern ClientArgParser *g_clientArgParser;
 
@@ -70,6 +82,11 @@ void Client::processEvent()
 
 void Client::mainLoop()
 {
+    if(!g_clientArgParser->replaySession.empty()){
+        benchLoop();
+        return;
+    }
+
     SwitchProcess(PROCESSID_LOGO);
     initASIO();
 
@@ -121,6 +138,119 @@ void Client::mainLoop()
     }
 }
 
+void Client::benchLoop()
+{
+    // replay recorded server messages at fixed timing and measure each frame
+    // no connection, no user input, frame step follows the draw delay of mainLoop()
+
+    m_sessionReplayer = std::make_unique<SessionReplayer>(g_clientArgParser->replaySession.c_str());
+    g_log->addLog(LOGTYPE_INFO, "Replay session: %s, messages = %zu, duration = %.3fsec", g_clientArgParser->replaySession.c_str(), m_sessionReplayer->messageCount(), (m_sessionReplayer->endTick() - m_sessionReplayer->startTick()) / 1000.0);
+
+    // session is recorded from the logo screen
+    // skip it, SM_LOGINOK in the session jumps into ProcessRun
+    SwitchProcess(PROCESSID_LOGIN);
+
+    struct CacheHitMiss
+    {
+        const char *name;
+        uint64_t hit;
+        uint64_t miss;
+    };
+
+    const auto fnCacheHitMissList = []()
+    {
+        const auto fnHitMiss = [](const char *name, const auto *db) -> CacheHitMiss
+        {
+            const auto stat = db->CacheStat();
+            return {name, stat.Hit, stat.Miss};
+        };
+
+        return std::vector<CacheHitMiss>
+        {
+            fnHitMiss("progUseDB" , g_progUseDB ),
+            fnHitMiss("mapDB"     , g_mapDB     ),
+            fnHitMiss("heroDB"    , g_heroDB    ),
+            fnHitMiss("monsterDB" , g_monsterDB ),
+            fnHitMiss("weaponDB"  , g_weaponDB  ),
+            fnHitMiss("magicDB"   , g_magicDB   ),
+            fnHitMiss("standNPCDB", g_standNPCDB),
+            fnHitMiss("fontexDB"  , g_fontexDB  ),
+        };
+    };
+
+    const auto startCacheList = fnCacheHitMissList();
+    const auto frameMS = (1000.0 / (1.0 * SYS_DEFFPS)) / 6.0;
+
+    std::vector<double> updateTimeList;
+    std::vector<double>   drawTimeList;
+    std::vector<size_t>   drawCallList;
+
+    // keep drawing one more second after the last message to let motions finish
+    for(double tick = m_sessionReplayer->startTick(); !m_sessionReplayer->done() || tick <= m_sessionReplayer->endTick() + 1000.0; tick += frameMS){
+        SwitchProcess();
+        if(!m_currentProcess || m_currentProcess->ID() == PROCESSID_EXIT){
+            break;
+        }
+
+        m_sessionReplayer->dispatch(tick, [this](uint8_t headCode, const uint8_t *data, size_t dataLen)
+        {
+            OnServerMessage(headCode, data, dataLen);
+        });
+
+        // drop input to make runs reproducible
+        SDL_PumpEvents();
+        SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+        {
+            hres_timer updateTimer;
+            update(frameMS);
+            updateTimeList.push_back(updateTimer.diff_nsec() / 1000000.0);
+        }
+
+        {
+            g_SDLDevice->resetDrawCallCount();
+            hres_timer drawTimer;
+
+            draw();
+            drawTimeList.push_back(drawTimer.diff_nsec() / 1000000.0);
+            drawCallList.push_back(g_SDLDevice->drawCallCount());
+        }
+    }
+
+    const auto fnReport = [](const char *name, auto valList)
+    {
+        if(valList.empty()){
+            return;
+        }
+
+        std::sort(valList.begin(), valList.end());
+        const auto fnPercentile = [&valList](double p)
+        {
+            return 1.0 * valList[std::min<size_t>(valList.size() - 1, (size_t)(std::lround(p * (valList.size() - 1))))];
+        };
+
+        const auto reportStr = str_printf("%-9s p50 = %10.3f, p90 = %10.3f, p99 = %10.3f, max = %10.3f", name, fnPercentile(0.50), fnPercentile(0.90), fnPercentile(0.99), 1.0 * valList.back());
+        g_log->addLog(LOGTYPE_INFO, "%s", reportStr.c_str());
+        std::printf("%s\n", reportStr.c_str());
+    };
+
+    std::printf("frames: %zu\n", drawTimeList.size());
+    fnReport("update ms", updateTimeList);
+    fnReport("draw ms"  , drawTimeList  );
+    fnReport("drawcall" , drawCallList  );
+
+    const auto doneCacheList = fnCacheHitMissList();
+    for(size_t i = 0; i < doneCacheList.size(); ++i){
+        const auto hit  = doneCacheList[i].hit  - startCacheList[i].hit;
+        const auto miss = doneCacheList[i].miss - startCacheList[i].miss;
+        const auto reportStr = str_printf("%-10s hit = %10" PRIu64 ", miss = %10" PRIu64 ", hit ratio = %.4f", doneCacheList[i].name, hit, miss, (hit + miss) ? (1.0 * hit / (hit + miss)) : 0.0);
+
+        g_log->addLog(LOGTYPE_INFO, "%s", reportStr.c_str());
+        std::printf("%s\n", reportStr.c_str());
+    }
+    std::fflush(stdout);
+}
+
 void Client::EventDelay(double fDelayMS)
 {
     double fStartDelayMS = SDL_GetTicks() * 1.0;
@@ -161,6 +291,10 @@ void Client::initASIO()
     std::string szIP;
     std::string szPort;
 
+    if(!g_clientArgParser->recordSession.empty()){
+        m_sessionRecorder = std::make_unique<SessionRecorder>(g_clientArgParser->recordSession.c_str());
+    }
+
     auto p1 = g_XMLConf->GetXMLNode("/Root/Network/Server/IP"  );
     auto p2 = g_XMLConf->GetXMLNode("/Root/Network/Server/Port");
 
@@ -176,6 +310,9 @@ void Client::initASIO()
     {
         // core should handle on fully recieved message from the serer
         // previously there are two steps (HC, Body) seperately handled, error-prone
+        if(m_sessionRecorder){
+            m_sessionRecorder->record(headCode, pData, nDataLen);
+        }
         OnServerMessage(headCode, pData, nDataLen);
     });
 }
@@ -296,6 +433,23 @@ void Client::OnServerMessage(uint8_t headCode, const uint8_t *pData, size_t nDat
                 }
                 break;
             }
+        case SM_UPDATEFRAME:
+            {
+                // always decode even no ProcessRun
+                // baseline needs to follow every frame
+                try{
+                    m_updateFrameDecoder.decode(pData, nDataLen, [this](uint8_t subHeadCode, const uint8_t *subData, size_t subDataLen)
+                    {
+                        OnServerMessage(subHeadCode, subData, subDataLen);
+                    });
+                }
+                catch(const std::exception &e){
+                    // baseline is broken, can't decode any following frame
+                    g_log->addLog(LOGTYPE_WARNING, "Invalid update frame: %s", e.what());
+                    m_netIO.stop();
+                }
+                break;
+            }
         case SM_OFFLINE:
             {
                 if(auto pRun = (ProcessRun *)(ProcessValid(PROCESSID_RUN))){
@@ -18,6 +18,7 @@
 
 #pragma once 
 #include <atomic>
+#include <memory>
 #include <SDL2/SDL.h>
 
 #include "netio.hpp"
@@ -26,6 +27,8 @@
 #include "sdldevice.hpp"
 #include "raiitimer.hpp"
 #include "cachequeue.hpp"
+#include "updateframe.hpp"
+#include "sessionrecord.hpp"
 
 class ProcessRun;
 class Client final
@@ -63,6 +66,17 @@ class Client final
     private:
         NetIO m_netIO;
 
+    private:
+        // baseline of SM_UPDATEFRAME
+        // lives as long as the connection
+        UpdateFrameDecoder m_updateFrameDecoder;
+
+    private:
+        // "--record-session" dumps every message from m_netIO
+        // "--replay-session" feeds them back without connection
+        std::unique_ptr<SessionRecorder> m_sessionRecorder;
+        std::unique_ptr<SessionReplayer> m_sessionReplayer;
+
     private:
         int m_requestProcess;
         Process *m_currentProcess;
@@ -77,6 +91,9 @@ class Client final
     public:
         void mainLoop();
 
+    private:
+        void benchLoop();
+
     public:
         void Clipboard(const std::string &szInfo)
         {
@@ -156,6 +173,10 @@ class Client final
     public:
         template<typename... U> void send(uint8_t headCode, U&&... u)
         {
+            if(m_sessionReplayer){
+                return;
+            }
+
             m_netIO.send(headCode, std::forward<U>(u)...);
             sendCMsgLog(headCode);
         }
@@ -17,8 +17,9 @@
  */
 
 #pragma once
-#include "argparser.hpp"
+#include <string>
 #include <cstdint>
+#include "argparser.hpp"
 
 struct ClientArgParser
 {
@@ -33,6 +34,13 @@ struct ClientArgParser
     const bool debugAlphaCover;         // "--debug-alpha-cover"
     const bool debugSlider;             // "--debug-slider"
     const bool drawFPS;                 // "--draw-fps"
+    const bool recordCacheTrace;        // "--record-cache-trace"
+    const bool disableMapChunk;         // "--disable-map-chunk"
+    const bool softwareRenderer;        // "--software-renderer"
+    const bool headless;                // "--headless"
+
+    const std::string recordSession;    // "--record-session"
+    const std::string replaySession;    // "--replay-session"
 
     bool traceMove;
 
@@ -48,6 +56,12 @@ struct ClientArgParser
         , debugAlphaCover(cmdParser["debug-alpha-cover"])
         , debugSlider(cmdParser["debug-slider"])
         , drawFPS(cmdParser["draw-fps"])
+        , recordCacheTrace(cmdParser["record-cache-trace"])
+        , disableMapChunk(cmdParser["disable-map-chunk"])
+        , softwareRenderer(cmdParser["software-renderer"])
+        , headless(cmdParser["headless"])
+        , recordSession(cmdParser("record-session").str())
+        , replaySession(cmdParser("replay-session").str())
         , traceMove(cmdParser["trace-move"])
     {}
 };
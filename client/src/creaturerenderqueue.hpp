@@ -0,0 +1,149 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: creaturerenderqueue.hpp
+ *        Created: 10/20/2026 08:14:37
+ *    Description: persistent creature drawing order of ProcessRun::draw()
+ *
+ *                 creatures are queued by map row and sorted by x in each row, entry
+ *                 moves only when the creature's location changes, rows keep their
+ *                 capacity so steady frames don't allocate
+ *
+ *                 entries refer creatures by UID, ProcessRun may replace or erase the
+ *                 creature behind an UID anywhere, stale entries get dropped lazily by
+ *                 the visitor while drawing
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <tuple>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+class CreatureRenderQueue final
+{
+    private:
+        struct QueueEntry
+        {
+            int      x;
+            uint64_t uid;
+
+            bool operator < (const QueueEntry &rhs) const
+            {
+                return std::tie(x, uid) < std::tie(rhs.x, rhs.uid);
+            }
+        };
+
+    private:
+        std::vector<std::vector<QueueEntry>> m_rowList;
+
+    private:
+        // where each UID is queued now
+        std::unordered_map<uint64_t, std::tuple<int, int>> m_locationList;
+
+    public:
+        CreatureRenderQueue() = default;
+
+    public:
+        // call when switching map, rows keep their capacity
+        void clear(int mapH)
+        {
+            for(auto &row: m_rowList){
+                row.clear();
+            }
+
+            m_rowList.resize(std::max<int>(mapH, 0));
+            m_locationList.clear();
+        }
+
+    public:
+        // cheap if location doesn't change
+        void update(uint64_t uid, int x, int y)
+        {
+            if(auto p = m_locationList.find(uid); p != m_locationList.end()){
+                if(p->second == std::make_tuple(x, y)){
+                    return;
+                }
+
+                eraseEntry(uid, std::get<0>(p->second), std::get<1>(p->second));
+                if(!validRow(y)){
+                    m_locationList.erase(p);
+                    return;
+                }
+
+                p->second = {x, y};
+                insertEntry(uid, x, y);
+                return;
+            }
+
+            if(validRow(y)){
+                m_locationList.emplace(uid, std::make_tuple(x, y));
+                insertEntry(uid, x, y);
+            }
+        }
+
+        void remove(uint64_t uid)
+        {
+            if(auto p = m_locationList.find(uid); p != m_locationList.end()){
+                eraseEntry(uid, std::get<0>(p->second), std::get<1>(p->second));
+                m_locationList.erase(p);
+            }
+        }
+
+    public:
+        // visit creatures queued in row y with x in [x0, x1] from left to right
+        // fnVisit(uid, x) returns false if the UID is stale, then it gets dropped
+        template<typename F> void forEach(int y, int x0, int x1, F &&fnVisit)
+        {
+            if(!validRow(y)){
+                return;
+            }
+
+            auto &row = m_rowList[y];
+            auto p = std::lower_bound(row.begin(), row.end(), QueueEntry{x0, 0});
+
+            while(p != row.end() && p->x <= x1){
+                if(const auto entry = *p; fnVisit(entry.uid, entry.x)){
+                    ++p;
+                }
+                else{
+                    p = row.erase(p);
+                    m_locationList.erase(entry.uid);
+                }
+            }
+        }
+
+    private:
+        bool validRow(int y) const
+        {
+            return y >= 0 && y < (int)(m_rowList.size());
+        }
+
+        void insertEntry(uint64_t uid, int x, int y)
+        {
+            auto &row = m_rowList[y];
+            const QueueEntry entry {x, uid};
+            row.insert(std::upper_bound(row.begin(), row.end(), entry), entry);
+        }
+
+        void eraseEntry(uint64_t uid, int x, int y)
+        {
+            if(validRow(y)){
+                auto &row = m_rowList[y];
+                if(auto p = std::lower_bound(row.begin(), row.end(), QueueEntry{x, uid}); p != row.end() && p->uid == uid){
+                    row.erase(p);
+                }
+            }
+        }
+};
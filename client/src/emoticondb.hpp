@@ -88,7 +88,7 @@ class emoticonDB: public innDB<uint32_t, emojiEntry>
         bool Load(const char *szEmojiDBName)
         {
             try{
-                m_zsdbPtr = std::make_unique<ZSDB>(szEmojiDBName);
+                m_zsdbPtr = std::make_unique<ZSDB>(szEmojiDBName, true);
             }catch(...){
                 return false;
             }
@@ -6,6 +6,10 @@
  *    Description: this class only releases resource automatically
  *                 on loading new resources
  *
+ *                 glyphs are packed into shared GlyphAtlas pages, an entry refers to
+ *                 a rect on the page texture, only glyphs too big for the atlas get
+ *                 their own texture
+ *
  *        Version: 1.0
  *       Revision: none
  *       Compiler: gcc
@@ -20,6 +24,7 @@
 #pragma once
 #include <map>
 #include <cstring>
+#include <optional>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
@@ -28,6 +33,7 @@
 #include "fflerror.hpp"
 #include "hexstr.hpp"
 #include "sdldevice.hpp"
+#include "glyphatlas.hpp"
 
 enum FontStyle: uint8_t
 {
@@ -42,7 +48,18 @@ enum FontStyle: uint8_t
 
 struct FontexEntry
 {
-    SDL_Texture *Texture;
+    SDL_Texture *Texture = nullptr;
+
+    int X = 0;
+    int Y = 0;
+    int W = 0;
+    int H = 0;
+
+    // true if texture is not an atlas page
+    bool Owned = false;
+
+    // glyph key in the atlas page
+    uint64_t Key = 0;
 };
 
 class FontexDB: public innDB<uint64_t, FontexEntry>
@@ -59,12 +76,20 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
     private:
         std::map<uint8_t, std::vector<uint8_t>> m_fontDataCache;
 
+    private:
+        GlyphAtlas m_atlas;
+
     public:
-        FontexDB(size_t nResMax)
+        FontexDB(size_t nResMax, int nAtlasW = 1024, int nAtlasH = 1024, size_t nAtlasPage = 4)
             : innDB<uint64_t, FontexEntry>(nResMax)
             , m_zsdbPtr()
             , m_TTFCache()
             , m_fontDataCache()
+            , m_atlas(nAtlasW, nAtlasH, nAtlasPage, [this](uint64_t nKey)
+              {
+                  // atlas page flushed, rect of this key is invalid
+                  this->EraseResource(nKey);
+              })
         {}
 
         virtual ~FontexDB()
@@ -119,7 +144,7 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
         bool Load(const char *szFontexDBName)
         {
             try{
-                m_zsdbPtr = std::make_unique<ZSDB>(szFontexDBName);
+                m_zsdbPtr = std::make_unique<ZSDB>(szFontexDBName, true);
                 m_entryList = m_zsdbPtr->GetEntryList();
             }catch(...){
                 return false;
@@ -128,15 +153,17 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
         }
 
     public:
-        SDL_Texture *Retrieve(uint64_t nKey)
+        // returned rect is valid until AtlasFlushCount() changes
+        // which happens only when loading new glyph and all atlas pages are full
+        std::optional<FontexEntry> Retrieve(uint64_t nKey)
         {
-            if(FontexEntry stEntry {nullptr}; this->RetrieveResource(nKey, &stEntry)){
-                return stEntry.Texture;
+            if(FontexEntry stEntry; this->RetrieveResource(nKey, &stEntry) && stEntry.Texture){
+                return stEntry;
             }
-            return nullptr;
+            return {};
         }
 
-        SDL_Texture *Retrieve(uint8_t nFontIndex, uint8_t nFontSize, uint8_t nFontStyle, uint32_t nUTF8Code)
+        std::optional<FontexEntry> Retrieve(uint8_t nFontIndex, uint8_t nFontSize, uint8_t nFontStyle, uint32_t nUTF8Code)
         {
             uint64_t nKey = 0
                 + (((uint64_t)nFontIndex) << 48)
@@ -146,6 +173,17 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
             return Retrieve(nKey);
         }
 
+    public:
+        size_t AtlasFlushCount() const
+        {
+            return m_atlas.flushCount();
+        }
+
+        double AtlasOccupancy() const
+        {
+            return m_atlas.occupancy();
+        }
+
     public:
         uint8_t findFontName(const char *fontName)
         {
@@ -170,7 +208,7 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
     public:
         virtual std::tuple<FontexEntry, size_t> loadResource(uint64_t nKey)
         {
-            FontexEntry stEntry {nullptr};
+            FontexEntry stEntry;
 
             uint16_t nTTFIndex  = ((nKey & 0X00FFFF0000000000) >> 40);
             uint8_t  nFontStyle = ((nKey & 0X000000FF00000000) >> 32);
@@ -224,18 +262,38 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
                 return {stEntry, 0};
             }
 
-            extern SDLDevice *g_SDLDevice;
-            stEntry.Texture = g_SDLDevice->CreateTextureFromSurface(pSurface);
-            SDL_FreeSurface(pSurface);
+            if(auto stRect = m_atlas.add(nKey, pSurface); stRect.has_value()){
+                stEntry.Texture = stRect->Texture;
+                stEntry.X       = stRect->X;
+                stEntry.Y       = stRect->Y;
+                stEntry.W       = stRect->W;
+                stEntry.H       = stRect->H;
+                stEntry.Owned   = false;
+                stEntry.Key     = nKey;
+            }else{
+                extern SDLDevice *g_SDLDevice;
+                stEntry.Texture = g_SDLDevice->CreateTextureFromSurface(pSurface);
+                stEntry.X       = 0;
+                stEntry.Y       = 0;
+                stEntry.W       = pSurface->w;
+                stEntry.H       = pSurface->h;
+                stEntry.Owned   = true;
+                stEntry.Key     = nKey;
+            }
 
+            SDL_FreeSurface(pSurface);
             return {stEntry, stEntry.Texture ? 1 : 0};
         }
 
         virtual void freeResource(FontexEntry &rstEntry)
         {
-            if(rstEntry.Texture){
+            // atlas page is owned by m_atlas
+            if(rstEntry.Texture && rstEntry.Owned){
                 SDL_DestroyTexture(rstEntry.Texture);
                 rstEntry.Texture = nullptr;
+            }else if(rstEntry.Texture){
+                m_atlas.remove(rstEntry.Key, rstEntry.Texture);
+                rstEntry.Texture = nullptr;
             }
         }
 };
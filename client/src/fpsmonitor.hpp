@@ -17,11 +17,15 @@
  */
 
 #pragma once
+#include <cmath>
 #include <deque>
+#include <vector>
 #include <cstdint>
 #include <cstddef>
+#include <algorithm>
 #include <SDL2/SDL.h>
 #include "fflerror.hpp"
+#include "raiitimer.hpp"
 
 class FPSMonitor
 {
@@ -29,6 +33,12 @@ class FPSMonitor
         size_t m_size;
         std::deque<uint32_t> m_timeStamp;
 
+    private:
+        // frame time in milliseconds
+        // measured by high resolution timer since SDL_GetTicks() only has 1ms resolution
+        hres_timer m_frameTimer;
+        std::deque<double> m_frameTime;
+
     public:
         FPSMonitor(size_t monitorSize = 0)
             : m_size(monitorSize ? monitorSize : 128)
@@ -41,6 +51,14 @@ class FPSMonitor
             if(m_timeStamp.size() > m_size){
                 m_timeStamp.pop_front();
             }
+
+            if(m_timeStamp.size() > 1){
+                m_frameTime.push_back(m_frameTimer.diff_nsec() / 1000000.0);
+                if(m_frameTime.size() > m_size){
+                    m_frameTime.pop_front();
+                }
+            }
+            m_frameTimer.reset();
         }
 
     public:
@@ -51,4 +69,20 @@ class FPSMonitor
             }
             return 1000 * m_timeStamp.size() / (m_timeStamp.back() + 1 - m_timeStamp.front());
         }
+
+    public:
+        // percentile of frame time in milliseconds over the monitor window
+        // percent in [0.0, 1.0], e.g. 0.50 gives the median, 0.99 gives p99
+        double frameTime(double percent) const
+        {
+            if(m_frameTime.empty()){
+                return 0.0;
+            }
+
+            std::vector<double> frameTimeList(m_frameTime.begin(), m_frameTime.end());
+            const auto index = (size_t)(std::lround(std::clamp<double>(percent, 0.0, 1.0) * (frameTimeList.size() - 1)));
+
+            std::nth_element(frameTimeList.begin(), frameTimeList.begin() + index, frameTimeList.end());
+            return frameTimeList[index];
+        }
 };
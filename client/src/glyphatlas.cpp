@@ -0,0 +1,187 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: glyphatlas.cpp
+ *        Created: 10/19/2026 23:18:40
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <cstring>
+#include "fflerror.hpp"
+#include "sdldevice.hpp"
+#include "glyphatlas.hpp"
+
+extern SDLDevice *g_SDLDevice;
+
+GlyphAtlas::GlyphAtlas(int pageW, int pageH, size_t pageMax, std::function<void(uint64_t)> evictFunc)
+    : m_pageW(pageW)
+    , m_pageH(pageH)
+    , m_pageMax(pageMax)
+    , m_evictFunc(std::move(evictFunc))
+{
+    if(m_pageW <= 0 || m_pageH <= 0 || m_pageMax == 0){
+        throw fflerror("invalid atlas page: w = %d, h = %d, max = %zu", m_pageW, m_pageH, m_pageMax);
+    }
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    for(auto &page: m_pageList){
+        if(page.Texture){
+            SDL_DestroyTexture(page.Texture);
+        }
+    }
+}
+
+double GlyphAtlas::occupancy() const
+{
+    if(m_pageList.empty()){
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for(const auto &page: m_pageList){
+        sum += page.Pack->occupancy();
+    }
+    return sum / m_pageList.size();
+}
+
+GlyphAtlas::AtlasPage &GlyphAtlas::createPage()
+{
+    // start from transparent pixels
+    // glyph padding area is never uploaded
+    m_uploadBuf.assign((size_t)(m_pageW) * m_pageH, 0);
+
+    AtlasPage page;
+    page.Texture = g_SDLDevice->createTexture(m_uploadBuf.data(), m_pageW, m_pageH);
+
+    if(!page.Texture){
+        throw fflerror("failed to create atlas page: %s", SDL_GetError());
+    }
+
+    page.Pack = std::make_unique<SkylinePack>(m_pageW, m_pageH);
+    m_pageList.push_back(std::move(page));
+    return m_pageList.back();
+}
+
+void GlyphAtlas::flushPage(AtlasPage &page)
+{
+    // only reset the packer
+    // stale pixels are overwritten by new glyphs with their padding
+    // evict callback may call remove() for the key, don't iterate page.KeyList directly
+    const auto keyList = std::move(page.KeyList);
+    page.KeyList.clear();
+
+    for(const auto key: keyList){
+        if(m_evictFunc){
+            m_evictFunc(key);
+        }
+    }
+
+    page.Pack->reset();
+    m_flushCount++;
+}
+
+void GlyphAtlas::remove(uint64_t key, SDL_Texture *texPtr)
+{
+    for(auto &page: m_pageList){
+        if(page.Texture == texPtr){
+            page.KeyList.erase(key);
+            return;
+        }
+    }
+}
+
+std::optional<GlyphRect> GlyphAtlas::add(uint64_t key, SDL_Surface *surfPtr)
+{
+    if(!surfPtr || surfPtr->w <= 0 || surfPtr->h <= 0){
+        return {};
+    }
+
+    // 1 pixel transparent border around each glyph
+    // avoids bleeding if texture gets linear filtering
+    const int padW = surfPtr->w + 2;
+    const int padH = surfPtr->h + 2;
+
+    if(padW > m_pageW || padH > m_pageH){
+        return {};
+    }
+
+    int padX = -1;
+    int padY = -1;
+    AtlasPage *pagePtr = nullptr;
+
+    for(auto p = m_pageList.rbegin(); p != m_pageList.rend(); ++p){
+        if(p->Pack->add(padW, padH, &padX, &padY)){
+            pagePtr = &(*p);
+            break;
+        }
+    }
+
+    if(!pagePtr){
+        if(m_pageList.size() < m_pageMax){
+            pagePtr = &createPage();
+        }
+        else{
+            pagePtr = &m_pageList[m_nextFlush];
+            m_nextFlush = (m_nextFlush + 1) % m_pageList.size();
+            flushPage(*pagePtr);
+        }
+
+        if(!pagePtr->Pack->add(padW, padH, &padX, &padY)){
+            throw fflerror("empty atlas page can't hold glyph: w = %d, h = %d", surfPtr->w, surfPtr->h);
+        }
+    }
+
+    // TTF_RenderUTF8_Solid/Shaded give palettized surface
+    // convert to the atlas format, which is the same as SDLDevice::createTexture()
+    SDL_Surface *convSurfPtr = surfPtr;
+    if(surfPtr->format->format != SDL_PIXELFORMAT_RGBA8888){
+        if(!(convSurfPtr = SDL_ConvertSurfaceFormat(surfPtr, SDL_PIXELFORMAT_RGBA8888, 0))){
+            return {};
+        }
+    }
+
+    m_uploadBuf.assign((size_t)(padW) * padH, 0);
+    if(SDL_MUSTLOCK(convSurfPtr)){
+        SDL_LockSurface(convSurfPtr);
+    }
+
+    for(int y = 0; y < convSurfPtr->h; ++y){
+        const auto srcRow = (const uint8_t *)(convSurfPtr->pixels) + (size_t)(y) * convSurfPtr->pitch;
+        std::memcpy(m_uploadBuf.data() + (size_t)(y + 1) * padW + 1, srcRow, (size_t)(convSurfPtr->w) * 4);
+    }
+
+    if(SDL_MUSTLOCK(convSurfPtr)){
+        SDL_UnlockSurface(convSurfPtr);
+    }
+
+    if(convSurfPtr != surfPtr){
+        SDL_FreeSurface(convSurfPtr);
+    }
+
+    const SDL_Rect padRect {padX, padY, padW, padH};
+    if(SDL_UpdateTexture(pagePtr->Texture, &padRect, m_uploadBuf.data(), padW * 4)){
+        return {};
+    }
+
+    pagePtr->KeyList.insert(key);
+    return GlyphRect
+    {
+        pagePtr->Texture,
+        padX + 1,
+        padY + 1,
+        surfPtr->w,
+        surfPtr->h,
+    };
+}
@@ -0,0 +1,108 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: glyphatlas.hpp
+ *        Created: 10/19/2026 23:18:40
+ *    Description: pack glyph surfaces into shared atlas textures
+ *
+ *                 each page is one big texture with a skyline packer, glyphs are white and
+ *                 get colored by per-quad color mod, so a paragraph can be drawn by one call
+ *
+ *                 packer can't free single glyph, when all pages are full the oldest page
+ *                 gets flushed and its keys are reported by the evict callback, callers
+ *                 should drop all rects they got from that page
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <unordered_set>
+#include <SDL2/SDL.h>
+#include "skylinepack.hpp"
+
+struct GlyphRect
+{
+    SDL_Texture *Texture = nullptr;
+
+    int X = 0;
+    int Y = 0;
+    int W = 0;
+    int H = 0;
+};
+
+class GlyphAtlas final
+{
+    private:
+        struct AtlasPage
+        {
+            SDL_Texture *Texture = nullptr;
+            std::unique_ptr<SkylinePack> Pack;
+            std::unordered_set<uint64_t> KeyList;
+        };
+
+    private:
+        const int m_pageW;
+        const int m_pageH;
+        const size_t m_pageMax;
+
+    private:
+        const std::function<void(uint64_t)> m_evictFunc;
+
+    private:
+        std::vector<AtlasPage> m_pageList;
+
+    private:
+        size_t m_nextFlush  = 0;
+        size_t m_flushCount = 0;
+
+    private:
+        std::vector<uint32_t> m_uploadBuf;
+
+    public:
+        GlyphAtlas(int, int, size_t, std::function<void(uint64_t)>);
+
+    public:
+        ~GlyphAtlas();
+
+    public:
+        // copy the glyph surface into atlas
+        // returns empty if the glyph is too big for one page or upload fails
+        std::optional<GlyphRect> add(uint64_t, SDL_Surface *);
+
+    public:
+        // caller evicts a glyph itself, forget its key
+        // pixels stay in the page until the page gets flushed
+        void remove(uint64_t, SDL_Texture *);
+
+    public:
+        // increases every time a page gets flushed
+        // rects got before a change of the count may point to overwritten pixels
+        size_t flushCount() const
+        {
+            return m_flushCount;
+        }
+
+        size_t pageCount() const
+        {
+            return m_pageList.size();
+        }
+
+        double occupancy() const;
+
+    private:
+        AtlasPage &createPage();
+        void flushPage(AtlasPage &);
+};
@@ -67,6 +67,7 @@ int main(int argc, char *argv[])
             delete g_mapDB          ; g_mapDB           = nullptr;
             delete g_heroDB         ; g_heroDB          = nullptr;
             delete g_monsterDB      ; g_monsterDB       = nullptr;
+            delete g_standNPCDB     ; g_standNPCDB      = nullptr;
             delete g_fontexDB       ; g_fontexDB        = nullptr;
             delete g_mapBinDB       ; g_mapBinDB        = nullptr;
             delete g_emoticonDB     ; g_emoticonDB      = nullptr;
@@ -93,15 +94,22 @@ int main(int argc, char *argv[])
         g_progUseDB       = new PNGTexDB(1024);
         g_groundItemDB    = new PNGTexDB(1024);
         g_commonItemDB    = new PNGTexDB(1024);
-        g_mapDB           = new PNGTexDB(8192);
+        g_mapDB           = new PNGTexDB(8192, 2);
         g_heroDB          = new PNGTexOffDB(1024);
-        g_monsterDB       = new PNGTexOffDB(1024);
+        g_monsterDB       = new PNGTexOffDB(1024, 1);
         g_weaponDB        = new PNGTexOffDB(1024);
         g_magicDB         = new PNGTexOffDB(1024);
-        g_standNPCDB      = new PNGTexOffDB(1024);
-        g_fontexDB        = new FontexDB(1024);
+        g_standNPCDB      = new PNGTexOffDB(1024, 1);
+        g_fontexDB        = new FontexDB(8192);
         g_mapBinDB        = new MapBinDB();
         g_emoticonDB      = new emoticonDB();
+
+        if(g_clientArgParser->recordCacheTrace){
+            // keys retrieved from these caches are dumped for tools/cachebench
+            g_mapDB    ->RecordTrace("mapdb.trace");
+            g_monsterDB->RecordTrace("monsterdb.trace");
+            g_fontexDB ->RecordTrace("fontexdb.trace");
+        }
         g_client          = new Client();       // loads fontex resource
         g_notifyBoard     = new NotifyBoard(0, 0, 10240, 0, 15, 0, colorf::RED + 255);
 
@@ -0,0 +1,190 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapchunkcache.cpp
+ *        Created: 10/19/2026 23:51:06
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include "colorf.hpp"
+#include "pngtexdb.hpp"
+#include "sdldevice.hpp"
+#include "mapchunkcache.hpp"
+
+extern PNGTexDB *g_mapDB;
+extern SDLDevice *g_SDLDevice;
+
+// don't bake incomplete chunk every frame
+// textures are uploaded with a time budget, wait for a batch of them
+constexpr uint32_t MAPCHUNK_REBAKEMS = 100;
+
+void MapChunkCache::clear()
+{
+    for(auto &p: m_chunkList){
+        if(p.second.Texture){
+            SDL_DestroyTexture(p.second.Texture);
+        }
+    }
+    m_chunkList.clear();
+}
+
+bool MapChunkCache::drawChunk(const Mir2xMapData &mapData, int cx, int cy, int originX, int originY)
+{
+    bool complete = true;
+    const int gx0 = cx * SYS_MAPCHUNKGRIDX;
+    const int gy0 = cy * SYS_MAPCHUNKGRIDY;
+
+    // tiles are 2x2 grids, chunk aligns to tile
+    for(int y = gy0; y < gy0 + SYS_MAPCHUNKGRIDY; y += 2){
+        for(int x = gx0; x < gx0 + SYS_MAPCHUNKGRIDX; x += 2){
+            if(!mapData.ValidC(x, y)){
+                continue;
+            }
+
+            if(const auto &tile = mapData.Tile(x, y); tile.Valid()){
+                if(auto texPtr = g_mapDB->Retrieve(tile.Image())){
+                    g_SDLDevice->DrawTexture(texPtr, (x - gx0) * SYS_MAPGRIDXP + originX, (y - gy0) * SYS_MAPGRIDYP + originY);
+                }
+                else{
+                    complete = false;
+                }
+            }
+        }
+    }
+
+    // objects are drawn at the bottom-left of its grid and go up and right
+    // include grids at left and below which can reach this chunk
+    for(int y = gy0; y < gy0 + SYS_MAPCHUNKGRIDY + SYS_OBJMAXH; ++y){
+        for(int x = gx0 - SYS_OBJMAXW; x < gx0 + SYS_MAPCHUNKGRIDX; ++x){
+            if(!mapData.ValidC(x, y)){
+                continue;
+            }
+
+            for(const int i: {0, 1}){
+                const auto objArr = mapData.Cell(x, y).ObjectArray(i);
+                if(!bakeable(objArr)){
+                    continue;
+                }
+
+                const uint32_t imageId = 0
+                    | (((uint32_t)(objArr[2])) << 16)
+                    | (((uint32_t)(objArr[1])) <<  8)
+                    | (((uint32_t)(objArr[0])) <<  0);
+
+                if(auto texPtr = g_mapDB->Retrieve(imageId)){
+                    const int texH = SDLDevice::getTextureHeight(texPtr);
+                    g_SDLDevice->DrawTexture(texPtr, (x - gx0) * SYS_MAPGRIDXP + originX, (y + 1 - gy0) * SYS_MAPGRIDYP + originY - texH);
+                }
+                else{
+                    complete = false;
+                }
+            }
+        }
+    }
+    return complete;
+}
+
+MapChunkCache::ChunkEntry *MapChunkCache::bakeChunk(const Mir2xMapData &mapData, int cx, int cy)
+{
+    auto p = m_chunkList.find(chunkKey(cx, cy));
+    if(p == m_chunkList.end()){
+        if(m_chunkList.size() >= m_chunkMax){
+            // evict the least recently drawn chunk
+            // never evict chunks drawn in this frame, only happens if the view needs more than m_chunkMax chunks
+            auto evictIter = std::min_element(m_chunkList.begin(), m_chunkList.end(), [](const auto &lhs, const auto &rhs)
+            {
+                return lhs.second.LastFrame < rhs.second.LastFrame;
+            });
+
+            if(evictIter->second.LastFrame == m_frame){
+                return nullptr;
+            }
+
+            SDL_DestroyTexture(evictIter->second.Texture);
+            m_chunkList.erase(evictIter);
+        }
+
+        auto texPtr = g_SDLDevice->createRenderTexture(SYS_MAPCHUNKGRIDX * SYS_MAPGRIDXP, SYS_MAPCHUNKGRIDY * SYS_MAPGRIDYP);
+        if(!texPtr){
+            return nullptr;
+        }
+
+        p = m_chunkList.emplace(chunkKey(cx, cy), ChunkEntry{}).first;
+        p->second.Texture = texPtr;
+    }
+
+    {
+        SDLDevice::EnableRenderTarget enableTarget(p->second.Texture);
+        g_SDLDevice->clearScreen();
+        p->second.Complete = drawChunk(mapData, cx, cy, 0, 0);
+    }
+
+    p->second.BakeTick = SDL_GetTicks();
+    return &(p->second);
+}
+
+void MapChunkCache::draw(const Mir2xMapData &mapData, int viewX, int viewY, int viewW, int viewH)
+{
+    m_frame++;
+    if(!mapData.Valid()){
+        return;
+    }
+
+    constexpr int chunkPW = SYS_MAPCHUNKGRIDX * SYS_MAPGRIDXP;
+    constexpr int chunkPH = SYS_MAPCHUNKGRIDY * SYS_MAPGRIDYP;
+
+    const auto fnFloorDiv = [](int a, int b) -> int
+    {
+        return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+    };
+
+    const int cx0 = std::max<int>(0, fnFloorDiv(viewX, chunkPW));
+    const int cy0 = std::max<int>(0, fnFloorDiv(viewY, chunkPH));
+    const int cx1 = std::min<int>((mapData.W() - 1) / SYS_MAPCHUNKGRIDX, fnFloorDiv(viewX + viewW - 1, chunkPW));
+    const int cy1 = std::min<int>((mapData.H() - 1) / SYS_MAPCHUNKGRIDY, fnFloorDiv(viewY + viewH - 1, chunkPH));
+
+    int bakeLeft = SYS_MAPCHUNKBAKE;
+    const auto currTick = SDL_GetTicks();
+
+    for(int cy = cy0; cy <= cy1; ++cy){
+        for(int cx = cx0; cx <= cx1; ++cx){
+            const int drawX = cx * chunkPW - viewX;
+            const int drawY = cy * chunkPH - viewY;
+
+            ChunkEntry *chunkPtr = nullptr;
+            if(auto p = m_chunkList.find(chunkKey(cx, cy)); p != m_chunkList.end()){
+                chunkPtr = &(p->second);
+            }
+
+            const bool needBake = !chunkPtr || (!chunkPtr->Complete && currTick >= chunkPtr->BakeTick + MAPCHUNK_REBAKEMS);
+            if(needBake && bakeLeft > 0){
+                bakeLeft--;
+                if(auto bakedPtr = bakeChunk(mapData, cx, cy)){
+                    chunkPtr = bakedPtr;
+                }
+            }
+
+            if(chunkPtr){
+                chunkPtr->LastFrame = m_frame;
+                g_SDLDevice->DrawTexture(chunkPtr->Texture, drawX, drawY);
+                continue;
+            }
+
+            // no budget to bake this frame
+            // draw it grid by grid, clip objects from neighbour chunks
+            SDLDevice::EnableClipRect enableClip(drawX, drawY, chunkPW, chunkPH);
+            drawChunk(mapData, cx, cy, drawX, drawY);
+        }
+    }
+}
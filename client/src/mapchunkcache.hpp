@@ -0,0 +1,118 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapchunkcache.hpp
+ *        Created: 10/19/2026 23:51:06
+ *    Description: bake static ground layer of map into chunk textures
+ *
+ *                 tiles and ground objects without animation and alpha are drawn into
+ *                 offscreen textures of SYS_MAPCHUNKGRIDX x SYS_MAPCHUNKGRIDY grids once,
+ *                 each frame only draws visible chunks
+ *
+ *                 ground objects can be higher than one grid, a chunk also bakes objects
+ *                 of the SYS_OBJMAXH rows below it, clipped by the chunk texture, so every
+ *                 pixel gets the same drawing order as drawing grid by grid
+ *
+ *                 chunk with missing texture (still loading in background) is marked as
+ *                 incomplete and gets baked again later
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <SDL2/SDL.h>
+#include "sysconst.hpp"
+#include "mir2xmapdata.hpp"
+
+class MapChunkCache final
+{
+    private:
+        struct ChunkEntry
+        {
+            SDL_Texture *Texture = nullptr;
+
+            bool     Complete  = false;
+            uint32_t BakeTick  = 0;
+            uint64_t LastFrame = 0;
+        };
+
+    private:
+        const size_t m_chunkMax;
+
+    private:
+        uint64_t m_frame = 0;
+        std::unordered_map<uint64_t, ChunkEntry> m_chunkList;
+
+    public:
+        MapChunkCache(size_t chunkMax = SYS_MAPCHUNKMAX)
+            : m_chunkMax(chunkMax)
+        {
+            static_assert(SYS_MAPCHUNKGRIDX % 2 == 0 && SYS_MAPCHUNKGRIDY % 2 == 0, "map chunk should align to tile");
+        }
+
+    public:
+        ~MapChunkCache()
+        {
+            clear();
+        }
+
+    public:
+        // call when switching map or render targets get lost
+        void clear();
+
+    public:
+        // draw tiles and static ground objects in the view
+        // caller still needs to draw ground objects which are not bakeable
+        void draw(const Mir2xMapData &, int, int, int, int);
+
+    public:
+        static bool aniObject(const std::array<uint8_t, 5> &objArr)
+        {
+            return (objArr[3] & 0X80) && (false
+                    || objArr[2] == 11
+                    || objArr[2] == 26
+                    || objArr[2] == 41
+                    || objArr[2] == 56
+                    || objArr[2] == 71);
+        }
+
+        static bool bakeable(const std::array<uint8_t, 5> &objArr)
+        {
+            return true
+                && ((bool)(objArr[4] & 0X80))   // valid
+                && ((bool)(objArr[4] & 0X01))   // ground
+                && !((bool)(objArr[4] & 0X02))  // alpha
+                && !aniObject(objArr);
+        }
+
+    public:
+        size_t chunkCount() const
+        {
+            return m_chunkList.size();
+        }
+
+    private:
+        static constexpr uint64_t chunkKey(int cx, int cy)
+        {
+            return ((uint64_t)((uint32_t)(cx)) << 32) | (uint64_t)((uint32_t)(cy));
+        }
+
+    private:
+        ChunkEntry *bakeChunk(const Mir2xMapData &, int, int);
+
+    private:
+        // draw all bakeable content of chunk (cx, cy) with its left-top at (originX, originY)
+        // returns false if any texture is not ready
+        static bool drawChunk(const Mir2xMapData &, int, int, int, int);
+};
@@ -209,6 +209,29 @@ void NetIO::readHeadCode()
                     asio::async_read(m_socket, asio::buffer(m_readLen, 4), fnOnReadLen);
                     return;
                 }
+            case 4:
+                {
+                    // [origLen: 4][compLen: 4][mask][comp]
+                    auto fnOnReadLen = [this, fnOnNetError](std::error_code errCode, size_t){
+                        if(errCode){ fnOnNetError(errCode); }
+                        else{
+                            uint32_t nOrigLenU32 = 0;
+                            uint32_t nCompLenU32 = 0;
+
+                            std::memcpy(&nOrigLenU32, m_readLen + 0, 4);
+                            std::memcpy(&nCompLenU32, m_readLen + 4, 4);
+
+                            if(nOrigLenU32 == 0 || nCompLenU32 > nOrigLenU32){
+                                shutdown();
+                                g_log->addLog(LOGTYPE_WARNING, "Invalid package: HC = %d, OrigLen = %d, CompLen = %d", (int)(m_readHC), (int)(nOrigLenU32), (int)(nCompLenU32));
+                                return;
+                            }
+                            readBody((nOrigLenU32 + 7) / 8, nCompLenU32);
+                        }
+                    };
+                    asio::async_read(m_socket, asio::buffer(m_readLen, 8), fnOnReadLen);
+                    return;
+                }
             default:
                 {
                     shutdown();
@@ -246,6 +269,10 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
         fnReportCurrentMessage();
     };
 
+    // length of decompressed data
+    // fixed by head code for mode-1, carried in message for mode-4
+    uint32_t nOrigLen = 0;
+
     ServerMsg stSMSG(m_readHC);
     switch(stSMSG.type()){
         case 0:
@@ -259,6 +286,7 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
                     fnReportInvalidArg();
                     return false;
                 }
+                nOrigLen = stSMSG.dataLen();
                 m_readBuf.resize(nMaskLen + nBodyLen + 8 + stSMSG.dataLen());
                 break;
             }
@@ -277,7 +305,17 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
                     fnReportInvalidArg();
                     return false;
                 }
-                m_readBuf.resize(stSMSG.dataLen());
+                m_readBuf.resize(nBodyLen);
+                break;
+            }
+        case 4:
+            {
+                std::memcpy(&nOrigLen, m_readLen, 4);
+                if(!((nMaskLen == (nOrigLen + 7) / 8) && (nBodyLen <= nOrigLen))){
+                    fnReportInvalidArg();
+                    return false;
+                }
+                m_readBuf.resize(nMaskLen + nBodyLen + 8 + nOrigLen);
                 break;
             }
         default:
@@ -288,7 +326,7 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
     }
 
     if(auto nDataLen = nMaskLen + nBodyLen){
-        auto fnDoneReadData = [this, nMaskLen, nBodyLen, stSMSG, fnReportCurrentMessage, fnOnNetError](std::error_code errCode, size_t){
+        auto fnDoneReadData = [this, nMaskLen, nBodyLen, nOrigLen, fnReportCurrentMessage, fnOnNetError](std::error_code errCode, size_t){
             if(errCode){ fnOnNetError(errCode); }
             else{
                 if(nMaskLen){
@@ -306,17 +344,17 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
                         return;
                     }
 
-                    if(nBodyLen <= stSMSG.dataLen()){
+                    if(nBodyLen <= nOrigLen){
                         auto pMaskData = &(m_readBuf[0]);
                         auto pCompData = &(m_readBuf[nMaskLen]);
                         auto pOrigData = &(m_readBuf[((nMaskLen + nBodyLen + 7) / 8) * 8]);
-                        if(Compress::Decode(pOrigData, stSMSG.dataLen(), pMaskData, pCompData) != (int)(nBodyLen)){
+                        if(Compress::Decode(pOrigData, nOrigLen, pMaskData, pCompData) != (int)(nBodyLen)){
                             g_log->addLog(LOGTYPE_WARNING, "Decode failed: MaskCount = %d, CompLen = %d", nMaskCount, (int)(nBodyLen));
                             fnReportCurrentMessage();
                             return;
                         }
                     }else{
-                        g_log->addLog(LOGTYPE_WARNING, "Corrupted data: DataLen = %d, CompLen = %d", (int)(stSMSG.dataLen()), (int)(nBodyLen));
+                        g_log->addLog(LOGTYPE_WARNING, "Corrupted data: DataLen = %d, CompLen = %d", (int)(nOrigLen), (int)(nBodyLen));
                         fnReportCurrentMessage();
                         return;
                     }
@@ -326,7 +364,7 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
                 // we should call the completion handler here
 
                 // 1. call completion on decompressed data
-                m_msgHandler(m_readHC, &(m_readBuf[nMaskLen ? ((nMaskLen + nBodyLen + 7) / 8 * 8) : 0]), nMaskLen ? stSMSG.dataLen() : nBodyLen);
+                m_msgHandler(m_readHC, &(m_readBuf[nMaskLen ? ((nMaskLen + nBodyLen + 7) / 8 * 8) : 0]), nMaskLen ? nOrigLen : nBodyLen);
 
                 // 2. read next readHeadCode()
                 readHeadCode();
@@ -48,7 +48,7 @@ class NetIO final
 
     private:
         uint8_t              m_readHC;
-        uint8_t              m_readLen[4];
+        uint8_t              m_readLen[8];
         std::vector<uint8_t> m_readBuf;
 
     private:
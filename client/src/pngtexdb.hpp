@@ -25,6 +25,7 @@
 #include "inndb.hpp"
 #include "hexstr.hpp"
 #include "sdldevice.hpp"
+#include "texloader.hpp"
 
 struct PNGTexEntry
 {
@@ -36,17 +37,30 @@ class PNGTexDB: public innDB<uint32_t, PNGTexEntry>
     private:
         std::unique_ptr<ZSDB> m_zsdbPtr;
 
+    private:
+        // decode in background if not zero
+        // miss returns nullptr as placeholder until the texture gets uploaded
+        const size_t m_asyncThread;
+        std::unique_ptr<TexLoader> m_loaderPtr;
+
     public:
-        PNGTexDB(size_t nResMax)
+        PNGTexDB(size_t nResMax, size_t nAsyncThread = 0)
             : innDB<uint32_t, PNGTexEntry>(nResMax)
             , m_zsdbPtr()
+            , m_asyncThread(nAsyncThread)
+            , m_loaderPtr()
         {}
 
     public:
         bool Load(const char *szPNGTexDBName)
         {
             try{
-                m_zsdbPtr = std::make_unique<ZSDB>(szPNGTexDBName);
+                m_loaderPtr.reset();
+                m_zsdbPtr = std::make_unique<ZSDB>(szPNGTexDBName, true);
+
+                if(m_asyncThread){
+                    m_loaderPtr = std::make_unique<TexLoader>(m_zsdbPtr.get(), m_asyncThread);
+                }
             }catch(...){
                 return false;
             }
@@ -56,6 +70,15 @@ class PNGTexDB: public innDB<uint32_t, PNGTexEntry>
     public:
         SDL_Texture *Retrieve(uint32_t nKey)
         {
+            if(m_loaderPtr){
+                if(PNGTexEntry stEntry {nullptr}; this->FindResource(nKey, &stEntry)){
+                    return stEntry.Texture;
+                }
+
+                m_loaderPtr->request(nKey, true);
+                return nullptr;
+            }
+
             if(PNGTexEntry stEntry {nullptr}; this->RetrieveResource(nKey, &stEntry)){
                 return stEntry.Texture;
             }
@@ -67,6 +90,32 @@ class PNGTexDB: public innDB<uint32_t, PNGTexEntry>
             return Retrieve((uint32_t)(((uint32_t)(nIndex) << 16) + nImage));
         }
 
+    public:
+        void Prefetch(uint32_t nKey)
+        {
+            if(m_loaderPtr && !this->HasResource(nKey)){
+                m_loaderPtr->request(nKey, false);
+            }
+        }
+
+        size_t Upload(double fBudgetMS)
+        {
+            if(!m_loaderPtr){
+                return 0;
+            }
+
+            return m_loaderPtr->upload(fBudgetMS, [this](const TexLoader::LoadResult &rstResult)
+            {
+                if(this->HasResource(rstResult.Key)){
+                    return;
+                }
+
+                extern SDLDevice *g_SDLDevice;
+                PNGTexEntry stEntry {g_SDLDevice->CreateTextureFromSurface(rstResult.Surface)};
+                this->InsertResource(rstResult.Key, stEntry, stEntry.Texture ? 1 : 0);
+            });
+        }
+
     public:
         virtual std::tuple<PNGTexEntry, size_t> loadResource(uint32_t nKey)
         {
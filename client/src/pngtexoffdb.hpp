@@ -28,6 +28,7 @@
 #include "inndb.hpp"
 #include "hexstr.hpp"
 #include "sdldevice.hpp"
+#include "texloader.hpp"
 
 struct PNGTexOffEntry
 {
@@ -41,17 +42,30 @@ class PNGTexOffDB: public innDB<uint32_t, PNGTexOffEntry>
     private:
         std::unique_ptr<ZSDB> m_zsdbPtr;
 
+    private:
+        // decode in background if not zero
+        // miss returns nullptr as placeholder until the texture gets uploaded
+        const size_t m_asyncThread;
+        std::unique_ptr<TexLoader> m_loaderPtr;
+
     public:
-        PNGTexOffDB(size_t nResMax)
+        PNGTexOffDB(size_t nResMax, size_t nAsyncThread = 0)
             : innDB<uint32_t, PNGTexOffEntry>(nResMax)
             , m_zsdbPtr()
+            , m_asyncThread(nAsyncThread)
+            , m_loaderPtr()
         {}
 
     public:
         bool Load(const char *szPNGTexOffDBName)
         {
             try{
-                m_zsdbPtr = std::make_unique<ZSDB>(szPNGTexOffDBName);
+                m_loaderPtr.reset();
+                m_zsdbPtr = std::make_unique<ZSDB>(szPNGTexOffDBName, true);
+
+                if(m_asyncThread){
+                    m_loaderPtr = std::make_unique<TexLoader>(m_zsdbPtr.get(), m_asyncThread);
+                }
             }catch(...){
                 return false;
             }
@@ -61,7 +75,21 @@ class PNGTexOffDB: public innDB<uint32_t, PNGTexOffEntry>
     public:
         SDL_Texture *Retrieve(uint32_t nKey, int *pDX, int *pDY)
         {
-            if(PNGTexOffEntry stEntry {nullptr, 0, 0}; this->RetrieveResource(nKey, &stEntry)){
+            const auto fnRetrieve = [this, nKey](PNGTexOffEntry *pEntry) -> bool
+            {
+                if(!m_loaderPtr){
+                    return this->RetrieveResource(nKey, pEntry);
+                }
+
+                if(this->FindResource(nKey, pEntry)){
+                    return true;
+                }
+
+                m_loaderPtr->request(nKey, true);
+                return false;
+            };
+
+            if(PNGTexOffEntry stEntry {nullptr, 0, 0}; fnRetrieve(&stEntry)){
                 if(pDX){
                     *pDX = stEntry.DX;
                 };
@@ -78,6 +106,61 @@ class PNGTexOffDB: public innDB<uint32_t, PNGTexOffEntry>
             return Retrieve((uint32_t)(((uint32_t)(nIndex) << 16) + nImage), pDX, pDY);
         }
 
+    public:
+        void Prefetch(uint32_t nKey)
+        {
+            if(m_loaderPtr && !this->HasResource(nKey)){
+                m_loaderPtr->request(nKey, false);
+            }
+        }
+
+        size_t Upload(double fBudgetMS)
+        {
+            if(!m_loaderPtr){
+                return 0;
+            }
+
+            return m_loaderPtr->upload(fBudgetMS, [this](const TexLoader::LoadResult &rstResult)
+            {
+                if(this->HasResource(rstResult.Key)){
+                    return;
+                }
+
+                PNGTexOffEntry stEntry {nullptr, 0, 0};
+                if(parseOffset(rstResult.FileName, &stEntry)){
+                    extern SDLDevice *g_SDLDevice;
+                    stEntry.Texture = g_SDLDevice->CreateTextureFromSurface(rstResult.Surface);
+                }
+                this->InsertResource(rstResult.Key, stEntry, stEntry.Texture ? 1 : 0);
+            });
+        }
+
+    private:
+        static bool parseOffset(const char *szFileName, PNGTexOffEntry *pEntry)
+        {
+            if(!(szFileName && (std::strlen(szFileName) >= 18))){
+                return false;
+            }
+
+            //
+            // [0 ~ 7] [8] [9] [10 ~ 13] [14 ~ 17]
+            //  <KEY>  <S> <S>   <+DX>     <+DY>
+            //    4    1/2 1/2     2         2
+            //
+            //   KEY: 3 bytes
+            //   S  : sign of DX, take 1 char, 1/2 byte, + for 1, - for 0
+            //   S  : sign of DY, take 1 char, 1/2 byte
+            //   +DX: abs(DX) take 4 chars, 2 bytes
+            //   +DY: abs(DY) take 4 chars, 2 bytes
+
+            pEntry->DX = (szFileName[8] != '0') ? 1 : (-1);
+            pEntry->DY = (szFileName[9] != '0') ? 1 : (-1);
+
+            pEntry->DX *= (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 10));
+            pEntry->DY *= (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 14));
+            return true;
+        }
+
     public:
         virtual std::tuple<PNGTexOffEntry, size_t> loadResource(uint32_t nKey)
         {
@@ -85,24 +168,7 @@ class PNGTexOffDB: public innDB<uint32_t, PNGTexOffEntry>
             std::vector<uint8_t> stBuf;
             PNGTexOffEntry stEntry {nullptr, 0, 0};
 
-            if(auto szFileName = m_zsdbPtr->Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, &stBuf); szFileName && (std::strlen(szFileName) >= 18)){
-                //
-                // [0 ~ 7] [8] [9] [10 ~ 13] [14 ~ 17]
-                //  <KEY>  <S> <S>   <+DX>     <+DY>
-                //    4    1/2 1/2     2         2
-                //
-                //   KEY: 3 bytes
-                //   S  : sign of DX, take 1 char, 1/2 byte, + for 1, - for 0
-                //   S  : sign of DY, take 1 char, 1/2 byte
-                //   +DX: abs(DX) take 4 chars, 2 bytes
-                //   +DY: abs(DY) take 4 chars, 2 bytes
-
-                stEntry.DX = (szFileName[8] != '0') ? 1 : (-1);
-                stEntry.DY = (szFileName[9] != '0') ? 1 : (-1);
-
-                stEntry.DX *= (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 10));
-                stEntry.DY *= (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 14));
-
+            if(auto szFileName = m_zsdbPtr->Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, &stBuf); parseOffset(szFileName, &stEntry)){
                 extern SDLDevice *g_SDLDevice;
                 stEntry.Texture = g_SDLDevice->CreateTexture(stBuf.data(), stBuf.size());
             }
@@ -25,6 +25,7 @@
 #include "sysconst.hpp"
 #include "mapbindb.hpp"
 #include "pngtexdb.hpp"
+#include "pngtexoffdb.hpp"
 #include "sdldevice.hpp"
 #include "clientargparser.hpp"
 #include "pathfinder.hpp"
@@ -44,6 +45,8 @@ extern PNGTexDB *g_mapDB;
 extern MapBinDB *g_mapBinDB;
 extern SDLDevice *g_SDLDevice;
 extern PNGTexDB *g_groundItemDB;
+extern PNGTexOffDB *g_monsterDB;
+extern PNGTexOffDB *g_standNPCDB;
 extern NotifyBoard *g_notifyBoard;
 extern ClientArgParser *g_clientArgParser;
 
@@ -54,6 +57,8 @@ ProcessRun::ProcessRun()
     , m_viewX(0)
     , m_viewY(0)
     , m_mapScrolling(false)
+    , m_prefetchGridX(-1)
+    , m_prefetchGridY(-1)
     , m_luaModule(this)
     , m_GUIManager(this)
     , m_mousePixlLoc(0, 0, "", 0, 15, 0, colorf::RGBA(0XFF, 0X00, 0X00, 0X00))
@@ -127,6 +132,7 @@ void ProcessRun::update(double fUpdateTime)
     getMyHero()->update(fUpdateTime);
     const int myHeroX = getMyHero()->x();
     const int myHeroY = getMyHero()->y();
+    m_renderQueue.update(getMyHero()->UID(), myHeroX, myHeroY);
 
     for(auto p = m_creatureList.begin(); p != m_creatureList.end();){
         if(p->second.get() == getMyHero()){
@@ -141,9 +147,13 @@ void ProcessRun::update(double fUpdateTime)
                 p->second->querySelf();
             }
             p->second->update(fUpdateTime);
+
+            const auto [newX, newY] = p->second->location();
+            m_renderQueue.update(p->first, newX, newY);
             ++p;
         }
         else{
+            m_renderQueue.remove(p->first);
             p = m_creatureList.erase(p);
         }
     }
@@ -180,6 +190,8 @@ void ProcessRun::update(double fUpdateTime)
         centerMyHero();
     }
 
+    prefetchTexture();
+
     m_starRatio += 0.05;
     if(m_starRatio >= 2.50){
         m_starRatio = 0.00;
@@ -256,6 +268,7 @@ uint64_t ProcessRun::FocusUID(int nFocusType)
 
 void ProcessRun::draw()
 {
+    uploadTexture();
     SDLDevice::RenderNewFrame newFrame;
     const auto fnLimitedRegion = [](int mn, int mx, int parm) -> int
     {
@@ -267,12 +280,24 @@ void ProcessRun::draw()
     const int x1 = fnLimitedRegion(0, m_mir2xMapData.W(), +SYS_OBJMAXW + (m_viewX + 2 * SYS_MAPGRIDXP + g_SDLDevice->getRendererWidth() ) / SYS_MAPGRIDXP);
     const int y1 = fnLimitedRegion(0, m_mir2xMapData.H(), +SYS_OBJMAXH + (m_viewY + 2 * SYS_MAPGRIDYP + g_SDLDevice->getRendererHeight()) / SYS_MAPGRIDYP);
 
-    drawTile(x0, y0, x1, y1);
+    if(!g_clientArgParser->disableMapChunk && g_SDLDevice->renderTargetSupported()){
+        // tiles and static ground objects are baked in chunks
+        // only draw animated and alpha ground objects here, drawGroundObject() keeps their z-order
+        m_mapChunkCache.draw(m_mir2xMapData, m_viewX, m_viewY, g_SDLDevice->getRendererWidth(), g_SDLDevice->getRendererHeight());
+        for(int y = y0; y <= y1; ++y){
+            for(int x = x0; x <= x1; ++x){
+                drawGroundObject(x, y, true, true);
+            }
+        }
+    }
+    else{
+        drawTile(x0, y0, x1, y1);
 
-    // ground objects
-    for(int y = y0; y <= y1; ++y){
-        for(int x = x0; x <= x1; ++x){
-            drawGroundObject(x, y, true);
+        // ground objects
+        for(int y = y0; y <= y1; ++y){
+            for(int x = x0; x <= x1; ++x){
+                drawGroundObject(x, y, true);
+            }
         }
     }
 
@@ -301,48 +326,40 @@ void ProcessRun::draw()
 
     drawGroundItem(x0, y0, x1, y1);
 
-    const auto locHashTable = [this]()
-    {
-        LocHashTable<std::vector<ClientCreature *>> table;
-        for(auto &p: m_creatureList){
-            table[p.second->location()].push_back(p.second.get());
-        }
-        return table;
-    }();
-
     // over ground objects
     for(int y = y0; y <= y1; ++y){
         for(int x = x0; x <= x1; ++x){
             drawGroundObject(x, y, false);
         }
 
-        for(int x = x0; x <= x1; ++x){
-            if(auto p = locHashTable.find({x, y}); p != locHashTable.end()){
-                for(auto creaturePtr: p->second){
-                    if(!(creaturePtr && creaturePtr->location() == std::make_tuple(x, y))){
-                        throw fflerror("invalid creature location table");
-                    }
-
-                    if(!creaturePtr->alive()){
-                        continue;
-                    }
+        // creatures of this row from left to right
+        // queue is synced in update(), creatures added since then show up next frame
+        int lastCoverX = -1;
+        m_renderQueue.forEach(y, x0, x1, [this, y, &lastCoverX](uint64_t uid, int x) -> bool
+        {
+            const auto p = m_creatureList.find(uid);
+            if(p == m_creatureList.end()){
+                return false;
+            }
 
-                    int focusMask = 0;
-                    for(auto focusType = 0; focusType < FOCUS_MAX; ++focusType){
-                        if(FocusUID(focusType) == creaturePtr->UID()){
-                            focusMask |= (1 << focusType);
-                        }
+            if(auto creaturePtr = p->second.get(); creaturePtr->alive()){
+                int focusMask = 0;
+                for(auto focusType = 0; focusType < FOCUS_MAX; ++focusType){
+                    if(FocusUID(focusType) == creaturePtr->UID()){
+                        focusMask |= (1 << focusType);
                     }
-                    creaturePtr->draw(m_viewX, m_viewY, focusMask);
                 }
+                creaturePtr->draw(m_viewX, m_viewY, focusMask);
+            }
 
-                if(g_clientArgParser->drawCreatureCover){
-                    SDLDevice::EnableDrawColor enableColor(colorf::RGBA(0, 0, 255, 128));
-                    SDLDevice::EnableDrawBlendMode enableBlendMode(SDL_BLENDMODE_BLEND);
-                    g_SDLDevice->fillRectangle(x * SYS_MAPGRIDXP - m_viewX, y * SYS_MAPGRIDYP - m_viewY, SYS_MAPGRIDXP, SYS_MAPGRIDYP);
-                }
+            if(g_clientArgParser->drawCreatureCover && x != lastCoverX){
+                SDLDevice::EnableDrawColor enableColor(colorf::RGBA(0, 0, 255, 128));
+                SDLDevice::EnableDrawBlendMode enableBlendMode(SDL_BLENDMODE_BLEND);
+                g_SDLDevice->fillRectangle(x * SYS_MAPGRIDXP - m_viewX, y * SYS_MAPGRIDYP - m_viewY, SYS_MAPGRIDXP, SYS_MAPGRIDYP);
+                lastCoverX = x;
             }
-        }
+            return true;
+        });
     }
 
     // draw all rotating stars
@@ -401,6 +418,12 @@ void ProcessRun::draw()
 
 void ProcessRun::processEvent(const SDL_Event &event)
 {
+    // baked map chunks are render target textures
+    // content is undefined after renderer reset
+    if(event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET){
+        m_mapChunkCache.clear();
+    }
+
     if(m_GUIManager.processEvent(event, true)){
         return;
     }
@@ -582,6 +605,11 @@ void ProcessRun::loadMap(uint32_t mapID)
     m_mapID = mapID;
     m_mir2xMapData = *mapBinPtr;
     m_groundItemList.clear();
+    m_mapChunkCache.clear();
+    m_renderQueue.clear(m_mir2xMapData.H());
+
+    m_prefetchGridX = -1;
+    m_prefetchGridY = -1;
 }
 
 bool ProcessRun::CanMove(bool bCheckGround, int nCheckCreature, int nX, int nY)
@@ -1302,12 +1330,17 @@ void ProcessRun::centerMyHero()
 
 std::tuple<int, int> ProcessRun::getRandLoc(uint32_t nMapID)
 {
-    const auto mapBinPtr = [nMapID, this]() -> const Mir2xMapData *
+    // keep the shared terrain alive while sampling
+    // it can be released by MapBinDB if nobody else holds it
+    std::shared_ptr<const Mir2xMapData> mapBinHolder;
+    const auto mapBinPtr = [nMapID, &mapBinHolder, this]() -> const Mir2xMapData *
     {
         if(nMapID == 0 || nMapID == MapID()){
             return &m_mir2xMapData;
         }
-        return g_mapBinDB->Retrieve(nMapID);
+
+        mapBinHolder = g_mapBinDB->Retrieve(nMapID);
+        return mapBinHolder.get();
     }();
 
     if(!mapBinPtr){
@@ -1531,6 +1564,59 @@ void ProcessRun::drawGroundItem(int x0, int y0, int x1, int y1)
     }
 }
 
+void ProcessRun::prefetchTexture()
+{
+    // request textures around current view to be decoded in background
+    // only takes effect for texture DBs with async loading enabled
+    const int gridX = m_viewX / SYS_MAPGRIDXP;
+    const int gridY = m_viewY / SYS_MAPGRIDYP;
+
+    if(gridX == m_prefetchGridX && gridY == m_prefetchGridY){
+        return;
+    }
+
+    m_prefetchGridX = gridX;
+    m_prefetchGridY = gridY;
+
+    const auto [rendererW, rendererH] = g_SDLDevice->getRendererSize();
+    const int x0 = gridX - SYS_PREFETCHGRIDX;
+    const int y0 = gridY - SYS_PREFETCHGRIDY;
+    const int x1 = gridX + SYS_PREFETCHGRIDX + rendererW / SYS_MAPGRIDXP;
+    const int y1 = gridY + SYS_PREFETCHGRIDY + rendererH / SYS_MAPGRIDYP + SYS_OBJMAXH;
+
+    for(int y = y0; y <= y1; ++y){
+        for(int x = x0; x <= x1; ++x){
+            if(!m_mir2xMapData.ValidC(x, y)){
+                continue;
+            }
+
+            if(!(x % 2) && !(y % 2)){
+                if(const auto &tile = m_mir2xMapData.Tile(x, y); tile.Valid()){
+                    g_mapDB->Prefetch(tile.Image());
+                }
+            }
+
+            for(const int i: {0, 1}){
+                if(const auto objArr = m_mir2xMapData.Cell(x, y).ObjectArray(i); objArr[4] & 0X80){
+                    g_mapDB->Prefetch(0
+                            | (((uint32_t)(objArr[2])) << 16)
+                            | (((uint32_t)(objArr[1])) <<  8)
+                            | (((uint32_t)(objArr[0])) <<  0));
+                }
+            }
+        }
+    }
+}
+
+void ProcessRun::uploadTexture()
+{
+    // textures decoded in background get uploaded in main thread
+    // limit time used per frame to avoid frame hitch when entering a new area
+    g_mapDB     ->Upload(SYS_TEXUPLOADMS * 0.6);
+    g_monsterDB ->Upload(SYS_TEXUPLOADMS * 0.3);
+    g_standNPCDB->Upload(SYS_TEXUPLOADMS * 0.1);
+}
+
 void ProcessRun::drawTile(int x0, int y0, int x1, int y1)
 {
     for(int y = y0; y < y1; ++y){
@@ -1546,7 +1632,7 @@ void ProcessRun::drawTile(int x0, int y0, int x1, int y1)
     }
 }
 
-void ProcessRun::drawGroundObject(int x, int y, bool ground)
+void ProcessRun::drawGroundObject(int x, int y, bool ground, bool skipBaked)
 {
     if(!m_mir2xMapData.ValidC(x, y)){
         return;
@@ -1554,6 +1640,10 @@ void ProcessRun::drawGroundObject(int x, int y, bool ground)
 
     for(const int i: {0, 1}){
         const auto objArr = m_mir2xMapData.Cell(x, y).ObjectArray(i);
+        if(skipBaked && MapChunkCache::bakeable(objArr)){
+            continue;
+        }
+
         if(true
                 && ((bool)(objArr[4] & 0X80))
                 && ((bool)(objArr[4] & 0X01) == ground)){
@@ -1582,7 +1672,58 @@ void ProcessRun::drawGroundObject(int x, int y, bool ground)
                     SDL_SetTextureBlendMode(texPtr, SDL_BLENDMODE_BLEND);
                     SDL_SetTextureAlphaMod(texPtr, 128);
                 }
-                g_SDLDevice->DrawTexture(texPtr, x * SYS_MAPGRIDXP - m_viewX, (y + 1) * SYS_MAPGRIDYP - m_viewY - texH);
+
+                const int drawX = x * SYS_MAPGRIDXP - m_viewX;
+                const int drawY = (y + 1) * SYS_MAPGRIDYP - m_viewY - texH;
+
+                g_SDLDevice->DrawTexture(texPtr, drawX, drawY);
+                if(skipBaked){
+                    redrawBakedObject(x, y, i, drawX, drawY, SDLDevice::getTextureWidth(texPtr), texH);
+                }
+            }
+        }
+    }
+}
+
+void ProcessRun::redrawBakedObject(int x, int y, int index, int rectX, int rectY, int rectW, int rectH)
+{
+    // object (x, y, index) is drawn over baked chunks, but in grid-by-grid order it's below the static
+    // ground objects drawn after it, redraw those inside its rect to keep the same z-order as before
+
+    // an object grows up-right from its grid, only these grids can reach the rect
+    const int gx0 = std::max<int>(0, (rectX + m_viewX) / SYS_MAPGRIDXP - SYS_OBJMAXW);
+    const int gx1 = (rectX + rectW + m_viewX) / SYS_MAPGRIDXP;
+    const int gy1 = (rectY + rectH + m_viewY) / SYS_MAPGRIDYP + SYS_OBJMAXH;
+
+    SDLDevice::EnableClipRect enableClip(rectX, rectY, rectW, rectH);
+    for(int cy = y; cy <= gy1; ++cy){
+        for(int cx = gx0; cx <= gx1; ++cx){
+            if(!m_mir2xMapData.ValidC(cx, cy)){
+                continue;
+            }
+
+            if(cy == y && cx < x){
+                continue;
+            }
+
+            for(const int i: {0, 1}){
+                if(cy == y && cx == x && i <= index){
+                    continue;
+                }
+
+                const auto objArr = m_mir2xMapData.Cell(cx, cy).ObjectArray(i);
+                if(!MapChunkCache::bakeable(objArr)){
+                    continue;
+                }
+
+                const uint32_t imageId = 0
+                    | (((uint32_t)(objArr[2])) << 16)
+                    | (((uint32_t)(objArr[1])) <<  8)
+                    | (((uint32_t)(objArr[0])) <<  0);
+
+                if(auto texPtr = g_mapDB->Retrieve(imageId)){
+                    g_SDLDevice->DrawTexture(texPtr, cx * SYS_MAPGRIDXP - m_viewX, (cy + 1) * SYS_MAPGRIDYP - m_viewY - SDLDevice::getTextureHeight(texPtr));
+                }
             }
         }
     }
@@ -1666,7 +1807,7 @@ void ProcessRun::drawMouseLocation()
 
 void ProcessRun::drawFPS()
 {
-    const auto fpsStr = std::to_string(g_SDLDevice->getFPS());
+    const auto fpsStr = str_printf("%d FPS, %.1f/%.1f/%.1f ms", (int)(g_SDLDevice->getFPS()), g_SDLDevice->getFrameTime(0.50), g_SDLDevice->getFrameTime(0.90), g_SDLDevice->getFrameTime(0.99));
     LabelBoard fpsBoard(0, 0, fpsStr.c_str(), 1, 12, 0, colorf::RGBA(0XFF, 0XFF, 0X00, 0X00));
 
     const int winWidth = g_SDLDevice->getRendererWidth();
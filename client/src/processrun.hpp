@@ -35,8 +35,10 @@
 #include "guimanager.hpp"
 #include "lochashtable.hpp"
 #include "mir2xmapdata.hpp"
+#include "mapchunkcache.hpp"
 #include "clientcreature.hpp"
 #include "clientluamodule.hpp"
+#include "creaturerenderqueue.hpp"
 
 class ClientPathFinder;
 class ProcessRun: public Process
@@ -93,6 +95,15 @@ class ProcessRun: public Process
     private:
         bool m_mapScrolling;
 
+    private:
+        // view grid of last texture prefetch
+        // only prefetch again when view moves to another grid
+        int m_prefetchGridX;
+        int m_prefetchGridY;
+
+    private:
+        MapChunkCache m_mapChunkCache;
+
     private:
         uint32_t m_aniSaveTick[8];
         uint8_t  m_aniTileFrame[8][16];
@@ -109,6 +120,10 @@ class ProcessRun: public Process
     private:
         std::unordered_map<uint64_t, std::unique_ptr<ClientCreature>> m_creatureList;
 
+    private:
+        // creatures in drawing order, synced in update()
+        CreatureRenderQueue m_renderQueue;
+
     private:
         std::set<uint64_t> m_UIDPending;
 
@@ -324,13 +339,18 @@ class ProcessRun: public Process
         void drawFPS();
         void drawMouseLocation();
 
+    private:
+        void prefetchTexture();
+        void uploadTexture();
+
     private:
         void drawTile(int, int, int, int);
         void drawGroundItem(int, int, int, int);
         void drawRotateStar(int, int, int, int);
 
     private:
-        void drawGroundObject(int, int, bool);
+        void drawGroundObject(int, int, bool, bool = false);
+        void redrawBakedObject(int, int, int, int, int, int, int);
 
     public:
         std::tuple<int, int> getACNum(const std::string &) const;
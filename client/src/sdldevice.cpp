@@ -45,6 +45,28 @@ SDLDevice::RenderNewFrame::~RenderNewFrame()
     g_SDLDevice->present();
 }
 
+SDLDevice::EnableRenderTarget::EnableRenderTarget(SDL_Texture *texture)
+    : OldTarget(g_SDLDevice->getRenderTarget())
+{
+    g_SDLDevice->setRenderTarget(texture);
+}
+
+SDLDevice::EnableRenderTarget::~EnableRenderTarget()
+{
+    SDL_SetRenderTarget(g_SDLDevice->m_renderer, OldTarget);
+}
+
+SDLDevice::EnableClipRect::EnableClipRect(int x, int y, int w, int h)
+{
+    const SDL_Rect rect {x, y, w, h};
+    g_SDLDevice->setClipRect(&rect);
+}
+
+SDLDevice::EnableClipRect::~EnableClipRect()
+{
+    g_SDLDevice->setClipRect(nullptr);
+}
+
 SDLDevice::EnableDrawColor::EnableDrawColor(uint32_t nRGBA)
 {
     g_SDLDevice->PushColor(nRGBA);
@@ -71,6 +93,13 @@ SDLDevice::SDLDevice()
         throw fflerror("multiple initialization for SDLDevice");
     }
 
+    if(g_clientArgParser->headless){
+        // no window system needed, the replay benchmark runs on build machines
+        // the dummy video driver only supports the software renderer
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+
     if(SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_EVENTS)){
         throw fflerror("initialization failed for SDL2: %s", SDL_GetError());
     }
@@ -197,6 +226,7 @@ void SDLDevice::DrawTexture(SDL_Texture *pstTexture,
         SDL_Rect stSrc {nSrcX, nSrcY, nSrcW, nSrcH};
         SDL_Rect stDst {nDstX, nDstY, nDstW, nDstH};
         SDL_RenderCopy(m_renderer, pstTexture, &stSrc, &stDst);
+        m_drawCallCount++;
     }
 }
 
@@ -209,6 +239,7 @@ void SDLDevice::DrawTexture(SDL_Texture *pstTexture,
         SDL_Rect stSrc {nSrcX, nSrcY, nSrcW, nSrcH};
         SDL_Rect stDst {nDstX, nDstY, nSrcW, nSrcH};
         SDL_RenderCopy(m_renderer, pstTexture, &stSrc, &stDst);
+        m_drawCallCount++;
     }
 }
 
@@ -222,6 +253,84 @@ void SDLDevice::DrawTexture(SDL_Texture *pstTexture, int nX, int nY)
     }
 }
 
+void SDLDevice::drawTextureQuad(SDL_Texture *texture, const TextureQuad *quadList, size_t quadCount)
+{
+    if(!texture || !quadList || !quadCount){
+        return;
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int texW = 0;
+    int texH = 0;
+
+    if(SDL_QueryTexture(texture, nullptr, nullptr, &texW, &texH)){
+        throw fflerror("query texture failed: %p", texture);
+    }
+
+    // reuse buffers, this function is only called by the render thread
+    static std::vector<SDL_Vertex> s_vertexList;
+    static std::vector<int> s_indexList;
+
+    s_vertexList.clear();
+    s_indexList.clear();
+
+    for(size_t i = 0; i < quadCount; ++i){
+        const auto &quad = quadList[i];
+        const SDL_Color color
+        {
+            colorf::R(quad.Color),
+            colorf::G(quad.Color),
+            colorf::B(quad.Color),
+            colorf::A(quad.Color),
+        };
+
+        const float x0 = quad.Dst.x;
+        const float y0 = quad.Dst.y;
+        const float x1 = quad.Dst.x + quad.Dst.w;
+        const float y1 = quad.Dst.y + quad.Dst.h;
+
+        const float u0 = 1.0f * (quad.Src.x             ) / texW;
+        const float v0 = 1.0f * (quad.Src.y             ) / texH;
+        const float u1 = 1.0f * (quad.Src.x + quad.Src.w) / texW;
+        const float v1 = 1.0f * (quad.Src.y + quad.Src.h) / texH;
+
+        const int base = (int)(s_vertexList.size());
+        s_vertexList.push_back({{x0, y0}, color, {u0, v0}});
+        s_vertexList.push_back({{x1, y0}, color, {u1, v0}});
+        s_vertexList.push_back({{x1, y1}, color, {u1, v1}});
+        s_vertexList.push_back({{x0, y1}, color, {u0, v1}});
+
+        for(const int index: {0, 1, 2, 0, 2, 3}){
+            s_indexList.push_back(base + index);
+        }
+    }
+
+    SDL_RenderGeometry(m_renderer, texture, s_vertexList.data(), (int)(s_vertexList.size()), s_indexList.data(), (int)(s_indexList.size()));
+    m_drawCallCount++;
+#else
+    // old SDL doesn't have geometry API
+    // all quads still share one texture so the renderer batches the copies
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 0;
+
+    SDL_GetTextureColorMod(texture, &r, &g, &b);
+    SDL_GetTextureAlphaMod(texture, &a);
+
+    for(size_t i = 0; i < quadCount; ++i){
+        const auto &quad = quadList[i];
+        SDL_SetTextureColorMod(texture, colorf::R(quad.Color), colorf::G(quad.Color), colorf::B(quad.Color));
+        SDL_SetTextureAlphaMod(texture, colorf::A(quad.Color));
+        SDL_RenderCopy(m_renderer, texture, &quad.Src, &quad.Dst);
+    }
+    m_drawCallCount += quadCount;
+
+    SDL_SetTextureColorMod(texture, r, g, b);
+    SDL_SetTextureAlphaMod(texture, a);
+#endif
+}
+
 TTF_Font *SDLDevice::CreateTTF(const uint8_t *pMem, size_t nSize, uint8_t nFontPointSize)
 {
     SDL_RWops *pstRWops = nullptr;
@@ -334,6 +443,14 @@ void SDLDevice::PopBlendMode()
     }
 }
 
+Uint32 SDLDevice::rendererFlags() const
+{
+    if(g_clientArgParser->softwareRenderer || g_clientArgParser->headless){
+        return SDL_RENDERER_SOFTWARE;
+    }
+    return 0;
+}
+
 void SDLDevice::CreateInitViewWindow()
 {
     if(m_renderer){
@@ -365,7 +482,7 @@ void SDLDevice::CreateInitViewWindow()
     SDL_RaiseWindow(m_window);
     SDL_SetWindowResizable(m_window, SDL_FALSE);
 
-    m_renderer = SDL_CreateRenderer(m_window, -1, 0);
+    m_renderer = SDL_CreateRenderer(m_window, -1, rendererFlags());
     if(!m_renderer){
         SDL_DestroyWindow(m_window);
         throw fflerror("failed to create SDL renderer: %s", SDL_GetError());
@@ -448,7 +565,7 @@ void SDLDevice::CreateMainWindow()
     }
 
     SDL_SetWindowMinimumSize(m_window, 800, 600);
-    m_renderer = SDL_CreateRenderer(m_window, -1, 0);
+    m_renderer = SDL_CreateRenderer(m_window, -1, rendererFlags());
 
     if(!m_renderer){
         SDL_DestroyWindow(m_window);
@@ -477,6 +594,7 @@ void SDLDevice::drawTextureEx(SDL_Texture *pTexture,
         SDL_Point stCenter {nCenterDstX, nCenterDstY};
 
         SDL_RenderCopyEx(m_renderer, pTexture, &stSrc, &stDst, fAngle, &stCenter, SDL_FLIP_NONE);
+        m_drawCallCount++;
     }
 }
 
@@ -495,6 +613,17 @@ SDL_Texture *SDLDevice::createTexture(const uint32_t *buf, int w, int h)
     return nullptr;
 }
 
+SDL_Texture *SDLDevice::createRenderTexture(int w, int h)
+{
+    if(auto ptex = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h)){
+        if(!SDL_SetTextureBlendMode(ptex, SDL_BLENDMODE_BLEND)){
+            return ptex;
+        }
+        SDL_DestroyTexture(ptex);
+    }
+    return nullptr;
+}
+
 TTF_Font *SDLDevice::DefaultTTF(uint8_t fontSize)
 {
     const static Rawbuf s_DefaultTTFData
@@ -563,6 +692,7 @@ void SDLDevice::fillRectangle(int nX, int nY, int nW, int nH)
     stRect.h = nH;
 
     SDL_RenderFillRect(m_renderer, &stRect);
+    m_drawCallCount++;
 }
 
 void SDLDevice::fillRectangle(uint32_t nRGBA, int nX, int nY, int nW, int nH)
@@ -584,6 +714,7 @@ void SDLDevice::DrawRectangle(int nX, int nY, int nW, int nH)
 
     SDL_RenderDrawRect(m_renderer, &rect);
     SDL_RenderDrawPoint(m_renderer, rect.x + rect.w - 1, rect.y + rect.h - 1);
+    m_drawCallCount += 2;
 }
 
 void SDLDevice::DrawRectangle(uint32_t color, int nX, int nY, int nW, int nH)
@@ -48,6 +48,28 @@ class SDLDevice final
            ~RenderNewFrame();
         };
 
+        struct EnableRenderTarget
+        {
+            SDL_Texture *OldTarget;
+
+            EnableRenderTarget(SDL_Texture *);
+           ~EnableRenderTarget();
+        };
+
+        struct EnableClipRect
+        {
+            EnableClipRect(int, int, int, int);
+           ~EnableClipRect();
+        };
+
+    public:
+        struct TextureQuad
+        {
+            SDL_Rect Src;
+            SDL_Rect Dst;
+            uint32_t Color;
+        };
+
     private:
         struct ColorStackNode
         {
@@ -85,6 +107,10 @@ class SDLDevice final
     private:
        std::unordered_map<int, SDL_Texture *> m_cover;
 
+    private:
+       // SDL_Render*() submissions, for the replay benchmark
+       size_t m_drawCallCount = 0;
+
     private:
        std::unordered_map<uint8_t, TTF_Font *> m_fontList;
 
@@ -104,6 +130,11 @@ class SDLDevice final
        void DrawTexture(SDL_Texture *, int, int, int, int, int, int);
        void DrawTexture(SDL_Texture *, int, int, int, int, int, int, int, int);
 
+    public:
+       // draw quads from one texture with per-quad color mod
+       // uses one SDL_RenderGeometry() call if SDL supports it
+       void drawTextureQuad(SDL_Texture *, const TextureQuad *, size_t);
+
     public:
        void drawTextureEx(SDL_Texture *,  
                int,     // x on src
@@ -140,11 +171,13 @@ class SDLDevice final
        {
            SetColor(0, 0, 0, 0);
            SDL_RenderClear(m_renderer);
+           m_drawCallCount++;
        }
 
        void DrawLine(int nX0, int nY0, int nX1, int nY1)
        {
            SDL_RenderDrawLine(m_renderer, nX0, nY0, nX1, nY1);
+           m_drawCallCount++;
        }
 
        void SetColor(uint8_t nR, uint8_t nG, uint8_t nB, uint8_t nA)
@@ -155,6 +188,18 @@ class SDLDevice final
        void DrawPixel(int nX, int nY)
        {
            SDL_RenderDrawPoint(m_renderer, nX, nY);
+           m_drawCallCount++;
+       }
+
+    public:
+       size_t drawCallCount() const
+       {
+           return m_drawCallCount;
+       }
+
+       void resetDrawCallCount()
+       {
+           m_drawCallCount = 0;
        }
 
     public:
@@ -239,6 +284,9 @@ class SDLDevice final
     public:
        TTF_Font *CreateTTF(const uint8_t *, size_t, uint8_t);
 
+    private:
+       Uint32 rendererFlags() const;
+
     public:
        void CreateMainWindow();
        void CreateInitViewWindow();
@@ -246,6 +294,33 @@ class SDLDevice final
     public:
        SDL_Texture *createTexture(const uint32_t *, int, int);
 
+    public:
+       // texture can be used as render target
+       // content gets lost on SDL_RENDER_TARGETS_RESET
+       SDL_Texture *createRenderTexture(int, int);
+
+       bool renderTargetSupported() const
+       {
+           return SDL_RenderTargetSupported(m_renderer);
+       }
+
+       SDL_Texture *getRenderTarget() const
+       {
+           return SDL_GetRenderTarget(m_renderer);
+       }
+
+       void setRenderTarget(SDL_Texture *texture)
+       {
+           if(SDL_SetRenderTarget(m_renderer, texture)){
+               throw fflerror("set render target failed: %s", SDL_GetError());
+           }
+       }
+
+       void setClipRect(const SDL_Rect *rect)
+       {
+           SDL_RenderSetClipRect(m_renderer, rect);
+       }
+
     public:
        TTF_Font *DefaultTTF(uint8_t);
 
@@ -260,6 +335,11 @@ class SDLDevice final
            return m_fpsMonitor.fps();
        }
 
+       double getFrameTime(double percent) const
+       {
+           return m_fpsMonitor.frameTime(percent);
+       }
+
     public:
        void setWindowResizable(bool resizable)
        {
@@ -0,0 +1,97 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: sessionrecord.cpp
+ *        Created: 10/20/2026 09:02:48
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <cstring>
+#include "fflerror.hpp"
+#include "sessionrecord.hpp"
+
+SessionRecorder::SessionRecorder(const char *fileName)
+{
+    if(!(fileName && std::strlen(fileName))){
+        throw fflerror("invalid session record file name");
+    }
+
+    if(!(m_file = std::fopen(fileName, "wb"))){
+        throw fflerror("failed to open session record file: %s", fileName);
+    }
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    if(m_file){
+        std::fclose(m_file);
+    }
+}
+
+void SessionRecorder::record(uint8_t headCode, const uint8_t *data, size_t dataLen)
+{
+    const auto tick = (uint32_t)(m_timer.diff_msec());
+    const auto size = (uint32_t)(data ? dataLen : 0);
+
+    std::fwrite(&tick,     sizeof(tick),     1, m_file);
+    std::fwrite(&headCode, sizeof(headCode), 1, m_file);
+    std::fwrite(&size,     sizeof(size),     1, m_file);
+
+    if(size){
+        std::fwrite(data, 1, size, m_file);
+    }
+}
+
+SessionReplayer::SessionReplayer(const char *fileName)
+{
+    if(!(fileName && std::strlen(fileName))){
+        throw fflerror("invalid session replay file name");
+    }
+
+    auto fp = std::fopen(fileName, "rb");
+    if(!fp){
+        throw fflerror("failed to open session replay file: %s", fileName);
+    }
+
+    while(true){
+        uint32_t tick     = 0;
+        uint8_t  headCode = 0;
+        uint32_t size     = 0;
+
+        if(std::fread(&tick, sizeof(tick), 1, fp) != 1){
+            break;
+        }
+
+        if(false
+                || std::fread(&headCode, sizeof(headCode), 1, fp) != 1
+                || std::fread(&size,     sizeof(size),     1, fp) != 1){
+            std::fclose(fp);
+            throw fflerror("truncated session record: %s", fileName);
+        }
+
+        if(!m_messageList.empty() && tick < m_messageList.back().tick){
+            std::fclose(fp);
+            throw fflerror("session record tick goes backward: %s", fileName);
+        }
+
+        const auto offset = m_dataBuf.size();
+        m_dataBuf.resize(offset + size);
+
+        if(size && std::fread(m_dataBuf.data() + offset, 1, size, fp) != size){
+            std::fclose(fp);
+            throw fflerror("truncated session record: %s", fileName);
+        }
+        m_messageList.push_back({tick, headCode, offset, size});
+    }
+    std::fclose(fp);
+}
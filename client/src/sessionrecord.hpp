@@ -0,0 +1,106 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: sessionrecord.hpp
+ *        Created: 10/20/2026 09:02:48
+ *    Description: record server messages received by Client::OnServerMessage() and
+ *                 replay them offline for the client rendering benchmark
+ *
+ *                 each record in the file is
+ *
+ *                     [uint32_t tick][uint8_t headCode][uint32_t dataLen][data]
+ *
+ *                 tick is msec since the recorder is created, integers are written
+ *                 in host byte order, records are only meant to replay on the same
+ *                 machine with the same client build
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+#include "raiitimer.hpp"
+
+class SessionRecorder final
+{
+    private:
+        std::FILE *m_file = nullptr;
+
+    private:
+        hres_timer m_timer;
+
+    public:
+        SessionRecorder(const char *);
+
+    public:
+        ~SessionRecorder();
+
+    public:
+        void record(uint8_t, const uint8_t *, size_t);
+};
+
+class SessionReplayer final
+{
+    private:
+        struct SessionMessage
+        {
+            uint32_t tick;
+            uint8_t  headCode;
+            size_t   offset;
+            size_t   dataLen;
+        };
+
+    private:
+        std::vector<uint8_t> m_dataBuf;
+        std::vector<SessionMessage> m_messageList;
+
+    private:
+        size_t m_currMessage = 0;
+
+    public:
+        SessionReplayer(const char *);
+
+    public:
+        uint32_t startTick() const
+        {
+            return m_messageList.empty() ? 0 : m_messageList.front().tick;
+        }
+
+        uint32_t endTick() const
+        {
+            return m_messageList.empty() ? 0 : m_messageList.back().tick;
+        }
+
+        size_t messageCount() const
+        {
+            return m_messageList.size();
+        }
+
+        bool done() const
+        {
+            return m_currMessage >= m_messageList.size();
+        }
+
+    public:
+        // dispatch all messages recorded no later than tick
+        // fnOnMessage(headCode, data, dataLen) follows Client::OnServerMessage()
+        template<typename F> size_t dispatch(double tick, F &&fnOnMessage)
+        {
+            size_t count = 0;
+            for(; !done() && m_messageList[m_currMessage].tick <= tick; ++m_currMessage, ++count){
+                const auto &msg = m_messageList[m_currMessage];
+                fnOnMessage(msg.headCode, msg.dataLen ? (m_dataBuf.data() + msg.offset) : nullptr, msg.dataLen);
+            }
+            return count;
+        }
+};
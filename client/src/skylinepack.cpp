@@ -0,0 +1,144 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: skylinepack.cpp
+ *        Created: 10/19/2026 23:02:17
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <limits>
+#include <algorithm>
+#include "fflerror.hpp"
+#include "skylinepack.hpp"
+
+SkylinePack::SkylinePack(int w, int h)
+    : m_w(w)
+    , m_h(h)
+    , m_usedArea(0)
+    , m_skyline()
+{
+    if(m_w <= 0 || m_h <= 0){
+        throw fflerror("invalid bin size: w = %d, h = %d", m_w, m_h);
+    }
+    reset();
+}
+
+void SkylinePack::reset()
+{
+    m_usedArea = 0;
+    m_skyline.clear();
+    m_skyline.push_back({0, 0, m_w});
+}
+
+int SkylinePack::fitNode(size_t index, int w, int h) const
+{
+    // returns the y to put a w x h rectangle with its left side at m_skyline[index].X
+    // returns -1 if it doesn't fit
+    const int x = m_skyline[index].X;
+    if(x + w > m_w){
+        return -1;
+    }
+
+    int y = 0;
+    int widthLeft = w;
+
+    for(size_t i = index; widthLeft > 0; ++i){
+        if(i >= m_skyline.size()){
+            return -1;
+        }
+
+        y = std::max<int>(y, m_skyline[i].Y);
+        if(y + h > m_h){
+            return -1;
+        }
+        widthLeft -= m_skyline[i].W;
+    }
+    return y;
+}
+
+void SkylinePack::addNode(size_t index, int x, int y, int w, int h)
+{
+    m_skyline.insert(m_skyline.begin() + index, SkylineNode{x, y + h, w});
+
+    // shrink or remove the nodes covered by the new one
+    for(size_t i = index + 1; i < m_skyline.size();){
+        const auto &prev = m_skyline[i - 1];
+        auto &curr = m_skyline[i];
+
+        if(curr.X >= prev.X + prev.W){
+            break;
+        }
+
+        const int shrink = prev.X + prev.W - curr.X;
+        curr.X += shrink;
+        curr.W -= shrink;
+
+        if(curr.W > 0){
+            break;
+        }
+        m_skyline.erase(m_skyline.begin() + i);
+    }
+
+    // merge neighbours at the same height
+    for(size_t i = 0; i + 1 < m_skyline.size();){
+        if(m_skyline[i].Y == m_skyline[i + 1].Y){
+            m_skyline[i].W += m_skyline[i + 1].W;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+        }
+        else{
+            ++i;
+        }
+    }
+}
+
+bool SkylinePack::add(int w, int h, int *px, int *py)
+{
+    if(w <= 0 || h <= 0){
+        throw fflerror("invalid rectangle size: w = %d, h = %d", w, h);
+    }
+
+    int bestX = -1;
+    int bestY = -1;
+
+    int bestTop   = std::numeric_limits<int>::max();
+    int bestWidth = std::numeric_limits<int>::max();
+
+    size_t bestIndex = 0;
+    for(size_t i = 0; i < m_skyline.size(); ++i){
+        if(const int y = fitNode(i, w, h); y >= 0){
+            if((y + h < bestTop) || (y + h == bestTop && m_skyline[i].W < bestWidth)){
+                bestX     = m_skyline[i].X;
+                bestY     = y;
+                bestTop   = y + h;
+                bestWidth = m_skyline[i].W;
+                bestIndex = i;
+            }
+        }
+    }
+
+    if(bestX < 0){
+        return false;
+    }
+
+    addNode(bestIndex, bestX, bestY, w, h);
+    m_usedArea += (size_t)(w) * (size_t)(h);
+
+    if(px){
+        *px = bestX;
+    }
+
+    if(py){
+        *py = bestY;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: skylinepack.hpp
+ *        Created: 10/19/2026 23:02:17
+ *    Description: skyline bottom-left rectangle packer for texture atlas
+ *
+ *                 keeps the top edge of the packed area as a list of horizontal segments
+ *                 each new rectangle is put on the segment which gives the lowest top edge
+ *                 ties are broken by the narrower segment to reduce wasted space
+ *
+ *                 doesn't support removing single rectangle, reset() to reuse the bin
+ *                 Pack2D is for the inventory grid, use this one for pixel atlas
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+
+class SkylinePack final
+{
+    private:
+        struct SkylineNode
+        {
+            int X;
+            int Y;
+            int W;
+        };
+
+    private:
+        const int m_w;
+        const int m_h;
+
+    private:
+        size_t m_usedArea;
+        std::vector<SkylineNode> m_skyline;
+
+    public:
+        SkylinePack(int, int);
+
+    public:
+        int W() const
+        {
+            return m_w;
+        }
+
+        int H() const
+        {
+            return m_h;
+        }
+
+    public:
+        double occupancy() const
+        {
+            return 1.0 * m_usedArea / ((size_t)(m_w) * (size_t)(m_h));
+        }
+
+    public:
+        void reset();
+
+    public:
+        // find room for a w x h rectangle
+        // returns false if the bin can't hold it, bin is unchanged in this case
+        bool add(int, int, int *, int *);
+
+    private:
+        int fitNode(size_t, int, int) const;
+        void addNode(size_t, int, int, int, int);
+};
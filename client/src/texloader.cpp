@@ -0,0 +1,170 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: texloader.cpp
+ *        Created: 10/19/2026 19:40:52
+ *    Description: 
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include <SDL2/SDL_image.h>
+#include "hexstr.hpp"
+#include "fflerror.hpp"
+#include "texloader.hpp"
+#include "raiitimer.hpp"
+
+TexLoader::TexLoader(ZSDB *zsdbPtr, size_t threadCount)
+    : m_zsdbPtr(zsdbPtr)
+{
+    if(!m_zsdbPtr){
+        throw fflerror("invalid argument: zsdbPtr = null");
+    }
+
+    if(!m_zsdbPtr->IsMMap()){
+        throw fflerror("async texture loading requires ZSDB in mmap mode");
+    }
+
+    for(size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i){
+        m_workerList.emplace_back([this]()
+        {
+            workerLoop();
+        });
+    }
+}
+
+TexLoader::~TexLoader()
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_stop = true;
+    }
+
+    m_condition.notify_all();
+    for(auto &worker: m_workerList){
+        worker.join();
+    }
+
+    for(auto &result: m_doneList){
+        if(result.Surface){
+            SDL_FreeSurface(result.Surface);
+        }
+    }
+}
+
+void TexLoader::request(uint32_t key, bool urgent)
+{
+    // prefetch request can be promoted to urgent
+    // the key may then be decoded twice, but it's rare and harmless
+    if(auto p = m_pendingList.find(key); p != m_pendingList.end()){
+        if(p->second || !urgent){
+            return;
+        }
+    }
+
+    m_pendingList[key] = urgent;
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        if(urgent){
+            m_urgentQ.push_back(key);
+        }else{
+            m_prefetchQ.push_back(key);
+            if(m_prefetchQ.size() > m_maxPrefetch){
+                if(auto p = m_pendingList.find(m_prefetchQ.front()); p != m_pendingList.end() && !p->second){
+                    m_pendingList.erase(p);
+                }
+                m_prefetchQ.pop_front();
+            }
+        }
+    }
+    m_condition.notify_one();
+}
+
+size_t TexLoader::upload(double budgetMS, const std::function<void(const LoadResult &)> &fnUpload)
+{
+    std::vector<LoadResult> doneList;
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        if(m_doneList.empty()){
+            return 0;
+        }
+        std::swap(doneList, m_doneList);
+    }
+
+    size_t uploaded = 0;
+    const hres_timer timer;
+
+    for(; uploaded < doneList.size(); ++uploaded){
+        // always upload at least one entry
+        // otherwise a tiny budget can starve the loader
+        if(uploaded > 0 && timer.diff_nsec() > budgetMS * 1000000.0){
+            break;
+        }
+
+        auto &result = doneList[uploaded];
+        if(fnUpload){
+            fnUpload(result);
+        }
+
+        if(result.Surface){
+            SDL_FreeSurface(result.Surface);
+            result.Surface = nullptr;
+        }
+        m_pendingList.erase(result.Key);
+    }
+
+    // put back entries over budget
+    // they get uploaded first in next frame
+    if(uploaded < doneList.size()){
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_doneList.insert(m_doneList.begin(), doneList.begin() + uploaded, doneList.end());
+    }
+    return uploaded;
+}
+
+void TexLoader::workerLoop()
+{
+    std::vector<uint8_t> dataBuf;
+    while(true){
+        uint32_t key = 0;
+        {
+            std::unique_lock<std::mutex> lockGuard(m_lock);
+            m_condition.wait(lockGuard, [this]() -> bool
+            {
+                return m_stop || !m_urgentQ.empty() || !m_prefetchQ.empty();
+            });
+
+            if(m_stop){
+                return;
+            }
+
+            auto &requestQ = m_urgentQ.empty() ? m_prefetchQ : m_urgentQ;
+            key = requestQ.front();
+            requestQ.pop_front();
+        }
+
+        char keyString[16];
+        LoadResult result {key, nullptr, nullptr};
+
+        // ZSDB in mmap mode is thread-safe
+        // SDL surface creation doesn't touch renderer, it's fine in worker thread
+        if((result.FileName = m_zsdbPtr->Decomp(hexstr::to_string<uint32_t, 4>(key, keyString, true), 8, &dataBuf)) && !dataBuf.empty()){
+            if(auto rwOpsPtr = SDL_RWFromConstMem(dataBuf.data(), dataBuf.size())){
+                result.Surface = IMG_LoadPNG_RW(rwOpsPtr);
+                SDL_FreeRW(rwOpsPtr);
+            }
+        }
+
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_doneList.push_back(result);
+    }
+}
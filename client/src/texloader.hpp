@@ -0,0 +1,99 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: texloader.hpp
+ *        Created: 10/19/2026 19:21:07
+ *    Description: background decode stage for PNGTexDB and PNGTexOffDB
+ *
+ *                 worker threads decompress entries from ZSDB and decode PNG into SDL_Surface
+ *                 SDL_Texture creation can only be done in the render thread, so main thread
+ *                 collects decoded surfaces by upload() with a time budget per frame
+ *
+ *                 request() and upload() are main-thread only
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include <SDL2/SDL.h>
+#include "zsdb.hpp"
+
+class TexLoader final
+{
+    public:
+        struct LoadResult
+        {
+            uint32_t     Key;
+            const char  *FileName;  // full entry name in ZSDB, nullptr if not found
+            SDL_Surface *Surface;   // nullptr if not found or decode failed
+        };
+
+    private:
+        // drop the oldest prefetch request if prefetch queue grows longer than this
+        // urgent requests are never dropped
+        constexpr static size_t m_maxPrefetch = 4096;
+
+    private:
+        ZSDB *m_zsdbPtr;
+
+    private:
+        bool m_stop = false;
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+
+    private:
+        std::deque<uint32_t>    m_urgentQ;
+        std::deque<uint32_t>    m_prefetchQ;
+        std::vector<LoadResult> m_doneList;
+
+    private:
+        // requested but not uploaded yet, value is true for urgent request
+        // only accessed by main thread, no lock
+        std::unordered_map<uint32_t, bool> m_pendingList;
+
+    private:
+        std::vector<std::thread> m_workerList;
+
+    public:
+        TexLoader(ZSDB *, size_t);
+
+    public:
+        ~TexLoader();
+
+    public:
+        void request(uint32_t, bool);
+
+    public:
+        bool pending(uint32_t key) const
+        {
+            return m_pendingList.find(key) != m_pendingList.end();
+        }
+
+    public:
+        // call the callback for decoded surfaces until budget in milliseconds is used
+        // surface is freed after callback, callback should not keep it
+        // a prefetched key promoted to urgent can be decoded twice, callback should ignore the duplicate
+        // return number of uploaded entries
+        size_t upload(double, const std::function<void(const LoadResult &)> &);
+
+    private:
+        void workerLoop();
+};
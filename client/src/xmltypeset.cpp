@@ -16,7 +16,9 @@
  * =====================================================================================
  */
 
+#include <vector>
 #include <cinttypes>
+#include <algorithm>
 #include "log.hpp"
 #include "lalign.hpp"
 #include "toll.hpp"
@@ -556,18 +558,13 @@ TOKEN XMLTypeset::buildUTF8Token(int leaf, uint8_t nFont, uint8_t nFontSize, uin
     auto nU64Key = utf8f::buildU64Key(nFont, nFontSize, nFontStyle, nUTF8Code);
 
     stToken.Leaf = leaf;
-    if(auto pTexture = g_fontexDB->Retrieve(nU64Key)){
-        int nBoxW = -1;
-        int nBoxH = -1;
-        if(!SDL_QueryTexture(pTexture, nullptr, nullptr, &nBoxW, &nBoxH)){
-            stToken.Box.Info.W      = nBoxW;
-            stToken.Box.Info.H      = nBoxH;
-            stToken.Box.State.H1    = stToken.Box.Info.H;
-            stToken.Box.State.H2    = 0;
-            stToken.UTF8Char.U64Key = nU64Key;
-            return stToken;
-        }
-        throw fflerror("SDL_QueryTexture(%p) failed", pTexture);
+    if(auto stEntry = g_fontexDB->Retrieve(nU64Key)){
+        stToken.Box.Info.W      = stEntry->W;
+        stToken.Box.Info.H      = stEntry->H;
+        stToken.Box.State.H1    = stToken.Box.Info.H;
+        stToken.Box.State.H2    = 0;
+        stToken.UTF8Char.U64Key = nU64Key;
+        return stToken;
     }
 
     nU64Key = utf8f::buildU64Key(m_font, m_fontSize, 0, nUTF8Code);
@@ -584,19 +581,14 @@ TOKEN XMLTypeset::buildUTF8Token(int leaf, uint8_t nFont, uint8_t nFontSize, uin
     // use system default font, don't fail it
 
     nU64Key = utf8f::buildU64Key(m_font, m_fontSize, nFontStyle, nUTF8Code);
-    if(auto pTexture = g_fontexDB->Retrieve(nU64Key)){
-        int nBoxW = -1;
-        int nBoxH = -1;
-        if(!SDL_QueryTexture(pTexture, nullptr, nullptr, &nBoxW, &nBoxH)){
-            g_log->addLog(LOGTYPE_WARNING, "Fallback to default font: font: %d -> %d, fontsize: %d -> %d", (int)(nFont), (int)(m_font), (int)(nFontSize), (int)(m_fontSize));
-            stToken.Box.Info.W      = nBoxW;
-            stToken.Box.Info.H      = nBoxH;
-            stToken.Box.State.H1    = stToken.Box.Info.H;
-            stToken.Box.State.H2    = 0;
-            stToken.UTF8Char.U64Key = nU64Key;
-            return stToken;
-        }
-        throw fflerror("SDL_QueryTexture(%p) failed", pTexture);
+    if(auto stEntry = g_fontexDB->Retrieve(nU64Key)){
+        g_log->addLog(LOGTYPE_WARNING, "Fallback to default font: font: %d -> %d, fontsize: %d -> %d", (int)(nFont), (int)(m_font), (int)(nFontSize), (int)(m_fontSize));
+        stToken.Box.Info.W      = stEntry->W;
+        stToken.Box.Info.H      = stEntry->H;
+        stToken.Box.State.H1    = stToken.Box.Info.H;
+        stToken.Box.State.H2    = 0;
+        stToken.UTF8Char.U64Key = nU64Key;
+        return stToken;
     }
     throw fflerror("fallback to default font failed: font: %d -> %d, fontsize: %d -> %d", (int)(nFont), (int)(m_font), (int)(nFontSize), (int)(m_fontSize));
 }
@@ -949,6 +941,117 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
     uint32_t fgColor = 0;
     uint32_t bgColor = 0;
 
+    // consecutive glyphs are collected and drawn as one batch
+    // batch gets flushed before any other drawing, so z-order is the same as drawing token by token
+    struct GlyphDraw
+    {
+        uint64_t U64Key;
+        SDL_Rect Dst;
+
+        int DX;
+        int DY;
+
+        uint32_t FGColor;
+        uint32_t BGColor;
+    };
+
+    struct GlyphQuad
+    {
+        const GlyphDraw *Glyph;
+        SDL_Texture *Texture;
+        SDLDevice::TextureQuad Quad;
+    };
+
+    std::vector<GlyphDraw> glyphDrawList;
+    std::vector<GlyphQuad> glyphQuadList;
+    std::vector<SDLDevice::TextureQuad> quadRun;
+
+    const auto fnFlushGlyph = [&glyphDrawList, &glyphQuadList, &quadRun]()
+    {
+        if(glyphDrawList.empty()){
+            return;
+        }
+
+        const auto fnResolve = [](const GlyphDraw &glyph) -> GlyphQuad
+        {
+            if(const auto entry = g_fontexDB->Retrieve(glyph.U64Key)){
+                return GlyphQuad
+                {
+                    &glyph,
+                    entry->Texture,
+                    SDLDevice::TextureQuad
+                    {
+                        {entry->X + glyph.DX, entry->Y + glyph.DY, glyph.Dst.w, glyph.Dst.h},
+                        glyph.Dst,
+                        glyph.FGColor,
+                    },
+                };
+            }
+            return GlyphQuad{&glyph, nullptr, {}};
+        };
+
+        // draw in token order, glyphs in a row sharing one atlas page go in one call
+        SDL_Texture *runTexPtr = nullptr;
+        const auto fnDrawRun = [&quadRun, &runTexPtr]()
+        {
+            if(!quadRun.empty()){
+                g_SDLDevice->drawTextureQuad(runTexPtr, quadRun.data(), quadRun.size());
+                quadRun.clear();
+            }
+            runTexPtr = nullptr;
+        };
+
+        const auto fnDrawQuad = [&quadRun, &runTexPtr, &fnDrawRun](const GlyphQuad &glyphQuad)
+        {
+            if(glyphQuad.Texture){
+                if(glyphQuad.Texture != runTexPtr){
+                    fnDrawRun();
+                    runTexPtr = glyphQuad.Texture;
+                }
+                quadRun.push_back(glyphQuad.Quad);
+            }
+            else{
+                fnDrawRun();
+                g_SDLDevice->DrawRectangle(colorf::CompColor(glyphQuad.Glyph->BGColor), glyphQuad.Glyph->Dst.x, glyphQuad.Glyph->Dst.y, glyphQuad.Glyph->Dst.w, glyphQuad.Glyph->Dst.h);
+            }
+
+            if(g_clientArgParser->drawTokenFrame){
+                fnDrawRun();
+                g_SDLDevice->DrawRectangle(colorf::PURPLE + 255, glyphQuad.Glyph->Dst.x, glyphQuad.Glyph->Dst.y, glyphQuad.Glyph->Dst.w, glyphQuad.Glyph->Dst.h);
+            }
+        };
+
+        // resolve atlas rects of the whole batch before drawing
+        // loading a new glyph can flush an atlas page and invalidate rects got before, redo till no flush happens
+        // the second pass only flushes again if the batch doesn't fit in the atlas, stop retrying then
+        bool resolved = false;
+        for(int retry = 0; !resolved && retry < 2; ++retry){
+            glyphQuadList.clear();
+            const auto flushCount = g_fontexDB->AtlasFlushCount();
+
+            for(const auto &glyph: glyphDrawList){
+                glyphQuadList.push_back(fnResolve(glyph));
+            }
+            resolved = (flushCount == g_fontexDB->AtlasFlushCount());
+        }
+
+        if(resolved){
+            for(const auto &glyphQuad: glyphQuadList){
+                fnDrawQuad(glyphQuad);
+            }
+        }
+        else{
+            // split the batch at every glyph, the rect is used before next retrieve can flush it
+            for(const auto &glyph: glyphDrawList){
+                fnDrawQuad(fnResolve(glyph));
+                fnDrawRun();
+            }
+        }
+
+        fnDrawRun();
+        glyphDrawList.clear();
+    };
+
     int lastLeaf = -1;
     for(int line = 0; line < lineCount(); ++line){
         for(int token = 0; token < lineTokenCount(line); ++token){
@@ -971,6 +1074,7 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
                 int bgBoxH = tokenPtr->Box.Info.H;
 
                 if(mathf::rectangleOverlapRegion(srcX, srcY, srcW, srcH, &bgBoxX, &bgBoxY, &bgBoxW, &bgBoxH)){
+                    fnFlushGlyph();
                     g_SDLDevice->fillRectangle(bgColor, bgBoxX + dstDX, bgBoxY + dstDY, bgBoxW, bgBoxH);
                 }
             }
@@ -993,17 +1097,15 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
             switch(leaf.Type()){
                 case LEAF_UTF8GROUP:
                     {
-                        if(auto texPtr = g_fontexDB->Retrieve(tokenPtr->UTF8Char.U64Key)){
-                            SDL_SetTextureColorMod(texPtr, colorf::R(fgColor), colorf::G(fgColor), colorf::B(fgColor));
-                            g_SDLDevice->DrawTexture(texPtr, drawDstX, drawDstY, dx, dy, boxW, boxH);
-                        }
-                        else{
-                            g_SDLDevice->DrawRectangle(colorf::CompColor(bgColor), drawDstX, drawDstY, boxW, boxH);
-                        }
-
-                        if(g_clientArgParser->drawTokenFrame){
-                            g_SDLDevice->DrawRectangle(colorf::PURPLE + 255, drawDstX, drawDstY, boxW, boxH);
-                        }
+                        glyphDrawList.push_back(GlyphDraw
+                        {
+                            tokenPtr->UTF8Char.U64Key,
+                            {drawDstX, drawDstY, boxW, boxH},
+                            dx,
+                            dy,
+                            fgColor,
+                            bgColor,
+                        });
                         break;
                     }
                 case LEAF_IMAGE:
@@ -1023,6 +1125,7 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
                         int xOnTex = 0;
                         int yOnTex = 0;
 
+                        fnFlushGlyph();
                         if(auto texPtr = g_emoticonDB->Retrieve(emojiKey, &xOnTex, &yOnTex, 0, 0, 0, 0, 0)){
                             g_SDLDevice->DrawTexture(texPtr, drawDstX, drawDstY, xOnTex + dx, yOnTex + dy, boxW, boxH);
                         }
@@ -1036,6 +1139,7 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
         }
     }
 
+    fnFlushGlyph();
     if(g_clientArgParser->drawBoardFrame){
         g_SDLDevice->DrawRectangle(colorf::YELLOW + 255, dstX, dstY, srcW, srcH);
     }
@@ -0,0 +1,77 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: actortrace.hpp
+ *        Created: 10/20/2026 06:18:05
+ *    Description: binary format of actor message trace
+ *
+ *                 written by monoserver with "--record-actor-message", read by
+ *                 tools/actortrace, layout of the dump file:
+ *
+ *                     [ActorTraceHeader]
+ *                     [type name] ... [type name]       // NameCount zero-terminated strings
+ *                     [ActorTraceRecord] ... [record]   // RecordCount records sorted by Time
+ *
+ *                 name of message type t is the t-th string
+ *                 all integers are in host byte order
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+enum ActorTraceEventType: uint16_t
+{
+    ATE_NONE   = 0,
+    ATE_POST   = 1, // message posted into a mailbox
+    ATE_HANDLE = 2, // message handled by an actor
+};
+
+#pragma pack(push, 1)
+struct ActorTraceHeader
+{
+    char     Magic[8];      // ACTORTRC
+    uint32_t Version;
+    uint32_t RecordSize;    // sizeof(ActorTraceRecord)
+    uint32_t NameCount;
+    uint32_t ThreadCount;   // actor threads, application threads use thread id -1
+    uint64_t RecordCount;
+    uint64_t DropCount;     // records overwritten in ring buffers before dump
+};
+
+struct ActorTraceRecord
+{
+    uint64_t Time;          // nanoseconds since recorder started, start time for ATE_HANDLE
+    uint64_t Duration;      // handling time in nanoseconds, 0 for ATE_POST
+
+    uint64_t From;
+    uint64_t To;
+
+    // ATE_HANDLE: unique sequence of this handling
+    // ATE_POST  : sequence of the handling which posts this message, 0 if posted outside any handler
+    uint64_t Seq;
+
+    uint32_t Type;
+    uint32_t Size;
+
+    uint16_t Event;
+    int16_t  Thread;
+    uint32_t Reserved;
+};
+#pragma pack(pop)
+
+static_assert(std::is_trivially_copyable_v<ActorTraceHeader>);
+static_assert(std::is_trivially_copyable_v<ActorTraceRecord>);
+
+constexpr uint32_t ACTORTRACE_VERSION = 1;
+constexpr char     ACTORTRACE_MAGIC[] = "ACTORTRC";
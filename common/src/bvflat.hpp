@@ -0,0 +1,585 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: bvflat.hpp
+ *        Created: 10/20/2026 07:41:15
+ *    Description: compiled behavior tree, same node semantics as bvtree.hpp
+ *
+ *                 bvflat::tree<T> is the node definition, a flat array built once and
+ *                 shared by all instances of the same agent type, leaves are member
+ *                 function pointers of T, no std::function, no shared_ptr
+ *
+ *                 bvflat::state is the per-instance blackboard, one uint64_t slot for
+ *                 each stateful node and each variable, allocated once when created
+ *
+ *                 tree::update() walks the array recursively and never allocates
+ *
+ *                 stage leaves start an async operation and return, the callback of the
+ *                 operation reports the result by bvflat::stage, a stage captured before
+ *                 the last reset() is ignored, same as bvtree::lambda_stage() but without
+ *                 keeping the result alive by shared_ptr
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include "bvtree.hpp"
+#include "fflerror.hpp"
+
+namespace bvflat
+{
+    template<typename T> class tree;
+
+    class state final
+    {
+        private:
+            template<typename T> friend class tree;
+            friend class stage;
+
+        private:
+            std::vector<uint64_t> m_slotList;
+
+        public:
+            state() = default;
+
+        public:
+            template<typename T> explicit state(const tree<T> &t)
+                : m_slotList(t.slotCount(), 0)
+            {
+                t.reset(*this);
+            }
+
+        public:
+            bool empty() const
+            {
+                return m_slotList.empty();
+            }
+
+            size_t size() const
+            {
+                return m_slotList.size();
+            }
+
+        public:
+            uint64_t get(uint32_t slot) const
+            {
+                return m_slotList.at(slot);
+            }
+
+            void set(uint32_t slot, uint64_t val)
+            {
+                m_slotList.at(slot) = val;
+            }
+    };
+
+    // handle to report result of a stage leaf
+    // 16 bytes, fits in the small buffer of std::function when captured alone
+    // carries the leaf argument, callbacks need no other capture
+    class stage final
+    {
+        private:
+            state *m_state;
+
+        private:
+            uint16_t m_slot;
+            uint16_t m_arg;
+            uint32_t m_gen;
+
+        public:
+            stage(state *s, uint16_t slot, uint16_t arg, uint32_t gen)
+                : m_state(s)
+                , m_slot(slot)
+                , m_arg(arg)
+                , m_gen(gen)
+            {}
+
+        public:
+            uint32_t arg() const
+            {
+                return m_arg;
+            }
+
+        public:
+            // stage slot layout: [gen: 32][unused: 24][result: 8]
+            // result 0 means not started
+            static uint64_t encode(uint32_t gen, int result)
+            {
+                return ((uint64_t)(gen) << 32) | (uint64_t)(result);
+            }
+
+        public:
+            bool expired() const
+            {
+                return (uint32_t)(m_state->m_slotList[m_slot] >> 32) != m_gen;
+            }
+
+        public:
+            void done(bvres_t result)
+            {
+                if(!expired()){
+                    m_state->m_slotList[m_slot] = encode(m_gen, (int)(result) + 1);
+                }
+            }
+
+        public:
+            uint64_t get(uint32_t slot) const
+            {
+                return m_state->get(slot);
+            }
+
+            // write variable only if this stage is still alive
+            // otherwise a late callback overwrites the variable of the next round
+            void set(uint32_t slot, uint64_t val)
+            {
+                if(!expired()){
+                    m_state->set(slot, val);
+                }
+            }
+    };
+
+    template<typename T> class tree final
+    {
+        public:
+            using action_t = bvres_t (T::*)(state &, uint32_t);
+            using check_t  = bool    (T::*)(state &, uint32_t);
+            using stage_t  = void    (T::*)(stage,   uint32_t);
+
+        private:
+            enum node_type_t: uint8_t
+            {
+                NODE_NONE,
+                NODE_ACTION,
+                NODE_CHECK,
+                NODE_STAGE,
+                NODE_ABORT,
+                NODE_DELAY,
+                NODE_RANDOM,
+                NODE_SELECTOR,
+                NODE_SEQUENCE,
+                NODE_IF_BRANCH,
+            };
+
+            struct node_t
+            {
+                node_type_t type  = NODE_NONE;
+                uint8_t     count = 0;          // child count
+                uint32_t    first = 0;          // first child in m_childList
+                uint32_t    slot  = 0;          // state slot, for stateful nodes
+                uint32_t    arg   = 0;          // leaf argument, usually a variable slot, or delay in ms
+
+                action_t action = nullptr;
+                check_t  check  = nullptr;
+                stage_t  start  = nullptr;
+            };
+
+        private:
+            std::vector<node_t>   m_nodeList;
+            std::vector<uint32_t> m_childList;
+
+        private:
+            uint32_t m_slotCount = 0;
+            uint32_t m_root      = 0;
+            bool     m_hasRoot   = false;
+
+        private:
+            // stage slots get a new generation in reset() instead of zero
+            std::vector<uint32_t> m_stageSlotList;
+
+        public:
+            tree() = default;
+
+        public:
+            uint32_t slotCount() const
+            {
+                return m_slotCount;
+            }
+
+            size_t nodeCount() const
+            {
+                return m_nodeList.size();
+            }
+
+        public:
+            // variable shared by leaves, like bvarg_ref
+            // returns the slot index passed to leaves as argument
+            uint32_t var()
+            {
+                return allocSlot();
+            }
+
+        public:
+            uint32_t action(action_t f, uint32_t arg = 0)
+            {
+                node_t node;
+                node.type   = NODE_ACTION;
+                node.action = f;
+                node.arg    = arg;
+                return addNode(node, {});
+            }
+
+            uint32_t check(check_t f, uint32_t arg = 0)
+            {
+                node_t node;
+                node.type  = NODE_CHECK;
+                node.check = f;
+                node.arg   = arg;
+                return addNode(node, {});
+            }
+
+            uint32_t lambda_stage(stage_t f, uint32_t arg = 0)
+            {
+                if(arg > 0XFFFF){
+                    throw fflerror("stage argument exceeds 16 bits: %u", arg);
+                }
+
+                node_t node;
+                node.type  = NODE_STAGE;
+                node.start = f;
+                node.arg   = arg;
+                node.slot  = allocSlot();
+
+                m_stageSlotList.push_back(node.slot);
+                return addNode(node, {});
+            }
+
+        public:
+            uint32_t op_abort()
+            {
+                node_t node;
+                node.type = NODE_ABORT;
+                return addNode(node, {});
+            }
+
+            uint32_t op_delay(uint32_t ms)
+            {
+                node_t node;
+                node.type = NODE_DELAY;
+                node.arg  = ms;
+                node.slot = allocSlot();
+                return addNode(node, {});
+            }
+
+            uint32_t op_delay(uint32_t ms, uint32_t operation)
+            {
+                node_t node;
+                node.type = NODE_DELAY;
+                node.arg  = ms;
+                node.slot = allocSlot();
+                return addNode(node, {operation});
+            }
+
+        public:
+            uint32_t random(std::initializer_list<uint32_t> children)
+            {
+                return addComposite(NODE_RANDOM, children);
+            }
+
+            uint32_t selector(std::initializer_list<uint32_t> children)
+            {
+                return addComposite(NODE_SELECTOR, children);
+            }
+
+            uint32_t sequence(std::initializer_list<uint32_t> children)
+            {
+                return addComposite(NODE_SEQUENCE, children);
+            }
+
+            uint32_t if_branch(uint32_t check, uint32_t on_true, uint32_t on_false)
+            {
+                return addComposite(NODE_IF_BRANCH, {check, on_true, on_false});
+            }
+
+        public:
+            void root(uint32_t node)
+            {
+                if(node >= m_nodeList.size()){
+                    throw fflerror("invalid root node: %u", node);
+                }
+
+                m_root    = node;
+                m_hasRoot = true;
+            }
+
+        public:
+            void reset(state &s) const
+            {
+                checkState(s);
+                for(const auto &node: m_nodeList){
+                    if(node.type != NODE_STAGE && nodeHasSlot(node)){
+                        s.m_slotList[node.slot] = 0;
+                    }
+                }
+
+                for(const auto slot: m_stageSlotList){
+                    s.m_slotList[slot] = stage::encode((uint32_t)(s.m_slotList[slot] >> 32) + 1, 0);
+                }
+            }
+
+        public:
+            // now is in ms, only used by op_delay
+            // pass the same clock for every update of one instance
+            bvres_t update(T &agent, state &s, uint64_t now) const
+            {
+                if(!m_hasRoot){
+                    throw fflerror("behavior tree has no root");
+                }
+
+                checkState(s);
+                return run(m_root, agent, s, now);
+            }
+
+        private:
+            void checkState(const state &s) const
+            {
+                if(s.m_slotList.size() != m_slotCount){
+                    throw fflerror("state doesn't match tree: state has %zu slots, tree needs %u", s.m_slotList.size(), m_slotCount);
+                }
+            }
+
+            static bool nodeHasSlot(const node_t &node)
+            {
+                switch(node.type){
+                    case NODE_STAGE:
+                    case NODE_DELAY:
+                    case NODE_RANDOM:
+                    case NODE_SELECTOR:
+                    case NODE_SEQUENCE:
+                    case NODE_IF_BRANCH:
+                        {
+                            return true;
+                        }
+                    default:
+                        {
+                            return false;
+                        }
+                }
+            }
+
+        private:
+            uint32_t allocSlot()
+            {
+                // stage keeps slot in 16 bits
+                if(m_slotCount >= 0XFFFF){
+                    throw fflerror("too many slots: %u", m_slotCount);
+                }
+                return m_slotCount++;
+            }
+
+        private:
+            uint32_t addNode(node_t node, std::initializer_list<uint32_t> children)
+            {
+                if(children.size() > 255){
+                    throw fflerror("too many children: %zu", children.size());
+                }
+
+                for(const auto child: children){
+                    if(child >= m_nodeList.size()){
+                        throw fflerror("invalid child node: %u", child);
+                    }
+                }
+
+                node.count = (uint8_t)(children.size());
+                node.first = (uint32_t)(m_childList.size());
+                m_childList.insert(m_childList.end(), children.begin(), children.end());
+
+                m_nodeList.push_back(node);
+                return (uint32_t)(m_nodeList.size() - 1);
+            }
+
+            uint32_t addComposite(node_type_t type, std::initializer_list<uint32_t> children)
+            {
+                if(children.size() == 0){
+                    throw fflerror("no valid node");
+                }
+
+                node_t node;
+                node.type = type;
+                node.slot = allocSlot();
+                return addNode(node, children);
+            }
+
+        private:
+            uint32_t child(const node_t &node, uint32_t index) const
+            {
+                return m_childList[node.first + index];
+            }
+
+            static bvres_t checkStatus(bvres_t status)
+            {
+                switch(status){
+                    case BV_ABORT:
+                    case BV_FAILURE:
+                    case BV_PENDING:
+                    case BV_SUCCESS:
+                        {
+                            return status;
+                        }
+                    default:
+                        {
+                            throw fflerror("invalid node status: %d", (int)(status));
+                        }
+                }
+            }
+
+        private:
+            bvres_t run(uint32_t index, T &agent, state &s, uint64_t now) const
+            {
+                const auto &node = m_nodeList[index];
+                switch(node.type){
+                    case NODE_ACTION:
+                        {
+                            return checkStatus((agent.*(node.action))(s, node.arg));
+                        }
+                    case NODE_CHECK:
+                        {
+                            return (agent.*(node.check))(s, node.arg) ? BV_SUCCESS : BV_FAILURE;
+                        }
+                    case NODE_STAGE:
+                        {
+                            auto &slotVal = s.m_slotList[node.slot];
+                            const auto gen = (uint32_t)(slotVal >> 32);
+                            if((slotVal & 0XFF) == 0){
+                                slotVal = stage::encode(gen, (int)(BV_PENDING) + 1);
+                                (agent.*(node.start))(stage(&s, (uint16_t)(node.slot), (uint16_t)(node.arg), gen), node.arg);
+                            }
+                            return checkStatus((bvres_t)((int)(s.m_slotList[node.slot] & 0XFF) - 1));
+                        }
+                    case NODE_ABORT:
+                        {
+                            return BV_ABORT;
+                        }
+                    case NODE_DELAY:
+                        {
+                            auto &slotVal = s.m_slotList[node.slot];
+                            // slot keeps (start + 1), zero means not running
+                            if(!slotVal){
+                                slotVal = now + 1;
+                            }
+
+                            if(now - (slotVal - 1) <= node.arg){
+                                return BV_PENDING;
+                            }
+                            return node.count ? checkStatus(run(child(node, 0), agent, s, now)) : BV_SUCCESS;
+                        }
+                    case NODE_RANDOM:
+                        {
+                            auto &slotVal = s.m_slotList[node.slot];
+                            // slot keeps (picked + 1)
+                            if(!slotVal){
+                                slotVal = (uint64_t)(std::rand() % node.count) + 1;
+                            }
+                            return checkStatus(run(child(node, (uint32_t)(slotVal - 1)), agent, s, now));
+                        }
+                    case NODE_SELECTOR:
+                        {
+                            auto &slotVal = s.m_slotList[node.slot];
+                            while(slotVal < node.count){
+                                switch(auto status = run(child(node, (uint32_t)(slotVal)), agent, s, now)){
+                                    case BV_ABORT:
+                                    case BV_SUCCESS:
+                                    case BV_PENDING:
+                                        {
+                                            return BV_PENDING;
+                                        }
+                                    case BV_FAILURE:
+                                        {
+                                            slotVal++;
+                                            break;
+                                        }
+                                    default:
+                                        {
+                                            throw fflerror("invalid node status: %d", (int)(status));
+                                        }
+                                }
+                            }
+                            return BV_FAILURE;
+                        }
+                    case NODE_SEQUENCE:
+                        {
+                            auto &slotVal = s.m_slotList[node.slot];
+                            while(slotVal < node.count){
+                                switch(auto status = run(child(node, (uint32_t)(slotVal)), agent, s, now)){
+                                    case BV_ABORT:
+                                    case BV_FAILURE:
+                                    case BV_PENDING:
+                                        {
+                                            return status;
+                                        }
+                                    case BV_SUCCESS:
+                                        {
+                                            slotVal++;
+                                            break;
+                                        }
+                                    default:
+                                        {
+                                            throw fflerror("invalid node status: %d", (int)(status));
+                                        }
+                                }
+                            }
+                            return BV_SUCCESS;
+                        }
+                    case NODE_IF_BRANCH:
+                        {
+                            auto &slotVal = s.m_slotList[node.slot];
+                            // slot: 0 in check, 1 in on_true, 2 in on_false
+                            if(slotVal == 0){
+                                switch(auto status = run(child(node, 0), agent, s, now)){
+                                    case BV_SUCCESS:
+                                        {
+                                            slotVal = 1;
+                                            break;
+                                        }
+                                    case BV_FAILURE:
+                                        {
+                                            slotVal = 2;
+                                            break;
+                                        }
+                                    case BV_ABORT:
+                                    case BV_PENDING:
+                                        {
+                                            return status;
+                                        }
+                                    default:
+                                        {
+                                            throw fflerror("invalid node status: %d", (int)(status));
+                                        }
+                                }
+                            }
+
+                            switch(auto status = run(child(node, (uint32_t)(slotVal)), agent, s, now)){
+                                case BV_ABORT:
+                                case BV_PENDING:
+                                    {
+                                        return status;
+                                    }
+                                case BV_SUCCESS:
+                                case BV_FAILURE:
+                                    {
+                                        return BV_SUCCESS;
+                                    }
+                                default:
+                                    {
+                                        throw fflerror("invalid node status: %d", (int)(status));
+                                    }
+                            }
+                        }
+                    default:
+                        {
+                            throw fflerror("invalid node type: %d", (int)(node.type));
+                        }
+                }
+            }
+    };
+}
@@ -17,7 +17,13 @@
  */
 
 #pragma once
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
 #include <optional>
+#include <unordered_map>
 #ifdef _MSC_VER
 #include <windows.h>
 #else
@@ -57,6 +63,24 @@ inline void coro_init_thread()
     }
 }
 
+// the coroutine running on current thread, empty in main context
+// type erased so coro_variable can wake its waiter up without knowing coro<T>
+struct coro_waker
+{
+    void *co = nullptr;
+    void (*resume)(void *) = nullptr;
+
+    // true if other coroutines can run on the same stack
+    // then anything on our stack gets copied out while we are suspended, don't give its address to others
+    bool shared_stack = false;
+};
+
+inline coro_waker &coro_get_running_ref()
+{
+    thread_local coro_waker t_running;
+    return t_running;
+}
+
 inline void coro_yield()
 {
 #ifdef _MSC_VER
@@ -68,27 +92,57 @@ inline void coro_yield()
 
 class coro_stack
 {
-#ifndef _MSC_VER
     private:
         template<typename T> friend class coro;
 
+    private:
+        const size_t m_size;
+
+#ifndef _MSC_VER
     private:
         aco_share_stack_t *m_stack = nullptr;
 
+    private:
+        // count of coroutines created on this stack and not destroyed yet
+        std::atomic<size_t> m_users {0};
+#endif
+
     public:
-        coro_stack()
+        // stackSize = 0 means libaco default, 2MB
+        // libaco rounds it up to page size and adds a guard page, overflow crashes instead of corrupts
+        // fibers always own their stacks, nothing to allocate on windows
+        explicit coro_stack(size_t stackSize = 0)
+            : m_size(stackSize)
         {
-            m_stack = aco_share_stack_new(0);
+#ifndef _MSC_VER
+            m_stack = aco_share_stack_new(stackSize);
             if(!m_stack){
                 throw fflerror("Failed to allocate aco shared stack");
             }
+#endif
         }
 
         ~coro_stack()
         {
+#ifndef _MSC_VER
             aco_share_stack_destroy(m_stack);
+#endif
+        }
+
+    public:
+        size_t size() const
+        {
+            return m_size;
         }
+
+        bool shared() const
+        {
+#ifdef _MSC_VER
+            return false;
+#else
+            return m_users.load(std::memory_order_relaxed) > 1;
 #endif
+        }
 };
 
 inline coro_stack *coro_get_tls_stack()
@@ -97,6 +151,83 @@ inline coro_stack *coro_get_tls_stack()
     return &t_stack;
 }
 
+// counters of coroutine switches, shared by all threads
+// if a coroutine doesn't own its stack, libaco saves the current owner's stack and restores ours on resume
+// bytes counts both directions, with dedicated stacks it should stay zero
+struct coro_switch_stat
+{
+    std::atomic<uint64_t> resume {0};
+    std::atomic<uint64_t> copy   {0};
+    std::atomic<uint64_t> bytes  {0};
+
+    void reset()
+    {
+        resume.store(0, std::memory_order_relaxed);
+        copy  .store(0, std::memory_order_relaxed);
+        bytes .store(0, std::memory_order_relaxed);
+    }
+};
+
+inline coro_switch_stat &coro_get_switch_stat()
+{
+    static coro_switch_stat s_stat;
+    return s_stat;
+}
+
+// dedicated stacks are mmap-ed with a guard page, too expensive to create for every spawned monster
+// recycle them by size, a stack only goes back to pool after the coroutine using it is destroyed
+class coro_stack_pool final
+{
+    private:
+        std::mutex m_lock;
+        std::unordered_map<size_t, std::vector<std::unique_ptr<coro_stack>>> m_freeList;
+
+    private:
+        coro_stack_pool() = default;
+
+    public:
+        static coro_stack_pool &get()
+        {
+            // never destroyed, coroutines can die during static destruction
+            static auto *s_pool = new coro_stack_pool();
+            return *s_pool;
+        }
+
+    public:
+        std::shared_ptr<coro_stack> alloc(size_t stackSize)
+        {
+            std::unique_ptr<coro_stack> stackPtr;
+            {
+                std::lock_guard<std::mutex> lockGuard(m_lock);
+                if(auto p = m_freeList.find(stackSize); p != m_freeList.end() && !p->second.empty()){
+                    stackPtr = std::move(p->second.back());
+                    p->second.pop_back();
+                }
+            }
+
+            if(!stackPtr){
+                stackPtr = std::make_unique<coro_stack>(stackSize);
+            }
+
+            return std::shared_ptr<coro_stack>(stackPtr.release(), [this, stackSize](coro_stack *stack)
+            {
+                std::lock_guard<std::mutex> lockGuard(m_lock);
+                m_freeList[stackSize].emplace_back(stack);
+            });
+        }
+
+        size_t idleCount()
+        {
+            size_t count = 0;
+            std::lock_guard<std::mutex> lockGuard(m_lock);
+
+            for(const auto &p: m_freeList){
+                count += p.second.size();
+            }
+            return count;
+        }
+};
+
 template<typename T> class coro final
 {
     private:
@@ -117,6 +248,11 @@ template<typename T> class coro final
         aco_t *m_handle = nullptr;
 #endif
 
+#ifndef _MSC_VER
+    private:
+        coro_stack *m_stackPtr = nullptr;
+#endif
+
     public:
         explicit coro(T t)
             : coro(nullptr, t)
@@ -162,6 +298,8 @@ template<typename T> class coro final
                     sstk = m_stack.get();
                 }
                 m_handle = aco_create(coro_get_main_coref(), sstk->m_stack, 0, fnRoutine, (void *)(this));
+                m_stackPtr = sstk;
+                m_stackPtr->m_users.fetch_add(1, std::memory_order_relaxed);
             }
 #endif
         }
@@ -173,6 +311,7 @@ template<typename T> class coro final
             DeleteFiber(m_handle);
 #else
             aco_destroy(m_handle);
+            m_stackPtr->m_users.fetch_sub(1, std::memory_order_relaxed);
 #endif
             m_handle = nullptr;
         }
@@ -183,23 +322,66 @@ template<typename T> class coro final
                 throw fflerror("Resume finished coroutine");
             }
 
+            if(coro_get_running_ref().co){
+                throw fflerror("Call coro_resume() inside a coroutine");
+            }
+
 #ifdef _MSC_VER
             {
                 if(GetCurrentFiber() != coro_get_main_coref()){
                     throw fflerror("Call coro_resume() not from mainCO");
                 }
+                coro_get_running_ref() = waker();
                 SwitchToFiber(m_handle);
+                coro_get_running_ref() = {};
+                coro_get_switch_stat().resume.fetch_add(1, std::memory_order_relaxed);
             }
 #else
             {
                 if(m_handle->main_co != coro_get_main_coref()){
                     throw fflerror("Call coro_resume() not from its mainCO");
                 }
+
+                // capture the owner before switch, libaco saves it out and restores us in aco_resume()
+                // the previous owner is not destroyed during our run, actors only get deleted by the pool outside of coroutines
+                aco_t *prevOwner = m_handle->share_stack->owner;
+                const size_t restoreBytes = (prevOwner == m_handle) ? 0 : m_handle->save_stack.valid_sz;
+
+                coro_get_running_ref() = waker();
                 aco_resume(m_handle);
+                coro_get_running_ref() = {};
+                coro_get_switch_stat().resume.fetch_add(1, std::memory_order_relaxed);
+
+                if(prevOwner != m_handle){
+                    const size_t saveBytes = prevOwner ? prevOwner->save_stack.valid_sz : 0;
+                    if(restoreBytes + saveBytes > 0){
+                        coro_get_switch_stat().copy .fetch_add(1, std::memory_order_relaxed);
+                        coro_get_switch_stat().bytes.fetch_add(restoreBytes + saveBytes, std::memory_order_relaxed);
+                    }
+                }
             }
 #endif
         }
 
+        coro_waker waker()
+        {
+            return {this, [](void *coptr)
+            {
+                if(auto p = reinterpret_cast<coro<T> *>(coptr); !p->is_done() && p->in_main()){
+                    p->coro_resume();
+                }
+            }, shared_stack()};
+        }
+
+        bool shared_stack() const
+        {
+#ifdef _MSC_VER
+            return false;
+#else
+            return m_stackPtr->shared();
+#endif
+        }
+
         bool in_main() const
         {
             if(is_done()){
@@ -237,13 +419,24 @@ template<typename T> class coro_variable
     private:
         std::optional<T> m_var;
 
+    private:
+        mutable coro_waker m_waiter;
+
     public:
         template<typename U = T> void assign(U &&u)
         {
             if(m_var.has_value()){
                 throw fflerror("Assign value to coro_variable twice");
             }
-            m_var = std::move(u);
+            m_var = std::forward<U>(u);
+
+            // assigned in main context, i.e. by a response handler, resume the waiter right now
+            // instead of waiting for its owner's next update, assigned inside a coroutine means no need
+            // don't touch this after resume, the variable lives on the coroutine stack and can be gone
+            // only valid if the waiter owns its stack, otherwise this variable is not at its address while suspended
+            if(const auto waiter = m_waiter; waiter.co && !coro_get_running_ref().co){
+                waiter.resume(waiter.co);
+            }
         }
 
     public:
@@ -257,6 +450,7 @@ template<typename T> class coro_variable
         const auto &wait() const
         {
             while(!m_var.has_value()){
+                m_waiter = coro_get_running_ref();
                 coro_yield();
             }
             return m_var.value();
@@ -83,6 +83,27 @@ namespace
     };
 }
 
+// runtime lookup by hash index over the unique copy of _Inn_XXXXX[] in dbcomrecord.cpp
+// index is built at compile time, lookup costs about one hash plus one string compare
+// returns 0 if not found, same as the linear search
+uint32_t DBCOM_ITEMID_INDEXED   (const char *);
+uint32_t DBCOM_MONSTERID_INDEXED(const char *);
+uint32_t DBCOM_MAGICID_INDEXED  (const char *);
+uint32_t DBCOM_MAPID_INDEXED    (const char *);
+
+// DBCOM_XXXXID() forwards to the index when not evaluated at compile time
+// so switch/case and constexpr usage keeps the linear search, string variables from lua, database and link tables don't
+// compilers without __builtin_is_constant_evaluated() always do the linear search
+#if defined(__clang__)
+    #define DBCOM_HAS_CONSTANT_EVALUATED (__clang_major__ >= 9)
+#elif defined(__GNUC__)
+    #define DBCOM_HAS_CONSTANT_EVALUATED (__GNUC__ >= 9)
+#elif defined(_MSC_VER)
+    #define DBCOM_HAS_CONSTANT_EVALUATED (_MSC_VER >= 1925)
+#else
+    #define DBCOM_HAS_CONSTANT_EVALUATED 0
+#endif
+
 // constexpr function to map utf-8 string to item record id
 // when use it in compile time never warry about its performance
 //
@@ -90,18 +111,17 @@ namespace
 //
 //      auto nID = DBCOM_ITEMID(szName);
 //
-// this would cause line search for all item record in itemrecord.inc
-// would be better if we can create a constexpr hashmap based on the data
-// check following repo:
-//
-//      https://github.com/benjibc/constexpr_hash_map.git
-//
-// but we don't need it currently, principle:
-// transfer ID between client and server but not string name
-// so we won't need to retrieve ID by a given a string variable name
-// only use this function with literal string to get ID since ID is not fixed (but unique)
+// this goes to DBCOM_ITEMID_INDEXED(), the hash index built at compile time in dbcomrecord.cpp
+// still prefer transferring ID between client and server but not string name
+// ID is not fixed (but unique) and depends on the .inc files
 constexpr uint32_t DBCOM_ITEMID(const char *szName)
 {
+#if DBCOM_HAS_CONSTANT_EVALUATED
+    if(!__builtin_is_constant_evaluated()){
+        return DBCOM_ITEMID_INDEXED(szName);
+    }
+#endif
+
     if(szName){
         for(size_t nIndex = 0; nIndex < sizeof(_Inn_ItemRecordList) / sizeof(_Inn_ItemRecordList[0]); ++nIndex){
             if(ConstExprFunc::CompareUTF8(szName, _Inn_ItemRecordList[nIndex].Name)){
@@ -114,6 +134,12 @@ constexpr uint32_t DBCOM_ITEMID(const char *szName)
 
 constexpr uint32_t DBCOM_MONSTERID(const char *szName)
 {
+#if DBCOM_HAS_CONSTANT_EVALUATED
+    if(!__builtin_is_constant_evaluated()){
+        return DBCOM_MONSTERID_INDEXED(szName);
+    }
+#endif
+
     if(szName){
         for(size_t nIndex = 0; nIndex < sizeof(_Inn_MonsterRecordList) / sizeof(_Inn_MonsterRecordList[0]); ++nIndex){
             if(ConstExprFunc::CompareUTF8(szName, _Inn_MonsterRecordList[nIndex].Name)){
@@ -126,6 +152,12 @@ constexpr uint32_t DBCOM_MONSTERID(const char *szName)
 
 constexpr uint32_t DBCOM_MAGICID(const char *szName)
 {
+#if DBCOM_HAS_CONSTANT_EVALUATED
+    if(!__builtin_is_constant_evaluated()){
+        return DBCOM_MAGICID_INDEXED(szName);
+    }
+#endif
+
     if(szName){
         for(size_t nIndex = 0; nIndex < sizeof(_Inn_MagicRecordList) / sizeof(_Inn_MagicRecordList[0]); ++nIndex){
             if(ConstExprFunc::CompareUTF8(szName, _Inn_MagicRecordList[nIndex].Name)){
@@ -138,6 +170,12 @@ constexpr uint32_t DBCOM_MAGICID(const char *szName)
 
 constexpr uint32_t DBCOM_MAPID(const char *szName)
 {
+#if DBCOM_HAS_CONSTANT_EVALUATED
+    if(!__builtin_is_constant_evaluated()){
+        return DBCOM_MAPID_INDEXED(szName);
+    }
+#endif
+
     if(szName){
         for(size_t nIndex = 0; nIndex < sizeof(_Inn_MapRecordList) / sizeof(_Inn_MapRecordList[0]); ++nIndex){
             if(ConstExprFunc::CompareUTF8(szName, _Inn_MapRecordList[nIndex].Name)){
@@ -21,10 +21,99 @@
  * =====================================================================================
  */
 
+#include <array>
 #include "dbcomid.hpp"
 #include "itemrecord.hpp"
 #include "monsterrecord.hpp"
 
+namespace
+{
+    // FNV-1a over utf-8 bytes
+    constexpr uint32_t _Inn_NameHash(const char *szName)
+    {
+        uint32_t nHash = 2166136261u;
+        for(; *szName; ++szName){
+            nHash ^= (uint8_t)(*szName);
+            nHash *= 16777619u;
+        }
+        return nHash;
+    }
+
+    constexpr size_t _Inn_NameIndexSize(size_t nRecordCount)
+    {
+        size_t nSize = 1;
+        while(nSize < 2 * nRecordCount){
+            nSize *= 2;
+        }
+        return nSize;
+    }
+
+    // open addressing with linear probe, load factor <= 0.5
+    // each slot keeps record index + 1, 0 means empty
+    // record 0 is the invalid entry and never indexed
+    template<typename T, size_t N> constexpr auto _Inn_BuildNameIndex(const T (&stRecordList)[N])
+    {
+        std::array<uint32_t, _Inn_NameIndexSize(N)> stSlotList {};
+        for(size_t nIndex = 1; nIndex < N; ++nIndex){
+            if(!(stRecordList[nIndex].Name && stRecordList[nIndex].Name[0])){
+                continue;
+            }
+
+            for(size_t nSlot = _Inn_NameHash(stRecordList[nIndex].Name) & (stSlotList.size() - 1);; nSlot = (nSlot + 1) & (stSlotList.size() - 1)){
+                if(!stSlotList[nSlot]){
+                    stSlotList[nSlot] = (uint32_t)(nIndex + 1);
+                    break;
+                }
+
+                // duplicated name, keep the first one as linear search does
+                if(ConstExprFunc::CompareUTF8(stRecordList[stSlotList[nSlot] - 1].Name, stRecordList[nIndex].Name)){
+                    break;
+                }
+            }
+        }
+        return stSlotList;
+    }
+
+    template<typename T, size_t N, size_t M> uint32_t _Inn_FindNameIndex(const T (&stRecordList)[N], const std::array<uint32_t, M> &stSlotList, const char *szName)
+    {
+        if(!(szName && szName[0])){
+            return 0;
+        }
+
+        for(size_t nSlot = _Inn_NameHash(szName) & (M - 1); stSlotList[nSlot]; nSlot = (nSlot + 1) & (M - 1)){
+            if(ConstExprFunc::CompareUTF8(stRecordList[stSlotList[nSlot] - 1].Name, szName)){
+                return stSlotList[nSlot] - 1;
+            }
+        }
+        return 0;
+    }
+
+    constexpr auto _Inn_ItemNameIndex    = _Inn_BuildNameIndex(_Inn_ItemRecordList);
+    constexpr auto _Inn_MonsterNameIndex = _Inn_BuildNameIndex(_Inn_MonsterRecordList);
+    constexpr auto _Inn_MagicNameIndex   = _Inn_BuildNameIndex(_Inn_MagicRecordList);
+    constexpr auto _Inn_MapNameIndex     = _Inn_BuildNameIndex(_Inn_MapRecordList);
+}
+
+uint32_t DBCOM_ITEMID_INDEXED(const char *szName)
+{
+    return _Inn_FindNameIndex(_Inn_ItemRecordList, _Inn_ItemNameIndex, szName);
+}
+
+uint32_t DBCOM_MONSTERID_INDEXED(const char *szName)
+{
+    return _Inn_FindNameIndex(_Inn_MonsterRecordList, _Inn_MonsterNameIndex, szName);
+}
+
+uint32_t DBCOM_MAGICID_INDEXED(const char *szName)
+{
+    return _Inn_FindNameIndex(_Inn_MagicRecordList, _Inn_MagicNameIndex, szName);
+}
+
+uint32_t DBCOM_MAPID_INDEXED(const char *szName)
+{
+    return _Inn_FindNameIndex(_Inn_MapRecordList, _Inn_MapNameIndex, szName);
+}
+
 const ItemRecord &DBCOM_ITEMRECORD(uint32_t nID)
 {
     if(true
@@ -6,12 +6,12 @@
  *    Description: Basic class of all integral based map cache
  *
  *                 Internal Database support for 
- *                 1. LRU
- *                 2. Double level cache
+ *                 1. CLOCK eviction with incremental resize, see ShardCache
+ *                 2. concurrent access by sharded locks
  *                 3. Easy for extension
  *
  *                 this class load resources with a external handler function
- *                 store it in a hash-table based cache, linear cache is optional
+ *                 store it in a sharded hash-table based cache
  *
  *                 to instantiation this class
  *                 1. define loadResource()
@@ -28,44 +28,44 @@
  * =====================================================================================
  */
 #pragma once
-#include "abdlist.hpp"
 #include <tuple>
-#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <type_traits>
+#include "fflerror.hpp"
+#include "shardcache.hpp"
 
 template<typename KeyT, typename ResT> class innDB
 {
     private:
-        struct ResourceEntry
-        {
-            ResT    Resource;
-            size_t  Weight;
-            size_t  DLinkOff;
-        };
-
-    private:
-        std::unordered_map<KeyT, ResourceEntry> m_cache;
+        ShardCache<KeyT, ResT> m_cache;
 
     private:
-        ABDList<KeyT> m_DLink;
-
-    private:
-        size_t m_resSum;
-
-    private:
-        const size_t m_resMax;
+        // record every key retrieved for offline replay by cachebench
+        // binary file of uint64_t in native byte order
+        std::mutex m_traceLock;
+        std::FILE *m_traceFile = nullptr;
+        std::atomic<bool> m_traceOn {false};
 
     public:
-        innDB(size_t nResMax)
-            : m_cache()
-            , m_DLink()
-            , m_resSum(0)
-            , m_resMax(nResMax)
+        innDB(size_t nResMax, size_t nShardNum = 1)
+            : m_cache(nResMax, nShardNum, [this](ResT &rstResource)
+              {
+                  freeResource(rstResource);
+              })
         {
             static_assert(std::is_unsigned<KeyT>::value, "innDB only support unsigned intergal key");
         }
 
     public:
-        virtual ~innDB() = default;
+        virtual ~innDB()
+        {
+            if(m_traceFile){
+                std::fclose(m_traceFile);
+            }
+        }
 
     public:
         virtual std::tuple<ResT, size_t> loadResource(KeyT  ) = 0;
@@ -74,62 +74,87 @@ template<typename KeyT, typename ResT> class innDB
     public:
         void ClearCache()
         {
-            for(auto &rstEntry: m_cache){
-                freeResource(rstEntry.second.Resource);
-            }
             m_cache.clear();
-            m_DLink.Clear();
+        }
+
+        auto CacheStat() const
+        {
+            return m_cache.stat();
+        }
+
+    public:
+        void RecordTrace(const char *szTraceFileName)
+        {
+            std::lock_guard<std::mutex> stLockGuard(m_traceLock);
+            if(m_traceFile){
+                std::fclose(m_traceFile);
+                m_traceFile = nullptr;
+            }
+
+            if(szTraceFileName){
+                if(!(m_traceFile = std::fopen(szTraceFileName, "wb"))){
+                    throw fflerror("failed to open trace file: %s", szTraceFileName);
+                }
+            }
+            m_traceOn = (m_traceFile != nullptr);
         }
 
     protected:
         bool RetrieveResource(KeyT nKey, ResT *pResource)
         {
-            if(auto p = m_cache.find(nKey); p != m_cache.end()){
-                if(pResource){
-                    *pResource = p->second.Resource;
-                }
-                if(m_resMax > 0){
-                    m_DLink.MoveHead(p->second.DLinkOff);
-                }
+            if(FindResource(nKey, pResource)){
                 return true;
             }
 
             auto [stResource, nWeight] = loadResource(nKey);
+            InsertResource(nKey, stResource, nWeight, pResource);
+            return true;
+        }
 
-            if(m_resMax){
-                m_DLink.PushHead(nKey);
-            }
-
-            ResourceEntry stEntry;
-            stEntry.Resource = stResource;
-            stEntry.Weight   = nWeight;
-            stEntry.DLinkOff = (m_resMax > 0) ? m_DLink.HeadOff() : 0;
+    protected:
+        // only check the cache, never call loadResource()
+        // used by derived class loading resource asynchronously
+        bool FindResource(KeyT nKey, ResT *pResource)
+        {
+            recordKey(nKey);
+            return m_cache.find(nKey, pResource);
+        }
 
-            m_cache[nKey] = stEntry;
+        bool HasResource(KeyT nKey)
+        {
+            return m_cache.has(nKey);
+        }
 
-            if(m_resMax){
-                m_resSum += nWeight;
-                if(m_resSum > m_resMax){
-                    Resize();
+        // insert a resource loaded outside of loadResource()
+        // if other thread already inserted the key, the passed resource gets freed and pResource gets the cached one
+        void InsertResource(KeyT nKey, ResT stResource, size_t nWeight, ResT *pResource = nullptr)
+        {
+            if(m_cache.insert(nKey, stResource, nWeight, pResource)){
+                if(pResource){
+                    *pResource = stResource;
                 }
+            }else{
+                freeResource(stResource);
             }
+        }
 
-            if(pResource){
-                *pResource = stResource;
-            }
-            return true;
+        // drop one cached resource, freeResource() is called for it
+        bool EraseResource(KeyT nKey)
+        {
+            return m_cache.erase(nKey);
         }
 
     private:
-        void Resize()
+        void recordKey(KeyT nKey)
         {
-            while((m_resMax > 0) && (m_resSum > m_resMax / 2) && !m_DLink.Empty()){
-                if(auto p = m_cache.find(m_DLink.Back()); p != m_cache.end()){
-                    freeResource(p->second.Resource);
-                    m_resSum -= p->second.Weight;
-                    m_cache.erase(p);
-                }
-                m_DLink.PopBack();
+            if(!m_traceOn.load(std::memory_order_relaxed)){
+                return;
+            }
+
+            std::lock_guard<std::mutex> stLockGuard(m_traceLock);
+            if(m_traceFile){
+                const auto nTraceKey = (uint64_t)(nKey);
+                std::fwrite(&nTraceKey, sizeof(nTraceKey), 1, m_traceFile);
             }
         }
 };
@@ -3,7 +3,12 @@
  *
  *       Filename: mapbindb.hpp
  *        Created: 08/31/2017 17:23:35
- *    Description: 
+ *    Description: map terrain is immutable after loading and shared by shared_ptr
+ *                 every ServerMap (including instances of the same map) refers to the same
+ *                 Mir2xMapData, cache eviction only drops the reference held by the cache
+ *
+ *                 loaded terrain is also tracked by weak_ptr, retrieving a map which is
+ *                 evicted from cache but still used gets the same copy without decoding
  *
  *        Version: 1.0
  *       Revision: none
@@ -17,6 +22,8 @@
  */
 
 #pragma once
+#include <mutex>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -27,7 +34,7 @@
 
 struct MapBinEntry
 {
-    Mir2xMapData *Map;
+    std::shared_ptr<const Mir2xMapData> Map;
 };
 
 class MapBinDB: public innDB<uint32_t, MapBinEntry>
@@ -35,6 +42,10 @@ class MapBinDB: public innDB<uint32_t, MapBinEntry>
     private:
         std::unique_ptr<ZSDB> m_ZSDBPtr;
 
+    private:
+        std::mutex m_liveLock;
+        std::unordered_map<uint32_t, std::weak_ptr<const Mir2xMapData>> m_liveList;
+
     public:
         MapBinDB()
             : innDB<uint32_t, MapBinEntry>(16)
@@ -45,7 +56,7 @@ class MapBinDB: public innDB<uint32_t, MapBinEntry>
         bool Load(const char *szMapDBName)
         {
             try{
-                m_ZSDBPtr = std::make_unique<ZSDB>(szMapDBName);
+                m_ZSDBPtr = std::make_unique<ZSDB>(szMapDBName, true);
             }catch(...){
                 return false;
             }
@@ -53,9 +64,9 @@ class MapBinDB: public innDB<uint32_t, MapBinEntry>
         }
 
     public:
-        Mir2xMapData *Retrieve(uint32_t nKey)
+        std::shared_ptr<const Mir2xMapData> Retrieve(uint32_t nKey)
         {
-            if(MapBinEntry stEntry {nullptr}; this->RetrieveResource(nKey, &stEntry)){
+            if(MapBinEntry stEntry; this->RetrieveResource(nKey, &stEntry)){
                 return stEntry.Map;
             }
             return nullptr;
@@ -64,15 +75,34 @@ class MapBinDB: public innDB<uint32_t, MapBinEntry>
     public:
         virtual std::tuple<MapBinEntry, size_t> loadResource(uint32_t nKey)
         {
+            {
+                std::lock_guard<std::mutex> stLockGuard(m_liveLock);
+                if(auto p = m_liveList.find(nKey); p != m_liveList.end()){
+                    if(auto pMap = p->second.lock()){
+                        return {MapBinEntry{pMap}, 1};
+                    }
+                    m_liveList.erase(p);
+                }
+            }
+
             char szKeyString[16];
-            MapBinEntry stEntry {nullptr};
+            MapBinEntry stEntry;
 
             if(std::vector<uint8_t> stBuf; m_ZSDBPtr->Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, &stBuf)){
-                auto pMap = new Mir2xMapData();
+                auto pMap = std::make_shared<Mir2xMapData>();
                 if(pMap->Load(stBuf.data(), stBuf.size())){
-                    stEntry.Map = pMap;
+                    stEntry.Map = std::move(pMap);
+                }
+            }
+
+            if(stEntry.Map){
+                // two threads may decode the same map concurrently
+                // keep the first one so all users share one copy
+                std::lock_guard<std::mutex> stLockGuard(m_liveLock);
+                if(auto pLiveMap = m_liveList[nKey].lock()){
+                    stEntry.Map = pLiveMap;
                 }else{
-                    delete pMap;
+                    m_liveList[nKey] = stEntry.Map;
                 }
             }
             return {stEntry, stEntry.Map ? 1 : 0};
@@ -80,9 +110,7 @@ class MapBinDB: public innDB<uint32_t, MapBinEntry>
 
         virtual void freeResource(MapBinEntry &rstEntry)
         {
-            if(rstEntry.Map){
-                delete rstEntry.Map;
-                rstEntry.Map = nullptr;
-            }
+            // users still holding the map keep it alive
+            rstEntry.Map.reset();
         }
 };
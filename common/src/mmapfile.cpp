@@ -0,0 +1,126 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mmapfile.cpp
+ *        Created: 10/19/2026 17:10:12
+ *    Description: 
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <cerrno>
+#include <cstring>
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mmapfile.hpp"
+#include "fflerror.hpp"
+
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+MMapFile::MMapFile(const char *path)
+{
+    if(!path){
+        throw fflerror("invalid path: (null)");
+    }
+
+    m_fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(m_fileHandle == INVALID_HANDLE_VALUE){
+        m_fileHandle = nullptr;
+        throw fflerror("failed to open file: %s", path);
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(m_fileHandle, &fileSize)){
+        CloseHandle(m_fileHandle);
+        throw fflerror("failed to get file size: %s", path);
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    if(m_size == 0){
+        return;
+    }
+
+    m_mapHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!m_mapHandle){
+        CloseHandle(m_fileHandle);
+        throw fflerror("failed to create file mapping: %s", path);
+    }
+
+    m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapHandle, FILE_MAP_READ, 0, 0, 0));
+    if(!m_data){
+        CloseHandle(m_mapHandle);
+        CloseHandle(m_fileHandle);
+        throw fflerror("failed to map file: %s", path);
+    }
+}
+
+MMapFile::~MMapFile()
+{
+    if(m_data){
+        UnmapViewOfFile(m_data);
+    }
+
+    if(m_mapHandle){
+        CloseHandle(m_mapHandle);
+    }
+
+    if(m_fileHandle){
+        CloseHandle(m_fileHandle);
+    }
+}
+#else
+MMapFile::MMapFile(const char *path)
+{
+    if(!path){
+        throw fflerror("invalid path: (null)");
+    }
+
+    const int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        throw fflerror("failed to open file: %s: %s", path, std::strerror(errno));
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat)){
+        close(fd);
+        throw fflerror("failed to get file size: %s: %s", path, std::strerror(errno));
+    }
+
+    m_size = static_cast<size_t>(fileStat.st_size);
+    if(m_size == 0){
+        close(fd);
+        return;
+    }
+
+    // mapping is still valid after close(fd)
+    // don't need to keep the descriptor
+    auto mapPtr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(mapPtr == MAP_FAILED){
+        throw fflerror("failed to map file: %s: %s", path, std::strerror(errno));
+    }
+    m_data = static_cast<const uint8_t *>(mapPtr);
+}
+
+MMapFile::~MMapFile()
+{
+    if(m_data){
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+}
+#endif
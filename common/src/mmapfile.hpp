@@ -0,0 +1,68 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mmapfile.hpp
+ *        Created: 10/19/2026 17:02:41
+ *    Description: read-only memory mapped file
+ *                 the whole file is mapped at construction and kept until destruction
+ *                 mapped memory is immutable, it's safe to read it from multiple threads
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class MMapFile final
+{
+    private:
+        const uint8_t *m_data = nullptr;
+        size_t         m_size = 0;
+
+    private:
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+        void *m_fileHandle = nullptr;
+        void *m_mapHandle  = nullptr;
+#endif
+
+    public:
+        explicit MMapFile(const char *);
+
+    public:
+        ~MMapFile();
+
+    public:
+        MMapFile(const MMapFile &) = delete;
+        MMapFile &operator = (const MMapFile &) = delete;
+
+    public:
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+    public:
+        // check if [off, off + len) is inside the mapped file
+        // return the pointer to off, otherwise return nullptr
+        const uint8_t *dataAt(uint64_t off, uint64_t len) const
+        {
+            if(off > m_size || len > m_size - off){
+                return nullptr;
+            }
+            return m_data + off;
+        }
+};
@@ -29,7 +29,7 @@ struct MsgAttribute
     //  1    : not empty,     fixed size,     compressed by xor
     //  2    : not empty,     fixed size, not compressed
     //  3    : not empty, not fixed size, not compressed
-    //  4    : not empty, not fixed size,     compressed by lz4
+    //  4    : not empty, not fixed size,     compressed by xor
     const int type;
 
     // define message length before compression
@@ -42,6 +42,7 @@ enum SMType: uint8_t
     SM_PICKUPOK,
     SM_GOLD,
     SM_NPCXMLLAYOUT,
+    SM_UPDATEFRAME,
     SM_MAX,
 };
 
@@ -280,6 +281,7 @@ class ServerMsg final: public MsgBase
                 {SM_REMOVEGROUNDITEM, {1, sizeof(SMRemoveGroundItem),      "SM_REMOVEGROUNDITEM"}},
                 {SM_NPCXMLLAYOUT,     {2, sizeof(SMNPCXMLLayout),          "SM_NPCXMLLAYOUT"    }},
                 {SM_GOLD,             {1, sizeof(SMGold),                  "SM_GOLD"            }},
+                {SM_UPDATEFRAME,      {4, 0,                               "SM_UPDATEFRAME"     }},
             };
 
             if(const auto p = s_msgAttributeTable.find(headCode); p != s_msgAttributeTable.end()){
@@ -19,8 +19,60 @@
 #include <new>
 #include <cstdio>
 #include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "shadow.hpp"
 
+// put shadow color to dst where src pixel is not transparent, keep other dst pixels
+// projected shadow merges two src rows into one dst row, so dst can't be simply overwritten
+static void MergeShadowRow(uint32_t *pDst, const uint32_t *pSrc, int nW, uint32_t nShadowColor)
+{
+    int nX = 0;
+#if defined(__SSE2__)
+    const __m128i stAlpha = _mm_set1_epi32((int)(0XFF000000));
+    const __m128i stColor = _mm_set1_epi32((int)(nShadowColor));
+    const __m128i stZero  = _mm_setzero_si128();
+
+    for(; nX + 4 <= nW; nX += 4){
+        const __m128i stSrc  = _mm_loadu_si128((const __m128i *)(pSrc + nX));
+        const __m128i stDst  = _mm_loadu_si128((const __m128i *)(pDst + nX));
+        const __m128i stKeep = _mm_cmpeq_epi32(_mm_and_si128(stSrc, stAlpha), stZero);
+        _mm_storeu_si128((__m128i *)(pDst + nX), _mm_or_si128(_mm_and_si128(stKeep, stDst), _mm_andnot_si128(stKeep, stColor)));
+    }
+#endif
+
+    for(; nX < nW; ++nX){
+        if(pSrc[nX] & 0XFF000000){
+            pDst[nX] = nShadowColor;
+        }
+    }
+}
+
+// put shadow color to dst where src pixel is not transparent, otherwise 0
+// every dst pixel gets written, no need to clear dst first
+static void FillShadowRow(uint32_t *pDst, const uint32_t *pSrc, int nW, uint32_t nShadowColor)
+{
+    int nX = 0;
+#if defined(__SSE2__)
+    const __m128i stAlpha = _mm_set1_epi32((int)(0XFF000000));
+    const __m128i stColor = _mm_set1_epi32((int)(nShadowColor));
+    const __m128i stZero  = _mm_setzero_si128();
+
+    for(; nX + 4 <= nW; nX += 4){
+        const __m128i stSrc  = _mm_loadu_si128((const __m128i *)(pSrc + nX));
+        const __m128i stKeep = _mm_cmpeq_epi32(_mm_and_si128(stSrc, stAlpha), stZero);
+        _mm_storeu_si128((__m128i *)(pDst + nX), _mm_andnot_si128(stKeep, stColor));
+    }
+#endif
+
+    for(; nX < nW; ++nX){
+        pDst[nX] = (pSrc[nX] & 0XFF000000) ? nShadowColor : 0;
+    }
+}
+
 uint32_t *Shadow::MakeShadow(uint32_t *pDst,
         bool bProject,
         const uint32_t *pData,
@@ -56,24 +108,17 @@ uint32_t *Shadow::MakeShadow(uint32_t *pDst,
     }
 
     if(bProject){
+        // src row nY goes to dst row (nY - nY / 2) with a shift of (nH - nY) / 2
+        // the shift is the same for the whole row, so it's a row-to-row merge
         std::memset(pDst, 0, nNewW * nNewH * sizeof(uint32_t));
         for(int nY = 0; nY < nH; ++nY){
             int nYCnt = nY - nY / 2;
-            for(int nX = 0; nX < nW; ++nX){
-                int nXCnt = nX + (nH - nY) / 2;
-                if(pData[nY * nW + nX] & 0XFF000000){
-                    pDst[nYCnt * nNewW + nXCnt] = nShadowColor;
-                }
-            }
+            int nXCnt = (nH - nY) / 2;
+            MergeShadowRow(pDst + nYCnt * nNewW + nXCnt, pData + nY * nW, nW, nShadowColor);
         }
     }else{
-        std::memset(pDst, 0, nNewW * nNewH * sizeof(uint32_t));
         for(int nY = 0; nY < nH; ++nY){
-            for(int nX = 0; nX < nW; ++nX){
-                if(pData[nY * nW + nX] & 0XFF000000){
-                    pDst[nY * nW + nX] = nShadowColor;
-                }
-            }
+            FillShadowRow(pDst + nY * nW, pData + nY * nW, nW, nShadowColor);
         }
     }
 
@@ -82,3 +127,48 @@ uint32_t *Shadow::MakeShadow(uint32_t *pDst,
 
     return pDst;
 }
+
+std::vector<Shadow::ShadowImage> Shadow::MakeShadowBatch(std::vector<uint32_t> &rstDstBuf, const Shadow::ShadowFrame *pFrame, size_t nFrameCount, uint32_t nShadowColor)
+{
+    if(!pFrame || !nFrameCount){
+        return {};
+    }
+
+    const auto fnValidFrame = [](const ShadowFrame &rstFrame) -> bool
+    {
+        return rstFrame.Data && rstFrame.W > 0 && rstFrame.H > 0;
+    };
+
+    size_t nTotalSize = 0;
+    for(size_t i = 0; i < nFrameCount; ++i){
+        if(fnValidFrame(pFrame[i])){
+            const int nNewW = pFrame[i].Project ? (pFrame[i].W + pFrame[i].H / 2) : pFrame[i].W;
+            const int nNewH = pFrame[i].Project ? (1 + pFrame[i].H / 2) : pFrame[i].H;
+            nTotalSize += (size_t)(nNewW) * nNewH;
+        }
+    }
+
+    // resize before filling any frame
+    // returned pointers stay valid until caller changes the buffer
+    rstDstBuf.resize(nTotalSize);
+
+    size_t nOffset = 0;
+    std::vector<ShadowImage> stImageList(nFrameCount);
+
+    for(size_t i = 0; i < nFrameCount; ++i){
+        if(!fnValidFrame(pFrame[i])){
+            continue;
+        }
+
+        int nNewW = 0;
+        int nNewH = 0;
+
+        MakeShadow(rstDstBuf.data() + nOffset, pFrame[i].Project, pFrame[i].Data, pFrame[i].W, pFrame[i].H, &nNewW, &nNewH, nShadowColor);
+        stImageList[i].Data = rstDstBuf.data() + nOffset;
+        stImageList[i].W    = nNewW;
+        stImageList[i].H    = nNewH;
+
+        nOffset += (size_t)(nNewW) * nNewH;
+    }
+    return stImageList;
+}
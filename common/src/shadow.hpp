@@ -17,6 +17,8 @@
  */
 
 #pragma once
+#include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <cinttypes>
 
@@ -30,4 +32,30 @@ namespace Shadow
             int *,                      // new width
             int *,                      // new height
             uint32_t);                  // shadow pixel color
+
+    struct ShadowFrame
+    {
+        const uint32_t *Data = nullptr;
+
+        int W = 0;
+        int H = 0;
+
+        bool Project = true;
+    };
+
+    struct ShadowImage
+    {
+        const uint32_t *Data = nullptr;
+
+        int W = 0;
+        int H = 0;
+    };
+
+    // make shadows for a whole animation sequence
+    // all shadow images are packed into the dst buffer, only resized once per call
+    // returned images point into the dst buffer, invalid frames give empty images
+    std::vector<ShadowImage> MakeShadowBatch(std::vector<uint32_t> &,  // dst buffer
+            const ShadowFrame *,                                        // frames
+            size_t,                                                     // frame count
+            uint32_t);                                                  // shadow pixel color
 }
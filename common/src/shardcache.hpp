@@ -0,0 +1,342 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: shardcache.hpp
+ *        Created: 10/19/2026 21:08:33
+ *    Description: concurrent weighted cache with CLOCK eviction
+ *
+ *                 keys are hashed into shards, each shard has its own lock, index and clock
+ *                 eviction is incremental: an insert only evicts enough entries to get the
+ *                 shard back under its capacity, instead of draining the whole cache
+ *
+ *                 evicted resources are freed by the callback outside of the shard lock
+ *                 resource returned by find() can be evicted by another thread, if cache is
+ *                 shared by multiple threads the resource should be copyable or ref-counted
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include "fflerror.hpp"
+
+template<typename KeyT, typename ResT> class ShardCache final
+{
+    public:
+        struct CacheStat
+        {
+            uint64_t Hit    = 0;
+            uint64_t Miss   = 0;
+            uint64_t Insert = 0;
+            uint64_t Evict  = 0;
+
+            size_t Count  = 0;
+            size_t Weight = 0;
+
+            double hitRatio() const
+            {
+                return (Hit + Miss) ? (1.0 * Hit / (Hit + Miss)) : 0.0;
+            }
+        };
+
+    private:
+        struct SlotEntry
+        {
+            KeyT   Key;
+            ResT   Resource;
+            size_t Weight;
+
+            bool Used;
+            bool Referenced;
+        };
+
+        struct Shard
+        {
+            std::mutex Lock;
+            std::unordered_map<KeyT, size_t> Index;
+
+            std::vector<SlotEntry> SlotList;
+            std::vector<size_t>    FreeSlot;
+
+            size_t Hand   = 0;
+            size_t Weight = 0;
+        };
+
+    private:
+        const size_t m_resMax;
+        const size_t m_shardResMax;
+
+    private:
+        const size_t m_shardMask;
+        std::unique_ptr<Shard[]> m_shardList;
+
+    private:
+        const std::function<void(ResT &)> m_freeFunc;
+
+    private:
+        std::atomic<uint64_t> m_hit    {0};
+        std::atomic<uint64_t> m_miss   {0};
+        std::atomic<uint64_t> m_insert {0};
+        std::atomic<uint64_t> m_evict  {0};
+
+    public:
+        // resMax   : max total weight, 0 means no eviction
+        // shardNum : rounded up to power of 2
+        ShardCache(size_t resMax, size_t shardNum, std::function<void(ResT &)> freeFunc)
+            : m_resMax(resMax)
+            , m_shardResMax(resMax ? std::max<size_t>(1, resMax / roundShardNum(shardNum)) : 0)
+            , m_shardMask(roundShardNum(shardNum) - 1)
+            , m_shardList(std::make_unique<Shard[]>(roundShardNum(shardNum)))
+            , m_freeFunc(std::move(freeFunc))
+        {
+            static_assert(std::is_integral<KeyT>::value, "ShardCache only support intergal key");
+        }
+
+    public:
+        // don't call freeFunc in destructor
+        // freeFunc may refer to the owner which is already partially destroyed, call clear() explicitly
+        ~ShardCache() = default;
+
+    public:
+        size_t resMax() const
+        {
+            return m_resMax;
+        }
+
+        size_t shardNum() const
+        {
+            return m_shardMask + 1;
+        }
+
+    public:
+        bool find(KeyT key, ResT *resPtr)
+        {
+            auto &shard = getShard(key);
+            {
+                std::lock_guard<std::mutex> lockGuard(shard.Lock);
+                if(auto p = shard.Index.find(key); p != shard.Index.end()){
+                    auto &slot = shard.SlotList[p->second];
+                    slot.Referenced = true;
+
+                    if(resPtr){
+                        *resPtr = slot.Resource;
+                    }
+
+                    m_hit.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+
+            m_miss.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        bool has(KeyT key)
+        {
+            auto &shard = getShard(key);
+            std::lock_guard<std::mutex> lockGuard(shard.Lock);
+            return shard.Index.find(key) != shard.Index.end();
+        }
+
+    public:
+        // insert resource if key doesn't exist and return true
+        // otherwise return false with the existing resource in existPtr, caller owns the resource passed in
+        bool insert(KeyT key, ResT res, size_t weight, ResT *existPtr = nullptr)
+        {
+            std::vector<ResT> evictList;
+            auto &shard = getShard(key);
+            {
+                std::lock_guard<std::mutex> lockGuard(shard.Lock);
+                if(auto p = shard.Index.find(key); p != shard.Index.end()){
+                    if(existPtr){
+                        *existPtr = shard.SlotList[p->second].Resource;
+                    }
+                    return false;
+                }
+
+                size_t slotIndex = 0;
+                if(shard.FreeSlot.empty()){
+                    slotIndex = shard.SlotList.size();
+                    shard.SlotList.push_back(SlotEntry {key, res, weight, true, true});
+                }else{
+                    slotIndex = shard.FreeSlot.back();
+                    shard.FreeSlot.pop_back();
+                    shard.SlotList[slotIndex] = SlotEntry {key, res, weight, true, true};
+                }
+
+                shard.Index[key] = slotIndex;
+                shard.Weight += weight;
+
+                if(m_shardResMax && shard.Weight > m_shardResMax){
+                    evict(shard, slotIndex, evictList);
+                }
+            }
+
+            m_insert.fetch_add(1, std::memory_order_relaxed);
+            m_evict .fetch_add(evictList.size(), std::memory_order_relaxed);
+
+            for(auto &evictRes: evictList){
+                freeResource(evictRes);
+            }
+            return true;
+        }
+
+        bool erase(KeyT key)
+        {
+            ResT res;
+            auto &shard = getShard(key);
+            {
+                std::lock_guard<std::mutex> lockGuard(shard.Lock);
+                auto p = shard.Index.find(key);
+
+                if(p == shard.Index.end()){
+                    return false;
+                }
+
+                res = releaseSlot(shard, p->second);
+                shard.Index.erase(p);
+            }
+
+            freeResource(res);
+            return true;
+        }
+
+        void clear()
+        {
+            for(size_t i = 0; i < shardNum(); ++i){
+                std::vector<ResT> evictList;
+                {
+                    auto &shard = m_shardList[i];
+                    std::lock_guard<std::mutex> lockGuard(shard.Lock);
+
+                    for(auto &slot: shard.SlotList){
+                        if(slot.Used){
+                            evictList.push_back(std::move(slot.Resource));
+                        }
+                    }
+
+                    shard.Index.clear();
+                    shard.SlotList.clear();
+                    shard.FreeSlot.clear();
+
+                    shard.Hand   = 0;
+                    shard.Weight = 0;
+                }
+
+                for(auto &res: evictList){
+                    freeResource(res);
+                }
+            }
+        }
+
+    public:
+        CacheStat stat() const
+        {
+            CacheStat cacheStat;
+            cacheStat.Hit    = m_hit   .load(std::memory_order_relaxed);
+            cacheStat.Miss   = m_miss  .load(std::memory_order_relaxed);
+            cacheStat.Insert = m_insert.load(std::memory_order_relaxed);
+            cacheStat.Evict  = m_evict .load(std::memory_order_relaxed);
+
+            for(size_t i = 0; i < shardNum(); ++i){
+                auto &shard = m_shardList[i];
+                std::lock_guard<std::mutex> lockGuard(shard.Lock);
+
+                cacheStat.Count  += shard.Index.size();
+                cacheStat.Weight += shard.Weight;
+            }
+            return cacheStat;
+        }
+
+    private:
+        Shard &getShard(KeyT key) const
+        {
+            // keys are usually packed IDs with structured low bits
+            // mix all bits before picking the shard, use murmur3 finalizer
+            auto h = (uint64_t)(key);
+            h ^= h >> 33;
+            h *= 0XFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+            h *= 0XC4CEB9FE1A85EC53ULL;
+            h ^= h >> 33;
+            return m_shardList[(size_t)(h) & m_shardMask];
+        }
+
+        void freeResource(ResT &res)
+        {
+            if(m_freeFunc){
+                m_freeFunc(res);
+            }
+        }
+
+        ResT releaseSlot(Shard &shard, size_t slotIndex)
+        {
+            auto &slot = shard.SlotList[slotIndex];
+            ResT res = std::move(slot.Resource);
+
+            shard.Weight -= slot.Weight;
+            shard.FreeSlot.push_back(slotIndex);
+
+            slot.Resource   = ResT();
+            slot.Weight     = 0;
+            slot.Used       = false;
+            slot.Referenced = false;
+            return res;
+        }
+
+        void evict(Shard &shard, size_t keepSlot, std::vector<ResT> &evictList)
+        {
+            // CLOCK: clear the reference bit for the first pass, evict on the second pass
+            // every entry gets visited at most twice, the just inserted entry is never evicted
+            for(size_t step = 0; (step < 2 * shard.SlotList.size()) && (shard.Weight > m_shardResMax); ++step){
+                if(shard.Hand >= shard.SlotList.size()){
+                    shard.Hand = 0;
+                }
+
+                const auto currSlot = shard.Hand++;
+                auto &slot = shard.SlotList[currSlot];
+
+                if(!slot.Used || currSlot == keepSlot){
+                    continue;
+                }
+
+                if(slot.Referenced){
+                    slot.Referenced = false;
+                    continue;
+                }
+
+                shard.Index.erase(slot.Key);
+                evictList.push_back(releaseSlot(shard, currSlot));
+            }
+        }
+
+    private:
+        static size_t roundShardNum(size_t shardNum)
+        {
+            if(shardNum == 0 || shardNum > 1024){
+                throw fflerror("invalid shard number: %zu", shardNum);
+            }
+
+            size_t roundNum = 1;
+            while(roundNum < shardNum){
+                roundNum <<= 1;
+            }
+            return roundNum;
+        }
+};
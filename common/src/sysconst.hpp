@@ -37,6 +37,19 @@ constexpr int SYS_MAPGRIDYP = 32;
 constexpr int SYS_OBJMAXW = 3;
 constexpr int SYS_OBJMAXH = 25;
 
+// client prefetches textures in grids around the view
+// and spends at most SYS_TEXUPLOADMS per frame to upload decoded textures
+constexpr int SYS_PREFETCHGRIDX = 8;
+constexpr int SYS_PREFETCHGRIDY = 8;
+constexpr double SYS_TEXUPLOADMS = 4.0;
+
+// client bakes tiles and static ground objects into chunk textures of SYS_MAPCHUNKGRIDX x SYS_MAPCHUNKGRIDY grids
+// keeps at most SYS_MAPCHUNKMAX chunks and bakes at most SYS_MAPCHUNKBAKE chunks per frame
+constexpr int SYS_MAPCHUNKGRIDX = 16;
+constexpr int SYS_MAPCHUNKGRIDY = 16;
+constexpr int SYS_MAPCHUNKMAX   = 48;
+constexpr int SYS_MAPCHUNKBAKE  =  2;
+
 constexpr int SYS_MAXR         = 40;
 constexpr int SYS_MAPVISIBLEW  = 60;
 constexpr int SYS_MAPVISIBLEH  = 40;
@@ -44,6 +57,17 @@ constexpr int SYS_MAPVISIBLECD = 100;
 
 constexpr int SYS_MAXPLAYERNUM = 8192;
 
+// server map counts players in regions of SYS_AIREGIONSIZE x SYS_AIREGIONSIZE grids
+// monster hibernates if no player in the 3 x 3 regions around it, checked every SYS_AIDORMANTCHECK ms
+constexpr int      SYS_AIREGIONSIZE   = 32;
+constexpr uint32_t SYS_AIDORMANTCHECK = 1000;
+
+// awake monster without target or master ticks every SYS_AIIDLEPERIOD ms, full rate once it gets a target
+constexpr uint32_t SYS_AIIDLEPERIOD = 200;
+
+// map script budget is checked every SYS_MAPSCRIPTHOOKSTEP lua instructions
+constexpr int SYS_MAPSCRIPTHOOKSTEP = 1000;
+
 constexpr int SYS_MAXDROPITEM     = 10;
 constexpr int SYS_MAXDROPITEMGRID = 81;
 
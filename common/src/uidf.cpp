@@ -25,12 +25,22 @@
 #include "toll.hpp"
 #include "fflerror.hpp"
 
-uint64_t uidf::buildMapUID(uint32_t mapID)
+uint64_t uidf::buildMapUID(uint32_t mapID, uint32_t instance)
 {
+    // 47-44 43-32 31-0
+    // |  |  |  |  |  |
+    // |  |  |  |  +--+---------> map id
+    // |  |  +--+---------------> instance, 0 is the shared world map
+    // +--+---------------------> UID_MAP
+
     if(!mapID){
         throw fflerror("invalid map ID: %llu", to_llu(mapID));
     }
-    return ((uint64_t)(UID_MAP) << 44) + (uint64_t)(mapID);
+
+    if(instance >= 4096){
+        throw fflerror("invalid map instance: %llu", to_llu(instance));
+    }
+    return ((uint64_t)(UID_MAP) << 44) + ((uint64_t)(instance) << 32) + (uint64_t)(mapID);
 }
 
 uint64_t uidf::buildNPCUID(uint16_t lookId)
@@ -111,6 +121,9 @@ std::string uidf::getUIDString(uint64_t uid)
             }
         case UID_MAP:
             {
+                if(const auto instance = getMapInstance(uid)){
+                    return str_printf("MAP%llu_%llu", to_llu(uid & 0XFFFFFFFF), to_llu(instance));
+                }
                 return str_printf("MAP%llu", to_llu(uid & 0XFFFFFFFF));
             }
         case UID_COR:
@@ -136,6 +149,14 @@ uint32_t uidf::getMapID(uint64_t uid)
     return uid & 0XFFFFFFFF;
 }
 
+uint32_t uidf::getMapInstance(uint64_t uid)
+{
+    if(uidf::getUIDType(uid) != UID_MAP){
+        throw fflerror("invalid uid type: %s", uidf::getUIDTypeString(uid));
+    }
+    return (uint32_t)((uid & 0X00000FFF00000000) >> 32);
+}
+
 uint16_t uidf::getLookID(uint64_t uid)
 {
     switch(uidf::getUIDType(uid)){
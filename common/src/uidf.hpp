@@ -49,7 +49,7 @@ namespace uidf
     // based on database id to create UID
     // always model it as ``build" even some of them are pure mapping
 
-    uint64_t buildMapUID(uint32_t);
+    uint64_t buildMapUID(uint32_t, uint32_t = 0);
     uint64_t buildNPCUID(uint16_t);
     uint64_t buildPlayerUID(uint32_t);
     uint64_t buildMonsterUID(uint32_t);
@@ -103,6 +103,7 @@ namespace uidf
     }
 
     uint32_t getMapID (uint64_t);
+    uint32_t getMapInstance(uint64_t);
     uint16_t getLookID(uint64_t);
 }
 
@@ -0,0 +1,197 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: updateframe.cpp
+ *        Created: 10/20/2026 04:12:36
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <cstring>
+#include <iterator>
+#include "fflerror.hpp"
+#include "servermsg.hpp"
+#include "updateframe.hpp"
+
+int UpdateFrame::batchSlot(uint8_t headCode)
+{
+    switch(headCode){
+        case SM_ACTION  : return 0;
+        case SM_UPDATEHP: return 1;
+        case SM_CORECORD: return 2;
+        default         : return -1;
+    }
+}
+
+bool UpdateFrame::batchable(uint8_t headCode)
+{
+    return batchSlot(headCode) >= 0;
+}
+
+void UpdateFrameEncoder::add(uint8_t headCode, const uint8_t *data, size_t dataLen)
+{
+    if(!batchable(headCode)){
+        throw fflerror("message can't be batched: %s", ServerMsg(headCode).name().c_str());
+    }
+
+    if(!(data && dataLen == ServerMsg(headCode).dataLen())){
+        throw fflerror("invalid message: %s, data = %p, dataLen = %zu", ServerMsg(headCode).name().c_str(), data, dataLen);
+    }
+
+    uint64_t uid = 0;
+    std::memcpy(&uid, data, sizeof(uid));
+
+    if(headCode == SM_UPDATEHP){
+        // only the last HP matters, but it can't move ahead of other messages of the same UID
+        // i.e. SM_CORECORD of a new creature must reach client before its HP
+        // overwrite the pending HP only if it's the last entry of this UID, otherwise drop it and append
+        for(auto p = m_pendingList.rbegin(); p != m_pendingList.rend(); ++p){
+            if(p->UID != uid){
+                continue;
+            }
+
+            if(p->HeadCode == SM_UPDATEHP){
+                std::memcpy(m_pendingBuf.data() + p->Offset, data, dataLen);
+                return;
+            }
+
+            for(auto q = std::next(p); q != m_pendingList.rend(); ++q){
+                if(q->UID == uid && q->HeadCode == SM_UPDATEHP){
+                    // its bytes stay in m_pendingBuf unreferenced until encode()
+                    m_pendingList.erase(std::next(q).base());
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    m_pendingList.push_back({headCode, uid, m_pendingBuf.size()});
+    m_pendingBuf.insert(m_pendingBuf.end(), data, data + dataLen);
+}
+
+const std::vector<uint8_t> &UpdateFrameEncoder::encode()
+{
+    if(m_pendingList.size() > 0XFFFF){
+        throw fflerror("too many messages in one frame: %zu", m_pendingList.size());
+    }
+
+    uint8_t flag = 0;
+    if(m_reset || m_baselineList.size() + m_pendingList.size() > m_baselineMax){
+        flag |= FLAG_RESET;
+        m_reset = false;
+
+        m_baselineList.clear();
+        for(auto &refTable: m_refList){
+            refTable.clear();
+        }
+    }
+
+    const auto count = (uint16_t)(m_pendingList.size());
+
+    m_frameBuf.clear();
+    m_frameBuf.push_back(flag);
+    m_frameBuf.insert(m_frameBuf.end(), (const uint8_t *)(&count), (const uint8_t *)(&count) + sizeof(count));
+
+    for(const auto &entry: m_pendingList){
+        const auto dataLen = ServerMsg(entry.HeadCode).dataLen();
+        const auto orig    = m_pendingBuf.data() + entry.Offset;
+
+        // new baseline sends ref 0 and raw message
+        // decoder gets the UID from message body
+        uint16_t ref = 0;
+        auto &refTable = m_refList.at(batchSlot(entry.HeadCode));
+
+        if(auto p = refTable.find(entry.UID); p != refTable.end()){
+            ref = p->second;
+        }
+
+        m_frameBuf.push_back(entry.HeadCode);
+        m_frameBuf.insert(m_frameBuf.end(), (const uint8_t *)(&ref), (const uint8_t *)(&ref) + sizeof(ref));
+
+        const auto offset = m_frameBuf.size();
+        m_frameBuf.insert(m_frameBuf.end(), orig, orig + dataLen);
+
+        if(ref){
+            auto &baseline = m_baselineList.at(ref - 1);
+            xorBuf(m_frameBuf.data() + offset, baseline.data(), dataLen);
+            std::memcpy(baseline.data(), orig, dataLen);
+        }
+        else{
+            m_baselineList.emplace_back(orig, orig + dataLen);
+            refTable[entry.UID] = (uint16_t)(m_baselineList.size());
+        }
+    }
+
+    m_pendingList.clear();
+    m_pendingBuf.clear();
+    return m_frameBuf;
+}
+
+void UpdateFrameDecoder::decode(const uint8_t *buf, size_t bufLen, const std::function<void(uint8_t, const uint8_t *, size_t)> &fnHandler)
+{
+    if(!(buf && bufLen >= 3)){
+        throw fflerror("invalid frame: buf = %p, bufLen = %zu", buf, bufLen);
+    }
+
+    uint16_t count = 0;
+    std::memcpy(&count, buf + 1, sizeof(count));
+
+    if(buf[0] & FLAG_RESET){
+        m_baselineList.clear();
+    }
+
+    size_t offset = 3;
+    for(uint16_t i = 0; i < count; ++i){
+        if(offset + 1 + 2 > bufLen){
+            throw fflerror("frame truncated: entry = %d", (int)(i));
+        }
+
+        const uint8_t headCode = buf[offset];
+        if(!batchable(headCode)){
+            throw fflerror("invalid head code in frame: %d", (int)(headCode));
+        }
+
+        uint16_t ref = 0;
+        std::memcpy(&ref, buf + offset + 1, sizeof(ref));
+        offset += 1 + 2;
+
+        const auto dataLen = ServerMsg(headCode).dataLen();
+        if(offset + dataLen > bufLen){
+            throw fflerror("frame truncated: entry = %d", (int)(i));
+        }
+
+        m_decodeBuf.assign(buf + offset, buf + offset + dataLen);
+        offset += dataLen;
+
+        if(ref){
+            if(ref > m_baselineList.size() || m_baselineList[ref - 1].size() != dataLen){
+                throw fflerror("invalid baseline reference: %d", (int)(ref));
+            }
+
+            auto &baseline = m_baselineList[ref - 1];
+            xorBuf(m_decodeBuf.data(), baseline.data(), dataLen);
+            baseline = m_decodeBuf;
+        }
+        else{
+            m_baselineList.push_back(m_decodeBuf);
+        }
+
+        if(fnHandler){
+            fnHandler(headCode, m_decodeBuf.data(), dataLen);
+        }
+    }
+
+    if(offset != bufLen){
+        throw fflerror("frame has trailing bytes: %zu", bufLen - offset);
+    }
+}
@@ -0,0 +1,148 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: updateframe.hpp
+ *        Created: 10/20/2026 04:12:36
+ *    Description: per-tick batched entity updates from server to client
+ *
+ *                 server collects SM_ACTION / SM_UPDATEHP / SM_CORECORD of one player in
+ *                 one tick and sends them as one SM_UPDATEFRAME, each entry is xor-ed
+ *                 with the last message of same head code and UID sent before, unchanged
+ *                 fields become zero and get removed by the mask compression of channel
+ *
+ *                 TCP keeps order and never drops, so the last sent message is what client
+ *                 has already applied, both sides keep the same baseline table without ack
+ *
+ *                 frame layout before compression:
+ *
+ *                     [flag: 1][count: 2][entry] ... [entry]
+ *                     entry: [headCode: 1][ref: 2][xor-ed message: ServerMsg(headCode).dataLen()]
+ *
+ *                 ref is 1-based index of the baseline, 0 means a new baseline and message
+ *                 is not xor-ed, both sides append new baseline in the same order
+ *
+ *                 baseline table is cleared on both sides when frame has FLAG_RESET
+ *                 encoder sets it when the table grows too big
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include "fflerror.hpp"
+
+class UpdateFrame
+{
+    public:
+        enum: uint8_t
+        {
+            FLAG_RESET = 0X01,
+        };
+
+    public:
+        // head codes can be batched into frame
+        // message body of these head codes starts with the UID
+        static bool batchable(uint8_t);
+
+    protected:
+        // last message of each (head code, UID)
+        // index is (ref - 1)
+        std::vector<std::vector<uint8_t>> m_baselineList;
+
+    protected:
+        static int batchSlot(uint8_t);
+
+    protected:
+        static void xorBuf(uint8_t *dst, const uint8_t *src, size_t len)
+        {
+            for(size_t i = 0; i < len; ++i){
+                dst[i] ^= src[i];
+            }
+        }
+};
+
+class UpdateFrameEncoder final: public UpdateFrame
+{
+    private:
+        struct PendingEntry
+        {
+            uint8_t  HeadCode = 0;
+            uint64_t UID      = 0;
+            size_t   Offset   = 0;
+        };
+
+    private:
+        const size_t m_baselineMax;
+
+    private:
+        // ref of (head code, UID), index by batchSlot(headCode)
+        std::array<std::unordered_map<uint64_t, uint16_t>, 3> m_refList;
+
+    private:
+        bool m_reset = false;
+
+    private:
+        std::vector<PendingEntry> m_pendingList;
+        std::vector<uint8_t>      m_pendingBuf;
+
+    private:
+        std::vector<uint8_t> m_frameBuf;
+
+    public:
+        UpdateFrameEncoder(size_t baselineMax = 2048)
+            : m_baselineMax(baselineMax)
+        {
+            if(m_baselineMax == 0 || m_baselineMax > 0XFFFF){
+                throw fflerror("invalid baseline limit: %zu", m_baselineMax);
+            }
+        }
+
+    public:
+        bool empty() const
+        {
+            return m_pendingList.empty();
+        }
+
+    public:
+        // queue one message for the next frame
+        // SM_UPDATEHP replaces the pending one of same UID since only the last HP matters
+        // the replacement never moves ahead of other pending messages of that UID
+        void add(uint8_t, const uint8_t *, size_t);
+
+    public:
+        // clear baseline at next frame
+        // call it when the connection gets rebound
+        void reset()
+        {
+            m_reset = true;
+        }
+
+    public:
+        // build frame of all pending messages and clear them
+        // returned buffer is valid till next call
+        const std::vector<uint8_t> &encode();
+};
+
+class UpdateFrameDecoder final: public UpdateFrame
+{
+    private:
+        std::vector<uint8_t> m_decodeBuf;
+
+    public:
+        // restore every message in the frame and call the handler in order
+        // throws if frame is broken, baseline is invalid after that
+        void decode(const uint8_t *, size_t, const std::function<void(uint8_t, const uint8_t *, size_t)> &);
+};
@@ -20,44 +20,104 @@
 #include <string>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "condcheck.hpp"
 #include "wilimagepackage.hpp"
 
-static uint32_t Color16To32Mapping(uint16_t srcColor, uint32_t chColor)
+// mapping of one RGB565 pixel to RGBA8888 with a color mask:
+//
+//     r = (srcColor & 0XF800) >> 8
+//     g = (srcColor & 0X07E0) >> 3
+//     b = (srcColor & 0X001F) << 3
+//
+//     if mask is not white, each channel c with mask m becomes (m <= c) ? m : lround(255 * c / m)
+//     alpha always comes from the mask
+//
+// channels are independent, masked colors use per-channel tables
+struct Color16To32Table
 {
-    uint8_t r  = (uint8_t)((srcColor & 0XF800) >> 8);
-    uint8_t g  = (uint8_t)((srcColor & 0X07E0) >> 3);
-    uint8_t b  = (uint8_t)((srcColor & 0X001F) << 3);
-
-    if((chColor & 0X00FFFFFF) != 0X00FFFFFF){
-        uint8_t br = (uint8_t)((chColor & 0X00FF0000) >> 16);
-        uint8_t bg = (uint8_t)((chColor & 0X0000FF00) >>  8);
-        uint8_t bb = (uint8_t)((chColor & 0X000000FF) >>  0);
-
-        r = (br <= r) ? br : (uint8_t)std::lround(255.0 * r / br);
-        g = (bg <= g) ? bg : (uint8_t)std::lround(255.0 * g / bg);
-        b = (bb <= b) ? bb : (uint8_t)std::lround(255.0 * b / bb);
-    }
+    uint32_t Alpha = 0;
+    bool     Mask  = false;
 
-    return (chColor & 0XFF000000) + (((uint32_t)(b)) << 16) + (((uint32_t)(g)) << 8) + (uint32_t)(r);
-}
+    uint32_t R[32];
+    uint32_t G[64];
+    uint32_t B[32];
 
-static void Memcpy16To32(uint32_t *dst, const uint16_t *src, int32_t n, uint32_t dwColor)
-{
-    if(src && dst){
-        for(int32_t ptr = 0; ptr < n; ptr++){
-            dst[ptr] = Color16To32Mapping(src[ptr], dwColor);
+    explicit Color16To32Table(uint32_t chColor)
+        : Alpha(chColor & 0XFF000000)
+        , Mask((chColor & 0X00FFFFFF) != 0X00FFFFFF)
+    {
+        if(!Mask){
+            return;
+        }
+
+        const auto fnMapChannel = [](uint32_t c, uint32_t m) -> uint32_t
+        {
+            return (m <= c) ? m : (uint32_t)((uint8_t)(std::lround(255.0 * c / m)));
+        };
+
+        for(uint32_t i = 0; i < 32; ++i){
+            R[i] = fnMapChannel(i << 3, (chColor & 0X00FF0000) >> 16) <<  0;
+            B[i] = fnMapChannel(i << 3, (chColor & 0X000000FF) >>  0) << 16;
+        }
+
+        for(uint32_t i = 0; i < 64; ++i){
+            G[i] = fnMapChannel(i << 2, (chColor & 0X0000FF00) >> 8) << 8;
         }
     }
+};
+
+static uint16_t Load16(const uint8_t *src, size_t index)
+{
+    // image data in the mapped file is not aligned
+    uint16_t val;
+    std::memcpy(&val, src + index * 2, 2);
+    return val;
 }
 
-static void MemSet32(uint32_t *dst, int n, uint32_t src)
+static void Memcpy16To32(uint32_t *dst, const uint8_t *src, size_t n, const Color16To32Table &table)
 {
-    if(dst){
-        for(int32_t ptr = 0; ptr < n; ptr++){
-            dst[ptr] = src;
+    size_t ptr = 0;
+    if(table.Mask){
+        for(; ptr < n; ++ptr){
+            const auto srcColor = Load16(src, ptr);
+            dst[ptr] = table.Alpha | table.R[(srcColor >> 11) & 0X1F] | table.G[(srcColor >> 5) & 0X3F] | table.B[srcColor & 0X1F];
         }
+        return;
+    }
+
+#if defined(__SSE2__)
+    // 8 pixels per iteration
+    // build (r | g << 8) and (b | a << 8) in 16-bit lanes, then interleave them into 32-bit pixels
+    const __m128i maskRB = _mm_set1_epi16(0X00F8);
+    const __m128i maskG  = _mm_set1_epi16(0X00FC);
+    const __m128i alpha  = _mm_set1_epi16((int16_t)((table.Alpha >> 16) & 0XFF00));
+
+    for(; ptr + 8 <= n; ptr += 8){
+        const __m128i srcColor = _mm_loadu_si128((const __m128i *)(src + ptr * 2));
+        const __m128i r = _mm_and_si128(_mm_srli_epi16(srcColor, 8), maskRB);
+        const __m128i g = _mm_and_si128(_mm_srli_epi16(srcColor, 3), maskG );
+        const __m128i b = _mm_and_si128(_mm_slli_epi16(srcColor, 3), maskRB);
+
+        const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        const __m128i ba = _mm_or_si128(b, alpha);
+
+        _mm_storeu_si128((__m128i *)(dst + ptr + 0), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i *)(dst + ptr + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+#endif
+
+    for(; ptr < n; ++ptr){
+        const auto srcColor = Load16(src, ptr);
+        dst[ptr] = table.Alpha
+            | (((uint32_t)(srcColor & 0X001F) << 3) << 16)
+            | (((uint32_t)(srcColor & 0X07E0) >> 3) <<  8)
+            | (((uint32_t)(srcColor & 0XF800) >> 8) <<  0);
     }
 }
 
@@ -66,24 +126,55 @@ WilImagePackage::WilImagePackage()
     , m_currentImageValid(false)
     , m_currentImageBuffer(2048)
     , m_wilPosition(2048)
-    , m_wilFile(nullptr)
+    , m_wilMap()
 {
     std::memset(&m_wixImageInfo,        0, sizeof(WIXIMAGEINFO ));
     std::memset(&m_currentWilImageInfo, 0, sizeof(WILIMAGEINFO ));
     std::memset(&m_wilFileHeader,       0, sizeof(WILFILEHEADER));
 }
 
-WilImagePackage::~WilImagePackage()
+WilImagePackage::~WilImagePackage() = default;
+
+const uint8_t *WilImagePackage::ImageData(uint32_t dwIndex, WILIMAGEINFO *pInfo) const
 {
-    if(m_wilFile){ std::fclose(m_wilFile); }
+    if(false
+            || !m_wilMap
+            || dwIndex >= (uint32_t)(m_wilPosition.size())
+            || dwIndex >= (uint32_t)(m_wixImageInfo.nIndexCount)
+            || m_wilPosition[dwIndex] <= 0){
+        return nullptr;
+    }
+
+    const auto pInfoData = m_wilMap->dataAt(m_wilPosition[dwIndex], sizeof(WILIMAGEINFO));
+    if(!pInfoData){
+        return nullptr;
+    }
+
+    WILIMAGEINFO stInfo;
+    std::memcpy(&stInfo, pInfoData, sizeof(stInfo));
+
+    const auto nWilOffset = WilOffset(m_wilFileHeader.shVer);
+    if(nWilOffset < 0){
+        return nullptr;
+    }
+
+    const auto pImageData = m_wilMap->dataAt((uint64_t)(m_wilPosition[dwIndex]) + nWilOffset, (uint64_t)(stInfo.dwImageLength) * sizeof(uint16_t));
+    if(!pImageData){
+        return nullptr;
+    }
+
+    if(pInfo){
+        *pInfo = stInfo;
+    }
+    return pImageData;
 }
 
 bool WilImagePackage::SetIndex(uint32_t dwIndex)
 {
     if(false
-            || m_wilFile == nullptr
-            || dwIndex   >= (uint32_t)(m_wilPosition.size())
-            || dwIndex   >= (uint32_t)(m_wixImageInfo.nIndexCount)){
+            || !m_wilMap
+            || dwIndex >= (uint32_t)(m_wilPosition.size())
+            || dwIndex >= (uint32_t)(m_wixImageInfo.nIndexCount)){
 
         m_currentImageValid = false;
         m_currentImageIndex = -1;
@@ -101,33 +192,14 @@ bool WilImagePackage::SetIndex(uint32_t dwIndex)
         return true;
     }
 
-    if(std::fseek(m_wilFile, m_wilPosition[dwIndex], SEEK_SET)){
-        m_currentImageValid = false;
-        return false;
-    }
-
-    if(std::fread(&m_currentWilImageInfo, sizeof(WILIMAGEINFO), 1, m_wilFile) != 1){
+    const auto pImageData = ImageData(dwIndex, &m_currentWilImageInfo);
+    if(!pImageData){
         m_currentImageValid = false;
         return false;
     }
 
-    m_currentImageBuffer.resize(0);
     m_currentImageBuffer.resize(m_currentWilImageInfo.dwImageLength);
-
-    auto nWilOffset = WilOffset(m_wilFileHeader.shVer);
-    if(nWilOffset < 0){
-        m_currentImageValid = false;
-        return false;
-    }
-
-    std::fseek(m_wilFile, m_wilPosition[dwIndex], SEEK_SET);
-    std::fseek(m_wilFile, nWilOffset, SEEK_CUR);
-
-    auto nCurrDataLen = m_currentWilImageInfo.dwImageLength;
-    if(std::fread(&(m_currentImageBuffer[0]), sizeof(uint16_t), nCurrDataLen, m_wilFile) != nCurrDataLen){
-        m_currentImageValid = false;
-        return false;
-    }
+    std::memcpy(m_currentImageBuffer.data(), pImageData, m_currentImageBuffer.size() * sizeof(uint16_t));
 
     m_currentImageValid = true;
     return true;
@@ -140,19 +212,32 @@ bool WilImagePackage::Load(const char* wilFilePath, const char *wilFileName, con
 
     auto fnReleaseFile = [this]()
     {
-        if(m_wilFile){ std::fclose(m_wilFile); m_wilFile = nullptr; }
+        m_wilMap.reset();
+    };
+
+    auto fnMapFile = [](const std::string &szPath) -> std::unique_ptr<MMapFile>
+    {
+        try{
+            return std::make_unique<MMapFile>(szPath.c_str());
+        }
+        catch(...){
+            return {};
+        }
     };
 
     // 2. load wil image library
     fnReleaseFile();
 
-    if(!m_wilFile){ m_wilFile = std::fopen((std::string(wilFilePath) + "/" + wilFileName + ".wil").c_str(), "rb"); }
-    if(!m_wilFile){ m_wilFile = std::fopen((std::string(wilFilePath) + "/" + wilFileName + ".Wil").c_str(), "rb"); }
-    if(!m_wilFile){ m_wilFile = std::fopen((std::string(wilFilePath) + "/" + wilFileName + ".WIL").c_str(), "rb"); }
+    if(!m_wilMap){ m_wilMap = fnMapFile(std::string(wilFilePath) + "/" + wilFileName + ".wil"); }
+    if(!m_wilMap){ m_wilMap = fnMapFile(std::string(wilFilePath) + "/" + wilFileName + ".Wil"); }
+    if(!m_wilMap){ m_wilMap = fnMapFile(std::string(wilFilePath) + "/" + wilFileName + ".WIL"); }
 
-    if(m_wilFile == nullptr){ return false; }
+    if(!m_wilMap){ return false; }
 
-    if(std::fread(&m_wilFileHeader, sizeof(WILFILEHEADER), 1, m_wilFile) != 1){
+    if(auto pHeader = m_wilMap->dataAt(0, sizeof(WILFILEHEADER))){
+        std::memcpy(&m_wilFileHeader, pHeader, sizeof(WILFILEHEADER));
+    }
+    else{
         fnReleaseFile(); return false;
     }
 
@@ -185,6 +270,8 @@ bool WilImagePackage::Load(const char* wilFilePath, const char *wilFileName, con
         std::fclose(hWixFile); fnReleaseFile(); return false;
     }
 
+    std::fclose(hWixFile);
+
     // set current index to an invalid index
     m_currentImageIndex = -1;
     return true;
@@ -215,11 +302,11 @@ const WILIMAGEINFO &WilImagePackage::CurrentImageInfo()
     }
 }
 
-void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2)
+void WilImagePackage::DecodeRLE(uint32_t *rectImageBuffer, const uint8_t *pwSrc, size_t srcLength, int nWidth, int nHeight, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2)
 {
-    auto pwSrc   = &(m_currentImageBuffer[0]);
-    int  nWidth  = m_currentWilImageInfo.shWidth;
-    int  nHeight = m_currentWilImageInfo.shHeight;
+    const Color16To32Table stTable0(dwColor0);
+    const Color16To32Table stTable1(dwColor1);
+    const Color16To32Table stTable2(dwColor2);
 
     size_t srcBeginPos    = 0;
     size_t srcEndPos      = 0;
@@ -227,28 +314,39 @@ void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint3
     size_t dstNowPosInRow = 0;
 
     for(int nRow = 0; nRow < nHeight; ++nRow){
-        srcEndPos     += pwSrc[srcBeginPos++];
+        auto dstRow = rectImageBuffer + (size_t)(nRow) * nWidth;
+        if(srcBeginPos >= srcLength){
+            std::fill_n(dstRow, nWidth, 0X00000000);
+            continue;
+        }
+
+        srcEndPos     += Load16(pwSrc, srcBeginPos++);
         srcNowPos      = srcBeginPos;
         dstNowPosInRow = 0;
 
-        while(srcNowPos < srcEndPos){
-            uint16_t  hdCode  = pwSrc[srcNowPos++];
-            uint16_t  cntCopy = pwSrc[srcNowPos++];
+        while(srcNowPos < srcEndPos && srcNowPos + 2 <= srcLength){
+            const uint16_t hdCode  = Load16(pwSrc, srcNowPos++);
+            const uint16_t cntCopy = Load16(pwSrc, srcNowPos++);
+
+            // never write out of the row
+            // pixels out of the row get overwritten by the next row anyway
+            const size_t cntDst = std::min<size_t>(cntCopy, (size_t)(nWidth) - std::min<size_t>(dstNowPosInRow, nWidth));
+            const size_t cntSrc = std::min<size_t>(cntDst, srcLength - std::min<size_t>(srcNowPos, srcLength));
 
             switch(hdCode){
                 case 0XC0: // jump code
-                    MemSet32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, cntCopy, 0X00000000);
+                    std::fill_n(dstRow + dstNowPosInRow, cntDst, 0X00000000);
                     break;
                 case 0XC1:
-                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, dwColor0);
+                    Memcpy16To32(dstRow + dstNowPosInRow, pwSrc + srcNowPos * 2, cntSrc, stTable0);
                     srcNowPos += cntCopy;
                     break;
                 case 0XC2:
-                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, dwColor1);
+                    Memcpy16To32(dstRow + dstNowPosInRow, pwSrc + srcNowPos * 2, cntSrc, stTable1);
                     srcNowPos += cntCopy;
                     break;
                 case 0XC3:
-                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, dwColor2);
+                    Memcpy16To32(dstRow + dstNowPosInRow, pwSrc + srcNowPos * 2, cntSrc, stTable2);
                     srcNowPos += cntCopy;
                     break;
                 default:
@@ -259,20 +357,48 @@ void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint3
         }
 
         // actually I don't think it's needed here, but put it here
-        MemSet32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, nWidth - dstNowPosInRow, 0X00000000);
+        if(dstNowPosInRow < (size_t)(nWidth)){
+            std::fill_n(dstRow + dstNowPosInRow, nWidth - dstNowPosInRow, 0X00000000);
+        }
+
         srcEndPos++;
         srcBeginPos = srcEndPos;
     }
 }
 
+void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2)
+{
+    DecodeRLE(rectImageBuffer, (const uint8_t *)(m_currentImageBuffer.data()), m_currentImageBuffer.size(), m_currentWilImageInfo.shWidth, m_currentWilImageInfo.shHeight, dwColor0, dwColor1, dwColor2);
+}
+
+std::optional<WILIMAGEINFO> WilImagePackage::ImageInfo(uint32_t dwIndex) const
+{
+    WILIMAGEINFO stInfo;
+    if(ImageData(dwIndex, &stInfo)){
+        return stInfo;
+    }
+    return {};
+}
+
+bool WilImagePackage::DecodeImage(uint32_t dwIndex, uint32_t *rectImageBuffer, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2) const
+{
+    // caller allocates shWidth * shHeight pixels for rectImageBuffer
+    WILIMAGEINFO stInfo;
+    if(const auto pImageData = ImageData(dwIndex, &stInfo)){
+        DecodeRLE(rectImageBuffer, pImageData, stInfo.dwImageLength, stInfo.shWidth, stInfo.shHeight, dwColor0, dwColor1, dwColor2);
+        return true;
+    }
+    return false;
+}
+
 int32_t WilImagePackage::ImageCount()
 {
-    return m_wilFile ? m_wilFileHeader.nImageCount : 0;
+    return m_wilMap ? m_wilFileHeader.nImageCount : 0;
 }
 
 int32_t WilImagePackage::IndexCount()
 {
-    return m_wilFile ? m_wixImageInfo.nIndexCount: 0;
+    return m_wilMap ? m_wixImageInfo.nIndexCount: 0;
 }
 
 bool WilImagePackage::CurrentImageValid()
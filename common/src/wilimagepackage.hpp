@@ -18,10 +18,13 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <cstdio>
 #include <cstdint>
 #include <cstdlib>
+#include <optional>
+#include "mmapfile.hpp"
 
 #pragma pack(push, 1)
 
@@ -69,7 +72,9 @@ class WilImagePackage
         std::vector< int32_t> m_wilPosition;
 
     private:
-        FILE *m_wilFile;
+        // wil file is mapped read-only
+        // ImageInfo() and DecodeImage() only read the mapping and are thread-safe
+        std::unique_ptr<MMapFile> m_wilMap;
 
     public:
         WilImagePackage();
@@ -89,6 +94,12 @@ class WilImagePackage
         bool Load(const char *, const char *, const char *);
         void Decode(uint32_t *, uint32_t, uint32_t, uint32_t);
 
+    public:
+        // thread-safe access by index, doesn't change the current image
+        // multiple threads can decode images from one package in parallel
+        std::optional<WILIMAGEINFO> ImageInfo(uint32_t) const;
+        bool DecodeImage(uint32_t, uint32_t *, uint32_t, uint32_t, uint32_t) const;
+
     public:
         const WILFILEHEADER &HeaderInfo() const;
 
@@ -100,4 +111,10 @@ class WilImagePackage
     public:
         static int WixOffset(int);
         static int WilOffset(int);
+
+    private:
+        const uint8_t *ImageData(uint32_t, WILIMAGEINFO *) const;
+
+    private:
+        static void DecodeRLE(uint32_t *, const uint8_t *, size_t, int, int, uint32_t, uint32_t, uint32_t);
 };
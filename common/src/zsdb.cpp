@@ -16,17 +16,25 @@
  * =====================================================================================
  */
 
+#include <map>
 #include <regex>
+#include <mutex>
 #include <zstd.h>
+#include <zdict.h>
 #include <cstdio>
 #include <cstring>
 #include <stdexcept>
+#include <optional>
 #include <cinttypes>
 #include <algorithm>
 #include <filesystem>
+#include <condition_variable>
 
 #include "zsdb.hpp"
 #include "fileptr.hpp"
+#include "fflerror.hpp"
+#include "raiitimer.hpp"
+#include "threadpool.hpp"
 
 const static int g_compLevel = 3;
 
@@ -151,6 +159,70 @@ static std::vector<uint8_t> decompFileOffData(std::FILE *fp, size_t nDataOff, si
     return decompressDataBuf(stCompBuf.data(), stCompBuf.size(), pDCtx, pDDict);
 }
 
+static std::optional<size_t> frameDataSize(const uint8_t *pDataBuf, size_t nDataLen)
+{
+    if(!pDataBuf || !nDataLen){
+        return {};
+    }
+
+    switch(auto nDecompSize = ZSTD_getFrameContentSize(pDataBuf, nDataLen)){
+        case ZSTD_CONTENTSIZE_ERROR:
+        case ZSTD_CONTENTSIZE_UNKNOWN:
+            {
+                return {};
+            }
+        default:
+            {
+                return check_cast<size_t>(nDecompSize);
+            }
+    }
+}
+
+static bool decompressDataBuf(const uint8_t *pDataBuf, size_t nDataLen, uint8_t *pDstBuf, size_t nDstSize, size_t *pDataSize, ZSTD_DCtx *pDCtx, const ZSTD_DDict *pDDict)
+{
+    const auto nDecompSize = frameDataSize(pDataBuf, nDataLen);
+    if(!nDecompSize.has_value()){
+        return false;
+    }
+
+    if(pDataSize){
+        *pDataSize = nDecompSize.value();
+    }
+
+    if(!pDstBuf || nDstSize < nDecompSize.value()){
+        return false;
+    }
+
+    const size_t nRC = pDDict
+        ? ZSTD_decompress_usingDDict(pDCtx, pDstBuf, nDstSize, pDataBuf, nDataLen, pDDict)
+        : ZSTD_decompressDCtx       (pDCtx, pDstBuf, nDstSize, pDataBuf, nDataLen);
+
+    if(ZSTD_isError(nRC)){
+        return false;
+    }
+
+    if(pDataSize){
+        *pDataSize = nRC;
+    }
+    return true;
+}
+
+static ZSTD_DCtx *getThreadDCtx()
+{
+    // DCtx is not thread-safe but DDict is
+    // every thread keeps its own DCtx and share the DDict owned by ZSDB
+    auto fnFreeDCtx = [](ZSTD_DCtx *pDCtx)
+    {
+        ZSTD_freeDCtx(pDCtx);
+    };
+
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(fnFreeDCtx)> t_DCtx(ZSTD_createDCtx(), fnFreeDCtx);
+    if(!t_DCtx){
+        throw fflerror("failed to create decompress context");
+    }
+    return t_DCtx.get();
+}
+
 const ZSDB::InnEntry &ZSDB::GetErrorEntry()
 {
     const static auto s_ErrorEntry = []() -> InnEntry
@@ -168,17 +240,25 @@ const ZSDB::InnEntry &ZSDB::GetErrorEntry()
     return s_ErrorEntry;
 }
 
-ZSDB::ZSDB(const char *szPath)
+ZSDB::ZSDB(const char *szPath, bool bMMap)
     : m_fp(nullptr)
+    , m_mmapPtr()
+    , m_fileLock()
     , m_DCtx(nullptr)
     , m_DDict(nullptr)
     , m_header()
     , m_entryList()
     , m_fileNameBuf()
+    , m_indexLock()
+    , m_indexList()
 {
-    m_fp = std::fopen(szPath, "rb");
-    if(!m_fp){
-        throw std::runtime_error("failed to open database file");
+    if(bMMap){
+        m_mmapPtr = std::make_unique<MMapFile>(szPath);
+    }else{
+        m_fp = std::fopen(szPath, "rb");
+        if(!m_fp){
+            throw std::runtime_error("failed to open database file");
+        }
     }
 
     m_DCtx = ZSTD_createDCtx();
@@ -186,22 +266,31 @@ ZSDB::ZSDB(const char *szPath)
         throw std::runtime_error("failed to create decompress context");
     }
 
-    if(auto stHeaderData = readFileOffData(m_fp, 0, sizeof(ZSDBHeader)); stHeaderData.empty()){
+    if(auto stHeaderData = ReadRawData(0, sizeof(ZSDBHeader)); stHeaderData.empty()){
         throw std::runtime_error("failed to load izdb header");
     }else{
         std::memcpy(&m_header, stHeaderData.data(), sizeof(m_header));
     }
 
+    const auto fnDecompRange = [this](uint64_t nOffset, uint64_t nLength, const ZSTD_DDict *pDDict) -> std::vector<uint8_t>
+    {
+        auto stCompBuf = ReadRawData(nOffset, nLength);
+        if(!stCompBuf.empty()){
+            if(auto stDataBuf = decompressDataBuf(stCompBuf.data(), stCompBuf.size(), m_DCtx, pDDict); !stDataBuf.empty()){
+                return stDataBuf;
+            }
+        }
+        throw std::runtime_error(std::string("failed to load data at (") + ((std::to_string(nOffset) + ", ") + std::to_string(nLength) + ")"));
+    };
+
     if(m_header.DictLength){
         auto nOffset = check_cast<size_t>(m_header.DictOffset);
         auto nLength = check_cast<size_t>(m_header.DictLength);
-        if(auto stDictBuf = decompFileOffData(m_fp, nOffset, nLength, m_DCtx, m_DDict); stDictBuf.empty()){
-            throw std::runtime_error(std::string("failed to load data at (") + ((std::to_string(nOffset) + ", ") + std::to_string(nLength) + ")"));
-        }else{
-            m_DDict = ZSTD_createDDict(stDictBuf.data(), stDictBuf.size());
-            if(!m_DDict){
-                throw std::runtime_error("create decompression dictory failed");
-            }
+
+        auto stDictBuf = fnDecompRange(nOffset, nLength, m_DDict);
+        m_DDict = ZSTD_createDDict(stDictBuf.data(), stDictBuf.size());
+        if(!m_DDict){
+            throw std::runtime_error("create decompression dictory failed");
         }
     }
 
@@ -209,74 +298,146 @@ ZSDB::ZSDB(const char *szPath)
         auto nOffset = check_cast<size_t>(m_header.EntryOffset);
         auto nLength = check_cast<size_t>(m_header.EntryLength);
 
-        if(auto stEntryBuf = decompFileOffData(m_fp, nOffset, nLength, m_DCtx, m_DDict); stEntryBuf.empty()){
-            throw std::runtime_error(std::string("failed to load data at (") + ((std::to_string(nOffset) + ", ") + std::to_string(nLength) + ")"));
-        }else{
-            if(stEntryBuf.size() != (1 + m_header.EntryNum) * sizeof(InnEntry)){
-                throw std::runtime_error("zsdb database file corrupted");
-            }
+        auto stEntryBuf = fnDecompRange(nOffset, nLength, m_DDict);
+        if(stEntryBuf.size() != (1 + m_header.EntryNum) * sizeof(InnEntry)){
+            throw std::runtime_error("zsdb database file corrupted");
+        }
 
-            auto *pHead = (InnEntry *)(stEntryBuf.data());
-            m_entryList.clear();
-            m_entryList.insert(m_entryList.end(), pHead, pHead + m_header.EntryNum + 1);
+        auto *pHead = (InnEntry *)(stEntryBuf.data());
+        m_entryList.clear();
+        m_entryList.insert(m_entryList.end(), pHead, pHead + m_header.EntryNum + 1);
 
-            if(std::memcmp(&m_entryList.back(), &GetErrorEntry(), sizeof(InnEntry))){
-                throw std::runtime_error("zsdb database file corrupted");
-            }
-            m_entryList.pop_back();
+        if(std::memcmp(&m_entryList.back(), &GetErrorEntry(), sizeof(InnEntry))){
+            throw std::runtime_error("zsdb database file corrupted");
         }
+        m_entryList.pop_back();
     }
 
     if(m_header.FileNameLength){
         auto nOffset = check_cast<size_t>(m_header.FileNameOffset);
         auto nLength = check_cast<size_t>(m_header.FileNameLength);
-        if(auto stFileNameBuf = decompFileOffData(m_fp, nOffset, nLength, m_DCtx, nullptr); stFileNameBuf.empty()){
-            throw std::runtime_error(std::string("failed to load data at (") + ((std::to_string(nOffset) + ", ") + std::to_string(nLength) + ")"));
-        }else{
-            auto *pHead = (char *)(stFileNameBuf.data());
-            m_fileNameBuf.clear();
-            m_fileNameBuf.insert(m_fileNameBuf.end(), pHead, pHead + stFileNameBuf.size());
-        }
+
+        auto stFileNameBuf = fnDecompRange(nOffset, nLength, nullptr);
+        auto *pHead = (char *)(stFileNameBuf.data());
+        m_fileNameBuf.clear();
+        m_fileNameBuf.insert(m_fileNameBuf.end(), pHead, pHead + stFileNameBuf.size());
     }
 }
 
 ZSDB::~ZSDB()
 {
-    std::fclose(m_fp);
+    if(m_fp){
+        std::fclose(m_fp);
+    }
+
     ZSTD_freeDCtx(m_DCtx);
     ZSTD_freeDDict(m_DDict);
 }
 
-const char *ZSDB::Decomp(const char *szFileName, size_t nCheckLen, std::vector<uint8_t> *pDstBuf)
+std::vector<uint8_t> ZSDB::ReadRawData(uint64_t nDataOff, uint64_t nDataLen)
 {
-    if(!szFileName || !std::strlen(szFileName)){
-        return nullptr;
+    if(m_mmapPtr){
+        if(auto pData = m_mmapPtr->dataAt(nDataOff, nDataLen)){
+            return std::vector<uint8_t>(pData, pData + nDataLen);
+        }
+        return {};
     }
+    return readFileOffData(m_fp, check_cast<size_t>(nDataOff), check_cast<size_t>(nDataLen));
+}
 
-    auto p = std::lower_bound(m_entryList.begin(), m_entryList.end(), szFileName, [this, nCheckLen](const InnEntry &lhs, const char *rhs) -> bool
+const std::unordered_map<std::string_view, size_t> &ZSDB::GetIndex(size_t nCheckLen)
+{
     {
+        std::shared_lock<std::shared_mutex> stLockGuard(m_indexLock);
+        if(auto p = m_indexList.find(nCheckLen); p != m_indexList.end()){
+            return p->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> stLockGuard(m_indexLock);
+    if(auto p = m_indexList.find(nCheckLen); p != m_indexList.end()){
+        return p->second;
+    }
+
+    // m_entryList is sorted by file name
+    // only keep the first entry for duplicated keys, same as std::lower_bound()
+    auto &rstIndex = m_indexList[nCheckLen];
+    rstIndex.reserve(m_entryList.size());
+
+    for(size_t nIndex = 0; nIndex < m_entryList.size(); ++nIndex){
+        std::string_view stKey(m_fileNameBuf.data() + m_entryList[nIndex].FileName);
         if(nCheckLen){
-            return std::strncmp(m_fileNameBuf.data() + lhs.FileName, rhs, nCheckLen) < 0;
-        }else{
-            return std::strcmp(m_fileNameBuf.data() + lhs.FileName, rhs) < 0;
+            stKey = stKey.substr(0, nCheckLen);
         }
-    });
+        rstIndex.emplace(stKey, nIndex);
+    }
+    return rstIndex;
+}
 
-    if(p == m_entryList.end()){
+const ZSDB::InnEntry *ZSDB::FindEntry(const char *szFileName, size_t nCheckLen)
+{
+    if(!szFileName || !std::strlen(szFileName)){
         return nullptr;
     }
 
+    // compare by strncmp(lhs, rhs, nCheckLen) equals to compare truncated string_view
+    // because strncmp stops at the first '\0'
+    std::string_view stKey(szFileName);
     if(nCheckLen){
-        if(std::strncmp(szFileName, m_fileNameBuf.data() + p->FileName, nCheckLen)){
-            return nullptr;
-        }
-    }else{
-        if(std::strcmp(szFileName, m_fileNameBuf.data() + p->FileName)){
-            return nullptr;
-        }
+        stKey = stKey.substr(0, nCheckLen);
+    }
+
+    const auto &rstIndex = GetIndex(nCheckLen);
+    if(auto p = rstIndex.find(stKey); p != rstIndex.end()){
+        return &m_entryList[p->second];
+    }
+    return nullptr;
+}
+
+const char *ZSDB::Decomp(const char *szFileName, size_t nCheckLen, std::vector<uint8_t> *pDstBuf)
+{
+    if(auto pEntry = FindEntry(szFileName, nCheckLen)){
+        return ZSDB::DecompEntry(*pEntry, pDstBuf) ? (m_fileNameBuf.data() + pEntry->FileName) : nullptr;
     }
+    return nullptr;
+}
 
-    return ZSDB::DecompEntry(*p, pDstBuf) ? (m_fileNameBuf.data() + p->FileName) : nullptr;
+const char *ZSDB::Decomp(const char *szFileName, size_t nCheckLen, uint8_t *pDstBuf, size_t nDstSize, size_t *pDataSize)
+{
+    if(auto pEntry = FindEntry(szFileName, nCheckLen)){
+        return ZSDB::DecompEntry(*pEntry, pDstBuf, nDstSize, pDataSize) ? (m_fileNameBuf.data() + pEntry->FileName) : nullptr;
+    }
+    return nullptr;
+}
+
+std::optional<size_t> ZSDB::DataSize(const char *szFileName, size_t nCheckLen)
+{
+    const auto pEntry = FindEntry(szFileName, nCheckLen);
+    if(!pEntry){
+        return {};
+    }
+
+    if(!pEntry->Length){
+        return 0;
+    }
+
+    if(!(pEntry->Attribute & F_COMPRESSED)){
+        return check_cast<size_t>(pEntry->Length);
+    }
+
+    if(m_mmapPtr){
+        const auto nLength = check_cast<size_t>(pEntry->Length);
+        return frameDataSize(m_mmapPtr->dataAt(m_header.StreamOffset + pEntry->Offset, nLength), nLength);
+    }
+
+    // only need the frame header to get content size
+    // ZSTD_FRAMEHEADERSIZE_MAX is 18 but only exported with ZSTD_STATIC_LINKING_ONLY
+    const auto nHeaderLen = std::min<size_t>(18, check_cast<size_t>(pEntry->Length));
+    {
+        std::lock_guard<std::mutex> stLockGuard(m_fileLock);
+        auto stHeaderBuf = readFileOffData(m_fp, m_header.StreamOffset + pEntry->Offset, nHeaderLen);
+        return frameDataSize(stHeaderBuf.data(), stHeaderBuf.size());
+    }
 }
 
 bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, std::vector<uint8_t> *pDstBuf)
@@ -290,11 +451,45 @@ bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, std::vector<uint8_t> *pDs
         return true;
     }
 
+    if(m_mmapPtr){
+        const auto nLength = check_cast<size_t>(rstEntry.Length);
+        const auto pData = m_mmapPtr->dataAt(m_header.StreamOffset + rstEntry.Offset, nLength);
+
+        if(!pData){
+            return false;
+        }
+
+        if(!(rstEntry.Attribute & F_COMPRESSED)){
+            pDstBuf->assign(pData, pData + nLength);
+            return true;
+        }
+
+        // decompress directly into pDstBuf
+        // reuse its capacity if caller keeps the buffer across calls
+        const auto nDecompSize = frameDataSize(pData, nLength);
+        if(!nDecompSize.has_value() || !nDecompSize.value()){
+            return false;
+        }
+
+        size_t nDataSize = 0;
+        pDstBuf->resize(nDecompSize.value());
+
+        if(!decompressDataBuf(pData, nLength, pDstBuf->data(), pDstBuf->size(), &nDataSize, getThreadDCtx(), m_DDict)){
+            return false;
+        }
+
+        pDstBuf->resize(nDataSize);
+        return true;
+    }
+
     std::vector<uint8_t> stRetBuf;
-    if(rstEntry.Attribute & F_COMPRESSED){
-        stRetBuf = decompFileOffData(m_fp, m_header.StreamOffset + rstEntry.Offset, rstEntry.Length, m_DCtx, m_DDict);
-    }else{
-        stRetBuf = readFileOffData(m_fp, m_header.StreamOffset + rstEntry.Offset, rstEntry.Length);
+    {
+        std::lock_guard<std::mutex> stLockGuard(m_fileLock);
+        if(rstEntry.Attribute & F_COMPRESSED){
+            stRetBuf = decompFileOffData(m_fp, m_header.StreamOffset + rstEntry.Offset, rstEntry.Length, m_DCtx, m_DDict);
+        }else{
+            stRetBuf = readFileOffData(m_fp, m_header.StreamOffset + rstEntry.Offset, rstEntry.Length);
+        }
     }
 
     if(stRetBuf.empty()){
@@ -305,6 +500,48 @@ bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, std::vector<uint8_t> *pDs
     return true;
 }
 
+bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, uint8_t *pDstBuf, size_t nDstSize, size_t *pDataSize)
+{
+    if(!rstEntry.Length){
+        if(pDataSize){
+            *pDataSize = 0;
+        }
+        return true;
+    }
+
+    const auto nLength = check_cast<size_t>(rstEntry.Length);
+    const auto fnCopyOrDecomp = [&rstEntry, nLength, pDstBuf, nDstSize, pDataSize](const uint8_t *pData, ZSTD_DCtx *pDCtx, const ZSTD_DDict *pDDict) -> bool
+    {
+        if(rstEntry.Attribute & F_COMPRESSED){
+            return decompressDataBuf(pData, nLength, pDstBuf, nDstSize, pDataSize, pDCtx, pDDict);
+        }
+
+        if(pDataSize){
+            *pDataSize = nLength;
+        }
+
+        if(!pDstBuf || nDstSize < nLength){
+            return false;
+        }
+
+        std::memcpy(pDstBuf, pData, nLength);
+        return true;
+    };
+
+    if(m_mmapPtr){
+        if(auto pData = m_mmapPtr->dataAt(m_header.StreamOffset + rstEntry.Offset, nLength)){
+            return fnCopyOrDecomp(pData, getThreadDCtx(), m_DDict);
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> stLockGuard(m_fileLock);
+    if(auto stReadBuf = readFileOffData(m_fp, m_header.StreamOffset + rstEntry.Offset, nLength); !stReadBuf.empty()){
+        return fnCopyOrDecomp(stReadBuf.data(), m_DCtx, m_DDict);
+    }
+    return false;
+}
+
 std::vector<ZSDB::Entry> ZSDB::GetEntryList() const
 {
     std::vector<ZSDB::Entry> stRetBuf;
@@ -314,134 +551,629 @@ std::vector<ZSDB::Entry> ZSDB::GetEntryList() const
     return stRetBuf;
 }
 
-bool ZSDB::BuildDB(const char *szSaveFullName, const char *szFileNameRegex, const char *szDataPath, const char *szDictPath, double fCompRatio)
+static std::vector<uint8_t> trainDictData(const std::vector<std::filesystem::path> &rstFileList, size_t nDictSize, size_t nSampleSize)
 {
-    if(!szSaveFullName){
-        return false;
+    if(rstFileList.empty() || !nDictSize){
+        return {};
     }
 
-    if(!szDataPath){
-        return false;
+    // zstd only learns from the beginning of each sample
+    // truncate big files and pick samples evenly from the sorted file list
+    constexpr size_t nMaxSampleLen = 128 * 1024;
+    if(!nSampleSize){
+        nSampleSize = nDictSize * 100;
     }
 
-    ZSTD_CDict *pCDict = nullptr;
-    std::vector<uint8_t> stCDictBuf;
-
-    if(szDictPath){
-        stCDictBuf = readFileData(szDictPath);
-        if(stCDictBuf.empty()){
-            return false;
+    uint64_t nTotalLen = 0;
+    for(const auto &rstPath: rstFileList){
+        std::error_code stEC;
+        if(const auto nFileLen = std::filesystem::file_size(rstPath, stEC); !stEC){
+            nTotalLen += std::min<uint64_t>(nFileLen, nMaxSampleLen);
         }
+    }
 
-        pCDict = ZSTD_createCDict(stCDictBuf.data(), stCDictBuf.size(), g_compLevel);
-        if(!pCDict){
-            return false;
+    const size_t nStride = std::max<size_t>(1, check_cast<size_t>((nTotalLen + nSampleSize - 1) / nSampleSize));
+
+    std::vector<uint8_t> stSampleBuf;
+    std::vector<size_t> stSampleSizeList;
+
+    for(size_t nIndex = 0; nIndex < rstFileList.size() && stSampleBuf.size() < nSampleSize; nIndex += nStride){
+        const auto stDataBuf = readFileData(rstFileList[nIndex].u8string().c_str());
+        if(stDataBuf.empty()){
+            continue;
         }
+
+        const auto nLength = std::min<size_t>(stDataBuf.size(), nMaxSampleLen);
+        stSampleBuf.insert(stSampleBuf.end(), stDataBuf.begin(), stDataBuf.begin() + nLength);
+        stSampleSizeList.push_back(nLength);
     }
 
-    ZSTD_CCtx *pCCtx = ZSTD_createCCtx();
-    if(!pCCtx){
-        return false;
+    std::vector<uint8_t> stDictBuf(nDictSize);
+    const auto nRC = ZDICT_trainFromBuffer(stDictBuf.data(), stDictBuf.size(), stSampleBuf.data(), stSampleSizeList.data(), check_cast<unsigned>(stSampleSizeList.size()));
+
+    // fails if samples are too few or too small
+    // caller builds without dictionary
+    if(ZDICT_isError(nRC)){
+        return {};
     }
 
-    std::vector<char> stFileNameBuf;
-    std::vector<uint8_t> stStreamBuf;
-    std::vector<InnEntry> stEntryList;
+    stDictBuf.resize(nRC);
+    return stDictBuf;
+}
 
-    size_t nCount = 0;
-    std::regex stFileNameReg(szFileNameRegex ? szFileNameRegex : ".*");
+std::optional<ZSDB::BuildReport> ZSDB::BuildDB(const char *szSaveFullName, const char *szDataPath, const ZSDB::BuildOption &rstOption)
+{
+    if(!szSaveFullName){
+        return {};
+    }
+
+    if(!szDataPath){
+        return {};
+    }
+
+    hres_timer stBuildTimer;
+    BuildReport stReport;
+
+    std::vector<std::filesystem::path> stFileList;
+    std::regex stFileNameReg(rstOption.FileNameRegex ? rstOption.FileNameRegex : ".*");
 
     for(auto &p: std::filesystem::directory_iterator(szDataPath)){
         if(!p.is_regular_file()){
             continue;
         }
 
-        auto szFileName = p.path().filename().u8string();
-        if(szFileNameRegex){
-            if(!std::regex_match(szFileName.c_str(), stFileNameReg)){
+        if(rstOption.FileNameRegex){
+            if(!std::regex_match(p.path().filename().u8string(), stFileNameReg)){
                 continue;
             }
         }
+        stFileList.push_back(p.path());
+    }
 
-        auto stSrcBuf = readFileData(p.path().u8string().c_str());
-        if(stSrcBuf.empty()){
-            continue;
+    // entries get written in this order
+    // the entry table is sorted by file name anyway, keep the stream layout deterministic
+    std::sort(stFileList.begin(), stFileList.end(), [](const auto &lhs, const auto &rhs) -> bool
+    {
+        return lhs.filename().u8string() < rhs.filename().u8string();
+    });
+
+    std::vector<uint8_t> stDictBuf;
+    if(rstOption.DictPath){
+        stDictBuf = readFileData(rstOption.DictPath);
+        if(stDictBuf.empty()){
+            return {};
+        }
+    }
+    else if(rstOption.TrainDictSize){
+        hres_timer stTrainTimer;
+        stDictBuf = trainDictData(stFileList, rstOption.TrainDictSize, rstOption.TrainSampleSize);
+
+        stReport.DictTrained = !stDictBuf.empty();
+        stReport.TrainTime = stTrainTimer.diff_nsec() / 1000000000.0;
+
+        if(!stDictBuf.empty() && rstOption.SaveDictPath){
+            auto fpDict = make_fileptr(rstOption.SaveDictPath, "wb");
+            if(!fpDict){
+                return {};
+            }
+
+            if(std::fwrite(stDictBuf.data(), stDictBuf.size(), 1, fpDict.get()) != 1){
+                return {};
+            }
+        }
+    }
+
+    std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> pCDict(nullptr, ZSTD_freeCDict);
+    if(!stDictBuf.empty()){
+        pCDict.reset(ZSTD_createCDict(stDictBuf.data(), stDictBuf.size(), g_compLevel));
+        if(!pCDict){
+            return {};
+        }
+    }
+
+    // CDict is read-only and shared by all threads
+    // CCtx is per thread, the last one is used by the writer thread
+    const size_t nThreadCount = ThreadPool::getThreadCount(rstOption.ThreadCount);
+    std::vector<std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)>> stCCtxList;
+
+    for(size_t i = 0; i < nThreadCount + 1; ++i){
+        stCCtxList.emplace_back(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        if(!stCCtxList.back()){
+            return {};
+        }
+    }
+
+    auto fp = make_fileptr(szSaveFullName, "wb");
+    if(!fp){
+        return {};
+    }
+
+    // header gets rewritten when all offsets are known
+    // readers use absolute offsets, so the tables can go after the stream
+    ZSDBHeader stHeader;
+    std::memset(&stHeader, 0, sizeof(stHeader));
+
+    if(std::fwrite(&stHeader, sizeof(stHeader), 1, fp.get()) != 1){
+        return {};
+    }
+
+    // dictionary is stored compressed without dictionary
+    // which is how ZSDB::ZSDB() loads it
+    std::vector<uint8_t> stDictCompBuf;
+    if(!stDictBuf.empty()){
+        stDictCompBuf = compressDataBuf(stDictBuf.data(), stDictBuf.size(), stCCtxList.back().get(), nullptr);
+        if(stDictCompBuf.empty()){
+            return {};
+        }
+
+        if(std::fwrite(stDictCompBuf.data(), stDictCompBuf.size(), 1, fp.get()) != 1){
+            return {};
+        }
+    }
+
+    struct BuildSlot
+    {
+        bool Done       = false;
+        bool Compressed = false;
+
+        size_t SrcSize = 0;
+        std::string Error;
+        std::vector<uint8_t> DataBuf;
+    };
+
+    std::mutex stSlotLock;
+    std::condition_variable stSlotCond;
+    std::vector<BuildSlot> stSlotList(stFileList.size());
+
+    const auto fnBuildSlot = [&stFileList, &stCCtxList, &pCDict, &rstOption](size_t nIndex, int nThreadID) -> BuildSlot
+    {
+        BuildSlot stSlot;
+        try{
+            auto stSrcBuf = readFileData(stFileList[nIndex].u8string().c_str());
+            if(stSrcBuf.empty()){
+                return stSlot;
+            }
+
+            auto stDstBuf = compressDataBuf(stSrcBuf.data(), stSrcBuf.size(), stCCtxList.at(nThreadID).get(), pCDict.get());
+            if(stDstBuf.empty()){
+                return stSlot;
+            }
+
+            stSlot.SrcSize = stSrcBuf.size();
+            stSlot.Compressed = ((1.00 * stDstBuf.size() / stSrcBuf.size()) < rstOption.CompRatio);
+            stSlot.DataBuf.swap(stSlot.Compressed ? stDstBuf : stSrcBuf);
+        }
+        catch(const std::exception &e){
+            stSlot.Error = e.what();
         }
+        return stSlot;
+    };
 
-        auto stDstBuf = compressDataBuf(stSrcBuf.data(), stSrcBuf.size(), pCCtx, pCDict);
-        if(stDstBuf.empty()){
+    // declared after everything the tasks reference
+    // on early return the pool gets finished before they are destroyed
+    ThreadPool stPool(nThreadCount);
+
+    size_t nSubmitCount = 0;
+    const auto fnSubmit = [&stPool, &stSlotLock, &stSlotCond, &stSlotList, &fnBuildSlot, &nSubmitCount]()
+    {
+        stPool.addTask([nIndex = nSubmitCount, &stSlotLock, &stSlotCond, &stSlotList, &fnBuildSlot](int nThreadID)
+        {
+            auto stSlot = fnBuildSlot(nIndex, nThreadID);
+            {
+                std::lock_guard<std::mutex> stLockGuard(stSlotLock);
+                stSlotList[nIndex] = std::move(stSlot);
+                stSlotList[nIndex].Done = true;
+            }
+            stSlotCond.notify_all();
+        });
+        nSubmitCount++;
+    };
+
+    // limit entries in flight
+    // finished entries wait in memory until all entries before them are written
+    const size_t nWindowSize = stPool.poolSize * 4;
+    while(nSubmitCount < std::min<size_t>(nWindowSize, stFileList.size())){
+        fnSubmit();
+    }
+
+    std::vector<char> stFileNameBuf;
+    std::vector<InnEntry> stEntryList;
+    uint64_t nStreamLength = 0;
+
+    for(size_t nIndex = 0; nIndex < stFileList.size(); ++nIndex){
+        BuildSlot stSlot;
+        {
+            std::unique_lock<std::mutex> stLockGuard(stSlotLock);
+            stSlotCond.wait(stLockGuard, [&stSlotList, nIndex]() -> bool
+            {
+                return stSlotList[nIndex].Done;
+            });
+            stSlot = std::move(stSlotList[nIndex]);
+        }
+
+        if(nSubmitCount < stFileList.size()){
+            fnSubmit();
+        }
+
+        if(!stSlot.Error.empty()){
+            throw fflerror("failed to build entry %s: %s", stFileList[nIndex].u8string().c_str(), stSlot.Error.c_str());
+        }
+
+        if(stSlot.DataBuf.empty()){
+            stReport.SkippedCount++;
             continue;
         }
 
-        bool bCompressed = ((1.00 * stDstBuf.size() / stSrcBuf.size()) < fCompRatio);
-        auto &rstCurrBuf = bCompressed ? stDstBuf : stSrcBuf;
+        if(std::fwrite(stSlot.DataBuf.data(), stSlot.DataBuf.size(), 1, fp.get()) != 1){
+            return {};
+        }
 
         InnEntry stEntry;
         std::memset(&stEntry, 0, sizeof(stEntry));
 
-        stEntry.Offset = stStreamBuf.size();
-        stEntry.Length = rstCurrBuf.size();
-        stStreamBuf.insert(stStreamBuf.end(), rstCurrBuf.begin(), rstCurrBuf.end());
+        stEntry.Offset = nStreamLength;
+        stEntry.Length = stSlot.DataBuf.size();
 
+        const auto szFileName = stFileList[nIndex].filename().u8string();
         stEntry.FileName = stFileNameBuf.size();
         stFileNameBuf.insert(stFileNameBuf.end(), szFileName.begin(), szFileName.end());
         stFileNameBuf.push_back('\0');
 
-        if(bCompressed){
+        if(stSlot.Compressed){
             stEntry.Attribute |= F_COMPRESSED;
+            stReport.CompressedCount++;
         }
 
         stEntryList.push_back(stEntry);
-        nCount++;
+        nStreamLength += stSlot.DataBuf.size();
+
+        stReport.FileCount++;
+        stReport.SrcBytes += stSlot.SrcSize;
+        stReport.DstBytes += stSlot.DataBuf.size();
     }
 
-    std::sort(stEntryList.begin(), stEntryList.end(), [&stFileNameBuf](const InnEntry &lhs, const InnEntry &rhs) -> bool
+    stPool.finish();
+
+    stHeader.ZStdVersion = ZSTD_versionNumber();
+    stHeader.DictOffset  = sizeof(stHeader);
+    stHeader.DictLength  = stDictCompBuf.size();
+
+    stHeader.StreamOffset = stHeader.DictOffset + stHeader.DictLength;
+    stHeader.StreamLength = nStreamLength;
+
+    if(!WriteIndex(fp.get(), stHeader, stEntryList, stFileNameBuf, stCCtxList.back().get(), pCDict.get())){
+        return {};
+    }
+
+    stReport.DictBytes = stDictBuf.size();
+    stReport.BuildTime = stBuildTimer.diff_nsec() / 1000000000.0;
+    return stReport;
+}
+
+bool ZSDB::BuildDB(const char *szSaveFullName, const char *szFileNameRegex, const char *szDataPath, const char *szDictPath, double fCompRatio)
+{
+    BuildOption stOption;
+    stOption.FileNameRegex = szFileNameRegex;
+    stOption.DictPath      = szDictPath;
+    stOption.CompRatio     = fCompRatio;
+
+    return BuildDB(szSaveFullName, szDataPath, stOption).has_value();
+}
+
+bool ZSDB::WriteIndex(std::FILE *fp, ZSDB::ZSDBHeader &rstHeader, std::vector<InnEntry> &rstEntryList, const std::vector<char> &rstFileNameBuf, ZSTD_CCtx *pCCtx, const ZSTD_CDict *pCDict)
+{
+    // write entry table and file name table right after the stream
+    // then rewrite the header, a crash before it leaves the previous index untouched
+    std::sort(rstEntryList.begin(), rstEntryList.end(), [&rstFileNameBuf](const InnEntry &lhs, const InnEntry &rhs) -> bool
     {
-        return std::strcmp(stFileNameBuf.data() + lhs.FileName, stFileNameBuf.data() + rhs.FileName) < 0;
+        return std::strcmp(rstFileNameBuf.data() + lhs.FileName, rstFileNameBuf.data() + rhs.FileName) < 0;
     });
 
-    stEntryList.push_back(GetErrorEntry());
-
-    ZSDBHeader stHeader;
-    std::memset(&stHeader, 0, sizeof(stHeader));
+    rstHeader.EntryNum = rstEntryList.size();
+    rstEntryList.push_back(GetErrorEntry());
 
-    stHeader.ZStdVersion = ZSTD_versionNumber();
-    stHeader.EntryNum    = nCount;
+    // entry table is loaded with the DDict, file name table without
+    auto stEntryCompBuf = compressDataBuf((uint8_t *)(rstEntryList.data()), rstEntryList.size() * sizeof(InnEntry), pCCtx, pCDict);
+    rstHeader.EntryOffset = rstHeader.StreamOffset + rstHeader.StreamLength;
+    rstHeader.EntryLength = stEntryCompBuf.size();
+    rstEntryList.pop_back();
 
-    stHeader.DictOffset = sizeof(stHeader);
-    stHeader.DictLength = stCDictBuf.size();
+    auto stFileNameCompBuf = compressDataBuf((uint8_t *)(rstFileNameBuf.data()), rstFileNameBuf.size(), pCCtx, nullptr);
+    rstHeader.FileNameOffset = rstHeader.EntryOffset + rstHeader.EntryLength;
+    rstHeader.FileNameLength = stFileNameCompBuf.size();
 
-    auto stEntryCompBuf = compressDataBuf((uint8_t *)(stEntryList.data()), stEntryList.size() * sizeof(InnEntry), pCCtx, nullptr);
-    stHeader.EntryOffset = stHeader.DictOffset + stHeader.DictLength;
-    stHeader.EntryLength = stEntryCompBuf.size();
+    if(std::fseek(fp, check_cast<long>(rstHeader.EntryOffset), SEEK_SET)){
+        return false;
+    }
 
-    auto stFileNameCompBuf = compressDataBuf((uint8_t *)(stFileNameBuf.data()), stFileNameBuf.size(), pCCtx, nullptr);
-    stHeader.FileNameOffset = stHeader.EntryOffset + stHeader.EntryLength;
-    stHeader.FileNameLength = stFileNameCompBuf.size();
+    if(std::fwrite(stEntryCompBuf.data(), stEntryCompBuf.size(), 1, fp) != 1){
+        return false;
+    }
 
-    stHeader.StreamOffset = stHeader.FileNameOffset + stHeader.FileNameLength;
-    stHeader.StreamLength = stStreamBuf.size();
+    if(!stFileNameCompBuf.empty()){
+        if(std::fwrite(stFileNameCompBuf.data(), stFileNameCompBuf.size(), 1, fp) != 1){
+            return false;
+        }
+    }
 
-    auto fp = make_fileptr(szSaveFullName, "wb");
-    if(!fp){
+    // index must be on disk before the header points to it
+    if(std::fflush(fp)){
         return false;
     }
 
-    if(std::fwrite(&stHeader, sizeof(stHeader), 1, fp.get()) != 1){
+    if(std::fseek(fp, 0, SEEK_SET)){
         return false;
     }
 
-    if(std::fwrite(stEntryCompBuf.data(), stEntryCompBuf.size(), 1, fp.get()) != 1){
+    if(std::fwrite(&rstHeader, sizeof(rstHeader), 1, fp) != 1){
         return false;
     }
+    return std::fflush(fp) == 0;
+}
+
+std::vector<uint8_t> ZSDB::LoadDictData()
+{
+    if(!m_header.DictLength){
+        return {};
+    }
 
-    if(std::fwrite(stFileNameCompBuf.data(), stFileNameCompBuf.size(), 1, fp.get()) != 1){
+    auto stCompBuf = ReadRawData(m_header.DictOffset, m_header.DictLength);
+    if(stCompBuf.empty()){
+        throw fflerror("failed to read dictionary");
+    }
+
+    auto stDictBuf = decompressDataBuf(stCompBuf.data(), stCompBuf.size(), m_DCtx, nullptr);
+    if(stDictBuf.empty()){
+        throw fflerror("failed to decompress dictionary");
+    }
+    return stDictBuf;
+}
+
+std::optional<ZSDB::PatchReport> ZSDB::PatchDB(const char *szDBPath, const char *szDataPath, const ZSDB::PatchOption &rstOption)
+{
+    if(!szDBPath){
+        return {};
+    }
+
+    hres_timer stPatchTimer;
+    PatchReport stReport;
+
+    ZSDBHeader stHeader;
+    std::vector<uint8_t> stDictBuf;
+
+    // InnEntry::FileName is meaningless in this map
+    // the file name table is rebuilt from its keys, names of removed entries get dropped
+    std::map<std::string, InnEntry> stEntryMap;
+    {
+        ZSDB stDB(szDBPath);
+        stHeader  = stDB.m_header;
+        stDictBuf = stDB.LoadDictData();
+
+        for(const auto &rstEntry: stDB.m_entryList){
+            stEntryMap.emplace(stDB.m_fileNameBuf.data() + rstEntry.FileName, rstEntry);
+        }
+    }
+
+    // removing an entry only drops it from the index
+    // its data stays in the stream as garbage until CompactDB()
+    if(rstOption.RemoveRegex){
+        std::regex stRemoveReg(rstOption.RemoveRegex);
+        for(auto p = stEntryMap.begin(); p != stEntryMap.end();){
+            if(std::regex_match(p->first, stRemoveReg)){
+                p = stEntryMap.erase(p);
+                stReport.RemoveCount++;
+            }
+            else{
+                ++p;
+            }
+        }
+    }
+
+    std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> pCDict(nullptr, ZSTD_freeCDict);
+    if(!stDictBuf.empty()){
+        pCDict.reset(ZSTD_createCDict(stDictBuf.data(), stDictBuf.size(), g_compLevel));
+        if(!pCDict){
+            return {};
+        }
+    }
+
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> pCCtx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if(!pCCtx){
+        return {};
+    }
+
+    auto fp = make_fileptr(szDBPath, "r+b");
+    if(std::fseek(fp.get(), 0, SEEK_END)){
+        return {};
+    }
+
+    // append after everything, including the current index
+    // new entries may point before or after the old index, offset is still relative to StreamOffset
+    uint64_t nAppendOffset = check_cast<uint64_t>(std::ftell(fp.get()));
+    if(szDataPath){
+        std::regex stFileNameReg(rstOption.FileNameRegex ? rstOption.FileNameRegex : ".*");
+        for(auto &p: std::filesystem::directory_iterator(szDataPath)){
+            if(!p.is_regular_file()){
+                continue;
+            }
+
+            auto szFileName = p.path().filename().u8string();
+            if(rstOption.FileNameRegex){
+                if(!std::regex_match(szFileName, stFileNameReg)){
+                    continue;
+                }
+            }
+
+            auto stSrcBuf = readFileData(p.path().u8string().c_str());
+            if(stSrcBuf.empty()){
+                continue;
+            }
+
+            auto stDstBuf = compressDataBuf(stSrcBuf.data(), stSrcBuf.size(), pCCtx.get(), pCDict.get());
+            if(stDstBuf.empty()){
+                continue;
+            }
+
+            const bool bCompressed = ((1.00 * stDstBuf.size() / stSrcBuf.size()) < rstOption.CompRatio);
+            const auto &rstCurrBuf = bCompressed ? stDstBuf : stSrcBuf;
+
+            if(std::fwrite(rstCurrBuf.data(), rstCurrBuf.size(), 1, fp.get()) != 1){
+                return {};
+            }
+
+            InnEntry stEntry;
+            std::memset(&stEntry, 0, sizeof(stEntry));
+
+            stEntry.Offset = nAppendOffset - stHeader.StreamOffset;
+            stEntry.Length = rstCurrBuf.size();
+
+            if(bCompressed){
+                stEntry.Attribute |= F_COMPRESSED;
+            }
+
+            nAppendOffset += rstCurrBuf.size();
+            if(stEntryMap.insert_or_assign(szFileName, stEntry).second){
+                stReport.AddCount++;
+            }
+            else{
+                stReport.ReplaceCount++;
+            }
+        }
+    }
+
+    std::vector<char> stFileNameBuf;
+    std::vector<InnEntry> stEntryList;
+
+    for(const auto &[szFileName, rstEntry]: stEntryMap){
+        auto stEntry = rstEntry;
+        stEntry.FileName = stFileNameBuf.size();
+        stFileNameBuf.insert(stFileNameBuf.end(), szFileName.begin(), szFileName.end());
+        stFileNameBuf.push_back('\0');
+
+        stEntryList.push_back(stEntry);
+        stReport.LiveBytes += stEntry.Length;
+    }
+
+    stHeader.StreamLength = nAppendOffset - stHeader.StreamOffset;
+    if(!WriteIndex(fp.get(), stHeader, stEntryList, stFileNameBuf, pCCtx.get(), pCDict.get())){
+        return {};
+    }
+
+    // everything in the stream not referenced by the new index
+    stReport.DeadBytes = stHeader.StreamLength - stReport.LiveBytes;
+    stReport.FileBytes = stHeader.FileNameOffset + stHeader.FileNameLength;
+    stReport.PatchTime = stPatchTimer.diff_nsec() / 1000000000.0;
+    return stReport;
+}
+
+bool ZSDB::CompactDB(const char *szDBPath, const char *szOutPath)
+{
+    if(!szDBPath){
         return false;
     }
 
-    if(std::fwrite(stStreamBuf.data(), stStreamBuf.size(), 1, fp.get()) != 1){
+    // write to a temporary file and rename if compacting in place
+    // the original database stays valid if anything fails
+    const std::string szSavePath = szOutPath ? std::string(szOutPath) : (std::string(szDBPath) + ".compact");
+    const auto fnCompact = [szDBPath, &szSavePath]() -> bool
+    {
+        ZSDB stDB(szDBPath, true);
+        auto fp = make_fileptr(szSavePath.c_str(), "wb");
+
+        ZSDBHeader stHeader = stDB.m_header;
+        if(std::fwrite(&stHeader, sizeof(stHeader), 1, fp.get()) != 1){
+            return false;
+        }
+
+        // copy the compressed dictionary and entries as they are
+        // no recompression, compaction only drops garbage
+        std::vector<uint8_t> stDictCompBuf;
+        if(stHeader.DictLength){
+            stDictCompBuf = stDB.ReadRawData(stHeader.DictOffset, stHeader.DictLength);
+            if(stDictCompBuf.empty()){
+                return false;
+            }
+
+            if(std::fwrite(stDictCompBuf.data(), stDictCompBuf.size(), 1, fp.get()) != 1){
+                return false;
+            }
+        }
+
+        stHeader.DictOffset   = sizeof(stHeader);
+        stHeader.StreamOffset = stHeader.DictOffset + stHeader.DictLength;
+
+        uint64_t nStreamLength = 0;
+        auto stEntryList = stDB.m_entryList;
+
+        for(auto &rstEntry: stEntryList){
+            if(rstEntry.Length){
+                const auto pData = stDB.m_mmapPtr->dataAt(stDB.m_header.StreamOffset + rstEntry.Offset, check_cast<size_t>(rstEntry.Length));
+                if(!pData){
+                    return false;
+                }
+
+                if(std::fwrite(pData, check_cast<size_t>(rstEntry.Length), 1, fp.get()) != 1){
+                    return false;
+                }
+            }
+
+            rstEntry.Offset = nStreamLength;
+            nStreamLength += rstEntry.Length;
+        }
+
+        stHeader.StreamLength = nStreamLength;
+        const auto stDictBuf = stDB.LoadDictData();
+
+        std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> pCDict(nullptr, ZSTD_freeCDict);
+        if(!stDictBuf.empty()){
+            pCDict.reset(ZSTD_createCDict(stDictBuf.data(), stDictBuf.size(), g_compLevel));
+            if(!pCDict){
+                return false;
+            }
+        }
+
+        std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> pCCtx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        if(!pCCtx){
+            return false;
+        }
+
+        if(!WriteIndex(fp.get(), stHeader, stEntryList, stDB.m_fileNameBuf, pCCtx.get(), pCDict.get())){
+            return false;
+        }
+        return true;
+    };
+
+    // temporary file is useless if anything fails, don't leave it on disk
+    // an explicit output path may be an existing file of the caller, keep it
+    const auto fnRemoveTemp = [szOutPath, &szSavePath]()
+    {
+        if(!szOutPath){
+            std::error_code stEC;
+            std::filesystem::remove(szSavePath, stEC);
+        }
+    };
+
+    bool bCompacted = false;
+    try{
+        bCompacted = fnCompact();
+    }catch(...){
+        fnRemoveTemp();
+        throw;
+    }
+
+    if(!bCompacted){
+        fnRemoveTemp();
         return false;
     }
 
+    if(!szOutPath){
+        std::error_code stEC;
+        std::filesystem::rename(szSavePath, szDBPath, stEC);
+
+        if(stEC){
+            fnRemoveTemp();
+            return false;
+        }
+    }
     return true;
 }
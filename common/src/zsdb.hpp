@@ -17,9 +17,16 @@
  */
 
 #pragma once
+#include <mutex>
 #include <vector>
+#include <memory>
 #include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
 #include "zstd.h"
+#include "mmapfile.hpp"
 
 class ZSDB final
 {
@@ -73,7 +80,14 @@ class ZSDB final
 #pragma pack(pop)
 
     private:
+        // only one of them is valid
+        // mmap mode maps the whole database and decompresses with per-thread DCtx, thread-safe without lock
+        // file mode reads by m_fp and decompresses by m_DCtx, every access is serialized by m_fileLock
         std::FILE *m_fp;
+        std::unique_ptr<MMapFile> m_mmapPtr;
+
+    private:
+        std::mutex m_fileLock;
 
     private:
         ZSTD_DCtx  *m_DCtx;
@@ -88,17 +102,47 @@ class ZSDB final
     private:
         std::vector<char> m_fileNameBuf;
 
+    private:
+        // hash index of m_entryList, key is the file name truncated by nCheckLen
+        // built lazily per nCheckLen, nCheckLen = 0 means the full file name
+        std::shared_mutex m_indexLock;
+        std::unordered_map<size_t, std::unordered_map<std::string_view, size_t>> m_indexList;
+
     public:
-        ZSDB(const char *);
+        ZSDB(const char *, bool = false);
 
     public:
         ~ZSDB();
 
     public:
+        // decompress the first entry matches szFileName in nCheckLen chars
+        // return the full file name of the matched entry, or nullptr if not found or failed
         const char *Decomp(const char *, size_t, std::vector<uint8_t> *);
 
+    public:
+        // decompress into caller-provided buffer, fails if buffer size is less than DataSize()
+        // the last argument gets the decompressed data size if not null
+        const char *Decomp(const char *, size_t, uint8_t *, size_t, size_t *);
+
+    public:
+        std::optional<size_t> DataSize(const char *, size_t);
+
+    public:
+        bool IsMMap() const
+        {
+            return m_mmapPtr != nullptr;
+        }
+
+    private:
+        const InnEntry *FindEntry(const char *, size_t);
+        const std::unordered_map<std::string_view, size_t> &GetIndex(size_t);
+
+    private:
+        std::vector<uint8_t> ReadRawData(uint64_t, uint64_t);
+
     private:
         bool DecompEntry(const InnEntry &, std::vector<uint8_t> *);
+        bool DecompEntry(const InnEntry &, uint8_t *, size_t, size_t *);
 
     private:
         static const InnEntry &GetErrorEntry();
@@ -106,6 +150,80 @@ class ZSDB final
     public:
         std::vector<ZSDB::Entry> GetEntryList() const;
 
+    public:
+        struct BuildOption
+        {
+            const char *FileNameRegex = nullptr;
+            const char *DictPath      = nullptr;    // compress with an existing dictionary
+            const char *SaveDictPath  = nullptr;    // save the trained dictionary if not null
+
+            double CompRatio   = 0.90;              // keep compressed data only if dst/src is less than it
+            size_t ThreadCount = 0;                 // 0 means std::thread::hardware_concurrency()
+
+            size_t TrainDictSize   = 0;             // train a dictionary with this size if no DictPath given, 0 disables training
+            size_t TrainSampleSize = 0;             // total bytes of training samples, 0 means 100 x TrainDictSize
+        };
+
+        struct BuildReport
+        {
+            size_t FileCount       = 0;
+            size_t CompressedCount = 0;
+            size_t SkippedCount    = 0;
+
+            uint64_t SrcBytes  = 0;
+            uint64_t DstBytes  = 0;
+            uint64_t DictBytes = 0;
+
+            bool DictTrained = false;
+
+            double TrainTime = 0.0;                 // in seconds
+            double BuildTime = 0.0;                 // in seconds, includes TrainTime
+        };
+
+    public:
+        // compress files across a thread pool and stream them to disk in file name order
+        // memory is bounded by the number of in-flight entries, not by the database size
+        static std::optional<BuildReport> BuildDB(const char *, const char *, const BuildOption &);
+
     public:
         static bool BuildDB(const char *, const char *, const char *, const char *, double);
+
+    public:
+        struct PatchOption
+        {
+            const char *FileNameRegex = nullptr;    // files to add or replace in the data dir
+            const char *RemoveRegex   = nullptr;    // entries to remove, applied before adding
+
+            double CompRatio = 0.90;
+        };
+
+        struct PatchReport
+        {
+            size_t AddCount     = 0;
+            size_t ReplaceCount = 0;
+            size_t RemoveCount  = 0;
+
+            uint64_t LiveBytes = 0;                 // stream bytes referenced by the index
+            uint64_t DeadBytes = 0;                 // stream bytes of removed or replaced entries
+            uint64_t FileBytes = 0;
+
+            double PatchTime = 0.0;                 // in seconds
+        };
+
+    public:
+        // append new entries to an existing database and rewrite its index after them
+        // old data is never touched, the header gets written last and switches to the new index
+        // works with databases from any version of BuildDB(), output is readable by old readers
+        static std::optional<PatchReport> PatchDB(const char *, const char *, const PatchOption &);
+
+    public:
+        // copy live entries into a new database, drops garbage left by PatchDB()
+        // compacts in place if output path is null
+        static bool CompactDB(const char *, const char *);
+
+    private:
+        std::vector<uint8_t> LoadDictData();
+
+    private:
+        static bool WriteIndex(std::FILE *, ZSDBHeader &, std::vector<InnEntry> &, const std::vector<char> &, ZSTD_CCtx *, const ZSTD_CDict *);
 };
@@ -71,7 +71,9 @@ enum MessagePackType: int
     MPK_PICKUPOK,
     MPK_REMOVEGROUNDITEM,
     MPK_CORECORD,
+    MPK_COSNAPSHOTLIST,
     MPK_NOTIFYNEWCO,
+    MPK_WAKEUP,
     MPK_CHECKMASTER,
     MPK_QUERYMASTER,
     MPK_QUERYFINALMASTER,
@@ -84,6 +86,8 @@ enum MessagePackType: int
     MPK_NPCEVENT,
     MPK_NPCXMLLAYOUT,
     MPK_NPCERROR,
+    MPK_CREATEMAPINSTANCE,
+    MPK_DESTROYMAPINSTANCE,
     MPK_MAX,
 };
 
@@ -287,6 +291,11 @@ struct AMQueryMapUID
     uint32_t MapID;
 };
 
+struct AMCreateMapInstance
+{
+    uint32_t MapID;
+};
+
 struct AMUID
 {
     uint64_t UID;
@@ -517,6 +526,9 @@ struct AMCORecord
         uint64_t ActionParam;
     }Action;
 
+    uint32_t HP;
+    uint32_t HPMax;
+
     // instantiation of anonymous struct is supported in C11
     // not C++11, so we define structs outside of anonymous union
 
@@ -545,6 +557,46 @@ struct AMCORecord
     };
 };
 
+// compact CO state kept by map
+// map answers MPK_PULLCOINFO by packed snapshots instead of asking every CO
+struct AMCOSnapshot
+{
+    uint64_t UID;
+
+    int16_t X;
+    int16_t Y;
+    int16_t Direction;
+
+    uint32_t HP;
+    uint32_t HPMax;
+
+    struct _AMCOSnapshot_Monster
+    {
+        uint32_t MonsterID;
+    };
+
+    struct _AMCOSnapshot_Player
+    {
+        uint32_t DBID;
+        uint32_t JobID;
+        uint32_t Level;
+    };
+
+    union
+    {
+        _AMCOSnapshot_Monster Monster;
+        _AMCOSnapshot_Player  Player;
+    };
+};
+
+struct AMCOSnapshotList
+{
+    uint32_t MapID;
+    uint32_t Count;
+
+    AMCOSnapshot SnapshotList[32];
+};
+
 struct AMNotifyNewCO
 {
     uint64_t UID;
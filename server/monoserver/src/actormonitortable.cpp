@@ -31,7 +31,7 @@ ActorMonitorTable::ActorMonitorTable(int nX, int nY, int nW, int nH, const char
     : Fl_TableImpl(nX, nY, nW, nH, szLabel)
     , m_columnName
       {
-          "UID", "TYPE", "GROUP", "LIVE", "BUSY", "MSG_DONE", "MSG_PENDING"
+          "UID", "TYPE", "GROUP", "LIVE", "BUSY", "MSG_DONE", "MSG_PENDING", "SCRIPT_RESUME", "SCRIPT_OVERRUN", "SCRIPT_BUSY", "SCRIPT_MAX(us)"
       }
     , m_actorMonitorList()
     , m_sortByCol(-1)
@@ -119,6 +119,22 @@ std::string ActorMonitorTable::GetGridData(int nRow, int nCol) const
             {
                 return fnAdjustLength(std::to_string(rstMonitor.MessagePending), std::to_string(m_monitorDataDiags.MaxMessagePending).size());
             }
+        case 7: // SCRIPT_RESUME
+            {
+                return std::to_string(rstMonitor.ScriptResume);
+            }
+        case 8: // SCRIPT_OVERRUN
+            {
+                return std::to_string(rstMonitor.ScriptOverrun);
+            }
+        case 9: // SCRIPT_BUSY
+            {
+                return GetTimeString(rstMonitor.ScriptBusyTick);
+            }
+        case 10: // SCRIPT_MAX(us)
+            {
+                return std::to_string(rstMonitor.ScriptMaxTick);
+            }
         default:
             {
                 return "???";
@@ -239,6 +255,10 @@ void ActorMonitorTable::SetupHeaderWidth()
         col_width(4, (std::max<int>)(fnHeaderWidth(4), 160)); // BUSY
         col_width(5, (std::max<int>)(fnHeaderWidth(5), 120)); // MSG_DONE
         col_width(6, (std::max<int>)(fnHeaderWidth(6),  30)); // MSG_PENDING
+        col_width(7, (std::max<int>)(fnHeaderWidth(7),  80)); // SCRIPT_RESUME
+        col_width(8, (std::max<int>)(fnHeaderWidth(8),  80)); // SCRIPT_OVERRUN
+        col_width(9, (std::max<int>)(fnHeaderWidth(9), 160)); // SCRIPT_BUSY
+        col_width(10, (std::max<int>)(fnHeaderWidth(10),  80)); // SCRIPT_MAX(us)
     }
 }
 
@@ -294,6 +314,10 @@ void ActorMonitorTable::ResetSort()
             case 4 : return fnArgedCompare(lhs.BusyTick, rhs.BusyTick);
             case 5 : return fnArgedCompare(lhs.MessageDone, rhs.MessageDone);
             case 6 : return fnArgedCompare(lhs.MessagePending, rhs.MessagePending);
+            case 7 : return fnArgedCompare(lhs.ScriptResume, rhs.ScriptResume);
+            case 8 : return fnArgedCompare(lhs.ScriptOverrun, rhs.ScriptOverrun);
+            case 9 : return fnArgedCompare(lhs.ScriptBusyTick, rhs.ScriptBusyTick);
+            case 10: return fnArgedCompare(lhs.ScriptMaxTick, rhs.ScriptMaxTick);
             default: return fnArgedCompare(&lhs, &rhs); // keep everything as it or reversed
         }
     });
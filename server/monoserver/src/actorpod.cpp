@@ -20,6 +20,7 @@
 #include <cinttypes>
 
 #include "uidf.hpp"
+#include "coro.hpp"
 #include "actorpod.hpp"
 #include "actorpool.hpp"
 #include "raiitimer.hpp"
@@ -32,7 +33,8 @@ extern ServerArgParser *g_serverArgParser;
 
 ActorPod::ActorPod(uint64_t nUID,
         const std::function<void()> &fnTrigger,
-        const std::function<void(const MessagePack &)> &fnOperation, uint32_t nExpireTime)
+        const std::function<void(const MessagePack &)> &fnOperation,
+        const std::function<void()> &fnMetronome, uint32_t nExpireTime)
     : m_UID([nUID]() -> uint64_t
       {
           if(!nUID){
@@ -46,10 +48,14 @@ ActorPod::ActorPod(uint64_t nUID,
       }())
     , m_trigger(fnTrigger)
     , m_operation(fnOperation)
+    , m_metronome(fnMetronome)
     , m_validID(0)
     , m_expireTime(nExpireTime)
     , m_respondHandlerGroup()
     , m_podMonitor()
+    , m_metronomeEnabled(true)
+    , m_metronomePeriod(0)
+    , m_metronomeTick(0)
 {
     if(!g_actorPool->Register(this)){
         throw fflerror("register actor failed: ActorPod = %p, ActorPod::UID() = %" PRIu64, this, UID());
@@ -80,28 +86,7 @@ void ActorPod::InnHandler(const MessagePack &rstMPK)
                 uidf::getUIDString(UID()).c_str(), uidf::getUIDString(rstMPK.from()).c_str(), rstMPK.Name(), rstMPK.ID(), rstMPK.Respond());
     }
 
-    if(m_expireTime){
-        while(!m_respondHandlerGroup.empty()){
-            if(g_monoServer->getCurrTick() >= m_respondHandlerGroup.begin()->second.ExpireTime){
-                // everytime when we received the new MPK we check if there is handler the timeout
-                // also this time get counted into the monitor entry
-                m_podMonitor.AMProcMonitorList[MPK_TIMEOUT].RecvCount++;
-                {
-                    raii_timer stTimer(&(m_podMonitor.AMProcMonitorList[MPK_TIMEOUT].ProcTick));
-                    m_respondHandlerGroup.begin()->second.Operation(MPK_TIMEOUT);
-                }
-                m_respondHandlerGroup.erase(m_respondHandlerGroup.begin());
-                continue;
-            }
-
-            // std::map<ID, Handler> keeps order in ID number
-            // ID number is the Resp() of the responding messages
-            //
-            // and we guarantee "ID1 < ID2" => "ExpireTime1 <= ExpireTime2"
-            // so if we get first non-expired handler, means the rest are all not expired
-            break;
-        }
-    }
+    ExpireHandler();
 
     if(rstMPK.Respond()){
         // try to find the response handler for current responding message
@@ -109,17 +94,21 @@ void ActorPod::InnHandler(const MessagePack &rstMPK)
         // 2. not find it: 1. didn't register for it, we must prevent this at sending
         //                 2. repsonse is too late ooops and the handler has already be deleted
         if(auto p = m_respondHandlerGroup.find(rstMPK.Respond()); p != m_respondHandlerGroup.end()){
-            if(p->second.Operation){
-                m_podMonitor.AMProcMonitorList[rstMPK.Type()].RecvCount++;
-                {
-                    raii_timer stTimer(&(m_podMonitor.AMProcMonitorList[rstMPK.Type()].ProcTick));
-                    p->second.Operation(rstMPK);
-                }
-            }else{
+            if(!p->second.Operation){
                 throw fflerror("%s <- %s : (Type: %s, ID: %" PRIu32 ", Resp: %" PRIu32 "): Response handler not executable",
                         uidf::getUIDString(UID()).c_str(), uidf::getUIDString(rstMPK.from()).c_str(), rstMPK.Name(), rstMPK.ID(), rstMPK.Respond());
             }
+
+            // take the handler out before calling it
+            // handler of forwardWait() resumes the waiting coroutine inline, which can register new handlers
+            auto fnOperation = std::move(p->second.Operation);
             m_respondHandlerGroup.erase(p);
+
+            m_podMonitor.AMProcMonitorList[rstMPK.Type()].RecvCount++;
+            {
+                raii_timer stTimer(&(m_podMonitor.AMProcMonitorList[rstMPK.Type()].ProcTick));
+                fnOperation(rstMPK);
+            }
         }else{
             // should only caused by deletion of timeout
             // do nothing for this case, don't take this as an error
@@ -150,6 +139,53 @@ void ActorPod::InnHandler(const MessagePack &rstMPK)
     }
 }
 
+void ActorPod::InnMetronome()
+{
+    // timeout of response handlers was checked by the metronome message
+    // keep it here, otherwise an actor without incoming message never times out
+    ExpireHandler();
+
+    m_podMonitor.AMProcMonitorList[MPK_METRONOME].RecvCount++;
+    {
+        raii_timer stTimer(&(m_podMonitor.AMProcMonitorList[MPK_METRONOME].ProcTick));
+        m_metronome();
+    }
+
+    if(m_trigger){
+        raii_timer stTimer(&(m_podMonitor.TriggerMonitor.ProcTick));
+        m_trigger();
+    }
+}
+
+void ActorPod::ExpireHandler()
+{
+    if(m_expireTime){
+        while(!m_respondHandlerGroup.empty()){
+            if(g_monoServer->getCurrTick() >= m_respondHandlerGroup.begin()->second.ExpireTime){
+                // everytime when we received the new MPK we check if there is handler the timeout
+                // also this time get counted into the monitor entry
+                // erase first, same as InnHandler(), the handler may resume a coroutine inline
+                auto fnOperation = std::move(m_respondHandlerGroup.begin()->second.Operation);
+                m_respondHandlerGroup.erase(m_respondHandlerGroup.begin());
+
+                m_podMonitor.AMProcMonitorList[MPK_TIMEOUT].RecvCount++;
+                {
+                    raii_timer stTimer(&(m_podMonitor.AMProcMonitorList[MPK_TIMEOUT].ProcTick));
+                    fnOperation(MPK_TIMEOUT);
+                }
+                continue;
+            }
+
+            // std::map<ID, Handler> keeps order in ID number
+            // ID number is the Resp() of the responding messages
+            //
+            // and we guarantee "ID1 < ID2" => "ExpireTime1 <= ExpireTime2"
+            // so if we get first non-expired handler, means the rest are all not expired
+            break;
+        }
+    }
+}
+
 uint32_t ActorPod::GetValidID()
 {
     // previously I use g_serverArgParser->TraceActorMessage to select use this one
@@ -245,6 +281,40 @@ bool ActorPod::forward(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond
     }
 }
 
+MessagePack ActorPod::forwardWait(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond)
+{
+    if(!coro_get_running_ref().co){
+        throw fflerror("%s -> %s: (Type: %s, ID: NA, Resp: %" PRIu32 "): Wait for response outside of coroutine",
+                uidf::getUIDString(UID()).c_str(), uidf::getUIDString(nUID).c_str(), MessagePack(rstMB.Type()).Name(), nRespond);
+    }
+
+    // the response handler writes the waiting slot on coroutine stack, with a shared stack it's saved out while suspended
+    if(coro_get_running_ref().shared_stack){
+        throw fflerror("%s -> %s: (Type: %s, ID: NA, Resp: %" PRIu32 "): Wait for response in coroutine on shared stack",
+                uidf::getUIDString(UID()).c_str(), uidf::getUIDString(nUID).c_str(), MessagePack(rstMB.Type()).Name(), nRespond);
+    }
+
+    coro_variable<MessagePack> stRMPK;
+    forward(nUID, rstMB, nRespond, [&stRMPK](const MessagePack &rstRMPK)
+    {
+        stRMPK.assign(rstRMPK);
+    });
+    return stRMPK.wait();
+}
+
+bool ActorPod::forwardOrWait(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond, std::function<void(const MessagePack &)> fnOPR)
+{
+    if(!coro_get_running_ref().co){
+        return forward(nUID, rstMB, nRespond, std::move(fnOPR));
+    }
+
+    const auto stRMPK = forwardWait(nUID, rstMB, nRespond);
+    if(fnOPR){
+        fnOPR(stRMPK);
+    }
+    return stRMPK.Type() != MPK_BADACTORPOD;
+}
+
 bool ActorPod::Detach(const std::function<void()> &fnAtExit) const
 {
     // we can call detach in its message handler
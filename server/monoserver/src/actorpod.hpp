@@ -19,6 +19,7 @@
 
 #include <map>
 #include <array>
+#include <algorithm>
 #include <string>
 #include <functional>
 
@@ -70,9 +71,27 @@ class ActorPod final
                 {}
             }TriggerMonitor;
 
+            // script driven by the actor, i.e. main() of the ServerMap lua module
+            // copied to the actor pool monitor after each metronome
+            struct _ScriptMonitor
+            {
+                uint64_t ResumeCount;
+                uint64_t OverrunCount;
+                uint64_t ProcTick;
+                uint64_t MaxProcTick;
+
+                _ScriptMonitor()
+                    : ResumeCount(0)
+                    , OverrunCount(0)
+                    , ProcTick(0)
+                    , MaxProcTick(0)
+                {}
+            }ScriptMonitor;
+
             ActorPodMonitor()
                 : AMProcMonitorList()
                 , TriggerMonitor()
+                , ScriptMonitor()
             {}
         };
 
@@ -98,6 +117,10 @@ class ActorPod final
         // this handler is provided at the initialization time and never change
         const std::function<void(const MessagePack &)> m_operation;
 
+        // called directly by actor pool in its tick phase, no message created
+        // an actor without this hook never gets ticked
+        const std::function<void()> m_metronome;
+
     private:
         // used by ValidID()
         // to create unique proper ID for an message expcecting response
@@ -123,10 +146,21 @@ class ActorPod final
     private:
         ActorPodMonitor m_podMonitor;
 
+    private:
+        // actor pool skips the metronome if disabled
+        // only switched by the actor itself in its message handler or metronome
+        bool m_metronomeEnabled;
+
+        // tick interval in ms, zero means every tick of the actor pool
+        // last tick time is only accessed while holding the mailbox
+        uint32_t m_metronomePeriod;
+        uint32_t m_metronomeTick;
+
     public:
         explicit ActorPod(uint64_t,
                 const std::function<void()> &,
-                const std::function<void(const MessagePack &)> &, uint32_t = 3600 * 1000);                            
+                const std::function<void(const MessagePack &)> &,
+                const std::function<void()> & = {}, uint32_t = 3600 * 1000);
 
     public:
         ~ActorPod();
@@ -136,6 +170,25 @@ class ActorPod final
 
     private:
         void InnHandler(const MessagePack &);
+        void InnMetronome();
+
+    private:
+        void ExpireHandler();
+
+    private:
+        bool MetronomeDue(uint32_t nCurrTick)
+        {
+            if(!(m_metronome && m_metronomeEnabled)){
+                return false;
+            }
+
+            if(m_metronomePeriod && (nCurrTick - m_metronomeTick < m_metronomePeriod)){
+                return false;
+            }
+
+            m_metronomeTick = nCurrTick;
+            return true;
+        }
 
     public:
         bool forward(uint64_t nUID, const MessageBuf &rstMB)
@@ -153,6 +206,30 @@ class ActorPod final
         bool forward(uint64_t, const MessageBuf &, uint32_t);
         bool forward(uint64_t, const MessageBuf &, uint32_t, std::function<void(const MessagePack &)>);
 
+    public:
+        // awaitable forward for actor logic in coro.hpp coroutines, yields until the response arrives
+        // returns MPK_TIMEOUT or MPK_BADACTORPOD if failed
+        // the resume happens inline: InnHandler()/ExpireHandler() run the handler which switches back into the coroutine
+        // and the handler returns only after the coroutine yields again or finishes
+        // the handler only captures a pointer to the waiting slot on coroutine stack, fits std::function without allocation
+        // throws if the coroutine runs on a shared stack, the slot isn't addressable while the coroutine is swapped out
+        MessagePack forwardWait(uint64_t nUID, const MessageBuf &rstMB)
+        {
+            return forwardWait(nUID, rstMB, 0);
+        }
+
+        MessagePack forwardWait(uint64_t, const MessageBuf &, uint32_t);
+
+    public:
+        // forward() in main context, forwardWait() and then fnOPR inside a coroutine
+        // lets callback style logic run in coroutines as is, each hop waits instead of registering a handler
+        bool forwardOrWait(uint64_t nUID, const MessageBuf &rstMB, std::function<void(const MessagePack &)> fnOPR)
+        {
+            return forwardOrWait(nUID, rstMB, 0, std::move(fnOPR));
+        }
+
+        bool forwardOrWait(uint64_t, const MessageBuf &, uint32_t, std::function<void(const MessagePack &)>);
+
     public:
         uint64_t UID() const
         {
@@ -167,4 +244,42 @@ class ActorPod final
 
     public:
         void PrintMonitor() const;
+
+    public:
+        void recordScript(uint64_t nProcTick, bool bOverrun)
+        {
+            m_podMonitor.ScriptMonitor.ResumeCount  += 1;
+            m_podMonitor.ScriptMonitor.OverrunCount += (bOverrun ? 1 : 0);
+            m_podMonitor.ScriptMonitor.ProcTick     += nProcTick;
+            m_podMonitor.ScriptMonitor.MaxProcTick   = std::max<uint64_t>(m_podMonitor.ScriptMonitor.MaxProcTick, nProcTick);
+        }
+
+        const ActorPodMonitor::_ScriptMonitor &scriptMonitor() const
+        {
+            return m_podMonitor.ScriptMonitor;
+        }
+
+    public:
+        void setMetronome(bool bMetronome)
+        {
+            m_metronomeEnabled = bMetronome;
+        }
+
+        bool hasMetronome() const
+        {
+            return m_metronome && m_metronomeEnabled;
+        }
+
+    public:
+        // e.g. 1000 for idle actors to tick at 1Hz
+        // can't be faster than logic FPS of the actor pool
+        void setMetronomePeriod(uint32_t nPeriod)
+        {
+            m_metronomePeriod = nPeriod;
+        }
+
+        uint32_t metronomePeriod() const
+        {
+            return m_metronomePeriod;
+        }
 };
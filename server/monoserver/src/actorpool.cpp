@@ -26,8 +26,10 @@
 #include "raiitimer.hpp"
 #include "actorpool.hpp"
 #include "monoserver.hpp"
+#include "serverargparser.hpp"
 
 extern MonoServer *g_monoServer;
+extern ServerArgParser *g_serverArgParser;
 
 // keep in mind:
 // 1. at ANY time only one thread can access one actor message handler
@@ -59,6 +61,8 @@ ActorPool::ActorPool(uint32_t nBucketCount, uint32_t nLogicFPS)
     , m_bucketList(nBucketCount)
     , m_receiverLock()
     , m_receiverList()
+    , m_profiler(g_serverArgParser->ProfileActor ? std::make_unique<ActorProfiler>(nBucketCount) : nullptr)
+    , m_tracer(g_serverArgParser->RecordActorMessage ? std::make_unique<ActorTracer>(1 << 16, nBucketCount) : nullptr)
 {}
 
 ActorPool::~ActorPool()
@@ -303,6 +307,10 @@ bool ActorPool::PostMessage(uint64_t nUID, MessagePack stMPK)
         throw fflerror("sending empty message to %" PRIu64, nUID);
     }
 
+    if(m_tracer){
+        m_tracer->recordPost(getWorkerID(), stMPK.from(), nUID, stMPK.Type(), stMPK.DataLen());
+    }
+
     if(IsReceiver(nUID)){
         std::lock_guard<std::mutex> stLockGuard(m_receiverLock);
         if(auto p = m_receiverList.find(nUID); p != m_receiverList.end()){
@@ -312,6 +320,10 @@ bool ActorPool::PostMessage(uint64_t nUID, MessagePack stMPK)
         return false;
     }
 
+    if(m_profiler){
+        stMPK.setPostTime(m_profiler->now());
+    }
+
     auto nIndex = nUID % m_bucketList.size();
     auto fnPostMessage = [this, nIndex, nUID](MessagePack stMPK)
     {
@@ -347,7 +359,7 @@ bool ActorPool::PostMessage(uint64_t nUID, MessagePack stMPK)
     }
 }
 
-bool ActorPool::RunOneMailbox(Mailbox *pMailbox, bool bMetronome)
+bool ActorPool::RunOneMailbox(Mailbox *pMailbox, bool bMetronome, uint32_t nCurrTick)
 {
     if(!isActorThread()){
         throw fflerror("accessing actor message handlers outside of any actor threads: %d", getWorkerID());
@@ -365,16 +377,50 @@ bool ActorPool::RunOneMailbox(Mailbox *pMailbox, bool bMetronome)
     // because it's in the message handling thread and it grabs the SchedLock
     // any thread want to flip the actor to detached status must firstly grab its SchedLock
 
+    auto fnHandle = [this, pMailbox](int nType, uint64_t nFrom, size_t nDataLen, const auto &fnHandler)
+    {
+        const auto nTraceSeq  = m_tracer ? m_tracer->beginHandle() : 0;
+        const auto nTraceTime = m_tracer ? m_tracer->now()         : 0;
+        {
+            raii_timer stTimer(&(pMailbox->Monitor.ProcTick));
+            fnHandler();
+
+            if(m_profiler){
+                m_profiler->recordProc(nType, stTimer.diff_nsec());
+            }
+        }
+
+        if(m_tracer){
+            m_tracer->endHandle(getWorkerID(), nTraceSeq, nTraceTime, nFrom, pMailbox->Monitor.UID, nType, nDataLen);
+        }
+        pMailbox->Monitor.MessageDone.fetch_add(1);
+    };
+
     if(bMetronome){
         if(pMailbox->SchedLock.Detached()){
             return false;
         }
 
-        {
-            raii_timer stTimer(&(pMailbox->Monitor.ProcTick));
-            pMailbox->Actor->InnHandler({MPK_METRONOME, 0, 0});
+        // tick phase of the bucket
+        // call update hook of the actor directly, no MPK_METRONOME created or queued
+        // actor without the hook, or turned it off, or not due yet only checks the response timeout
+        if(pMailbox->Actor->MetronomeDue(nCurrTick)){
+            fnHandle(MPK_METRONOME, 0, 0, [pMailbox](){ pMailbox->Actor->InnMetronome(); });
+
+            // script only runs in metronome
+            // actor can detach itself in it, then Actor is null
+            if(!pMailbox->SchedLock.Detached()){
+                if(const auto &rstScript = pMailbox->Actor->scriptMonitor(); rstScript.ResumeCount != pMailbox->Monitor.ScriptResume.load()){
+                    pMailbox->Monitor.ScriptResume     .store(rstScript.ResumeCount);
+                    pMailbox->Monitor.ScriptOverrun    .store(rstScript.OverrunCount);
+                    pMailbox->Monitor.ScriptProcTick   .store(rstScript.ProcTick);
+                    pMailbox->Monitor.ScriptMaxProcTick.store(rstScript.MaxProcTick);
+                }
+            }
+        }
+        else{
+            pMailbox->Actor->ExpireHandler();
         }
-        pMailbox->Monitor.MessageDone.fetch_add(1);
     }
 
     if(pMailbox->CurrQ.empty()){
@@ -400,11 +446,11 @@ bool ActorPool::RunOneMailbox(Mailbox *pMailbox, bool bMetronome)
             return false;
         }
 
-        {
-            raii_timer stTimer(&(pMailbox->Monitor.ProcTick));
-            pMailbox->Actor->InnHandler(*p);
+        if(m_profiler){
+            m_profiler->recordWait(p->Type(), p->postTime());
         }
-        pMailbox->Monitor.MessageDone.fetch_add(1);
+
+        fnHandle(p->Type(), p->from(), p->DataLen(), [pMailbox, p](){ pMailbox->Actor->InnHandler(*p); });
     }
 
     pMailbox->CurrQ.clear();
@@ -416,7 +462,7 @@ void ActorPool::RunWorkerSteal(size_t nMaxIndex)
     std::shared_lock<std::shared_mutex> stLock(m_bucketList[nMaxIndex].BucketLock);
     for(auto p = m_bucketList[nMaxIndex].MailboxList.rbegin(); p != m_bucketList[nMaxIndex].MailboxList.rend(); ++p){
         if(MailboxLock stMailboxLock(p->second->SchedLock, getWorkerID()); stMailboxLock.Locked()){
-            RunOneMailbox(p->second.get(), false);
+            RunOneMailbox(p->second.get(), false, 0);
         }
     }
 }
@@ -439,14 +485,26 @@ void ActorPool::RunWorker(size_t nIndex)
 {
     hres_timer stHRTimer;
     RunWorkerOneLoop(nIndex);
-    m_bucketList[nIndex].RunTimer.Push(stHRTimer.diff_nsec());
+
+    const auto nRunTime = stHRTimer.diff_nsec();
+    m_bucketList[nIndex].RunTimer.Push(nRunTime);
+
+    if(m_profiler){
+        m_profiler->recordTick(nIndex, nRunTime);
+    }
 
     if(HasWorkSteal()){
         auto [nAvgTime, nMaxIndex] = CheckWorkerTime();
         if((m_bucketList[nIndex].RunTimer.GetAvgTime()) < nAvgTime && (nIndex != nMaxIndex)){
             hres_timer stHRStealTimer;
             RunWorkerSteal(nMaxIndex);
-            m_bucketList[nIndex].StealTimer.Push(stHRStealTimer.diff_nsec());
+
+            const auto nStealTime = stHRStealTimer.diff_nsec();
+            m_bucketList[nIndex].StealTimer.Push(nStealTime);
+
+            if(m_profiler){
+                m_profiler->recordSteal(nIndex, nStealTime);
+            }
         }
     }
 }
@@ -528,7 +586,11 @@ void ActorPool::RunWorkerOneLoop(size_t nIndex)
         throw fflerror("accessing message handler outside of its dedicated actor thread: WorkerID = %d, BucketID = %d", getWorkerID(), (int)(nIndex));
     }
 
-    auto fnUpdate = [this](size_t nIndex, auto p)
+    // one tick time for the whole bucket
+    // actors with same metronome period in one bucket get ticked together
+    const auto nCurrTick = g_monoServer->getCurrTick();
+
+    auto fnUpdate = [this, nCurrTick](size_t nIndex, auto p)
     {
         while(p != m_bucketList[nIndex].MailboxList.end()){
             switch(MailboxLock stMailboxLock(p->second->SchedLock, getWorkerID()); stMailboxLock.LockType()){
@@ -546,7 +608,7 @@ void ActorPool::RunWorkerOneLoop(size_t nIndex)
 
                         // don't try clean it
                         // since we can't guarentee to clean it complately
-                        if(!RunOneMailbox(p->second.get(), true)){
+                        if(!RunOneMailbox(p->second.get(), true, nCurrTick)){
                             return p;
                         }
 
@@ -713,3 +775,31 @@ std::vector<ActorPool::ActorMonitor> ActorPool::GetActorMonitor() const
     }
     return stRetList;
 }
+
+std::string ActorPool::DumpProfiler() const
+{
+    if(m_profiler){
+        return m_profiler->dumpJSON();
+    }
+    return {};
+}
+
+void ActorPool::ResetProfiler()
+{
+    if(m_profiler){
+        m_profiler->reset();
+    }
+}
+
+void ActorPool::DumpTracer(const std::string &szFileName) const
+{
+    if(!m_tracer){
+        throw fflerror("actor message recorder disabled");
+    }
+
+    std::vector<std::string> stNameList;
+    for(int nType = 0; nType < MPK_MAX; ++nType){
+        stNameList.push_back(MessagePack(nType).Name());
+    }
+    m_tracer->dump(szFileName, stNameList);
+}
@@ -22,6 +22,7 @@
 #include <array>
 #include <chrono>
 #include <future>
+#include <memory>
 #include <atomic>
 #include <vector>
 #include <thread>
@@ -30,6 +31,8 @@
 #include "condcheck.hpp"
 #include "raiitimer.hpp"
 #include "messagepack.hpp"
+#include "actortracer.hpp"
+#include "actorprofiler.hpp"
 
 class ActorPod;
 class Receiver;
@@ -55,12 +58,22 @@ class ActorPool final
             uint32_t MessageDone;
             uint32_t MessagePending;
 
-            ActorMonitor(uint64_t nUID, uint32_t nLiveTick, uint32_t nBusyTick, uint32_t nMessageDone, uint32_t nMessagePending)
+            // zero for actors without script
+            uint64_t ScriptResume;
+            uint64_t ScriptOverrun;
+            uint32_t ScriptBusyTick;
+            uint32_t ScriptMaxTick;     // in us
+
+            ActorMonitor(uint64_t nUID, uint32_t nLiveTick, uint32_t nBusyTick, uint32_t nMessageDone, uint32_t nMessagePending, uint64_t nScriptResume, uint64_t nScriptOverrun, uint32_t nScriptBusyTick, uint32_t nScriptMaxTick)
                 : UID(nUID)
                 , LiveTick(nLiveTick)
                 , BusyTick(nBusyTick)
                 , MessageDone(nMessageDone)
                 , MessagePending(nMessagePending)
+                , ScriptResume(nScriptResume)
+                , ScriptOverrun(nScriptOverrun)
+                , ScriptBusyTick(nScriptBusyTick)
+                , ScriptMaxTick(nScriptMaxTick)
             {}
 
             ActorMonitor()
@@ -268,12 +281,22 @@ class ActorPool final
                 std::atomic<uint32_t> MessageDone;
                 std::atomic<uint32_t> MessagePending;
 
+                // copied from ActorPod::scriptMonitor() after each metronome
+                std::atomic<uint64_t> ScriptResume;
+                std::atomic<uint64_t> ScriptOverrun;
+                std::atomic<uint64_t> ScriptProcTick;
+                std::atomic<uint64_t> ScriptMaxProcTick;
+
                 MailboxMonitor(uint64_t nUID)
                     : UID(nUID)
                     , LiveTimer()
                     , ProcTick {0}
                     , MessageDone {0}
                     , MessagePending {0}
+                    , ScriptResume {0}
+                    , ScriptOverrun {0}
+                    , ScriptProcTick {0}
+                    , ScriptMaxProcTick {0}
                 {}
             } Monitor;
 
@@ -286,6 +309,10 @@ class ActorPool final
                     (uint32_t)(Monitor.ProcTick.load() / 1000000),
                     Monitor.MessageDone.load(),
                     Monitor.MessagePending.load(),
+                    Monitor.ScriptResume.load(),
+                    Monitor.ScriptOverrun.load(),
+                    (uint32_t)(Monitor.ScriptProcTick.load() / 1000000),
+                    (uint32_t)(Monitor.ScriptMaxProcTick.load() / 1000),
                 };
             }
 
@@ -319,6 +346,11 @@ class ActorPool final
         std::mutex m_receiverLock;
         std::map<uint64_t, Receiver *> m_receiverList;
 
+    private:
+        // null if disabled by command line
+        const std::unique_ptr<ActorProfiler> m_profiler;
+        const std::unique_ptr<ActorTracer>   m_tracer;
+
     public:
         ActorPool(uint32_t = 23, uint32_t = 30);
 
@@ -374,7 +406,7 @@ class ActorPool final
         void RunWorker(size_t);
         void RunWorkerSteal(size_t);
         void RunWorkerOneLoop(size_t);
-        bool RunOneMailbox(Mailbox *, bool);
+        bool RunOneMailbox(Mailbox *, bool, uint32_t);
 
     private:
         void ClearOneMailbox(Mailbox *);
@@ -395,4 +427,23 @@ class ActorPool final
     public:
         ActorMonitor GetActorMonitor(uint64_t) const;
         std::vector<ActorMonitor> GetActorMonitor() const;
+
+    public:
+        bool HasProfiler() const
+        {
+            return (bool)(m_profiler);
+        }
+
+        // empty string if profiling disabled
+        std::string DumpProfiler() const;
+        void ResetProfiler();
+
+    public:
+        bool HasTracer() const
+        {
+            return (bool)(m_tracer);
+        }
+
+        // throws if recorder disabled or file can't be written
+        void DumpTracer(const std::string &) const;
 };
@@ -0,0 +1,84 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: actorprofiler.cpp
+ *        Created: 10/20/2026 05:41:13
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <cinttypes>
+#include "strf.hpp"
+#include "messagepack.hpp"
+#include "actorprofiler.hpp"
+
+static std::string histogramJSON(const LatencyHistogram &hist)
+{
+    std::string result = str_printf("{\"count\": %" PRIu64 ", \"sum\": %" PRIu64 ", \"max\": %" PRIu64, hist.count(), hist.sum(), hist.max());
+    for(const auto &[name, pct]: {std::make_pair("p50", 50.0), std::make_pair("p90", 90.0), std::make_pair("p99", 99.0), std::make_pair("p999", 99.9)}){
+        result += str_printf(", \"%s\": %" PRIu64, name, hist.percentile(pct));
+    }
+
+    // only non-empty buckets as [lower, upper, count]
+    // enough to rebuild the full distribution offline
+    result += ", \"buckets\": [";
+    bool first = true;
+
+    for(size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i){
+        if(const auto count = hist.bucketCount(i)){
+            result += str_printf("%s[%" PRIu64 ", %" PRIu64 ", %" PRIu64 "]", first ? "" : ", ", LatencyHistogram::bucketLower(i), LatencyHistogram::bucketUpper(i), count);
+            first = false;
+        }
+    }
+
+    result += "]}";
+    return result;
+}
+
+void ActorProfiler::reset()
+{
+    for(auto &hist: m_procList){
+        hist.reset();
+    }
+
+    for(auto &hist: m_waitList){
+        hist.reset();
+    }
+
+    for(size_t i = 0; i < m_bucketCount; ++i){
+        m_tickList [i].reset();
+        m_stealList[i].reset();
+    }
+}
+
+std::string ActorProfiler::dumpJSON() const
+{
+    std::string result = str_printf("{\n\"time\": %" PRIu64 ",\n\"message\": [", now());
+    bool first = true;
+
+    for(int type = MPK_NONE + 1; type < MPK_MAX; ++type){
+        if(m_procList[type].count() || m_waitList[type].count()){
+            result += first ? "\n" : ",\n";
+            result += str_printf("{\"type\": \"%s\", \"proc\": %s, \"wait\": %s}", MessagePack(type).Name(), histogramJSON(m_procList[type]).c_str(), histogramJSON(m_waitList[type]).c_str());
+            first = false;
+        }
+    }
+
+    result += "\n],\n\"bucket\": [";
+    for(size_t i = 0; i < m_bucketCount; ++i){
+        result += (i == 0) ? "\n" : ",\n";
+        result += str_printf("{\"id\": %zu, \"tick\": %s, \"steal\": %s}", i, histogramJSON(m_tickList[i]).c_str(), histogramJSON(m_stealList[i]).c_str());
+    }
+
+    result += "\n]\n}\n";
+    return result;
+}
@@ -0,0 +1,165 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: actortracer.cpp
+ *        Created: 10/20/2026 06:18:05
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "fflerror.hpp"
+#include "actortracer.hpp"
+
+ActorTracer::ActorTracer(size_t ringSize, size_t threadCount)
+    : m_ringSize(ringSize)
+    , m_threadCount(threadCount)
+    , m_timer()
+    , m_ringListLock()
+    , m_ringList()
+{
+    if(m_ringSize == 0){
+        throw fflerror("invalid ring size: %zu", m_ringSize);
+    }
+}
+
+ActorTracer::TraceRing *ActorTracer::getRing()
+{
+    // one tracer per process, the ring of current thread never changes
+    // ring is owned by tracer and outlives the thread
+    thread_local TraceRing *t_ring = nullptr;
+    if(t_ring){
+        return t_ring;
+    }
+
+    auto ringPtr = std::make_unique<TraceRing>();
+    ringPtr->RecordList.resize(m_ringSize);
+
+    std::lock_guard<std::mutex> lockGuard(m_ringListLock);
+    ringPtr->Slot = m_ringList.size() + 1;
+    m_ringList.push_back(std::move(ringPtr));
+
+    t_ring = m_ringList.back().get();
+    return t_ring;
+}
+
+void ActorTracer::pushRecord(TraceRing *ringPtr, const ActorTraceRecord &record)
+{
+    std::lock_guard<std::mutex> lockGuard(ringPtr->Lock);
+    ringPtr->RecordList[ringPtr->Count % ringPtr->RecordList.size()] = record;
+    ringPtr->Count++;
+}
+
+void ActorTracer::recordPost(int thread, uint64_t from, uint64_t to, int type, size_t size)
+{
+    auto ringPtr = getRing();
+
+    ActorTraceRecord record;
+    std::memset(&record, 0, sizeof(record));
+
+    record.Time   = now();
+    record.From   = from;
+    record.To     = to;
+    record.Seq    = ringPtr->CurrSeq;
+    record.Type   = (uint32_t)(type);
+    record.Size   = (uint32_t)(size);
+    record.Event  = ATE_POST;
+    record.Thread = (int16_t)(thread);
+
+    pushRecord(ringPtr, record);
+}
+
+uint64_t ActorTracer::beginHandle()
+{
+    // sequence is unique across rings without a shared counter
+    auto ringPtr = getRing();
+    ringPtr->CurrSeq = (ringPtr->Slot << 40) | (++ringPtr->NextSeq & 0XFFFFFFFFFF);
+    return ringPtr->CurrSeq;
+}
+
+void ActorTracer::endHandle(int thread, uint64_t seq, uint64_t startTime, uint64_t from, uint64_t to, int type, size_t size)
+{
+    auto ringPtr = getRing();
+    ringPtr->CurrSeq = 0;
+
+    ActorTraceRecord record;
+    std::memset(&record, 0, sizeof(record));
+
+    record.Time     = startTime;
+    record.Duration = now() - startTime;
+    record.From     = from;
+    record.To       = to;
+    record.Seq      = seq;
+    record.Type     = (uint32_t)(type);
+    record.Size     = (uint32_t)(size);
+    record.Event    = ATE_HANDLE;
+    record.Thread   = (int16_t)(thread);
+
+    pushRecord(ringPtr, record);
+}
+
+void ActorTracer::dump(const std::string &fileName, const std::vector<std::string> &nameList) const
+{
+    uint64_t dropCount = 0;
+    std::vector<ActorTraceRecord> recordList;
+    {
+        std::lock_guard<std::mutex> lockGuard(m_ringListLock);
+        for(const auto &ringPtr: m_ringList){
+            std::lock_guard<std::mutex> ringLockGuard(ringPtr->Lock);
+            const auto ringSize = ringPtr->RecordList.size();
+
+            if(ringPtr->Count > ringSize){
+                dropCount += ringPtr->Count - ringSize;
+                recordList.insert(recordList.end(), ringPtr->RecordList.begin(), ringPtr->RecordList.end());
+            }
+            else{
+                recordList.insert(recordList.end(), ringPtr->RecordList.begin(), ringPtr->RecordList.begin() + ringPtr->Count);
+            }
+        }
+    }
+
+    std::stable_sort(recordList.begin(), recordList.end(), [](const auto &lhs, const auto &rhs)
+    {
+        return lhs.Time < rhs.Time;
+    });
+
+    ActorTraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, ACTORTRACE_MAGIC, sizeof(header.Magic));
+
+    header.Version     = ACTORTRACE_VERSION;
+    header.RecordSize  = sizeof(ActorTraceRecord);
+    header.NameCount   = (uint32_t)(nameList.size());
+    header.ThreadCount = (uint32_t)(m_threadCount);
+    header.RecordCount = recordList.size();
+    header.DropCount   = dropCount;
+
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> fp(std::fopen(fileName.c_str(), "wb"), &std::fclose);
+    if(!fp){
+        throw fflerror("can't open file: %s", fileName.c_str());
+    }
+
+    bool done = (std::fwrite(&header, sizeof(header), 1, fp.get()) == 1);
+    for(const auto &name: nameList){
+        done = done && (std::fwrite(name.c_str(), name.size() + 1, 1, fp.get()) == 1);
+    }
+
+    if(!recordList.empty()){
+        done = done && (std::fwrite(recordList.data(), sizeof(ActorTraceRecord), recordList.size(), fp.get()) == recordList.size());
+    }
+
+    if(!done){
+        throw fflerror("failed to write file: %s", fileName.c_str());
+    }
+}
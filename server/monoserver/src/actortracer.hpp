@@ -0,0 +1,89 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: actortracer.hpp
+ *        Created: 10/20/2026 06:18:05
+ *    Description: record actor messages into per-thread ring buffers
+ *
+ *                 every thread posting or handling messages gets its own ring, so the
+ *                 recording never contends, only locked by the dump
+ *
+ *                 a ring keeps the last RingSize records of its thread, older records get
+ *                 overwritten and counted as dropped
+ *
+ *                 only created with "--record-actor-message", see actortrace.hpp for the
+ *                 dump format and tools/actortrace for the viewer
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "raiitimer.hpp"
+#include "actortrace.hpp"
+
+class ActorTracer final
+{
+    private:
+        struct TraceRing
+        {
+            std::mutex Lock;
+
+            uint64_t Slot    = 0;
+            uint64_t Count   = 0;
+            uint64_t CurrSeq = 0;
+            uint64_t NextSeq = 0;
+
+            std::vector<ActorTraceRecord> RecordList;
+        };
+
+    private:
+        const size_t m_ringSize;
+        const size_t m_threadCount;
+
+    private:
+        hres_timer m_timer;
+
+    private:
+        mutable std::mutex m_ringListLock;
+        std::vector<std::unique_ptr<TraceRing>> m_ringList;
+
+    public:
+        ActorTracer(size_t, size_t);
+
+    public:
+        uint64_t now() const
+        {
+            return m_timer.diff_nsec();
+        }
+
+    public:
+        void recordPost(int, uint64_t, uint64_t, int, size_t);
+
+    public:
+        // handling on one thread never nests
+        // posts between these two calls get the sequence of this handling
+        uint64_t beginHandle();
+        void endHandle(int, uint64_t, uint64_t, uint64_t, uint64_t, int, size_t);
+
+    public:
+        // write all rings into one file sorted by time
+        // recording continues during dump, records after the dump starts may be missed
+        void dump(const std::string &, const std::vector<std::string> &) const;
+
+    private:
+        TraceRing *getRing();
+        static void pushRecord(TraceRing *, const ActorTraceRecord &);
+};
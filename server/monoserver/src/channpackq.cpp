@@ -119,20 +119,49 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                     }
                 }
 
-                auto pDst = GetPostBuf(nDataLen + 4);
+                auto pDst = GetPostBuf(1 + 4 + nDataLen);
+                pDst[0] = nHC;
 
                 // 1. setup the message length encoding
                 {
                     auto nDataLenU32 = (uint32_t)(nDataLen);
-                    std::memcpy(pDst, &nDataLenU32, sizeof(nDataLenU32));
+                    std::memcpy(pDst + 1, &nDataLenU32, sizeof(nDataLenU32));
                 }
 
                 // 2. copy data if there is
                 if(pData){
-                    std::memcpy(pDst + 4, pData, nDataLen);
+                    std::memcpy(pDst + 1 + 4, pData, nDataLen);
                 }
 
-                return AddPackMark(GetBufOff(pDst), nDataLen + 4, std::move(rstDoneCB));
+                return AddPackMark(GetBufOff(pDst), 1 + 4 + nDataLen, std::move(rstDoneCB));
+            }
+        case 4:
+            {
+                // not empty, not fixed size, compressed
+                // [HC][origLen: 4][compLen: 4][mask][comp], mask length is decided by origLen
+
+                if(!(pData && nDataLen && (nDataLen <= 0XFFFFFFFF))){
+                    fnReportError("Invalid argument");
+                    return false;
+                }
+
+                const auto nMaskLen = (nDataLen + 7) / 8;
+                auto pDst = GetPostBuf(1 + 4 + 4 + nMaskLen + nDataLen);
+                auto nCompCnt = Compress::Encode(pDst + 1 + 4 + 4, pData, nDataLen);
+
+                if(nCompCnt < 0){
+                    fnReportError("Compression failed");
+                    return false;
+                }
+
+                const auto nOrigLenU32 = (uint32_t)(nDataLen);
+                const auto nCompLenU32 = (uint32_t)(nCompCnt);
+
+                pDst[0] = nHC;
+                std::memcpy(pDst + 1,     &nOrigLenU32, 4);
+                std::memcpy(pDst + 1 + 4, &nCompLenU32, 4);
+
+                return AddPackMark(GetBufOff(pDst), 1 + 4 + 4 + nMaskLen + (size_t)(nCompCnt), std::move(rstDoneCB));
             }
         default:
             {
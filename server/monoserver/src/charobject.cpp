@@ -175,6 +175,7 @@ uint64_t CharObject::Activate()
 {
     if(auto nUID = ServerObject::Activate(); nUID){
         DispatchAction(ActionSpawn(X(), Y(), Direction()));
+        ReportCORecord(MapUID());
         return nUID;
     }
     return 0;
@@ -398,7 +399,7 @@ bool CharObject::requestMove(int nX, int nY, int nSpeed, bool allowHalfMove, boo
 
                     m_actorPod->forward(rstMPK.from(), MPK_OK, rstMPK.ID());
                     DispatchAction(ActionMove(nOldX, nOldY, X(), Y(), nSpeed, Horse()));
-                    SortInViewCO();
+                    PruneInViewCO();
 
                     if(fnOnOK){
                         fnOnOK();
@@ -509,6 +510,7 @@ bool CharObject::requestSpaceMove(int locX, int locY, bool strictMove, std::func
 
                                     //  dispatch/report space move part 2 on new map
                                     DispatchAction(ActionSpaceMove2(X(), Y(), Direction()));
+                                    ReportCORecord(m_map->UID());
                                     if(uidf::getUIDType(UID()) == UID_PLY){
                                         dynamic_cast<Player *>(this)->ReportAction(UID(), ActionSpaceMove2(X(), Y(), Direction()));
                                     }
@@ -653,7 +655,9 @@ bool CharObject::requestMapSwitch(uint32_t mapID, int locX, int locY, bool stric
                                                     m_actorPod->forward(m_map->UID(), MPK_OK, rmpk.ID());
 
                                                     // 2. notify all players on the new map
+                                                    //    and let new map keep snapshot of current CO
                                                     DispatchAction(ActionStand(X(), Y(), Direction()));
+                                                    ReportCORecord(m_map->UID());
 
                                                     // 3. inform the client for map swith
                                                     // 4. get neighbors
@@ -804,7 +808,7 @@ void CharObject::retrieveLocation(uint64_t nUID, std::function<void(const COLoca
     stAMQL.UID   = UID();
     stAMQL.MapID = MapID();
 
-    m_actorPod->forward(nUID, {MPK_QUERYLOCATION, stAMQL}, [this, nUID, fnOnOK, fnOnError](const MessagePack &rstRMPK)
+    m_actorPod->forwardOrWait(nUID, {MPK_QUERYLOCATION, stAMQL}, [this, nUID, fnOnOK, fnOnError](const MessagePack &rstRMPK)
     {
         switch(rstRMPK.Type()){
             case MPK_LOCATION:
@@ -842,10 +846,6 @@ void CharObject::retrieveLocation(uint64_t nUID, std::function<void(const COLoca
                     // then this branch get called, then m_inViewCOList get updated implicitly
 
                     RemoveInViewCO(nUID);
-                    if(uidf::getUIDType(UID()) == UID_MON){
-                        dynamic_cast<Monster *>(this)->RemoveTarget(nUID);
-                    }
-
                     fnOnError();
                     return;
                 }
@@ -1273,17 +1273,13 @@ void CharObject::SetLastAction(int nAction)
 
 void CharObject::AddInViewCO(const COLocation &rstCOLocation)
 {
+    // CO moved out of view
+    // drop it from the list but keep it as target if any
     if(!InView(rstCOLocation.MapID, rstCOLocation.X, rstCOLocation.Y)){
+        m_inViewCOList.erase(rstCOLocation.UID);
         return;
     }
-
-    if(auto p = GetInViewCOPtr(rstCOLocation.UID)){
-        *p = rstCOLocation;
-    }
-    else{
-        m_inViewCOList.push_back(rstCOLocation);
-    }
-    SortInViewCO();
+    m_inViewCOList.update(rstCOLocation);
 }
 
 void CharObject::ForeachInViewCO(std::function<void(const COLocation &)> fnOnLoc)
@@ -1309,29 +1305,20 @@ void CharObject::AddInViewCO(uint64_t nUID, uint32_t nMapID, int nX, int nY, int
     AddInViewCO(COLocation(nUID, nMapID, g_monoServer->getCurrTick(), nX, nY, nDirection));
 }
 
-void CharObject::SortInViewCO()
+void CharObject::PruneInViewCO()
 {
-    RemoveInViewCO(0);
-    std::sort(m_inViewCOList.begin(), m_inViewCOList.end(), [this](const auto &rstLoc1, const auto &rstLoc2)
+    // call when *this* CO moves
+    // other COs report their moves by MPK_ACTION and get updated in AddInViewCO()
+    m_inViewCOList.eraseIf([this](const auto &rstCOLoc)
     {
-        return mathf::LDistance2(rstLoc1.X, rstLoc1.Y, X(), Y()) < mathf::LDistance2(rstLoc2.X, rstLoc2.Y, X(), Y());
+        return !InView(rstCOLoc.MapID, rstCOLoc.X, rstCOLoc.Y);
     });
 }
 
 void CharObject::RemoveInViewCO(uint64_t nUID)
 {
-    m_inViewCOList.erase(std::remove_if(m_inViewCOList.begin(), m_inViewCOList.end(), [this, nUID](const auto &rstCOLoc)
-    {
-        return rstCOLoc.UID == nUID || !InView(rstCOLoc.MapID, rstCOLoc.X, rstCOLoc.Y);
-    }), m_inViewCOList.end());
-
-    if((m_inViewCOList.size() < m_inViewCOList.capacity() / 2) && (m_inViewCOList.capacity() > 20)){
-        m_inViewCOList.shrink_to_fit();
-    }
-
-    if(uidf::getUIDType(UID()) == UID_MON){
-        dynamic_cast<Monster *>(this)->RemoveTarget(nUID);
-    }
+    m_inViewCOList.erase(nUID);
+    onRemoveInViewCO(nUID);
 }
 
 bool CharObject::InView(uint32_t nMapID, int nX, int nY) const
@@ -1349,12 +1336,7 @@ COLocation &CharObject::GetInViewCORef(uint64_t nUID)
 
 COLocation *CharObject::GetInViewCOPtr(uint64_t nUID)
 {
-    for(auto &rstCOLoc: m_inViewCOList){
-        if(rstCOLoc.UID == nUID){
-            return &rstCOLoc;
-        }
-    }
-    return nullptr;
+    return m_inViewCOList.find(nUID);
 }
 
 bool CharObject::IsOffender(uint64_t nUID)
@@ -1379,7 +1361,7 @@ void CharObject::QueryFinalMaster(uint64_t nUID, std::function<void(uint64_t)> f
 
     auto fnQuery = [this, fnOp](uint64_t nQueryUID)
     {
-        m_actorPod->forward(nQueryUID, MPK_QUERYFINALMASTER, [this, nQueryUID, fnOp](const MessagePack &rstRMPK)
+        m_actorPod->forwardOrWait(nQueryUID, MPK_QUERYFINALMASTER, [this, nQueryUID, fnOp](const MessagePack &rstRMPK)
         {
             switch(rstRMPK.Type()){
                 case MPK_UID:
@@ -21,8 +21,11 @@
 #include <list>
 #include <deque>
 #include <vector>
+#include <algorithm>
+#include <unordered_map>
 
 #include "toll.hpp"
+#include "mathf.hpp"
 #include "svobuf.hpp"
 #include "fflerror.hpp"
 #include "servermap.hpp"
@@ -73,6 +76,122 @@ struct COLocation
     {}
 };
 
+// in-view list of one CO
+// UID lookup, insert and erase are O(1), entries are kept in a dense vector for iteration
+// distance ordering is only needed for target searching, sort lazily when asked
+class InViewCOList final
+{
+    private:
+        std::vector<COLocation> m_list;
+        std::unordered_map<uint64_t, size_t> m_indexList;
+
+    private:
+        bool m_sorted = true;
+
+    private:
+        int m_sortX = -1;
+        int m_sortY = -1;
+
+    public:
+        size_t size() const
+        {
+            return m_list.size();
+        }
+
+        bool empty() const
+        {
+            return m_list.empty();
+        }
+
+    public:
+        auto begin() const
+        {
+            return m_list.begin();
+        }
+
+        auto end() const
+        {
+            return m_list.end();
+        }
+
+    public:
+        COLocation *find(uint64_t nUID)
+        {
+            if(auto p = m_indexList.find(nUID); p != m_indexList.end()){
+                return &(m_list[p->second]);
+            }
+            return nullptr;
+        }
+
+    public:
+        void update(const COLocation &rstCOLocation)
+        {
+            if(auto p = find(rstCOLocation.UID)){
+                *p = rstCOLocation;
+            }
+            else{
+                m_indexList[rstCOLocation.UID] = m_list.size();
+                m_list.push_back(rstCOLocation);
+            }
+            m_sorted = false;
+        }
+
+        bool erase(uint64_t nUID)
+        {
+            auto p = m_indexList.find(nUID);
+            if(p == m_indexList.end()){
+                return false;
+            }
+
+            // swap with the last one and pop
+            // breaks the distance ordering
+            if(const auto nIndex = p->second; nIndex + 1 != m_list.size()){
+                m_list[nIndex] = m_list.back();
+                m_indexList[m_list[nIndex].UID] = nIndex;
+            }
+
+            m_list.pop_back();
+            m_indexList.erase(p);
+
+            m_sorted = false;
+            return true;
+        }
+
+        template<typename F> void eraseIf(F fnErase)
+        {
+            for(size_t nIndex = 0; nIndex < m_list.size();){
+                if(fnErase(m_list[nIndex])){
+                    erase(m_list[nIndex].UID);
+                }
+                else{
+                    nIndex++;
+                }
+            }
+        }
+
+    public:
+        // entries sorted by distance to (nX, nY), nearest first
+        // reference is invalidated by any change to the list
+        const std::vector<COLocation> &sortedList(int nX, int nY)
+        {
+            if(!m_sorted || m_sortX != nX || m_sortY != nY){
+                std::sort(m_list.begin(), m_list.end(), [nX, nY](const auto &rstLoc1, const auto &rstLoc2)
+                {
+                    return mathf::LDistance2(rstLoc1.X, rstLoc1.Y, nX, nY) < mathf::LDistance2(rstLoc2.X, rstLoc2.Y, nX, nY);
+                });
+
+                for(size_t nIndex = 0; nIndex < m_list.size(); ++nIndex){
+                    m_indexList[m_list[nIndex].UID] = nIndex;
+                }
+
+                m_sorted = true;
+                m_sortX  = nX;
+                m_sortY  = nY;
+            }
+            return m_list;
+        }
+};
+
 class CharObject: public ServerObject
 {
     protected:
@@ -157,7 +276,7 @@ class CharObject: public ServerObject
         // 3. need to report to map if moving
         // 4. part of these COs are neighbors if close enough
         // 5. don't remove COs in this list if expired, otherwise action in (2) may miss
-        std::vector<COLocation> m_inViewCOList;
+        InViewCOList m_inViewCOList;
 
     protected:
         int m_X;
@@ -364,7 +483,7 @@ class CharObject: public ServerObject
         bool InView(uint32_t, int, int) const;
 
     protected:
-        void SortInViewCO();
+        void PruneInViewCO();
         void RemoveInViewCO(uint64_t);
         void AddInViewCO(const COLocation &);
         void AddInViewCO(uint64_t, uint32_t, int, int, int);
@@ -374,6 +493,11 @@ class CharObject: public ServerObject
         COLocation &GetInViewCORef(uint64_t);
         COLocation *GetInViewCOPtr(uint64_t);
 
+    protected:
+        // called after RemoveInViewCO(UID)
+        // derived class drops its own reference to the UID
+        virtual void onRemoveInViewCO(uint64_t) {}
+
     protected:
         virtual void checkFriend(uint64_t, std::function<void(int)>) = 0;
 
@@ -0,0 +1,180 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: latencyhistogram.hpp
+ *        Created: 10/20/2026 05:26:48
+ *    Description: lock-free log-linear histogram of nanoseconds, HDR style
+ *
+ *                 values below 2^SUB_BITS get their own bucket, every power of two after
+ *                 that is split into 2^SUB_BITS linear buckets, so any recorded value is
+ *                 reported with at most 1 / 2^SUB_BITS relative error
+ *
+ *                 record() is one relaxed atomic add, can be called from any thread
+ *                 readers may see a histogram in the middle of recording, good enough
+ *                 for profiling
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+class LatencyHistogram final
+{
+    public:
+        constexpr static int SUB_BITS = 4;
+        constexpr static int MAX_BITS = 40; // 2^40 ns is about 18 minutes, larger values are clamped
+
+    public:
+        constexpr static size_t SUB_COUNT    = (size_t)(1) << SUB_BITS;
+        constexpr static size_t BUCKET_COUNT = (MAX_BITS - SUB_BITS + 2) * SUB_COUNT;
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_bucketList;
+
+    private:
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_sum;
+        std::atomic<uint64_t> m_max;
+
+    public:
+        LatencyHistogram()
+        {
+            reset();
+        }
+
+    public:
+        void reset()
+        {
+            for(auto &bucket: m_bucketList){
+                bucket.store(0, std::memory_order_relaxed);
+            }
+
+            m_count.store(0, std::memory_order_relaxed);
+            m_sum  .store(0, std::memory_order_relaxed);
+            m_max  .store(0, std::memory_order_relaxed);
+        }
+
+    public:
+        void record(uint64_t val)
+        {
+            m_bucketList[bucketIndex(val)].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(val, std::memory_order_relaxed);
+
+            for(auto currMax = m_max.load(std::memory_order_relaxed); currMax < val;){
+                if(m_max.compare_exchange_weak(currMax, val, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+        }
+
+    public:
+        uint64_t count() const
+        {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+        uint64_t sum() const
+        {
+            return m_sum.load(std::memory_order_relaxed);
+        }
+
+        uint64_t max() const
+        {
+            return m_max.load(std::memory_order_relaxed);
+        }
+
+        uint64_t bucketCount(size_t index) const
+        {
+            return m_bucketList.at(index).load(std::memory_order_relaxed);
+        }
+
+    public:
+        // upper bound of the bucket where the given percentile falls into
+        // percentile is in [0.0, 100.0], returns 0 if nothing recorded
+        uint64_t percentile(double pct) const
+        {
+            const auto total = count();
+            if(total == 0){
+                return 0;
+            }
+
+            auto target = (uint64_t)(total * pct / 100.0 + 0.5);
+            if(target == 0){
+                target = 1;
+            }
+
+            uint64_t seen = 0;
+            for(size_t i = 0; i < BUCKET_COUNT; ++i){
+                seen += m_bucketList[i].load(std::memory_order_relaxed);
+                if(seen >= target){
+                    return std::min<uint64_t>(bucketUpper(i), max());
+                }
+            }
+            return max();
+        }
+
+    public:
+        static size_t bucketIndex(uint64_t val)
+        {
+            if(val < SUB_COUNT){
+                return (size_t)(val);
+            }
+
+            if(val >> (MAX_BITS + 1)){
+                val = ((uint64_t)(1) << (MAX_BITS + 1)) - 1;
+            }
+
+            const int shift = msb(val) - SUB_BITS;
+            return (size_t)(shift + 1) * SUB_COUNT + (size_t)((val >> shift) - SUB_COUNT);
+        }
+
+        static uint64_t bucketLower(size_t index)
+        {
+            if(index < SUB_COUNT){
+                return index;
+            }
+
+            const int shift = (int)(index / SUB_COUNT) - 1;
+            return (uint64_t)(index % SUB_COUNT + SUB_COUNT) << shift;
+        }
+
+        static uint64_t bucketUpper(size_t index)
+        {
+            if(index < SUB_COUNT){
+                return index;
+            }
+
+            const int shift = (int)(index / SUB_COUNT) - 1;
+            return bucketLower(index) + ((uint64_t)(1) << shift) - 1;
+        }
+
+    private:
+        static int msb(uint64_t val)
+        {
+#ifdef _MSC_VER
+            unsigned long index = 0;
+            _BitScanReverse64(&index, val);
+            return (int)(index);
+#else
+            return 63 - __builtin_clzll(val);
+#endif
+        }
+};
@@ -38,6 +38,10 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
         uint32_t m_ID;
         uint32_t m_respond;
 
+    private:
+        // stamped by actor pool when profiling
+        uint64_t m_postTime;
+
     private:
         uint8_t  m_SBuf[StaticBufferLength];
         size_t   m_SBufLen;
@@ -52,6 +56,7 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
             , m_from(nFrom)
             , m_ID(nID)
             , m_respond(nRespond)
+            , m_postTime(0)
         {
             if(pData && nDataLen){
                 if(nDataLen <= StaticBufferLength){
@@ -88,6 +93,7 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
             , m_from(rstMPK.from())
             , m_ID(rstMPK.ID())
             , m_respond(rstMPK.Respond())
+            , m_postTime(rstMPK.postTime())
         {
             // invalidate the r-ref message by
             // 1. remove its from/id/resp
@@ -97,6 +103,7 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
             rstMPK.m_from    = 0;
             rstMPK.m_ID      = 0;
             rstMPK.m_respond = 0;
+            rstMPK.m_postTime = 0;
 
             // case-1: use dynamic buffer, steal the buffer
             //         after this call rstMPK should be destructed immediately
@@ -148,6 +155,7 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
            std::swap(m_from   , stMPK.m_from   );
            std::swap(m_ID     , stMPK.m_ID     );
            std::swap(m_respond, stMPK.m_respond);
+           std::swap(m_postTime, stMPK.m_postTime);
 
            std::swap(m_SBufLen, stMPK.m_SBufLen);
            std::swap(m_DBuf   , stMPK.m_DBuf   );
@@ -218,6 +226,16 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
             return m_respond;
         }
 
+        uint64_t postTime() const
+        {
+            return m_postTime;
+        }
+
+        void setPostTime(uint64_t postTime)
+        {
+            m_postTime = postTime;
+        }
+
         const char *Name() const
         {
             switch(m_type){
@@ -272,7 +290,9 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
                 case MPK_PICKUPOK            : return "MPK_PICKUPOK";
                 case MPK_REMOVEGROUNDITEM    : return "MPK_REMOVEGROUNDITEM";
                 case MPK_CORECORD            : return "MPK_CORECORD";
+                case MPK_COSNAPSHOTLIST      : return "MPK_COSNAPSHOTLIST";
                 case MPK_NOTIFYNEWCO         : return "MPK_NOTIFYNEWCO";
+                case MPK_WAKEUP              : return "MPK_WAKEUP";
                 case MPK_CHECKMASTER         : return "MPK_CHECKMASTER";
                 case MPK_QUERYMASTER         : return "MPK_QUERYMASTER";
                 case MPK_QUERYFINALMASTER    : return "MPK_QUERYFINALMASTER";
@@ -284,6 +304,8 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
                 case MPK_NPCEVENT            : return "MPK_NPCEVENT";
                 case MPK_NPCXMLLAYOUT        : return "MPK_NPCXMLLAYOUT";
                 case MPK_NPCERROR            : return "MPK_NPCERROR";
+                case MPK_CREATEMAPINSTANCE   : return "MPK_CREATEMAPINSTANCE";
+                case MPK_DESTROYMAPINSTANCE  : return "MPK_DESTROYMAPINSTANCE";
                 default                      : return "MPK_UNKNOWN";
             }
         }
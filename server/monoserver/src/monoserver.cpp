@@ -19,6 +19,7 @@
 #include <chrono>
 #include <vector>
 #include <string>
+#include <cstdio>
 #include <cstring>
 #include <cstdarg>
 #include <cstdlib>
@@ -26,6 +27,7 @@
 #include <FL/fl_ask.H>
 
 #include "log.hpp"
+#include "coro.hpp"
 #include "dbpod.hpp"
 #include "toll.hpp"
 #include "taskhub.hpp"
@@ -402,6 +404,47 @@ bool MonoServer::addNPChar(uint16_t npcID, uint32_t mapID, int x, int y, bool st
     }
 }
 
+uint64_t MonoServer::createMapInstance(uint32_t mapID)
+{
+    AMCreateMapInstance amCMI;
+    std::memset(&amCMI, 0, sizeof(amCMI));
+
+    amCMI.MapID = mapID;
+    switch(auto rmpk = SyncDriver().forward(m_serviceCore->UID(), {MPK_CREATEMAPINSTANCE, amCMI}); rmpk.Type()){
+        case MPK_UID:
+            {
+                const auto mapUID = rmpk.conv<AMUID>().UID;
+                addLog(LOGTYPE_INFO, "Create map instance: %s", uidf::getUIDString(mapUID).c_str());
+                return mapUID;
+            }
+        default:
+            {
+                addLog(LOGTYPE_WARNING, "Create map instance failed: mapID = %llu", to_llu(mapID));
+                return 0;
+            }
+    }
+}
+
+bool MonoServer::destroyMapInstance(uint64_t mapUID)
+{
+    AMUID amUID;
+    std::memset(&amUID, 0, sizeof(amUID));
+
+    amUID.UID = mapUID;
+    switch(auto rmpk = SyncDriver().forward(m_serviceCore->UID(), {MPK_DESTROYMAPINSTANCE, amUID}); rmpk.Type()){
+        case MPK_OK:
+            {
+                addLog(LOGTYPE_INFO, "Destroy map instance: %s", uidf::getUIDString(mapUID).c_str());
+                return true;
+            }
+        default:
+            {
+                addLog(LOGTYPE_WARNING, "Destroy map instance failed, not an empty instance: %s", uidf::getUIDString(mapUID).c_str());
+                return false;
+            }
+    }
+}
+
 std::vector<int> MonoServer::GetMapList()
 {
     switch(auto stRMPK = SyncDriver().forward(m_serviceCore->UID(), MPK_QUERYMAPLIST); stRMPK.Type()){
@@ -807,6 +850,21 @@ void MonoServer::RegisterLuaExport(CommandLuaModule *pModule, uint32_t nCWID)
         return false;
     });
 
+    // register command createMapInstance(mapID) / destroyMapInstance(mapUID)
+    // map UID is passed as string since lua number can't hold all uint64_t
+    pModule->getLuaState().set_function("createMapInstance", [this](int mapID) -> std::string
+    {
+        if(const auto mapUID = createMapInstance((uint32_t)(mapID))){
+            return std::to_string(mapUID);
+        }
+        return {};
+    });
+
+    pModule->getLuaState().set_function("destroyMapInstance", [this](std::string mapUIDString) -> bool
+    {
+        return destroyMapInstance(uidf::toUID(mapUIDString));
+    });
+
     // register command mapList
     // return a table (userData) to lua for ipairs() check
     pModule->getLuaState().set_function("getMapIDList", [this](sol::this_state stThisLua)
@@ -814,6 +872,86 @@ void MonoServer::RegisterLuaExport(CommandLuaModule *pModule, uint32_t nCWID)
         return sol::make_object(sol::state_view(stThisLua), GetMapList());
     });
 
+    // register command dumpActorProfile(fileName)
+    // write actor latency histograms as JSON, only works when started with --profile-actor
+    pModule->getLuaState().set_function("dumpActorProfile", [this, nCWID](std::string fileName) -> bool
+    {
+        if(!g_actorPool->HasProfiler()){
+            addCWLog(nCWID, 2, ">>> ", "actor profiler disabled, restart with --profile-actor");
+            return false;
+        }
+
+        std::FILE *fp = std::fopen(fileName.c_str(), "wb");
+        if(!fp){
+            addCWLog(nCWID, 2, ">>> ", "can't open file: %s", fileName.c_str());
+            return false;
+        }
+
+        const auto profStr = g_actorPool->DumpProfiler();
+        const bool done = (std::fwrite(profStr.data(), 1, profStr.size(), fp) == profStr.size());
+
+        std::fclose(fp);
+        if(!done){
+            addCWLog(nCWID, 2, ">>> ", "failed to write file: %s", fileName.c_str());
+            return false;
+        }
+
+        addCWLog(nCWID, 0, "> ", "actor profile dumped to %s (%zu bytes)", fileName.c_str(), profStr.size());
+        return true;
+    });
+
+    // register command resetActorProfile()
+    // clear all histograms to measure a new period
+    pModule->getLuaState().set_function("resetActorProfile", [this, nCWID]()
+    {
+        if(!g_actorPool->HasProfiler()){
+            addCWLog(nCWID, 2, ">>> ", "actor profiler disabled, restart with --profile-actor");
+            return;
+        }
+
+        g_actorPool->ResetProfiler();
+        addCWLog(nCWID, 0, "> ", "actor profile reset");
+    });
+
+    // register command dumpActorTrace(fileName)
+    // write recorded actor messages for tools/actortrace, only works when started with --record-actor-message
+    pModule->getLuaState().set_function("dumpActorTrace", [this, nCWID](std::string fileName) -> bool
+    {
+        if(!g_actorPool->HasTracer()){
+            addCWLog(nCWID, 2, ">>> ", "actor message recorder disabled, restart with --record-actor-message");
+            return false;
+        }
+
+        try{
+            g_actorPool->DumpTracer(fileName);
+        }
+        catch(const std::exception &e){
+            addCWLog(nCWID, 2, ">>> ", "dumpActorTrace failed: %s", e.what());
+            return false;
+        }
+
+        addCWLog(nCWID, 0, "> ", "actor message trace dumped to %s", fileName.c_str());
+        return true;
+    });
+
+    // register command printCoroStat(reset)
+    // print coroutine resumes and stack bytes copied, copies should stay zero since every coroutine owns its stack
+    pModule->getLuaState().set_function("printCoroStat", [this, nCWID](sol::variadic_args args)
+    {
+        auto &stat = coro_get_switch_stat();
+        const auto resume = stat.resume.load(std::memory_order_relaxed);
+        const auto copy   = stat.copy  .load(std::memory_order_relaxed);
+        const auto bytes  = stat.bytes .load(std::memory_order_relaxed);
+
+        addCWLog(nCWID, 0, "> ", "coro resume: %llu, stack copy: %llu, bytes copied: %llu, bytes per resume: %.2f, idle pooled stacks: %zu",
+                to_llu(resume), to_llu(copy), to_llu(bytes), resume ? (1.0 * bytes / resume) : 0.0, coro_stack_pool::get().idleCount());
+
+        if(const std::vector<sol::object> argList(args.begin(), args.end()); !argList.empty() && argList[0].is<bool>() && argList[0].as<bool>()){
+            stat.reset();
+            addCWLog(nCWID, 0, "> ", "coro stat reset");
+        }
+    });
+
     pModule->getLuaState().script(
         R"###( function mapID2Name(mapID)                                              )###""\n"
         R"###(     return "map_name"                                                   )###""\n"
@@ -834,7 +972,13 @@ void MonoServer::RegisterLuaExport(CommandLuaModule *pModule, uint32_t nCWID)
 
     pModule->getLuaState().script(
         R"###( g_helpTable = {}                                                        )###""\n"
-        R"###( g_helpTable["listMap"] = "print all map indices to current window"      )###""\n");
+        R"###( g_helpTable["listMap"] = "print all map indices to current window"      )###""\n"
+        R"###( g_helpTable["dumpActorProfile"] = "write actor latency histograms to file" )###""\n"
+        R"###( g_helpTable["resetActorProfile"] = "clear actor latency histograms"        )###""\n"
+        R"###( g_helpTable["dumpActorTrace"] = "write recorded actor messages to file"   )###""\n"
+        R"###( g_helpTable["printCoroStat"] = "print coroutine stack copy counters"      )###""\n"
+        R"###( g_helpTable["createMapInstance"] = "create an instance of map, return its UID" )###""\n"
+        R"###( g_helpTable["destroyMapInstance"] = "destroy an empty map instance by its UID" )###""\n");
 
     // part-2: make up the function to print the table entry
     pModule->getLuaState().script(
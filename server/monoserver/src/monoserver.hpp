@@ -130,6 +130,10 @@ class MonoServer final
     public:
         bool addNPChar(uint16_t, uint32_t, int, int, bool);
 
+    public:
+        uint64_t createMapInstance(uint32_t);
+        bool destroyMapInstance(uint64_t);
+
     public:
         uint32_t getCurrTick() const
         {
@@ -111,8 +111,11 @@ Monster::Monster(uint32_t   nMonsterID,
     , m_masterUID(nMasterUID)
     , m_monsterRecord(DBCOM_MONSTERRECORD(nMonsterID))
     , m_AStarCache()
-    , m_bvTree()
-    , m_updateCoro([this](){ UpdateCoroFunc(); })
+    , m_bvState()
+    // dedicated pooled stack, monster can be resumed by any worker thread
+    , m_updateCoro(coro_stack_pool::get().alloc((size_t)(g_serverArgParser->CoroStackSize) * 1024), [this](){ UpdateCoroFunc(); })
+    , m_dormant(false)
+    , m_dormantCheckTick(0)
 {
     if(!m_monsterRecord){
         g_monoServer->addLog(LOGTYPE_WARNING, "Invalid monster record: MonsterID = %d", (int)(MonsterID()));
@@ -473,7 +476,7 @@ uint64_t Monster::Activate()
                 }
             });
         }
-        CreateBvTree();
+        m_bvState = bvflat::state(BvTree());
         return nUID;
     }
     return 0;
@@ -513,7 +516,7 @@ bool Monster::update()
     }
 
     if(g_serverArgParser->useBvTree){
-        switch(auto nState = m_bvTree->update()){
+        switch(auto nState = BvTree().update(*this, m_bvState, g_monoServer->getCurrTick())){
             case BV_PENDING:
                 {
                     return true;
@@ -522,7 +525,7 @@ bool Monster::update()
             case BV_SUCCESS:
             case BV_FAILURE:
                 {
-                    m_bvTree->reset();
+                    BvTree().reset(m_bvState);
                     return true;
                 }
             default:
@@ -538,12 +541,45 @@ bool Monster::update()
     return true;
 }
 
+void Monster::checkDormant()
+{
+    if(const auto nCurrTick = g_monoServer->getCurrTick(); m_dormantCheckTick + SYS_AIDORMANTCHECK < nCurrTick){
+        m_dormantCheckTick = nCurrTick;
+
+        // pets follow their master, never sleep
+        // dead monster keeps ticking till MPK_DEADFADEOUT
+        if(masterUID() || GetState(STATE_DEAD)){
+            return;
+        }
+
+        if(!m_map->regionObserved(X(), Y())){
+            setDormant(true);
+        }
+    }
+}
+
+void Monster::setDormant(bool bDormant)
+{
+    if(m_dormant == bDormant){
+        return;
+    }
+
+    m_dormant = bDormant;
+    m_actorPod->setMetronome(!bDormant);
+
+    // check again after a full period once woken up
+    // otherwise the stale region count may put it back to sleep
+    if(!bDormant){
+        m_dormantCheckTick = g_monoServer->getCurrTick();
+    }
+}
+
 void Monster::OperateAM(const MessagePack &rstMPK)
 {
     switch(rstMPK.Type()){
-        case MPK_METRONOME:
+        case MPK_WAKEUP:
             {
-                On_MPK_METRONOME(rstMPK);
+                On_MPK_WAKEUP(rstMPK);
                 break;
             }
         case MPK_CHECKMASTER:
@@ -673,6 +709,9 @@ void Monster::ReportCORecord(uint64_t toUID)
     stAMCOR.Action.AimUID      = 0;
     stAMCOR.Action.ActionParam = 0;
 
+    stAMCOR.HP    = HP();
+    stAMCOR.HPMax = HPMax();
+
     stAMCOR.Monster.MonsterID = MonsterID();
     m_actorPod->forward(toUID, {MPK_CORECORD, stAMCOR});
 }
@@ -777,6 +816,9 @@ void Monster::SetTarget(uint64_t nUID)
 {
     m_target.UID = nUID;
     m_target.ActiveTime = g_monoServer->getCurrTick();
+
+    // leave the idle tick rate right away, don't wait for the next slow metronome
+    m_actorPod->setMetronomePeriod(0);
 }
 
 bool Monster::GoDie()
@@ -1099,7 +1141,7 @@ bool Monster::MoveOneStepAStar(int nX, int nY, std::function<void()> fnOnOK, std
     stAMPF.EndX    = nX;
     stAMPF.EndY    = nY;
 
-    return m_actorPod->forward(MapUID(), {MPK_PATHFIND, stAMPF}, [this, nX, nY, fnOnOK, fnOnError](const MessagePack &rstRMPK)
+    return m_actorPod->forwardOrWait(MapUID(), {MPK_PATHFIND, stAMPF}, [this, nX, nY, fnOnOK, fnOnError](const MessagePack &rstRMPK)
     {
         switch(rstRMPK.Type()){
             case MPK_PATHFINDOK:
@@ -1177,21 +1219,25 @@ void Monster::RandomDrop()
 
 void Monster::RecursiveCheckInViewTarget(size_t nIndex, std::function<void(uint64_t)> fnTarget)
 {
-    if(nIndex >= m_inViewCOList.size()){
+    // check COs from the nearest one
+    // list only gets sorted again if changed
+    const auto &stSortedList = m_inViewCOList.sortedList(X(), Y());
+    if(nIndex >= stSortedList.size()){
         fnTarget(0);
         return;
     }
 
-    auto nUID = m_inViewCOList[nIndex].UID;
+    auto nUID = stSortedList[nIndex].UID;
     checkFriend(nUID, [this, nIndex, nUID, fnTarget](int nFriendType)
     {
         // when reach here
-        // m_inViewCOList[nIndex] may not be nUID anymore
+        // sorted list at nIndex may not be nUID anymore
 
         // if changed
         // we'd better redo the search
 
-        if(nIndex >= m_inViewCOList.size() || m_inViewCOList[nIndex].UID != nUID){
+        const auto &stSortedList = m_inViewCOList.sortedList(X(), Y());
+        if(nIndex >= stSortedList.size() || stSortedList[nIndex].UID != nUID){
             RecursiveCheckInViewTarget(0, fnTarget);
             return;
         }
@@ -1238,25 +1284,6 @@ void Monster::GetProperTarget(std::function<void(uint64_t)> fnTarget)
     SearchNearestTarget(fnTarget);
 }
 
-void Monster::CreateBvTree()
-{
-    bvarg_ref nTargetUID;
-
-    m_bvTree = bvtree::if_branch
-    (
-        BvNode_GetProperTarget(nTargetUID),
-        BvNode_TrackAttackUID(nTargetUID),
-
-        bvtree::if_branch
-        (
-            BvNode_HasMaster(),
-            BvNode_FollowMaster(),
-            BvNode_RandomMove()
-        )
-    );
-    m_bvTree->reset();
-}
-
 void Monster::QueryMaster(uint64_t nUID, std::function<void(uint64_t)> fnOp)
 {
     if(!nUID){
@@ -1304,7 +1331,7 @@ void Monster::checkFriend_AsGuard(uint64_t nUID, std::function<void(int)> fnOp)
             }
         case UID_PLY:
             {
-                m_actorPod->forward(nUID, MPK_QUERYNAMECOLOR, [fnOp](const MessagePack &rstMPK)
+                m_actorPod->forwardOrWait(nUID, MPK_QUERYNAMECOLOR, [fnOp](const MessagePack &rstMPK)
                 {
                     switch(rstMPK.Type()){
                         case MPK_NAMECOLOR:
@@ -1540,7 +1567,7 @@ void Monster::QueryFriendType(uint64_t nUID, uint64_t nTargetUID, std::function<
 
     stAMQFT.UID = nTargetUID;
 
-    m_actorPod->forward(nUID, {MPK_QUERYFRIENDTYPE, stAMQFT}, [fnOp](const MessagePack &rstMPK)
+    m_actorPod->forwardOrWait(nUID, {MPK_QUERYFRIENDTYPE, stAMQFT}, [fnOp](const MessagePack &rstMPK)
     {
         switch(rstMPK.Type()){
             case MPK_FRIENDTYPE:
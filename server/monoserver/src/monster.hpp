@@ -18,7 +18,7 @@
 #pragma once
 #include <functional>
 #include "coro.hpp"
-#include "bvtree.hpp"
+#include "bvflat.hpp"
 #include "fflerror.hpp"
 #include "charobject.hpp"
 #include "monsterrecord.hpp"
@@ -76,9 +76,15 @@ class Monster final: public CharObject
         AStarCache m_AStarCache;
 
     protected:
-        bvnode_ptr m_bvTree;
+        bvflat::state m_bvState;
         coro<std::function<void()>> m_updateCoro;
 
+    protected:
+        // dormant monster gets no metronome
+        // map sends MPK_WAKEUP when a player comes to the neighbor regions
+        bool     m_dormant;
+        uint32_t m_dormantCheckTick;
+
     public:
         Monster(uint32_t,               // monster id
                 ServiceCore *,          // service core
@@ -145,7 +151,7 @@ class Monster final: public CharObject
         void On_MPK_ACTION          (const MessagePack &);
         void On_MPK_OFFLINE         (const MessagePack &);
         void On_MPK_UPDATEHP        (const MessagePack &);
-        void On_MPK_METRONOME       (const MessagePack &);
+        void On_MPK_WAKEUP          (const MessagePack &);
         void On_MPK_MAPSWITCH       (const MessagePack &);
         void On_MPK_MASTERKILL      (const MessagePack &);
         void On_MPK_NOTIFYDEAD      (const MessagePack &);
@@ -163,6 +169,13 @@ class Monster final: public CharObject
     protected:
         void OperateAM(const MessagePack &);
 
+    protected:
+        void onMetronome() override;
+
+    protected:
+        void checkDormant();
+        void setDormant(bool);
+
     protected:
         void ReportCORecord(uint64_t);
 
@@ -182,6 +195,12 @@ class Monster final: public CharObject
         void QueryFriendType(uint64_t, uint64_t, std::function<void(int)>);
         void checkFriend(uint64_t, std::function<void(int)>) override;
 
+    protected:
+        void onRemoveInViewCO(uint64_t nUID) override
+        {
+            RemoveTarget(nUID);
+        }
+
     private:
         void checkFriend_AsGuard      (uint64_t, std::function<void(int)>);
         void checkFriend_CtrlByPlayer (uint64_t, std::function<void(int)>);
@@ -209,28 +228,26 @@ class Monster final: public CharObject
         virtual bool GoGhost();
 
     protected:
-        virtual void CreateBvTree();
+        const bvflat::tree<Monster> &BvTree() const;
 
     protected:
         void     CoroNode_Wait(uint64_t);
         void     CoroNode_RandomMove();
         bool     CoroNode_MoveForward();
         bool     CoroNode_FollowMaster();
+        int      CoroNode_CheckFriend(uint64_t);
         uint64_t CoroNode_GetProperTarget();
         bool     CoroNode_TrackAttackUID(uint64_t);
 
     protected:
-        virtual bvnode_ptr BvNode_HasMaster();
-        virtual bvnode_ptr BvNode_GetMasterUID(bvarg_ref);
-        virtual bvnode_ptr BvNode_FollowMaster();
-        virtual bvnode_ptr BvNode_LocateUID(bvarg_ref, bvarg_ref);
-        virtual bvnode_ptr BvNode_RandomMove();
-        virtual bvnode_ptr BvNode_RandomTurn();
-        virtual bvnode_ptr BvNode_AttackUID(bvarg_ref, bvarg_ref);
-        virtual bvnode_ptr BvNode_MoveForward();
-        virtual bvnode_ptr BvNode_MoveOneStep(bvarg_ref);
-        virtual bvnode_ptr BvNode_GetProperTarget(bvarg_ref);
-        virtual bvnode_ptr BvNode_TrackAttackUID(bvarg_ref);
+        // leaves of bvflat::tree<Monster>
+        // argument is the variable slot, unused for most leaves
+        bool    BvLeaf_HasMaster      (bvflat::state &, uint32_t);
+        bvres_t BvLeaf_RandomTurn     (bvflat::state &, uint32_t);
+        void    BvLeaf_FollowMaster   (bvflat::stage,   uint32_t);
+        void    BvLeaf_MoveForward    (bvflat::stage,   uint32_t);
+        void    BvLeaf_GetProperTarget(bvflat::stage,   uint32_t);
+        void    BvLeaf_TrackAttackUID (bvflat::stage,   uint32_t);
 
     public:
         static bool IsPet(uint64_t);
@@ -18,37 +18,9 @@
 #include "coro.hpp"
 #include "monster.hpp"
 #include "monoserver.hpp"
+#include "friendtype.hpp"
 
-bvnode_ptr Monster::BvNode_GetMasterUID(bvarg_ref nMasterUID)
-{
-    return bvtree::lambda_bool([this, nMasterUID]() mutable -> bool
-    {
-        nMasterUID.assign<uint64_t>(masterUID());
-        return masterUID();
-    });
-}
-
-bvnode_ptr Monster::BvNode_FollowMaster()
-{
-    return bvtree::if_branch
-    (
-        bvtree::lambda_stage([this](bvarg_ref nStage) mutable
-        {
-            FollowMaster([nStage]() mutable
-            {
-                nStage.assign<bvres_t>(BV_SUCCESS);
-            },
-
-            [nStage]() mutable
-            {
-                nStage.assign<bvres_t>(BV_FAILURE);
-            });
-        }),
-
-        bvtree::op_delay(1000),
-        bvtree::op_delay(200)
-    );
-}
+extern MonoServer *g_monoServer;
 
 bool Monster::CoroNode_FollowMaster()
 {
@@ -64,23 +36,6 @@ bool Monster::CoroNode_FollowMaster()
     return false;
 }
 
-bvnode_ptr Monster::BvNode_LocateUID(bvarg_ref nUID, bvarg_ref stLocation)
-{
-    return bvtree::lambda_stage([this, nUID, stLocation](bvarg_ref nStage) mutable
-    {
-        retrieveLocation(nUID.as<uint64_t>(), [nStage, stLocation](const COLocation &stLoc) mutable
-        {
-            stLocation.assign<tuple<uint32_t, int, int>>(stLoc.MapID, stLoc.X, stLoc.Y);
-            nStage.assign<bvres_t>(BV_SUCCESS);
-        },
-
-        [nStage]() mutable
-        {
-            nStage.assign<bvres_t>(BV_FAILURE);
-        });
-    });
-}
-
 void Monster::CoroNode_Wait(uint64_t ms)
 {
     if(ms == 0){
@@ -115,68 +70,6 @@ void Monster::CoroNode_RandomMove()
     }
 }
 
-bvnode_ptr Monster::BvNode_RandomMove()
-{
-    return bvtree::random
-    (
-        BvNode_RandomTurn(),
-        BvNode_MoveForward(),
-        BvNode_MoveForward(),
-        BvNode_MoveForward(),
-        BvNode_MoveForward(),
-        BvNode_MoveForward(),
-        BvNode_MoveForward(),
-        BvNode_MoveForward()
-    );
-}
-
-bvnode_ptr Monster::BvNode_RandomTurn()
-{
-    auto fnUpdate = [this]() -> bvres_t
-    {
-        static const int nDirV[]
-        {
-            DIR_UP,
-            DIR_UPRIGHT,
-            DIR_RIGHT,
-            DIR_DOWNRIGHT,
-            DIR_DOWN,
-            DIR_DOWNLEFT,
-            DIR_LEFT,
-            DIR_UPLEFT,
-        };
-
-        auto nDirCount = (int)(std::extent<decltype(nDirV)>::value);
-        auto nDirStart = (int)(std::rand() % nDirCount);
-
-        for(int nIndex = 0; nIndex < nDirCount; ++nIndex){
-            auto nDirection = nDirV[(nDirStart + nIndex) % nDirCount];
-            if(Direction() != nDirection){
-                int nX = -1;
-                int nY = -1;
-                if(OneStepReach(nDirection, 1, &nX, &nY) == 1){
-                    // current direction is possible for next move
-                    // report the turn and do motion (by chance) in next update
-                    m_direction = nDirection;
-                    DispatchAction(ActionStand(X(), Y(), Direction()));
-
-                    // we won't do ReportStand() for monster
-                    // monster's moving is only driven by server currently
-                    return BV_SUCCESS;
-                }
-            }
-        }
-        return BV_FAILURE;
-    };
-
-    return bvtree::if_branch
-    (
-        bvtree::lambda(fnUpdate),
-        bvtree::op_delay(200),
-        bvtree::op_abort()
-    );
-}
-
 bool Monster::CoroNode_MoveForward()
 {
     int nextX = -1;
@@ -191,163 +84,184 @@ bool Monster::CoroNode_MoveForward()
     return done.wait();
 }
 
-bvnode_ptr Monster::BvNode_MoveForward()
+int Monster::CoroNode_CheckFriend(uint64_t uid)
 {
-    bvarg_ref nStage;
+    // checkFriend() sends its queries by forwardOrWait(), inside coroutine each hop waits in place
+    // fnOp has run when checkFriend() returns, wait() doesn't yield
+    coro_variable<int> friendType;
+    checkFriend(uid, [&friendType](int type){ friendType.assign(type); });
+    return friendType.wait();
+}
 
-    auto fnReset = [nStage]() mutable
-    {
-        nStage.assign_void();
-    };
+uint64_t Monster::CoroNode_GetProperTarget()
+{
+    // same as GetProperTarget() but one check per loop iteration
+    // no recursive callback copies std::function per in-view CO
+    if(const auto targetUID = m_target.UID; targetUID && g_monoServer->getCurrTick() < m_target.ActiveTime + 60 * 1000){
+        if(CoroNode_CheckFriend(targetUID) == FT_ENEMY){
+            return targetUID;
+        }
+        RemoveTarget(targetUID);
+    }
+    else{
+        RemoveTarget(m_target.UID);
+    }
 
-    auto fnUpdate = [this, nStage]() mutable -> bvres_t
-    {
-        if(!nStage.has_value()){
-            int nX = -1;
-            int nY = -1;
-
-            if(OneStepReach(Direction(), 1, &nX, &nY) == 1){
-                requestMove(nX, nY, MoveSpeed(), false, false, [nStage]() mutable
-                {
-                    nStage.assign<bvres_t>(BV_SUCCESS);
-                },
-
-                [nStage]() mutable
-                {
-                    nStage.assign<bvres_t>(BV_FAILURE);
-                });
-                return BV_PENDING;
-            }else{
-                return BV_FAILURE;
-            }
+    for(size_t index = 0;;){
+        const auto uid = [this, index]() -> uint64_t
+        {
+            const auto &sortedList = m_inViewCOList.sortedList(X(), Y());
+            return index < sortedList.size() ? sortedList[index].UID : 0;
+        }();
+
+        if(!uid){
+            return 0;
+        }
+
+        const auto friendType = CoroNode_CheckFriend(uid);
+
+        // list can change during the wait, redo the search if the entry moved
+        if(const auto &sortedList = m_inViewCOList.sortedList(X(), Y()); index >= sortedList.size() || sortedList[index].UID != uid){
+            index = 0;
+            continue;
         }
 
-        switch(auto nStatus = nStage.as<bvres_t>()){
-            case BV_ABORT:
-            case BV_FAILURE:
-            case BV_PENDING:
-            case BV_SUCCESS:
-                {
-                    return nStatus;
-                }
-            default:
-                {
-                    throw fflerror("invalid node status: %d", nStatus);
-                }
+        if(friendType == FT_ENEMY){
+            return uid;
         }
-    };
-
-    return bvtree::if_branch
-    (
-        bvtree::lambda(fnReset, fnUpdate),
-        bvtree::op_delay(1000),
-        bvtree::op_delay( 200)
-    );
+        index++;
+    }
 }
 
-bvnode_ptr Monster::BvNode_MoveOneStep(bvarg_ref stDstLocation)
+bool Monster::CoroNode_TrackAttackUID(uint64_t targetUID)
 {
-    return bvtree::lambda_stage([this, stDstLocation](bvarg_ref nStage) mutable
-    {
-        auto [nMapID, nX, nY] = stDstLocation.as<tuple<uint32_t, int, int>>();
-        if(!m_map->In(nMapID, nX, nY)){
-            nStage.assign<bvres_t>(BV_ABORT);
-            return;
-        }
+    coro_variable<bool> done;
+    TrackAttackUID(targetUID, [&done]{ done.assign(true); }, [&done]{ done.assign(false); });
 
-        MoveOneStep(nX, nY, [nStage]() mutable
-        {
-            nStage.assign<bvres_t>(BV_SUCCESS);
-        },
+    if(done.wait()){
+        CoroNode_Wait(1200);
+        return true;
+    }
 
-        [nStage]() mutable
-        {
-            nStage.assign<bvres_t>(BV_FAILURE);
-        });
-    });
+    CoroNode_Wait(200);
+    return false;
 }
 
-bvnode_ptr Monster::BvNode_HasMaster()
+bool Monster::BvLeaf_HasMaster(bvflat::state &, uint32_t)
 {
-    return bvtree::lambda_bool([this]() -> bool
-    {
-        return masterUID();
-    });
+    return masterUID();
 }
 
-bvnode_ptr Monster::BvNode_GetProperTarget(bvarg_ref nTargetUID)
+void Monster::BvLeaf_FollowMaster(bvflat::stage stStage, uint32_t)
 {
-    return bvtree::lambda_stage([this, nTargetUID](bvarg_ref nStage) mutable
+    FollowMaster([stStage]() mutable
     {
-        GetProperTarget([nTargetUID, nStage](uint64_t nUID) mutable
-        {
-            if(!nUID){
-                nTargetUID.assign<uint64_t>(0);
-                nStage.assign<bvres_t>(BV_FAILURE);
-                return;
-            }
-
-            nTargetUID.assign<uint64_t>(nUID);
-            nStage.assign<bvres_t>(BV_SUCCESS);
-        });
+        stStage.done(BV_SUCCESS);
+    },
+
+    [stStage]() mutable
+    {
+        stStage.done(BV_FAILURE);
     });
 }
 
-uint64_t Monster::CoroNode_GetProperTarget()
+bvres_t Monster::BvLeaf_RandomTurn(bvflat::state &, uint32_t)
 {
-    coro_variable<uint64_t> targetUID;
-    GetProperTarget([&targetUID](uint64_t uid){ targetUID.assign(uid); });
-    return targetUID.wait();
+    return RandomTurn() ? BV_SUCCESS : BV_FAILURE;
 }
 
-bvnode_ptr Monster::BvNode_AttackUID(bvarg_ref nTargetUID, bvarg_ref nDCType)
+void Monster::BvLeaf_MoveForward(bvflat::stage stStage, uint32_t)
 {
-    return bvtree::lambda_stage([this, nTargetUID, nDCType](bvarg_ref nStage)
+    int nX = -1;
+    int nY = -1;
+
+    if(OneStepReach(Direction(), 1, &nX, &nY) != 1){
+        stStage.done(BV_FAILURE);
+        return;
+    }
+
+    requestMove(nX, nY, MoveSpeed(), false, false, [stStage]() mutable
     {
-        AttackUID(nTargetUID.as<uint64_t>(), nDCType.as<int>(), [nStage]() mutable
-        {
-            nStage.assign<bvres_t>(BV_SUCCESS);
-        },
+        stStage.done(BV_SUCCESS);
+    },
 
-        [nStage]() mutable
-        {
-            nStage.assign<bvres_t>(BV_FAILURE);
-        });
+    [stStage]() mutable
+    {
+        stStage.done(BV_FAILURE);
     });
 }
 
-bool Monster::CoroNode_TrackAttackUID(uint64_t targetUID)
+void Monster::BvLeaf_GetProperTarget(bvflat::stage stStage, uint32_t)
 {
-    coro_variable<bool> done;
-    TrackAttackUID(targetUID, [&done]{ done.assign(true); }, [&done]{ done.assign(false); });
+    GetProperTarget([stStage](uint64_t nUID) mutable
+    {
+        stStage.set(stStage.arg(), nUID);
+        stStage.done(nUID ? BV_SUCCESS : BV_FAILURE);
+    });
+}
 
-    if(done.wait()){
-        CoroNode_Wait(1200);
-        return true;
-    }
+void Monster::BvLeaf_TrackAttackUID(bvflat::stage stStage, uint32_t nTargetUID)
+{
+    TrackAttackUID(stStage.get(nTargetUID), [stStage]() mutable
+    {
+        stStage.done(BV_SUCCESS);
+    },
 
-    CoroNode_Wait(200);
-    return false;
+    [stStage]() mutable
+    {
+        stStage.done(BV_FAILURE);
+    });
 }
 
-bvnode_ptr Monster::BvNode_TrackAttackUID(bvarg_ref nTargetUID)
+const bvflat::tree<Monster> &Monster::BvTree() const
 {
-    return bvtree::if_branch
-    (
-        bvtree::lambda_stage([this, nTargetUID](bvarg_ref nStage) mutable
-        {
-            TrackAttackUID(nTargetUID.as<uint64_t>(), [nStage]() mutable
-            {
-                nStage.assign<bvres_t>(BV_SUCCESS);
-            },
-
-            [nStage]() mutable
-            {
-                nStage.assign<bvres_t>(BV_FAILURE);
-            });
-        }),
-
-        bvtree::op_delay(1000),
-        bvtree::op_delay(200)
-    );
+    // built once and shared by all monsters
+    // Monster is final, per-type AI would dispatch on MonsterID() here
+    static const auto s_bvTree = []()
+    {
+        bvflat::tree<Monster> stTree;
+        const auto nTargetUID = stTree.var();
+
+        // one move-forward node listed seven times
+        // random picks only one child per round, they can share the state slots
+        const auto nMoveForward = stTree.if_branch
+        (
+            stTree.lambda_stage(&Monster::BvLeaf_MoveForward),
+            stTree.op_delay(1000),
+            stTree.op_delay( 200)
+        );
+
+        const auto nRandomTurn = stTree.if_branch
+        (
+            stTree.action(&Monster::BvLeaf_RandomTurn),
+            stTree.op_delay(200),
+            stTree.op_abort()
+        );
+
+        stTree.root(stTree.if_branch
+        (
+            stTree.lambda_stage(&Monster::BvLeaf_GetProperTarget, nTargetUID),
+            stTree.if_branch
+            (
+                stTree.lambda_stage(&Monster::BvLeaf_TrackAttackUID, nTargetUID),
+                stTree.op_delay(1000),
+                stTree.op_delay( 200)
+            ),
+
+            stTree.if_branch
+            (
+                stTree.check(&Monster::BvLeaf_HasMaster),
+                stTree.if_branch
+                (
+                    stTree.lambda_stage(&Monster::BvLeaf_FollowMaster),
+                    stTree.op_delay(1000),
+                    stTree.op_delay( 200)
+                ),
+
+                stTree.random({nRandomTurn, nMoveForward, nMoveForward, nMoveForward, nMoveForward, nMoveForward, nMoveForward, nMoveForward})
+            )
+        ));
+        return stTree;
+    }();
+    return s_bvTree;
 }
@@ -25,9 +25,22 @@
 #include "monoserver.hpp"
 
 extern MonoServer *g_monoServer;
-void Monster::On_MPK_METRONOME(const MessagePack &)
+void Monster::onMetronome()
 {
     update();
+    checkDormant();
+
+    if(m_target.UID || masterUID() || GetState(STATE_DEAD)){
+        m_actorPod->setMetronomePeriod(0);
+    }
+    else{
+        m_actorPod->setMetronomePeriod(SYS_AIIDLEPERIOD);
+    }
+}
+
+void Monster::On_MPK_WAKEUP(const MessagePack &)
+{
+    setDormant(false);
 }
 
 void Monster::On_MPK_MISS(const MessagePack &rstMPK)
@@ -156,6 +169,9 @@ void Monster::On_MPK_ATTACK(const MessagePack &rstMPK)
     AMAttack stAMAK;
     std::memcpy(&stAMAK, rstMPK.Data(), sizeof(stAMAK));
 
+    // attacked by pets out of any player's view
+    setDormant(false);
+
     switch(GetState(STATE_DEAD)){
         case 0:
             {
@@ -326,7 +326,6 @@ void NPChar::OperateAM(const MessagePack &mpk)
 {
     switch(mpk.Type()){
         case MPK_OFFLINE:
-        case MPK_METRONOME:
             {
                 break;
             }
@@ -70,11 +70,6 @@ Player::~Player()
 void Player::OperateAM(const MessagePack &rstMPK)
 {
     switch(rstMPK.Type()){
-        case MPK_METRONOME:
-            {
-                On_MPK_METRONOME(rstMPK);
-                break;
-            }
         case MPK_BADACTORPOD:
             {
                 On_MPK_BADACTORPOD(rstMPK);
@@ -185,6 +180,11 @@ void Player::OperateAM(const MessagePack &rstMPK)
                 On_MPK_CORECORD(rstMPK);
                 break;
             }
+        case MPK_COSNAPSHOTLIST:
+            {
+                On_MPK_COSNAPSHOTLIST(rstMPK);
+                break;
+            }
         case MPK_NOTIFYDEAD:
             {
                 On_MPK_NOTIFYDEAD(rstMPK);
@@ -246,6 +246,9 @@ void Player::ReportCORecord(uint64_t toUID)
     stAMCOR.Action.AimUID      = 0;
     stAMCOR.Action.ActionParam = 0;
 
+    stAMCOR.HP    = HP();
+    stAMCOR.HPMax = HPMax();
+
     stAMCOR.Player.DBID  = DBID();
     stAMCOR.Player.JobID = JobID();
     stAMCOR.Player.Level = Level();
@@ -282,7 +285,7 @@ void Player::ReportAction(uint64_t nUID, const ActionNode &rstAction)
         stSMA.AimUID      = rstAction.AimUID;
         stSMA.ActionParam = rstAction.ActionParam;
 
-        g_netDriver->Post(ChannID(), SM_ACTION, stSMA);
+        postNetMessage(SM_ACTION, stSMA);
     }
 }
 
@@ -483,7 +486,7 @@ void Player::ReportOffline(uint64_t nUID, uint32_t nMapID)
         stSMO.UID   = nUID;
         stSMO.MapID = nMapID;
 
-        g_netDriver->Post(ChannID(), SM_OFFLINE, stSMO);
+        postNetMessage(SM_OFFLINE, stSMO);
     }
 }
 
@@ -498,10 +501,29 @@ bool Player::Offline()
 
 bool Player::postNetMessage(uint8_t nHC, const uint8_t *pData, size_t nDataLen)
 {
-    if(ChannID()){
-        return g_netDriver->Post(ChannID(), nHC, pData, nDataLen);
+    if(!ChannID()){
+        return false;
     }
-    return false;
+
+    if(UpdateFrame::batchable(nHC)){
+        m_updateFrame.add(nHC, pData, nDataLen);
+        return true;
+    }
+
+    // keep message order
+    // all updates queued before current message go first
+    flushUpdateFrame();
+    return g_netDriver->Post(ChannID(), nHC, pData, nDataLen);
+}
+
+bool Player::flushUpdateFrame()
+{
+    if(!ChannID() || m_updateFrame.empty()){
+        return false;
+    }
+
+    const auto &frameBuf = m_updateFrame.encode();
+    return g_netDriver->Post(ChannID(), SM_UPDATEFRAME, frameBuf.data(), frameBuf.size());
 }
 
 void Player::OnCMActionStand(CMAction stCMA)
@@ -671,7 +693,7 @@ void Player::OnCMActionSpell(CMAction stCMA)
 
                 Delay(1400, [this, stSMFM]()
                 {
-                    g_netDriver->Post(ChannID(), SM_FIREMAGIC, stSMFM);
+                    postNetMessage(SM_FIREMAGIC, stSMFM);
                 });
                 break;
             }
@@ -686,7 +708,7 @@ void Player::OnCMActionSpell(CMAction stCMA)
 
                 Delay(800, [this, stSMFM]()
                 {
-                    g_netDriver->Post(ChannID(), SM_FIREMAGIC, stSMFM);
+                    postNetMessage(SM_FIREMAGIC, stSMFM);
                 });
                 break;
             }
@@ -813,6 +835,7 @@ void Player::GainExp(int nExp)
         if(m_exp >= nLevelExp){
             m_exp    = m_exp - nLevelExp;
             m_level += 1;
+            ReportCORecord(MapUID());
         }
     }
 }
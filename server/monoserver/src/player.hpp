@@ -21,6 +21,7 @@
 #include <cstdint>
 #include "monoserver.hpp"
 #include "charobject.hpp"
+#include "updateframe.hpp"
 
 class Player final: public CharObject
 {
@@ -34,6 +35,11 @@ class Player final: public CharObject
     protected:
         uint32_t m_channID;
 
+    protected:
+        // entity updates posted in current tick
+        // sent as one SM_UPDATEFRAME by flushUpdateFrame()
+        UpdateFrameEncoder m_updateFrame;
+
     protected:
         uint32_t m_exp;
         uint32_t m_level;
@@ -101,6 +107,9 @@ class Player final: public CharObject
     protected:
         void OperateAM(const MessagePack &);
 
+    protected:
+        void onMetronome() override;
+
     private:
         void On_MPK_EXP(const MessagePack &);
         void On_MPK_MISS(const MessagePack &);
@@ -108,10 +117,10 @@ class Player final: public CharObject
         void On_MPK_ATTACK(const MessagePack &);
         void On_MPK_OFFLINE(const MessagePack &);
         void On_MPK_CORECORD(const MessagePack &);
+        void On_MPK_COSNAPSHOTLIST(const MessagePack &);
         void On_MPK_PICKUPOK(const MessagePack &);
         void On_MPK_UPDATEHP(const MessagePack &);
         void On_MPK_NPCQUERY(const MessagePack &);
-        void On_MPK_METRONOME(const MessagePack &);
         void On_MPK_MAPSWITCH(const MessagePack &);
         void On_MPK_NETPACKAGE(const MessagePack &);
         void On_MPK_BADCHANNEL(const MessagePack &);
@@ -176,11 +185,14 @@ class Player final: public CharObject
 
     private:
         bool postNetMessage(uint8_t, const uint8_t *, size_t);
-        template<typename T> bool postNetMessage(uint8_t nHC, T& stMessage)
+        template<typename T> bool postNetMessage(uint8_t nHC, const T &stMessage)
         {
             return postNetMessage(nHC, (const uint8_t *)(&stMessage), sizeof(stMessage));
         }
 
+    private:
+        bool flushUpdateFrame();
+
     protected:
         virtual bool GoDie();
         virtual bool GoGhost();
@@ -16,6 +16,7 @@
  * =====================================================================================
  */
 
+#include <algorithm>
 #include <cinttypes>
 #include "toll.hpp"
 #include "player.hpp"
@@ -28,13 +29,14 @@
 extern NetDriver *g_netDriver;
 extern MonoServer *g_monoServer;
 
-void Player::On_MPK_METRONOME(const MessagePack &)
+void Player::onMetronome()
 {
     update();
+    flushUpdateFrame();
 
     SMPing stSMP;
     stSMP.Tick = g_monoServer->getCurrTick();
-    g_netDriver->Post(ChannID(), SM_PING, stSMP);
+    postNetMessage(SM_PING, stSMP);
 }
 
 void Player::On_MPK_BADACTORPOD(const MessagePack &rstMPK)
@@ -52,6 +54,7 @@ void Player::On_MPK_BINDCHANNEL(const MessagePack &rstMPK)
     // bind channel here
     // set the channel actor as this->GetAddress()
     m_channID = stAMBC.ChannID;
+    m_updateFrame.reset();
 
     g_netDriver->BindActor(ChannID(), UID());
 
@@ -68,7 +71,11 @@ void Player::On_MPK_BINDCHANNEL(const MessagePack &rstMPK)
     stSMLOK.JobID     = JobID();
     stSMLOK.Level     = Level();
 
-    g_netDriver->Post(ChannID(), SM_LOGINOK, stSMLOK);
+    postNetMessage(SM_LOGINOK, stSMLOK);
+
+    // DBID, job and level are ready after bind
+    // refresh snapshot kept by map
+    ReportCORecord(MapUID());
     PullRectCO(10, 10);
 }
 
@@ -278,7 +285,7 @@ void Player::On_MPK_UPDATEHP(const MessagePack &rstMPK)
         stSMUHP.HP    = stAMUHP.HP;
         stSMUHP.HPMax = stAMUHP.HPMax;
 
-        g_netDriver->Post(ChannID(), SM_UPDATEHP, stSMUHP);
+        postNetMessage(SM_UPDATEHP, stSMUHP);
     }
 }
 
@@ -294,7 +301,7 @@ void Player::On_MPK_DEADFADEOUT(const MessagePack &rstMPK)
         stSMDFO.MapID = stAMDFO.MapID;
         stSMDFO.X     = stAMDFO.X;
         stSMDFO.Y     = stAMDFO.Y;
-        g_netDriver->Post(ChannID(), SM_DEADFADEOUT, stSMDFO);
+        postNetMessage(SM_DEADFADEOUT, stSMDFO);
     }
 }
 
@@ -308,7 +315,7 @@ void Player::On_MPK_EXP(const MessagePack &rstMPK)
     if(stAME.Exp > 0){
         SMExp stSME;
         stSME.Exp = stAME.Exp;
-        g_netDriver->Post(ChannID(), SM_EXP, stSME);
+        postNetMessage(SM_EXP, stSME);
     }
 }
 
@@ -347,7 +354,7 @@ void Player::On_MPK_SHOWDROPITEM(const MessagePack &rstMPK)
             break;
         }
     }
-    g_netDriver->Post(ChannID(), SM_SHOWDROPITEM, stSMSDI);
+    postNetMessage(SM_SHOWDROPITEM, stSMSDI);
 }
 
 void Player::On_MPK_NPCXMLLAYOUT(const MessagePack &msg)
@@ -475,6 +482,63 @@ void Player::On_MPK_CORECORD(const MessagePack &rstMPK)
     postNetMessage(SM_CORECORD, stSMCOR);
 }
 
+void Player::On_MPK_COSNAPSHOTLIST(const MessagePack &mpk)
+{
+    const auto amCOSL = mpk.conv<AMCOSnapshotList>();
+    const auto nCount = std::min<size_t>(amCOSL.Count, std::extent_v<decltype(amCOSL.SnapshotList)>);
+
+    for(size_t nIndex = 0; nIndex < nCount; ++nIndex){
+        const auto &rstSnapshot = amCOSL.SnapshotList[nIndex];
+
+        SMCORecord stSMCOR;
+        std::memset(&stSMCOR, 0, sizeof(stSMCOR));
+
+        stSMCOR.Action.UID   = rstSnapshot.UID;
+        stSMCOR.Action.MapID = amCOSL.MapID;
+
+        stSMCOR.Action.Action    = ACTION_STAND;
+        stSMCOR.Action.Speed     = SYS_DEFSPEED;
+        stSMCOR.Action.Direction = rstSnapshot.Direction;
+
+        stSMCOR.Action.X    = rstSnapshot.X;
+        stSMCOR.Action.Y    = rstSnapshot.Y;
+        stSMCOR.Action.AimX = rstSnapshot.X;
+        stSMCOR.Action.AimY = rstSnapshot.Y;
+
+        switch(uidf::getUIDType(rstSnapshot.UID)){
+            case UID_PLY:
+                {
+                    stSMCOR.Player.DBID  = rstSnapshot.Player.DBID;
+                    stSMCOR.Player.JobID = rstSnapshot.Player.JobID;
+                    stSMCOR.Player.Level = rstSnapshot.Player.Level;
+                    break;
+                }
+            case UID_MON:
+                {
+                    stSMCOR.Monster.MonsterID = rstSnapshot.Monster.MonsterID;
+                    break;
+                }
+            default:
+                {
+                    break;
+                }
+        }
+        postNetMessage(SM_CORECORD, stSMCOR);
+
+        // HP is unknown if CO never reports it
+        if(rstSnapshot.HPMax){
+            SMUpdateHP stSMUHP;
+            std::memset(&stSMUHP, 0, sizeof(stSMUHP));
+
+            stSMUHP.UID   = rstSnapshot.UID;
+            stSMUHP.MapID = amCOSL.MapID;
+            stSMUHP.HP    = rstSnapshot.HP;
+            stSMUHP.HPMax = rstSnapshot.HPMax;
+            postNetMessage(SM_UPDATEHP, stSMUHP);
+        }
+    }
+}
+
 void Player::On_MPK_NOTIFYDEAD(const MessagePack &)
 {
 }
@@ -18,6 +18,8 @@
 
 #pragma once
 #include <cstdint>
+#include <algorithm>
+#include "fflerror.hpp"
 #include "argparser.hpp"
 
 struct ServerArgParser
@@ -25,13 +27,21 @@ struct ServerArgParser
     const bool DisableMapScript;        // "--disable-map-script"
     const bool TraceActorMessage;       // "--trace-actor-message"
     const bool TraceActorMessageCount;  // "--trace-actor-message-count"
+    const bool ProfileActor;            // "--profile-actor"
+    const bool RecordActorMessage;      // "--record-actor-message"
     const bool useBvTree;               // "--use-bvtree"
     const int  ActorPoolThread;         // "--actor-pool-thread"
+    const int  CoroStackSize;           // "--coro-stack-size", in KB, must be positive
+    const int  MapScriptInstBudget;     // "--map-script-inst-budget", lua instructions per tick, 0 means unlimited
+    const int  MapScriptTimeBudget;     // "--map-script-time-budget", in us per tick, 0 means unlimited
+    const bool ShareMapScriptBytecode;  // "--share-map-script-bytecode"
 
     ServerArgParser(const argh::parser &cmdParser)
         : DisableMapScript(cmdParser["disable-map-script"])
         , TraceActorMessage(cmdParser["trace-actor-message"])
         , TraceActorMessageCount(cmdParser["trace-actor-message-count"])
+        , ProfileActor(cmdParser["profile-actor"])
+        , RecordActorMessage(cmdParser["record-actor-message"])
         , useBvTree(cmdParser["use-bvtree"])
         , ActorPoolThread([&cmdParser]()
           {
@@ -44,5 +54,47 @@ struct ServerArgParser
               }
               return 1;
           }())
+        , CoroStackSize([&cmdParser]()
+          {
+              // every monster coroutine needs its own stack
+              // actors sharing one stack can be resumed by different worker threads at the same time
+              if(auto szStackSize = cmdParser("coro-stack-size").str(); !szStackSize.empty()){
+                  int nStackSize = 256;
+                  try{
+                      nStackSize = std::stoi(szStackSize);
+                  }catch(...){
+                      return 256;
+                  }
+
+                  if(nStackSize <= 0){
+                      throw fflerror("invalid --coro-stack-size: %s, requires positive size in KB", szStackSize.c_str());
+                  }
+                  return nStackSize;
+              }
+              return 256;
+          }())
+        , MapScriptInstBudget([&cmdParser]()
+          {
+              if(auto szBudget = cmdParser("map-script-inst-budget").str(); !szBudget.empty()){
+                  try{
+                      return std::max<int>(0, std::stoi(szBudget));
+                  }catch(...){
+                      return 100000;
+                  }
+              }
+              return 100000;
+          }())
+        , MapScriptTimeBudget([&cmdParser]()
+          {
+              if(auto szBudget = cmdParser("map-script-time-budget").str(); !szBudget.empty()){
+                  try{
+                      return std::max<int>(0, std::stoi(szBudget));
+                  }catch(...){
+                      return 2000;
+                  }
+              }
+              return 2000;
+          }())
+        , ShareMapScriptBytecode(cmdParser["share-map-script-bytecode"])
     {}
 };
@@ -16,10 +16,14 @@
  * =====================================================================================
  */
 
+#include <mutex>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <type_traits>
+#include <unordered_map>
 #include "uidf.hpp"
+#include "toll.hpp"
 #include "npchar.hpp"
 #include "player.hpp"
 #include "dbcomid.hpp"
@@ -34,19 +38,95 @@
 #include "charobject.hpp"
 #include "monoserver.hpp"
 #include "dbcomrecord.hpp"
+#include "raiitimer.hpp"
 #include "rotatecoord.hpp"
+#include "serverargparser.hpp"
 #include "serverconfigurewindow.hpp"
 
 extern MapBinDB *g_mapBinDB;
 extern MonoServer *g_monoServer;
+extern ServerArgParser *g_serverArgParser;
 extern ServerConfigureWindow *g_serverConfigureWindow;
 
-ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
+namespace
 {
-    if(!mapPtr){
-        throw fflerror("ServerMapLuaModule binds to empty ServerMap");
+    // budget of the map script being resumed by current thread
+    // set only during ServerMapLuaModule::resumeLoop(), hook does nothing otherwise
+    struct MapScriptBudget
+    {
+        lua_State *lua = nullptr;
+        hres_timer timer;
+
+        uint64_t maxNanos        = 0;
+        uint64_t maxInstructions = 0;
+        uint64_t instructions    = 0;
+
+        bool overrun = false;
+    };
+
+    thread_local MapScriptBudget *t_mapScriptBudget = nullptr;
+
+    void mapScriptBudgetHook(lua_State *pLua, lua_Debug *)
+    {
+        // coroutines created by the script inherit the hook, only yield main()
+        auto pBudget = t_mapScriptBudget;
+        if(!pBudget || pBudget->lua != pLua){
+            return;
+        }
+
+        pBudget->instructions += SYS_MAPSCRIPTHOOKSTEP;
+        if(false
+                || (pBudget->maxInstructions && pBudget->instructions >= pBudget->maxInstructions)
+                || (pBudget->maxNanos && pBudget->timer.diff_nsec() >= pBudget->maxNanos)){
+
+            // can't yield inside C functions or metamethods
+            // keep running and check again in next step
+            if(lua_isyieldable(pLua)){
+                pBudget->overrun = true;
+                lua_yield(pLua, 0);
+            }
+        }
     }
 
+    // compiled chunk of each script file, shared by all maps using it
+    // every lua_State still creates its own prototype, this saves reading and parsing the file per map
+    const std::string &loadMapScriptBytecode(lua_State *pLua, const std::string &scriptName)
+    {
+        static std::mutex s_bytecodeLock;
+        static std::unordered_map<std::string, std::string> s_bytecodeTable;
+
+        const std::lock_guard<std::mutex> lockGuard(s_bytecodeLock);
+        if(auto p = s_bytecodeTable.find(scriptName); p != s_bytecodeTable.end()){
+            return p->second;
+        }
+
+        if(luaL_loadfile(pLua, scriptName.c_str()) != LUA_OK){
+            const std::string errInfo = lua_tostring(pLua, -1) ? lua_tostring(pLua, -1) : "unknown error";
+            lua_pop(pLua, 1);
+            throw fflerror("failed to compile map script %s: %s", scriptName.c_str(), errInfo.c_str());
+        }
+
+        std::string bytecode;
+        lua_dump(pLua, [](lua_State *, const void *pData, size_t nSize, void *pBytecode) -> int
+        {
+            static_cast<std::string *>(pBytecode)->append(static_cast<const char *>(pData), nSize);
+            return 0;
+        }, &bytecode, 0);
+
+        lua_pop(pLua, 1);
+        return s_bytecodeTable.emplace(scriptName, std::move(bytecode)).first->second;
+    }
+}
+
+ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
+    : m_mapPtr([mapPtr]() -> ServerMap *
+      {
+          if(!mapPtr){
+              throw fflerror("ServerMapLuaModule binds to empty ServerMap");
+          }
+          return mapPtr;
+      }())
+{
     getLuaState().set_function("scriptDone", []() -> bool
     {
         return false;
@@ -62,6 +142,11 @@ ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
         return std::string(DBCOM_MAPRECORD(mapPtr->ID()).Name);
     });
 
+    getLuaState().set_function("getMemoryReport", [mapPtr]() -> std::string
+    {
+        return mapPtr->memoryReport();
+    });
+
     getLuaState().set_function("getMonsterList", [mapPtr](sol::this_state thisLua)
     {
         return sol::make_object(sol::state_view(thisLua), mapPtr->getMonsterList());
@@ -213,7 +298,12 @@ ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
         return false;
     });
 
-    getLuaState().script_file([mapPtr]() -> std::string
+    getLuaState().set_function("getScriptReport", [this]() -> std::string
+    {
+        return scriptReport();
+    });
+
+    const auto scriptName = [mapPtr]() -> std::string
     {
         const auto configScriptPath = g_serverConfigureWindow->GetScriptPath();
         const auto scriptPath = configScriptPath.empty() ? std::string("script/map") : configScriptPath;
@@ -228,7 +318,21 @@ ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
             return defaultScriptName;
         }
         throw fflerror("can't load proper script for map %s", DBCOM_MAPRECORD(mapPtr->ID()).Name);
-    }());
+    }();
+
+    if(g_serverArgParser->ShareMapScriptBytecode){
+        lua_State *pLua = getLuaState().lua_state();
+        const auto &bytecode = loadMapScriptBytecode(pLua, scriptName);
+
+        if(luaL_loadbufferx(pLua, bytecode.data(), bytecode.size(), ("@" + scriptName).c_str(), "b") != LUA_OK || lua_pcall(pLua, 0, 0, 0) != LUA_OK){
+            const std::string errInfo = lua_tostring(pLua, -1) ? lua_tostring(pLua, -1) : "unknown error";
+            lua_pop(pLua, 1);
+            throw fflerror("failed to run map script %s: %s", scriptName.c_str(), errInfo.c_str());
+        }
+    }
+    else{
+        getLuaState().script_file(scriptName);
+    }
 
     m_coHandler = getLuaState()["main"];
     if(!m_coHandler){
@@ -238,6 +342,47 @@ ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
     // checkResult(m_coHandler());
 }
 
+void ServerMap::ServerMapLuaModule::resumeLoop()
+{
+    if(!m_coHandler){
+        throw fflerror("ServerMap lua coroutine is not callable");
+    }
+
+    MapScriptBudget stBudget;
+    stBudget.lua             = getLuaState().lua_state();
+    stBudget.maxNanos        = (uint64_t)(g_serverArgParser->MapScriptTimeBudget) * 1000;
+    stBudget.maxInstructions = (uint64_t)(g_serverArgParser->MapScriptInstBudget);
+
+    const bool bBudget = stBudget.maxNanos || stBudget.maxInstructions;
+    if(bBudget){
+        t_mapScriptBudget = &stBudget;
+        lua_sethook(stBudget.lua, mapScriptBudgetHook, LUA_MASKCOUNT, SYS_MAPSCRIPTHOOKSTEP);
+    }
+
+    const auto result = m_coHandler();
+
+    if(bBudget){
+        lua_sethook(stBudget.lua, nullptr, 0, 0);
+        t_mapScriptBudget = nullptr;
+    }
+
+    // CPU usage of the script is shown in the actor monitor of the map
+    m_mapPtr->m_actorPod->recordScript(stBudget.timer.diff_nsec(), stBudget.overrun);
+    checkResult(result);
+}
+
+std::string ServerMap::ServerMapLuaModule::scriptReport() const
+{
+    const auto &rstScript = m_mapPtr->m_actorPod->scriptMonitor();
+    return str_printf("Map script %s: resume %llu, overrun %llu, total %.3fms, average %.3fus, max %.3fus",
+            DBCOM_MAPRECORD(m_mapPtr->ID()).Name,
+            to_llu(rstScript.ResumeCount),
+            to_llu(rstScript.OverrunCount),
+            rstScript.ProcTick / 1000000.0,
+            rstScript.ResumeCount ? (rstScript.ProcTick / 1000.0 / rstScript.ResumeCount) : 0.0,
+            rstScript.MaxProcTick / 1000.0);
+}
+
 ServerMap::ServerPathFinder::ServerPathFinder(const ServerMap *pMap, int nMaxStep, int nCheckCO)
     : AStarPathFinder([this](int nSrcX, int nSrcY, int nDstX, int nDstY) -> double
       {
@@ -306,10 +451,11 @@ ServerMap::ServerPathFinder::ServerPathFinder(const ServerMap *pMap, int nMaxSte
     }
 }
 
-ServerMap::ServerMap(ServiceCore *pServiceCore, uint32_t nMapID)
-    : ServerObject(uidf::buildMapUID(nMapID))
+ServerMap::ServerMap(ServiceCore *pServiceCore, uint32_t nMapID, uint32_t nInstance)
+    : ServerObject(uidf::buildMapUID(nMapID, nInstance))
     , m_ID(nMapID)
-    , m_mir2xMapData(*([nMapID]() -> Mir2xMapData *
+    , m_instance(nInstance)
+    , m_mir2xMapData([nMapID]() -> std::shared_ptr<const Mir2xMapData>
       {
           // server is multi-thread
           // but creating server map is always in service core
@@ -321,20 +467,19 @@ ServerMap::ServerMap(ServiceCore *pServiceCore, uint32_t nMapID)
           // when constructing a servermap
           // servicecore should test if current nMapID valid
           throw fflerror("load map failed: ID = %d, Name = %s", nMapID, DBCOM_MAPRECORD(nMapID).Name);
-      }()))
+      }())
     , m_serviceCore(pServiceCore)
+    , m_regionW((m_mir2xMapData->W() + SYS_AIREGIONSIZE - 1) / SYS_AIREGIONSIZE)
+    , m_regionH((m_mir2xMapData->H() + SYS_AIREGIONSIZE - 1) / SYS_AIREGIONSIZE)
+    , m_regionPlayerCount(std::make_unique<std::atomic<int>[]>((size_t)(m_regionW) * (size_t)(m_regionH)))
 {
-    if(!m_mir2xMapData.Valid()){
+    if(!m_mir2xMapData->Valid()){
         throw fflerror("load map failed: ID = %d, Name = %s", nMapID, DBCOM_MAPRECORD(nMapID).Name);
     }
 
-    m_cellVec2D.resize(W());
-    m_cellVec2D.shrink_to_fit();
-
-    for(auto &rstStateLine: m_cellVec2D){
-        rstStateLine.resize(H());
-        rstStateLine.shrink_to_fit();
-    }
+    const size_t nCellCount = (size_t)(W()) * (size_t)(H());
+    m_lockBits  .resize((nCellCount + 63) / 64, 0);
+    m_occupyBits.resize((nCellCount + 63) / 64, 0);
 
     for(auto stLinkEntry: DBCOM_MAPRECORD(nMapID).LinkArray){
         if(true
@@ -342,17 +487,58 @@ ServerMap::ServerMap(ServiceCore *pServiceCore, uint32_t nMapID)
                 && stLinkEntry.H > 0
                 && ValidC(stLinkEntry.X, stLinkEntry.Y)){
 
-            for(int nW = 0; nW < stLinkEntry.W; ++nW){
-                for(int nH = 0; nH < stLinkEntry.H; ++nH){
-                    getCell(stLinkEntry.X + nW,stLinkEntry.Y + nH).mapID   = DBCOM_MAPID(stLinkEntry.EndName);
-                    getCell(stLinkEntry.X + nW,stLinkEntry.Y + nH).switchX = stLinkEntry.EndX;
-                    getCell(stLinkEntry.X + nW,stLinkEntry.Y + nH).switchY = stLinkEntry.EndY;
-                }
-            }
+            m_switchLinkList.push_back(SwitchLink
+            {
+                stLinkEntry.X,
+                stLinkEntry.Y,
+                stLinkEntry.W,
+                stLinkEntry.H,
+
+                DBCOM_MAPID(stLinkEntry.EndName),
+                stLinkEntry.EndX,
+                stLinkEntry.EndY,
+            });
         }else{
             break;
         }
     }
+    g_monoServer->addLog(LOGTYPE_DEBUG, "%s", memoryReport().c_str());
+}
+
+std::string ServerMap::memoryReport() const
+{
+    // estimate of heap usage by cell states
+    // hash node counts key, value and two pointers, buckets count one pointer each
+    const auto fnTableBytes = [](const auto &table, size_t nValueBytes) -> size_t
+    {
+        return table.size() * (sizeof(typename std::decay_t<decltype(table)>::value_type) + 2 * sizeof(void *) + nValueBytes) + table.bucket_count() * sizeof(void *);
+    };
+
+    size_t nUIDBytes = 0;
+    size_t nUIDCount = 0;
+
+    for(const auto &p: m_uidListTable){
+        nUIDBytes += p.second.capacity() * sizeof(uint64_t);
+        nUIDCount += p.second.size();
+    }
+
+    const size_t nLockBytes   = m_lockBits.capacity() * sizeof(uint64_t);
+    const size_t nOccupyBytes = m_occupyBits.capacity() * sizeof(uint64_t) + fnTableBytes(m_uidListTable, 0) + nUIDBytes;
+    const size_t nItemBytes   = fnTableBytes(m_groundItemTable, 0);
+    const size_t nLinkBytes   = m_switchLinkList.capacity() * sizeof(SwitchLink);
+    const size_t nSnapBytes   = fnTableBytes(m_snapshotTable, 0);
+    const size_t nRegionBytes = (size_t)(m_regionW) * (size_t)(m_regionH) * sizeof(std::atomic<int>);
+
+    // terrain is shared, not counted in total
+    return str_printf("Map %s (instance %u, %dx%d, terrain shared by %ld): lock %zu bytes, occupancy %zu bytes (%zu cells, %zu UIDs), ground item %zu bytes (%zu cells), link %zu bytes (%zu links), snapshot %zu bytes (%zu COs), region %zu bytes (%dx%d), total %zu bytes",
+            DBCOM_MAPRECORD(ID()).Name, instance(), W(), H(), m_mir2xMapData.use_count(),
+            nLockBytes,
+            nOccupyBytes, m_uidListTable.size(), nUIDCount,
+            nItemBytes, m_groundItemTable.size(),
+            nLinkBytes, m_switchLinkList.size(),
+            nSnapBytes, m_snapshotTable.size(),
+            nRegionBytes, m_regionW, m_regionH,
+            nLockBytes + nOccupyBytes + nItemBytes + nLinkBytes + nSnapBytes + nRegionBytes);
 }
 
 void ServerMap::OperateAM(const MessagePack &rstMPK)
@@ -408,11 +594,6 @@ void ServerMap::OperateAM(const MessagePack &rstMPK)
                 On_MPK_TRYMAPSWITCH(rstMPK);
                 break;
             }
-        case MPK_METRONOME:
-            {
-                On_MPK_METRONOME(rstMPK);
-                break;
-            }
         case MPK_TRYSPACEMOVE:
             {
                 On_MPK_TRYSPACEMOVE(rstMPK);
@@ -428,6 +609,11 @@ void ServerMap::OperateAM(const MessagePack &rstMPK)
                 On_MPK_PULLCOINFO(rstMPK);
                 break;
             }
+        case MPK_CORECORD:
+            {
+                On_MPK_CORECORD(rstMPK);
+                break;
+            }
         case MPK_QUERYCOCOUNT:
             {
                 On_MPK_QUERYCOCOUNT(rstMPK);
@@ -438,6 +624,11 @@ void ServerMap::OperateAM(const MessagePack &rstMPK)
                 On_MPK_QUERYRECTUIDLIST(rstMPK);
                 break;
             }
+        case MPK_DESTROYMAPINSTANCE:
+            {
+                On_MPK_DESTROYMAPINSTANCE(rstMPK);
+                break;
+            }
         case MPK_OFFLINE:
             {
                 On_MPK_OFFLINE(rstMPK);
@@ -454,9 +645,9 @@ void ServerMap::OperateAM(const MessagePack &rstMPK)
 bool ServerMap::groundValid(int nX, int nY) const
 {
     return true
-        && m_mir2xMapData.Valid()
-        && m_mir2xMapData.ValidC(nX, nY)
-        && m_mir2xMapData.Cell(nX, nY).CanThrough();
+        && m_mir2xMapData->Valid()
+        && m_mir2xMapData->ValidC(nX, nY)
+        && m_mir2xMapData->Cell(nX, nY).CanThrough();
 }
 
 bool ServerMap::canMove(bool bCheckCO, bool bCheckLock, int nX, int nY) const
@@ -471,7 +662,7 @@ bool ServerMap::canMove(bool bCheckCO, bool bCheckLock, int nX, int nY) const
         }
 
         if(bCheckLock){
-            if(getCell(nX, nY).Locked){
+            if(cellLocked(nX, nY)){
                 return false;
             }
         }
@@ -663,7 +854,13 @@ void ServerMap::addGridUID(uint64_t uid, int nX, int nY, bool bForce)
 
     if(bForce || groundValid(nX, nY)){
         if(!hasGridUID(uid, nX, nY)){
-            getUIDList(nX, nY).push_back(uid);
+            const auto nIndex = cellIndex(nX, nY);
+            m_uidListTable[nIndex].push_back(uid);
+            setBit(m_occupyBits, nIndex, true);
+
+            if(uidf::getUIDType(uid) == UID_PLY){
+                updateRegionPlayer(nX, nY, 1);
+            }
         }
     }
 }
@@ -684,7 +881,14 @@ void ServerMap::removeGridUID(uint64_t uid, int nX, int nY)
         throw fflerror("invalid location: (%d, %d)", nX, nY);
     }
 
-    auto &uidList = getUIDList(nX, nY);
+    const auto nIndex = cellIndex(nX, nY);
+    auto pList = m_uidListTable.find(nIndex);
+
+    if(pList == m_uidListTable.end()){
+        return;
+    }
+
+    auto &uidList = pList->second;
     auto p = std::find(uidList.begin(), uidList.end(), uid); 
 
     if(p == uidList.end()){
@@ -694,8 +898,82 @@ void ServerMap::removeGridUID(uint64_t uid, int nX, int nY)
     std::swap(uidList.back(), *p);
     uidList.pop_back();
 
-    if(uidList.size() * 2 < uidList.capacity()){
-        uidList.shrink_to_fit();
+    if(uidList.empty()){
+        m_uidListTable.erase(pList);
+        setBit(m_occupyBits, nIndex, false);
+    }
+
+    if(uidf::getUIDType(uid) == UID_PLY){
+        updateRegionPlayer(nX, nY, -1);
+    }
+}
+
+int ServerMap::regionPlayerNeighbor(int nRegionX, int nRegionY) const
+{
+    int nCount = 0;
+    for(int nY = std::max<int>(0, nRegionY - 1); nY <= std::min<int>(m_regionH - 1, nRegionY + 1); ++nY){
+        for(int nX = std::max<int>(0, nRegionX - 1); nX <= std::min<int>(m_regionW - 1, nRegionX + 1); ++nX){
+            nCount += m_regionPlayerCount[nX + nY * m_regionW].load(std::memory_order_relaxed);
+        }
+    }
+    return nCount;
+}
+
+bool ServerMap::regionObserved(int nX, int nY) const
+{
+    if(!ValidC(nX, nY)){
+        return false;
+    }
+    return regionPlayerNeighbor(nX / SYS_AIREGIONSIZE, nY / SYS_AIREGIONSIZE) > 0;
+}
+
+void ServerMap::updateRegionPlayer(int nX, int nY, int nDiff)
+{
+    const int nRegionX = nX / SYS_AIREGIONSIZE;
+    const int nRegionY = nY / SYS_AIREGIONSIZE;
+    auto &rstCount = m_regionPlayerCount[nRegionX + nRegionY * m_regionW];
+
+    if(nDiff <= 0 || rstCount.load(std::memory_order_relaxed) > 0){
+        rstCount.fetch_add(nDiff, std::memory_order_relaxed);
+        return;
+    }
+
+    // first player in this region
+    // wake monsters in neighbor regions which were not observed
+    std::vector<std::tuple<int, int>> stWakeList;
+    for(int nCurrY = std::max<int>(0, nRegionY - 1); nCurrY <= std::min<int>(m_regionH - 1, nRegionY + 1); ++nCurrY){
+        for(int nCurrX = std::max<int>(0, nRegionX - 1); nCurrX <= std::min<int>(m_regionW - 1, nRegionX + 1); ++nCurrX){
+            if(regionPlayerNeighbor(nCurrX, nCurrY) == 0){
+                stWakeList.emplace_back(nCurrX, nCurrY);
+            }
+        }
+    }
+
+    // increase before waking
+    // then woken monsters see it observed
+    rstCount.fetch_add(nDiff, std::memory_order_relaxed);
+    for(const auto [nWakeX, nWakeY]: stWakeList){
+        wakeRegion(nWakeX, nWakeY);
+    }
+}
+
+void ServerMap::wakeRegion(int nRegionX, int nRegionY)
+{
+    const int nX0 = nRegionX * SYS_AIREGIONSIZE;
+    const int nY0 = nRegionY * SYS_AIREGIONSIZE;
+
+    for(int nY = nY0; nY < std::min<int>(H(), nY0 + SYS_AIREGIONSIZE); ++nY){
+        for(int nX = nX0; nX < std::min<int>(W(), nX0 + SYS_AIREGIONSIZE); ++nX){
+            if(!testBit(m_occupyBits, cellIndex(nX, nY))){
+                continue;
+            }
+
+            for(const auto nUID: getUIDList(nX, nY)){
+                if(uidf::getUIDType(nUID) == UID_MON){
+                    m_actorPod->forward(nUID, MPK_WAKEUP);
+                }
+            }
+        }
     }
 }
 
@@ -850,7 +1128,7 @@ bool ServerMap::DoCenterSquare(int nCX, int nCY, int nW, int nH, bool bPriority,
     return false;
 }
 
-int ServerMap::FindGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
+int ServerMap::FindGroundItem(const CommonItem &rstCommonItem, int nX, int nY) const
 {
     if(ValidC(nX, nY)){
         auto &rstGroundItemList = GetGroundItemList(nX, nY);
@@ -863,7 +1141,7 @@ int ServerMap::FindGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
     return -1;
 }
 
-int ServerMap::GroundItemCount(const CommonItem &rstCommonItem, int nX, int nY)
+int ServerMap::GroundItemCount(const CommonItem &rstCommonItem, int nX, int nY) const
 {
     if(ValidC(nX, nY)){
         auto &rstGroundItemList = GetGroundItemList(nX, nY);
@@ -882,11 +1160,17 @@ void ServerMap::RemoveGroundItem(const CommonItem &rstCommonItem, int nX, int nY
 {
     auto nFind = FindGroundItem(rstCommonItem, nX, nY);
     if(nFind >= 0){
-        auto &rstGroundItemList = GetGroundItemList(nX, nY);
+        auto p = m_groundItemTable.find(cellIndex(nX, nY));
+        auto &rstGroundItemList = p->second;
+
         for(int nIndex = nFind; nIndex < ((int)(rstGroundItemList.Length()) - 1); ++nIndex){
             rstGroundItemList[nIndex] = rstGroundItemList[nIndex + 1];
         }
+
         rstGroundItemList.PopBack();
+        if(rstGroundItemList.Empty()){
+            m_groundItemTable.erase(p);
+        }
     }
 }
 
@@ -899,7 +1183,7 @@ bool ServerMap::AddGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
         // check if item is valid
         // then push back and report, would override if already full
 
-        auto &rstGroundItemList = GetGroundItemList(nX, nY);
+        auto &rstGroundItemList = m_groundItemTable[cellIndex(nX, nY)];
         rstGroundItemList.PushBack(rstCommonItem);
 
         AMShowDropItem stAMSDI;
@@ -942,15 +1226,13 @@ bool ServerMap::AddGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
 int ServerMap::GetMonsterCount(uint32_t nMonsterID)
 {
     int nCount = 0;
-    for(int nX = 0; nX < W(); ++nX){
-        for(int nY = 0; nY < H(); ++nY){
-            for(auto nUID: getUIDList(nX, nY)){
-                if(uidf::getUIDType(nUID) == UID_MON){
-                    if(nMonsterID){
-                        nCount += ((uidf::getMonsterID(nUID) == nMonsterID) ? 1 : 0);
-                    }else{
-                        nCount++;
-                    }
+    for(const auto &p: m_uidListTable){
+        for(auto nUID: p.second){
+            if(uidf::getUIDType(nUID) == UID_MON){
+                if(nMonsterID){
+                    nCount += ((uidf::getMonsterID(nUID) == nMonsterID) ? 1 : 0);
+                }else{
+                    nCount++;
                 }
             }
         }
@@ -1090,11 +1372,11 @@ Player *ServerMap::AddPlayer(uint32_t nDBID, int nHintX, int nHintY, int nDirect
 
 int ServerMap::CheckPathGrid(int nX, int nY) const
 {
-    if(!m_mir2xMapData.ValidC(nX, nY)){
+    if(!m_mir2xMapData->ValidC(nX, nY)){
         return PathFind::INVALID;
     }
 
-    if(!m_mir2xMapData.Cell(nX, nY).CanThrough()){
+    if(!m_mir2xMapData->Cell(nX, nY).CanThrough()){
         return PathFind::OBSTACLE;
     }
 
@@ -1108,7 +1390,7 @@ int ServerMap::CheckPathGrid(int nX, int nY) const
         return PathFind::OCCUPIED;
     }
 
-    if(getCell(nX, nY).Locked){
+    if(cellLocked(nX, nY)){
         return PathFind::LOCKED;
     }
 
@@ -19,8 +19,12 @@
 #pragma once
 
 #include <tuple>
+#include <atomic>
+#include <memory>
+#include <string>
 #include <vector>
 #include <cstdint>
+#include <unordered_map>
 
 #include "sysconst.hpp"
 #include "querytype.hpp"
@@ -42,6 +46,9 @@ class ServerMap final: public ServerObject
     private:
         class ServerMapLuaModule: public ServerLuaModule
         {
+            private:
+                ServerMap * const m_mapPtr;
+
             private:
                 sol::coroutine m_coHandler;
 
@@ -49,13 +56,12 @@ class ServerMap final: public ServerObject
                 ServerMapLuaModule(ServerMap *);
 
             public:
-                void resumeLoop()
-                {
-                    if(!m_coHandler){
-                        throw fflerror("ServerMap lua coroutine is not callable");
-                    }
-                    checkResult(m_coHandler());
-                }
+                // resume main() once per metronome with instruction and time budget
+                // script exceeds the budget gets yielded by the hook and continues next tick
+                void resumeLoop();
+
+            public:
+                std::string scriptReport() const;
 
             private:
                 template<typename T> void checkResult(const T &result)
@@ -95,43 +101,56 @@ class ServerMap final: public ServerObject
         friend class ServerPathFinder;
 
     private:
-        struct MapCell
+        struct SwitchLink
         {
-            bool Locked;
-            std::vector<uint64_t> UIDList;
-
-            uint32_t mapID;
-            int      switchX;
-            int      switchY;
-
-            CacheQueue<CommonItem, SYS_MAXDROPITEM> GroundItemQueue;
-
-            MapCell()
-                : Locked(false)
-                , mapID(0)
-                , switchX(-1)
-                , switchY(-1)
-                , GroundItemQueue()
-            {}
-
-            bool empty() const
-            {
-                return !Locked && UIDList.empty() && (mapID == 0) && GroundItemQueue.Empty();
-            }
+            int X;
+            int Y;
+            int W;
+            int H;
+
+            uint32_t MapID;
+            int      SwitchX;
+            int      SwitchY;
         };
 
     private:
-        template<typename T> using Vec2D = std::vector<std::vector<T>>;
+        using GroundItemQueue = CacheQueue<CommonItem, SYS_MAXDROPITEM>;
 
     private:
-        const uint32_t     m_ID;
-        const Mir2xMapData m_mir2xMapData;
+        const uint32_t m_ID;
+        const uint32_t m_instance;
+
+    private:
+        // terrain is read-only and shared by all instances of this map
+        const std::shared_ptr<const Mir2xMapData> m_mir2xMapData;
 
     private:
         ServiceCore *m_serviceCore;
 
     private:
-        Vec2D<MapCell> m_cellVec2D;
+        // cell states are sparse, most cells never get locked, hold items or link to other map
+        // cell index is x + y * W(), only the lock and occupancy bits are dense
+        std::vector<uint64_t> m_lockBits;
+        std::vector<uint64_t> m_occupyBits;
+
+    private:
+        std::vector<SwitchLink> m_switchLinkList;
+
+    private:
+        std::unordered_map<uint32_t, std::vector<uint64_t>> m_uidListTable;
+        std::unordered_map<uint32_t, GroundItemQueue>       m_groundItemTable;
+
+    private:
+        // snapshots of players and monsters on this map, reported by COs and kept by map messages
+        // pull requests get answered from here without a query round trip to each CO
+        std::unordered_map<uint64_t, AMCOSnapshot> m_snapshotTable;
+
+    private:
+        // player count of each region, for monster hibernation
+        // only written in map thread, monsters read it in their own threads
+        const int m_regionW;
+        const int m_regionH;
+        const std::unique_ptr<std::atomic<int>[]> m_regionPlayerCount;
 
     private:
         ServerMapLuaModule *m_luaModulePtr = nullptr;
@@ -139,12 +158,16 @@ class ServerMap final: public ServerObject
     private:
         void OperateAM(const MessagePack &);
 
+    private:
+        void onMetronome() override;
+
     public:
-        ServerMap(ServiceCore *, uint32_t);
+        ServerMap(ServiceCore *, uint32_t, uint32_t = 0);
        ~ServerMap() = default;
 
     public:
         uint32_t ID() const { return m_ID; }
+        uint32_t instance() const { return m_instance; }
 
     public:
         bool In(uint32_t nMapID, int nX, int nY) const
@@ -164,29 +187,29 @@ class ServerMap final: public ServerObject
     public:
         const Mir2xMapData &GetMir2xMapData() const
         {
-            return m_mir2xMapData;
+            return *m_mir2xMapData;
         }
 
     public:
         int W() const
         {
-            return m_mir2xMapData.Valid() ? m_mir2xMapData.W() : 0;
+            return m_mir2xMapData->Valid() ? m_mir2xMapData->W() : 0;
         }
 
         int H() const
         {
-            return m_mir2xMapData.Valid() ? m_mir2xMapData.H() : 0;
+            return m_mir2xMapData->Valid() ? m_mir2xMapData->H() : 0;
         }
 
     public:
         bool ValidC(int nX, int nY) const
         {
-            return m_mir2xMapData.ValidC(nX, nY);
+            return m_mir2xMapData->ValidC(nX, nY);
         }
 
         bool ValidP(int nX, int nY) const
         {
-            return m_mir2xMapData.ValidP(nX, nY);
+            return m_mir2xMapData->ValidP(nX, nY);
         }
 
     public:
@@ -217,47 +240,94 @@ class ServerMap final: public ServerObject
         std::vector<std::string> getMonsterList() const;
 
     private:
-        auto &getCell(int nX, int nY)
+        uint32_t cellIndex(int nX, int nY) const
         {
             if(!ValidC(nX, nY)){
                 throw fflerror("invalid location: x = %d, y = %d", nX, nY);
             }
-            return m_cellVec2D[nX][nY];
+            return (uint32_t)(nX) + (uint32_t)(nY) * (uint32_t)(W());
         }
 
-        const auto &getCell(int nX, int nY) const
+        static bool testBit(const std::vector<uint64_t> &bits, uint32_t nIndex)
         {
-            if(!ValidC(nX, nY)){
-                throw fflerror("invalid location: x = %d, y = %d", nX, nY);
+            return bits[nIndex / 64] & (1ULL << (nIndex % 64));
+        }
+
+        static void setBit(std::vector<uint64_t> &bits, uint32_t nIndex, bool bValue)
+        {
+            if(bValue){
+                bits[nIndex / 64] |=  (1ULL << (nIndex % 64));
+            }else{
+                bits[nIndex / 64] &= ~(1ULL << (nIndex % 64));
             }
-            return m_cellVec2D[nX][nY];
         }
 
     private:
-        auto &getUIDList(int nX, int nY)
+        bool cellLocked(int nX, int nY) const
+        {
+            return testBit(m_lockBits, cellIndex(nX, nY));
+        }
+
+        void lockCell(int nX, int nY, bool bLock)
         {
-            return getCell(nX, nY).UIDList;
+            setBit(m_lockBits, cellIndex(nX, nY), bLock);
         }
 
-        const auto &getUIDList(int nX, int nY) const
+    private:
+        const SwitchLink *getSwitchLink(int nX, int nY) const
         {
-            return getCell(nX, nY).UIDList;
+            // only a few links per map, linear search is fine
+            // search backward, a later link overrides overlapping cells like the old per-cell table
+            for(auto p = m_switchLinkList.rbegin(); p != m_switchLinkList.rend(); ++p){
+                if(true
+                        && nX >= p->X && nX < p->X + p->W
+                        && nY >= p->Y && nY < p->Y + p->H){
+                    return &(*p);
+                }
+            }
+            return nullptr;
         }
 
     private:
-        auto &GetGroundItemList(int nX, int nY)
+        // returned list is invalidated by addGridUID() and removeGridUID()
+        const std::vector<uint64_t> &getUIDList(int nX, int nY) const
         {
-            return getCell(nX, nY).GroundItemQueue;
+            const static std::vector<uint64_t> s_emptyUIDList;
+            if(const auto nIndex = cellIndex(nX, nY); testBit(m_occupyBits, nIndex)){
+                if(auto p = m_uidListTable.find(nIndex); p != m_uidListTable.end()){
+                    return p->second;
+                }
+                throw fflerror("occupancy index broken: x = %d, y = %d", nX, nY);
+            }
+            return s_emptyUIDList;
         }
 
-        const auto &GetGroundItemList(int nX, int nY) const
+    private:
+        const GroundItemQueue &GetGroundItemList(int nX, int nY) const
         {
-            return getCell(nX, nY).GroundItemQueue;
+            const static GroundItemQueue s_emptyGroundItemQueue;
+            if(auto p = m_groundItemTable.find(cellIndex(nX, nY)); p != m_groundItemTable.end()){
+                return p->second;
+            }
+            return s_emptyGroundItemQueue;
         }
 
+    public:
+        std::string memoryReport() const;
+
+    public:
+        // any player in the 3 x 3 regions around (nX, nY)
+        // thread safe, may be stale for one message round trip
+        bool regionObserved(int, int) const;
+
+    private:
+        int regionPlayerNeighbor(int, int) const;
+        void updateRegionPlayer(int, int, int);
+        void wakeRegion(int, int);
+
     private:
-        int FindGroundItem(const CommonItem &, int, int);
-        int GroundItemCount(const CommonItem &, int, int);
+        int FindGroundItem(const CommonItem &, int, int) const;
+        int GroundItemCount(const CommonItem &, int, int) const;
 
         bool AddGroundItem(const CommonItem &, int, int);
         void RemoveGroundItem(const CommonItem &, int, int);
@@ -285,7 +355,7 @@ class ServerMap final: public ServerObject
         void On_MPK_TRYLEAVE(const MessagePack &);
         void On_MPK_PATHFIND(const MessagePack &);
         void On_MPK_UPDATEHP(const MessagePack &);
-        void On_MPK_METRONOME(const MessagePack &);
+        void On_MPK_CORECORD(const MessagePack &);
         void On_MPK_PULLCOINFO(const MessagePack &);
         void On_MPK_BADACTORPOD(const MessagePack &);
         void On_MPK_DEADFADEOUT(const MessagePack &);
@@ -295,6 +365,7 @@ class ServerMap final: public ServerObject
         void On_MPK_TRYSPACEMOVE(const MessagePack &);
         void On_MPK_ADDCHAROBJECT(const MessagePack &);
         void On_MPK_QUERYRECTUIDLIST(const MessagePack &);
+        void On_MPK_DESTROYMAPINSTANCE(const MessagePack &);
 
     private:
         bool RegisterLuaExport(ServerMapLuaModule *);
@@ -15,6 +15,7 @@
  *
  * =====================================================================================
  */
+#include <algorithm>
 #include <cinttypes>
 #include "player.hpp"
 #include "dbcomid.hpp"
@@ -32,7 +33,7 @@
 extern MonoServer *g_monoServer;
 extern ServerArgParser *g_serverArgParser;
 
-void ServerMap::On_MPK_METRONOME(const MessagePack &)
+void ServerMap::onMetronome()
 {
     if(m_luaModulePtr && !g_serverArgParser->DisableMapScript){
         m_luaModulePtr->resumeLoop();
@@ -50,6 +51,12 @@ void ServerMap::On_MPK_ACTION(const MessagePack &rstMPK)
         return;
     }
 
+    // location of snapshot only follows grid change
+    // action may start from a location before the move gets confirmed
+    if(auto p = m_snapshotTable.find(amA.UID); p != m_snapshotTable.end()){
+        p->second.Direction = amA.Direction;
+    }
+
     DoCircle(amA.X, amA.Y, 10, [this, amA](int nX, int nY) -> bool
     {
         if(true || ValidC(nX, nY)){
@@ -351,13 +358,13 @@ void ServerMap::On_MPK_TRYMOVE(const MessagePack &rstMPK)
     stAMMOK.EndX  = nMostX;
     stAMMOK.EndY  = nMostY;
 
-    getCell(nMostX, nMostY).Locked = true;
+    lockCell(nMostX, nMostY, true);
     m_actorPod->forward(rstMPK.from(), {MPK_MOVEOK, stAMMOK}, rstMPK.ID(), [this, stAMTM, nMostX, nMostY](const MessagePack &rstRMPK)
     {
-        if(!getCell(nMostX, nMostY).Locked){
+        if(!cellLocked(nMostX, nMostY)){
             throw fflerror("cell lock released before MOVEOK get responsed: MapUID = %" PRIu64, UID());
         }
-        getCell(nMostX, nMostY).Locked = false;
+        lockCell(nMostX, nMostY, false);
 
         switch(rstRMPK.Type()){
             case MPK_OK:
@@ -365,34 +372,34 @@ void ServerMap::On_MPK_TRYMOVE(const MessagePack &rstMPK)
                     // the object comfirm to move
                     // and it's internal state has changed
 
-                    // 1. leave last cell
-                    bool bFindCO = false;
-                    auto &rstUIDList = getUIDList(stAMTM.X, stAMTM.Y);
+                    // 1. push to the new cell
+                    //    check if it should switch the map
+                    //    enter before leave, region player count never drops to zero in one move
+                    if(!hasGridUID(stAMTM.UID, stAMTM.X, stAMTM.Y)){
+                        throw fflerror("CO location error: (UID = %" PRIu32 ", X = %d, Y = %d)", stAMTM.UID, stAMTM.X, stAMTM.Y);
+                    }
 
-                    for(auto &nUID: rstUIDList){
-                        if(nUID == stAMTM.UID){
-                            bFindCO = true;
-                            std::swap(nUID, rstUIDList.back());
-                            rstUIDList.pop_back();
-                            break;
-                        }
+                    if(nMostX != stAMTM.X || nMostY != stAMTM.Y){
+                        addGridUID(stAMTM.UID, nMostX, nMostY, true);
+
+                        // 2. leave last cell
+                        removeGridUID(stAMTM.UID, stAMTM.X, stAMTM.Y);
                     }
 
-                    if(!bFindCO){
-                        throw fflerror("CO location error: (UID = %" PRIu32 ", X = %d, Y = %d)", stAMTM.UID, stAMTM.X, stAMTM.Y);
+                    if(auto p = m_snapshotTable.find(stAMTM.UID); p != m_snapshotTable.end()){
+                        p->second.X = nMostX;
+                        p->second.Y = nMostY;
                     }
 
-                    // 2. push to the new cell
-                    //    check if it should switch the map
-                    addGridUID(stAMTM.UID, nMostX, nMostY, true);
-                    if(uidf::getUIDType(stAMTM.UID) == UID_PLY && getCell(nMostX, nMostY).mapID){
+                    const auto pLink = getSwitchLink(nMostX, nMostY);
+                    if(uidf::getUIDType(stAMTM.UID) == UID_PLY && pLink && pLink->MapID){
                         AMMapSwitch stAMMS;
                         std::memset(&stAMMS, 0, sizeof(stAMMS));
 
-                        stAMMS.UID   = uidf::buildMapUID(getCell(nMostX, nMostY).mapID); // TODO
-                        stAMMS.MapID = getCell(nMostX, nMostY).mapID;
-                        stAMMS.X     = getCell(nMostX, nMostY).switchX;
-                        stAMMS.Y     = getCell(nMostX, nMostY).switchY;
+                        stAMMS.UID   = uidf::buildMapUID(pLink->MapID); // TODO
+                        stAMMS.MapID = pLink->MapID;
+                        stAMMS.X     = pLink->SwitchX;
+                        stAMMS.Y     = pLink->SwitchY;
                         m_actorPod->forward(stAMTM.UID, {MPK_MAPSWITCH, stAMMS});
                     }
                     break;
@@ -410,6 +417,7 @@ void ServerMap::On_MPK_TRYLEAVE(const MessagePack &mpk)
     const auto amTL = mpk.conv<AMTryLeave>();
     if(In(ID(), amTL.X, amTL.Y) && hasGridUID(mpk.from(), amTL.X, amTL.Y)){
         removeGridUID(mpk.from(), amTL.X, amTL.Y);
+        m_snapshotTable.erase(mpk.from());
         m_actorPod->forward(mpk.from(), MPK_OK, mpk.ID());
         return;
     }
@@ -426,18 +434,46 @@ void ServerMap::On_MPK_PULLCOINFO(const MessagePack &rstMPK)
     AMPullCOInfo stAMPCOI;
     std::memcpy(&stAMPCOI, rstMPK.Data(), sizeof(stAMPCOI));
 
-    DoCenterSquare(stAMPCOI.X, stAMPCOI.Y, stAMPCOI.W, stAMPCOI.H, false, [this, stAMPCOI](int nX, int nY) -> bool
+    AMCOSnapshotList stAMCOSL;
+    std::memset(&stAMCOSL, 0, sizeof(stAMCOSL));
+
+    stAMCOSL.MapID = ID();
+    const auto fnFlush = [this, &stAMCOSL, nUID = stAMPCOI.UID]()
+    {
+        if(stAMCOSL.Count){
+            m_actorPod->forward(nUID, {MPK_COSNAPSHOTLIST, stAMCOSL});
+            stAMCOSL.Count = 0;
+        }
+    };
+
+    DoCenterSquare(stAMPCOI.X, stAMPCOI.Y, stAMPCOI.W, stAMPCOI.H, false, [this, stAMPCOI, &stAMCOSL, &fnFlush](int nX, int nY) -> bool
     {
         if(true || ValidC(nX, nY)){
-            doUIDList(nX, nY, [this, stAMPCOI](uint64_t nUID) -> bool
+            doUIDList(nX, nY, [this, nX, nY, stAMPCOI, &stAMCOSL, &fnFlush](uint64_t nUID) -> bool
             {
                 if(nUID != stAMPCOI.UID){
                     if(uidf::getUIDType(nUID) == UID_PLY || uidf::getUIDType(nUID) == UID_MON){
-                        AMQueryCORecord stAMQCOR;
-                        std::memset(&stAMQCOR, 0, sizeof(stAMQCOR));
+                        if(auto p = m_snapshotTable.find(nUID); p != m_snapshotTable.end()){
+                            auto &rstSnapshot = stAMCOSL.SnapshotList[stAMCOSL.Count++];
+                            rstSnapshot = p->second;
 
-                        stAMQCOR.UID = stAMPCOI.UID;
-                        m_actorPod->forward(nUID, {MPK_QUERYCORECORD, stAMQCOR});
+                            // grid is the authority of location
+                            rstSnapshot.X = nX;
+                            rstSnapshot.Y = nY;
+
+                            if(stAMCOSL.Count >= std::extent_v<decltype(stAMCOSL.SnapshotList)>){
+                                fnFlush();
+                            }
+                        }
+                        else{
+                            // CO just arrived and its record is still on the way
+                            // fall back to query the CO directly
+                            AMQueryCORecord stAMQCOR;
+                            std::memset(&stAMQCOR, 0, sizeof(stAMQCOR));
+
+                            stAMQCOR.UID = stAMPCOI.UID;
+                            m_actorPod->forward(nUID, {MPK_QUERYCORECORD, stAMQCOR});
+                        }
                     }
                 }
                 return false;
@@ -445,6 +481,52 @@ void ServerMap::On_MPK_PULLCOINFO(const MessagePack &rstMPK)
         }
         return false;
     });
+    fnFlush();
+}
+
+void ServerMap::On_MPK_CORECORD(const MessagePack &rstMPK)
+{
+    const auto stAMCOR = rstMPK.conv<AMCORecord>();
+    const auto nUID = stAMCOR.Action.UID;
+
+    // only accept record reported by CO itself at its current location
+    // record can arrive after the CO already left this map
+    if(false
+            || nUID != rstMPK.from()
+            || !ValidC(stAMCOR.Action.X, stAMCOR.Action.Y)
+            || !hasGridUID(nUID, stAMCOR.Action.X, stAMCOR.Action.Y)){
+        return;
+    }
+
+    AMCOSnapshot stAMCOS;
+    std::memset(&stAMCOS, 0, sizeof(stAMCOS));
+
+    stAMCOS.UID       = nUID;
+    stAMCOS.X         = stAMCOR.Action.X;
+    stAMCOS.Y         = stAMCOR.Action.Y;
+    stAMCOS.Direction = stAMCOR.Action.Direction;
+    stAMCOS.HP        = stAMCOR.HP;
+    stAMCOS.HPMax     = stAMCOR.HPMax;
+
+    switch(uidf::getUIDType(nUID)){
+        case UID_PLY:
+            {
+                stAMCOS.Player.DBID  = stAMCOR.Player.DBID;
+                stAMCOS.Player.JobID = stAMCOR.Player.JobID;
+                stAMCOS.Player.Level = stAMCOR.Player.Level;
+                break;
+            }
+        case UID_MON:
+            {
+                stAMCOS.Monster.MonsterID = stAMCOR.Monster.MonsterID;
+                break;
+            }
+        default:
+            {
+                return;
+            }
+    }
+    m_snapshotTable[nUID] = stAMCOS;
 }
 
 void ServerMap::On_MPK_TRYMAPSWITCH(const MessagePack &mpk)
@@ -464,14 +546,14 @@ void ServerMap::On_MPK_TRYMAPSWITCH(const MessagePack &mpk)
     amMSOK.X   = amTMS.X;
     amMSOK.Y   = amTMS.Y;
 
-    getCell(amTMS.X, amTMS.Y).Locked = true;
+    lockCell(amTMS.X, amTMS.Y, true);
     m_actorPod->forward(mpk.from(), {MPK_MAPSWITCHOK, amMSOK}, mpk.ID(), [this, reqUID, amMSOK](const MessagePack &rmpk)
     {
-        if(!getCell(amMSOK.X, amMSOK.Y).Locked){
+        if(!cellLocked(amMSOK.X, amMSOK.Y)){
             throw fflerror("cell lock released before MAPSWITCHOK get responsed: MapUID = %lld", to_llu(UID()));
         }
 
-        getCell(amMSOK.X, amMSOK.Y).Locked = false;
+        lockCell(amMSOK.X, amMSOK.Y, false);
         switch(rmpk.Type()){
             case MPK_OK:
                 {
@@ -577,6 +659,11 @@ void ServerMap::On_MPK_UPDATEHP(const MessagePack &rstMPK)
     AMUpdateHP stAMUHP;
     std::memcpy(&stAMUHP, rstMPK.Data(), sizeof(stAMUHP));
 
+    if(auto p = m_snapshotTable.find(stAMUHP.UID); p != m_snapshotTable.end()){
+        p->second.HP    = stAMUHP.HP;
+        p->second.HPMax = stAMUHP.HPMax;
+    }
+
     if(ValidC(stAMUHP.X, stAMUHP.Y)){
         DoCircle(stAMUHP.X, stAMUHP.Y, 20, [this, stAMUHP](int nX, int nY) -> bool
         {
@@ -601,6 +688,7 @@ void ServerMap::On_MPK_DEADFADEOUT(const MessagePack &rstMPK)
 
     if(ValidC(stAMDFO.X, stAMDFO.Y)){
         removeGridUID(stAMDFO.UID, stAMDFO.X, stAMDFO.Y);
+        m_snapshotTable.erase(stAMDFO.UID);
         DoCircle(stAMDFO.X, stAMDFO.Y, 20, [this, stAMDFO](int nX, int nY) -> bool
         {
             if(true || ValidC(nX, nY)){
@@ -745,6 +833,7 @@ void ServerMap::On_MPK_OFFLINE(const MessagePack &rstMPK)
     // this may fail
     // because player may get offline at try move
     removeGridUID(stAMO.UID, stAMO.X, stAMO.Y);
+    m_snapshotTable.erase(stAMO.UID);
 
     DoCircle(stAMO.X, stAMO.Y, 10, [stAMO, this](int nX, int nY) -> bool
     {
@@ -807,3 +896,24 @@ void ServerMap::On_MPK_PICKUP(const MessagePack &rstMPK)
         // likely the client need re-sync for the gound items
     }
 }
+
+void ServerMap::On_MPK_DESTROYMAPINSTANCE(const MessagePack &mpk)
+{
+    // objects on map and pending map switches hold raw pointer of this map
+    // only an empty instance can go, the shared world map never goes
+    const bool cellLockFree = std::all_of(m_lockBits.begin(), m_lockBits.end(), [](uint64_t bits)
+    {
+        return bits == 0;
+    });
+
+    if(false
+            || !m_instance
+            || !cellLockFree
+            || !m_uidListTable.empty()){
+        m_actorPod->forward(mpk.from(), MPK_ERROR, mpk.ID());
+        return;
+    }
+
+    m_actorPod->forward(mpk.from(), MPK_OK, mpk.ID());
+    Deactivate();
+}
@@ -81,7 +81,7 @@ ServerObject::~ServerObject()
 uint64_t ServerObject::Activate()
 {
     if(!m_actorPod){
-        m_actorPod = new ActorPod(m_UID, [this](){ m_stateHook.Execute(); }, [this](const MessagePack &rstMPK){ OperateAM(rstMPK); });
+        m_actorPod = new ActorPod(m_UID, [this](){ m_stateHook.Execute(); }, [this](const MessagePack &rstMPK){ OperateAM(rstMPK); }, [this](){ onMetronome(); });
         return UID();
     }
     throw fflerror("activation twice: %s", uidf::getUIDString(UID()).c_str());
@@ -156,6 +156,14 @@ class ServerObject
     public:
         virtual void OperateAM(const MessagePack &) = 0;
 
+    protected:
+        // called by actor pool in its tick phase, every tick or every metronomePeriod() ms
+        // default one turns itself off, actors without per-tick work never get ticked again
+        virtual void onMetronome()
+        {
+            m_actorPod->setMetronome(false);
+        }
+
     public:
         void Delay(uint32_t, const std::function<void()> &);
 };
@@ -40,11 +40,6 @@ void ServiceCore::OperateAM(const MessagePack &rstMPK)
                 On_MPK_BADCHANNEL(rstMPK);
                 break;
             }
-        case MPK_METRONOME:
-            {
-                On_MPK_METRONOME(rstMPK);
-                break;
-            }
         case MPK_ADDCHAROBJECT:
             {
                 On_MPK_ADDCHAROBJECT(rstMPK);
@@ -70,6 +65,16 @@ void ServiceCore::OperateAM(const MessagePack &rstMPK)
                 On_MPK_QUERYMAPUID(rstMPK);
                 break;
             }
+        case MPK_CREATEMAPINSTANCE:
+            {
+                On_MPK_CREATEMAPINSTANCE(rstMPK);
+                break;
+            }
+        case MPK_DESTROYMAPINSTANCE:
+            {
+                On_MPK_DESTROYMAPINSTANCE(rstMPK);
+                break;
+            }
         default:
             {
                 extern MonoServer *g_monoServer;
@@ -113,6 +118,29 @@ void ServiceCore::loadMap(uint32_t mapID)
     m_mapList[mapID] = mapPtr;
 }
 
+uint64_t ServiceCore::createMapInstance(uint32_t mapID)
+{
+    // instance has its own dynamic state and UID
+    // terrain is shared from MapBinDB, no decoding or copying
+    if(!mapID){
+        return 0;
+    }
+
+    if(!g_mapBinDB->Retrieve(mapID)){
+        return 0;
+    }
+
+    for(uint32_t instance = 1; instance < 4096; ++instance){
+        if(const auto mapUID = uidf::buildMapUID(mapID, instance); !m_mapInstanceList.count(mapUID)){
+            auto mapPtr = new ServerMap(this, mapID, instance);
+            mapPtr->Activate();
+            m_mapInstanceList[mapUID] = mapPtr;
+            return mapUID;
+        }
+    }
+    return 0;
+}
+
 const ServerMap *ServiceCore::retrieveMap(uint32_t mapID)
 {
     if(!mapID){
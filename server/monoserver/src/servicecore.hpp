@@ -37,6 +37,10 @@ class ServiceCore final: public ServerObject
     protected:
         std::map<uint32_t, ServerMap *> m_mapList;
 
+    protected:
+        // map UID -> instance, instances share terrain with the world map in m_mapList
+        std::map<uint64_t, ServerMap *> m_mapInstanceList;
+
     public:
         ServiceCore();
        ~ServiceCore() = default;
@@ -49,15 +53,19 @@ class ServiceCore final: public ServerObject
         void loadMap(uint32_t);
         const ServerMap *retrieveMap(uint32_t);
 
+    protected:
+        uint64_t createMapInstance(uint32_t);
+
     private:
         void On_MPK_LOGIN(const MessagePack &);
-        void On_MPK_METRONOME(const MessagePack &);
         void On_MPK_BADCHANNEL(const MessagePack &);
         void On_MPK_NETPACKAGE(const MessagePack &);
         void On_MPK_QUERYMAPUID(const MessagePack &);
         void On_MPK_QUERYMAPLIST(const MessagePack &);
         void On_MPK_QUERYCOCOUNT(const MessagePack &);
         void On_MPK_ADDCHAROBJECT(const MessagePack &);
+        void On_MPK_CREATEMAPINSTANCE(const MessagePack &);
+        void On_MPK_DESTROYMAPINSTANCE(const MessagePack &);
 
     private:
         void Net_CM_Login(uint32_t, uint8_t, const uint8_t *, size_t);
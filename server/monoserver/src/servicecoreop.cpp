@@ -51,10 +51,6 @@ void ServiceCore::On_MPK_NETPACKAGE(const MessagePack &rstMPK)
     }
 }
 
-void ServiceCore::On_MPK_METRONOME(const MessagePack &)
-{
-}
-
 void ServiceCore::On_MPK_ADDCHAROBJECT(const MessagePack &rstMPK)
 {
     const auto stAMACO = rstMPK.conv<AMAddCharObject>();
@@ -129,6 +125,51 @@ void ServiceCore::On_MPK_QUERYMAPUID(const MessagePack &mpk)
     m_actorPod->forward(mpk.from(), {MPK_UID, amUID}, mpk.ID());
 }
 
+void ServiceCore::On_MPK_CREATEMAPINSTANCE(const MessagePack &mpk)
+{
+    const auto amCMI = mpk.conv<AMCreateMapInstance>();
+    const auto mapUID = createMapInstance(amCMI.MapID);
+
+    if(!mapUID){
+        m_actorPod->forward(mpk.from(), MPK_ERROR, mpk.ID());
+        return;
+    }
+
+    AMUID amUID;
+    std::memset(&amUID, 0, sizeof(amUID));
+
+    amUID.UID = mapUID;
+    m_actorPod->forward(mpk.from(), {MPK_UID, amUID}, mpk.ID());
+}
+
+void ServiceCore::On_MPK_DESTROYMAPINSTANCE(const MessagePack &mpk)
+{
+    // instance decides itself if it can go, objects on it hold its pointer
+    // it deactivates and responds MPK_OK only when nothing is on it
+    const auto mapUID = mpk.conv<AMUID>().UID;
+    if(!m_mapInstanceList.count(mapUID)){
+        m_actorPod->forward(mpk.from(), MPK_ERROR, mpk.ID());
+        return;
+    }
+
+    m_actorPod->forward(mapUID, MPK_DESTROYMAPINSTANCE, [this, mapUID, mpk](const MessagePack &rmpk)
+    {
+        switch(rmpk.Type()){
+            case MPK_OK:
+                {
+                    m_mapInstanceList.erase(mapUID);
+                    m_actorPod->forward(mpk.from(), MPK_OK, mpk.ID());
+                    return;
+                }
+            default:
+                {
+                    m_actorPod->forward(mpk.from(), MPK_ERROR, mpk.ID());
+                    return;
+                }
+        }
+    });
+}
+
 void ServiceCore::On_MPK_QUERYCOCOUNT(const MessagePack &rstMPK)
 {
     AMQueryCOCount stAMQCOC;
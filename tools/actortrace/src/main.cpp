@@ -0,0 +1,388 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: main.cpp
+ *        Created: 10/20/2026 06:52:40
+ *    Description: offline viewer of actor message trace dumped by monoserver
+ *
+ *                 1. summary: handling time of each message type and each actor
+ *                 2. chains : follow messages posted inside a handler to their handling,
+ *                             group trees by the path of the heaviest branch, so the
+ *                             message flows dominating a slow tick show up on top
+ *                 3. timeline: chrome trace event json, open in chrome://tracing or
+ *                             perfetto, one track per actor thread, arrows for posts
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <map>
+#include <deque>
+#include <tuple>
+#include <vector>
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cinttypes>
+#include <algorithm>
+#include <unordered_map>
+
+#include "uidf.hpp"
+#include "strf.hpp"
+#include "argparser.hpp"
+#include "actortrace.hpp"
+
+struct TraceFile
+{
+    ActorTraceHeader Header;
+    std::vector<std::string> NameList;
+    std::vector<ActorTraceRecord> RecordList;
+};
+
+struct CostEntry
+{
+    uint64_t Count = 0;
+    uint64_t Total = 0;
+    uint64_t Max   = 0;
+
+    void add(uint64_t cost)
+    {
+        Count += 1;
+        Total += cost;
+        Max    = std::max<uint64_t>(Max, cost);
+    }
+};
+
+static int cmd_help()
+{
+    std::printf("--help\n");
+    std::printf("--input          trace file dumped by dumpActorTrace()\n");
+    std::printf("--top            entries printed in each table, default 20\n");
+    std::printf("--depth          max message types shown in one chain, default 8\n");
+    std::printf("--timeline       write chrome trace event json to this file\n");
+    return 0;
+}
+
+static int intParam(const arg_parser &cmd, const char *opt, int defVal)
+{
+    if(const auto val = cmd.has_param(opt); !val.empty()){
+        return std::stoi(val);
+    }
+    return defVal;
+}
+
+static bool loadTraceFile(const std::string &fileName, TraceFile *traceFile)
+{
+    auto fp = std::fopen(fileName.c_str(), "rb");
+    if(!fp){
+        std::printf("can't open file: %s\n", fileName.c_str());
+        return false;
+    }
+
+    std::vector<char> buf;
+    {
+        char readBuf[4096];
+        while(true){
+            const auto readSize = std::fread(readBuf, 1, sizeof(readBuf), fp);
+            buf.insert(buf.end(), readBuf, readBuf + readSize);
+
+            if(readSize < sizeof(readBuf)){
+                break;
+            }
+        }
+        std::fclose(fp);
+    }
+
+    if(buf.size() < sizeof(ActorTraceHeader)){
+        std::printf("file too short: %s\n", fileName.c_str());
+        return false;
+    }
+
+    std::memcpy(&(traceFile->Header), buf.data(), sizeof(ActorTraceHeader));
+    const auto &header = traceFile->Header;
+
+    if(std::memcmp(header.Magic, ACTORTRACE_MAGIC, sizeof(header.Magic)) || header.Version != ACTORTRACE_VERSION || header.RecordSize != sizeof(ActorTraceRecord)){
+        std::printf("not an actor trace file or version mismatch: %s\n", fileName.c_str());
+        return false;
+    }
+
+    size_t offset = sizeof(ActorTraceHeader);
+    for(uint32_t i = 0; i < header.NameCount; ++i){
+        const auto end = std::find(buf.begin() + offset, buf.end(), '\0');
+        if(end == buf.end()){
+            std::printf("type name table truncated\n");
+            return false;
+        }
+
+        traceFile->NameList.emplace_back(buf.begin() + offset, end);
+        offset = (size_t)(end - buf.begin()) + 1;
+    }
+
+    if(buf.size() - offset != header.RecordCount * sizeof(ActorTraceRecord)){
+        std::printf("record count mismatch: expect %" PRIu64 ", file has %zu bytes\n", header.RecordCount, buf.size() - offset);
+        return false;
+    }
+
+    traceFile->RecordList.resize(header.RecordCount);
+    if(header.RecordCount){
+        std::memcpy(traceFile->RecordList.data(), buf.data() + offset, buf.size() - offset);
+    }
+    return true;
+}
+
+static std::string typeName(const TraceFile &traceFile, uint32_t type)
+{
+    if(type < traceFile.NameList.size()){
+        return traceFile.NameList[type];
+    }
+    return str_printf("MPK_%u", type);
+}
+
+static const char *actorKind(uint64_t uid)
+{
+    if(!uid){
+        return "APP";
+    }
+
+    if(uidf::getUIDType(uid) == UID_INN){
+        return "RECV";
+    }
+    return uidf::getUIDTypeString(uid);
+}
+
+static double msec(uint64_t nsec)
+{
+    return nsec / 1000000.0;
+}
+
+template<typename K> static std::vector<std::pair<K, CostEntry>> topEntries(const std::map<K, CostEntry> &costTable, size_t top)
+{
+    std::vector<std::pair<K, CostEntry>> result(costTable.begin(), costTable.end());
+    std::sort(result.begin(), result.end(), [](const auto &lhs, const auto &rhs)
+    {
+        return lhs.second.Total > rhs.second.Total;
+    });
+
+    if(result.size() > top){
+        result.resize(top);
+    }
+    return result;
+}
+
+// for each handling record find the post record which delivered it
+// mailboxes keep FIFO order, posts of same (from, to, type) are handled in posting order
+// returns index of post record for each record, -1 if not found or not a handling
+static std::vector<int64_t> matchPost(const TraceFile &traceFile)
+{
+    std::vector<int64_t> result(traceFile.RecordList.size(), -1);
+    std::map<std::tuple<uint64_t, uint64_t, uint32_t>, std::deque<int64_t>> pendingList;
+
+    for(size_t i = 0; i < traceFile.RecordList.size(); ++i){
+        const auto &record = traceFile.RecordList[i];
+        const auto key = std::make_tuple(record.From, record.To, record.Type);
+
+        if(record.Event == ATE_POST){
+            pendingList[key].push_back(i);
+        }
+        else if(record.Event == ATE_HANDLE){
+            if(auto p = pendingList.find(key); p != pendingList.end() && !p->second.empty()){
+                result[i] = p->second.front();
+                p->second.pop_front();
+            }
+        }
+    }
+    return result;
+}
+
+static void printSummary(const TraceFile &traceFile, size_t top)
+{
+    uint64_t postCount   = 0;
+    uint64_t handleCount = 0;
+
+    std::map<uint32_t, CostEntry> typeTable;
+    std::map<uint64_t, CostEntry> actorTable;
+    std::map<int, CostEntry> threadTable;
+
+    for(const auto &record: traceFile.RecordList){
+        if(record.Event == ATE_POST){
+            postCount++;
+            continue;
+        }
+
+        handleCount++;
+        typeTable[record.Type].add(record.Duration);
+        actorTable[record.To].add(record.Duration);
+        threadTable[record.Thread].add(record.Duration);
+    }
+
+    const auto &recordList = traceFile.RecordList;
+    const auto timeSpan = recordList.empty() ? 0 : (recordList.back().Time - recordList.front().Time);
+
+    std::printf("records: %" PRIu64 " (post %" PRIu64 ", handle %" PRIu64 "), dropped %" PRIu64 ", span %.2fms, actor threads %u\n",
+            traceFile.Header.RecordCount, postCount, handleCount, traceFile.Header.DropCount, msec(timeSpan), traceFile.Header.ThreadCount);
+
+    std::printf("\nthread     count     total(ms)   max(ms)\n");
+    for(const auto &[thread, cost]: threadTable){
+        std::printf("%6d %9" PRIu64 " %13.2f %9.3f\n", thread, cost.Count, msec(cost.Total), msec(cost.Max));
+    }
+
+    std::printf("\n%-28s %9s %13s %9s %9s\n", "type", "count", "total(ms)", "avg(us)", "max(ms)");
+    for(const auto &[type, cost]: topEntries(typeTable, top)){
+        std::printf("%-28s %9" PRIu64 " %13.2f %9.2f %9.3f\n", typeName(traceFile, type).c_str(), cost.Count, msec(cost.Total), cost.Total / 1000.0 / cost.Count, msec(cost.Max));
+    }
+
+    std::printf("\n%-28s %9s %13s %9s %9s\n", "actor", "count", "total(ms)", "avg(us)", "max(ms)");
+    for(const auto &[uid, cost]: topEntries(actorTable, top)){
+        std::printf("%-28s %9" PRIu64 " %13.2f %9.2f %9.3f\n", uidf::getUIDString(uid).c_str(), cost.Count, msec(cost.Total), cost.Total / 1000.0 / cost.Count, msec(cost.Max));
+    }
+}
+
+static void printChain(const TraceFile &traceFile, const std::vector<int64_t> &postList, size_t top, int depth)
+{
+    const auto &recordList = traceFile.RecordList;
+
+    std::unordered_map<uint64_t, size_t> seqTable;
+    for(size_t i = 0; i < recordList.size(); ++i){
+        if(recordList[i].Event == ATE_HANDLE){
+            seqTable[recordList[i].Seq] = i;
+        }
+    }
+
+    // parent of a handling is the handling which posted its message
+    // parent always starts earlier, so walking backward finishes children before parents
+    std::vector<int64_t> parentList(recordList.size(), -1);
+    for(size_t i = 0; i < recordList.size(); ++i){
+        if(postList[i] >= 0 && recordList[postList[i]].Seq){
+            if(auto p = seqTable.find(recordList[postList[i]].Seq); p != seqTable.end() && p->second < i){
+                parentList[i] = p->second;
+            }
+        }
+    }
+
+    std::vector<uint64_t> treeCost(recordList.size(), 0);
+    std::vector<int64_t>  heavyChild(recordList.size(), -1);
+
+    for(size_t i = recordList.size(); i-- > 0;){
+        if(recordList[i].Event != ATE_HANDLE){
+            continue;
+        }
+
+        treeCost[i] += recordList[i].Duration;
+        if(const auto parent = parentList[i]; parent >= 0){
+            treeCost[parent] += treeCost[i];
+            if(heavyChild[parent] < 0 || treeCost[heavyChild[parent]] < treeCost[i]){
+                heavyChild[parent] = i;
+            }
+        }
+    }
+
+    std::map<std::string, CostEntry> chainTable;
+    for(size_t i = 0; i < recordList.size(); ++i){
+        if(recordList[i].Event != ATE_HANDLE || parentList[i] >= 0){
+            continue;
+        }
+
+        std::string chain;
+        int64_t curr = i;
+
+        for(int d = 0; d < depth && curr >= 0; ++d, curr = heavyChild[curr]){
+            chain += str_printf("%s%s@%s", chain.empty() ? "" : " -> ", typeName(traceFile, recordList[curr].Type).c_str(), actorKind(recordList[curr].To));
+        }
+
+        if(curr >= 0){
+            chain += " -> ...";
+        }
+        chainTable[chain].add(treeCost[i]);
+    }
+
+    std::printf("\n%9s %13s %9s  chain (heaviest branch)\n", "count", "total(ms)", "max(ms)");
+    for(const auto &[chain, cost]: topEntries(chainTable, top)){
+        std::printf("%9" PRIu64 " %13.2f %9.3f  %s\n", cost.Count, msec(cost.Total), msec(cost.Max), chain.c_str());
+    }
+}
+
+static bool writeTimeline(const TraceFile &traceFile, const std::vector<int64_t> &postList, const std::string &fileName)
+{
+    auto fp = std::fopen(fileName.c_str(), "wb");
+    if(!fp){
+        std::printf("can't open file: %s\n", fileName.c_str());
+        return false;
+    }
+
+    const auto &recordList = traceFile.RecordList;
+    auto fnEventSep = [first = true]() mutable
+    {
+        const char *sep = first ? "\n" : ",\n";
+        first = false;
+        return sep;
+    };
+
+    std::fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    for(size_t i = 0; i < recordList.size(); ++i){
+        const auto &record = recordList[i];
+        if(record.Event != ATE_HANDLE){
+            continue;
+        }
+
+        std::fprintf(fp, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"from\": \"%s\", \"to\": \"%s\", \"size\": %u}}",
+                fnEventSep(), typeName(traceFile, record.Type).c_str(), actorKind(record.To), (int)(record.Thread), record.Time / 1000.0, record.Duration / 1000.0,
+                uidf::getUIDString(record.From).c_str(), uidf::getUIDString(record.To).c_str(), record.Size);
+
+        // flow arrow from post point to handling
+        if(const auto post = postList[i]; post >= 0){
+            std::fprintf(fp, "%s{\"name\": \"post\", \"cat\": \"post\", \"ph\": \"s\", \"id\": %zu, \"pid\": 0, \"tid\": %d, \"ts\": %.3f}", fnEventSep(), i, (int)(recordList[post].Thread), recordList[post].Time / 1000.0);
+            std::fprintf(fp, "%s{\"name\": \"post\", \"cat\": \"post\", \"ph\": \"f\", \"bp\": \"e\", \"id\": %zu, \"pid\": 0, \"tid\": %d, \"ts\": %.3f}", fnEventSep(), i, (int)(record.Thread), record.Time / 1000.0);
+        }
+    }
+
+    std::fprintf(fp, "\n]}\n");
+    std::fclose(fp);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    arg_parser cmd(argc, argv);
+    if(cmd.has_option("help")){
+        return cmd_help();
+    }
+
+    const auto input = cmd.has_param("input");
+    if(input.empty()){
+        std::printf("no input file, use --input=<trace file>\n");
+        return 1;
+    }
+
+    const int top   = intParam(cmd, "top", 20);
+    const int depth = intParam(cmd, "depth", 8);
+
+    if(top <= 0 || depth <= 0){
+        std::printf("invalid parameters\n");
+        return 1;
+    }
+
+    TraceFile traceFile;
+    if(!loadTraceFile(input, &traceFile)){
+        return 1;
+    }
+
+    const auto postList = matchPost(traceFile);
+    printSummary(traceFile, top);
+    printChain(traceFile, postList, top, depth);
+
+    if(const auto timeline = cmd.has_param("timeline"); !timeline.empty()){
+        if(!writeTimeline(traceFile, postList, timeline)){
+            return 1;
+        }
+        std::printf("\ntimeline written to %s\n", timeline.c_str());
+    }
+    return 0;
+}
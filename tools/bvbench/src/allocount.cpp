@@ -0,0 +1,50 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: allocount.cpp
+ *        Created: 10/20/2026 08:26:03
+ *    Description: global operator new counting every heap allocation
+ *
+ *                 keep it in its own translation unit, otherwise gcc inlines it into
+ *                 std::allocator and warns free() on a pointer from operator new
+ *
+ *                 benchmark is single threaded, plain counters are good enough
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+
+uint64_t g_allocCount = 0;
+uint64_t g_allocBytes = 0;
+
+void *operator new(size_t size)
+{
+    g_allocCount++;
+    g_allocBytes += size;
+
+    if(auto p = std::malloc(size ? size : 1)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
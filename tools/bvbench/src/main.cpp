@@ -0,0 +1,541 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: main.cpp
+ *        Created: 10/20/2026 08:26:03
+ *    Description: tick many agents with the monster behavior tree
+ *
+ *                 compares bvtree, which builds one heap node graph per agent, against
+ *                 bvflat, which shares one tree and keeps a blackboard per agent
+ *
+ *                 agents mock the monster API, every async operation takes callbacks as
+ *                 std::function and calls them before return with a random result, so
+ *                 both trees run the same shape of work and the allocation counter only
+ *                 sees what the tree runtime and its callbacks need
+ *
+ *                 bvtree::op_delay() reads a wall clock timer per node, the bvtree agents
+ *                 use benchDelay() instead which reads the same simulated tick as bvflat,
+ *                 so both runs make the same decisions and the leaf counts are equal
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cinttypes>
+#include <functional>
+
+#include "bvtree.hpp"
+#include "bvflat.hpp"
+#include "fflerror.hpp"
+#include "argparser.hpp"
+#include "raiitimer.hpp"
+
+// replaced operator new in allocount.cpp
+extern uint64_t g_allocCount;
+extern uint64_t g_allocBytes;
+
+// simulated time between two ticks
+constexpr uint64_t BENCH_TICKMS = 50;
+
+// same as bvtree::op_delay() but reads the simulated tick
+// start time is kept as (start + 1) like bvflat, zero means not running
+static bvnode_ptr benchDelay(const uint64_t &now, uint64_t ms)
+{
+    bvarg_ref nStart;
+    return bvtree::lambda([nStart]() mutable
+    {
+        nStart.assign_void();
+    },
+
+    [&now, nStart, ms]() mutable -> bvres_t
+    {
+        if(!nStart.has_value()){
+            nStart.assign<uint64_t>(now + 1);
+        }
+        return (now - (nStart.as<uint64_t>() - 1) <= ms) ? BV_PENDING : BV_SUCCESS;
+    });
+}
+
+class Agent
+{
+    private:
+        uint32_t m_seed;
+
+    private:
+        const uint64_t m_masterUID;
+
+    public:
+        uint64_t leafCount = 0;
+
+    public:
+        Agent(uint32_t seed)
+            : m_seed(seed ? seed : 1)
+            , m_masterUID((seed % 10 == 0) ? seed : 0)
+        {}
+
+    private:
+        bool roll(uint32_t percent)
+        {
+            // xorshift32, each agent has its own sequence
+            m_seed ^= m_seed << 13;
+            m_seed ^= m_seed >> 17;
+            m_seed ^= m_seed <<  5;
+            return m_seed % 100 < percent;
+        }
+
+    public:
+        uint64_t masterUID() const
+        {
+            return m_masterUID;
+        }
+
+    public:
+        bool RandomTurn()
+        {
+            leafCount++;
+            return roll(95);
+        }
+
+        bool CanMoveForward()
+        {
+            return roll(90);
+        }
+
+        void FollowMaster(std::function<void()> fnOnOK, std::function<void()> fnOnError)
+        {
+            leafCount++;
+            roll(80) ? fnOnOK() : fnOnError();
+        }
+
+        void RequestMove(std::function<void()> fnOnOK, std::function<void()> fnOnError)
+        {
+            leafCount++;
+            roll(90) ? fnOnOK() : fnOnError();
+        }
+
+        void TrackAttackUID(uint64_t, std::function<void()> fnOnOK, std::function<void()> fnOnError)
+        {
+            leafCount++;
+            roll(50) ? fnOnOK() : fnOnError();
+        }
+
+        void GetProperTarget(std::function<void(uint64_t)> fnTarget)
+        {
+            leafCount++;
+            fnTarget(roll(30) ? (m_seed | 1) : 0);
+        }
+
+    public:
+        // same tree as Monster::CreateBvTree() before bvflat
+        // op_delay() is replaced by benchDelay() to read the simulated tick
+        bvnode_ptr CreateBvTree(const uint64_t &now)
+        {
+            bvarg_ref nTargetUID;
+
+            const auto fnFollowMaster = [this, &now]()
+            {
+                return bvtree::if_branch
+                (
+                    bvtree::lambda_stage([this](bvarg_ref nStage) mutable
+                    {
+                        FollowMaster([nStage]() mutable
+                        {
+                            nStage.assign<bvres_t>(BV_SUCCESS);
+                        },
+
+                        [nStage]() mutable
+                        {
+                            nStage.assign<bvres_t>(BV_FAILURE);
+                        });
+                    }),
+
+                    benchDelay(now, 1000),
+                    benchDelay(now, 200)
+                );
+            };
+
+            const auto fnRandomTurn = [this, &now]()
+            {
+                return bvtree::if_branch
+                (
+                    bvtree::lambda([this]() -> bvres_t
+                    {
+                        return RandomTurn() ? BV_SUCCESS : BV_FAILURE;
+                    }),
+
+                    benchDelay(now, 200),
+                    bvtree::op_abort()
+                );
+            };
+
+            const auto fnMoveForward = [this, &now]()
+            {
+                bvarg_ref nStage;
+
+                auto fnReset = [nStage]() mutable
+                {
+                    nStage.assign_void();
+                };
+
+                auto fnUpdate = [this, nStage]() mutable -> bvres_t
+                {
+                    if(!nStage.has_value()){
+                        if(!CanMoveForward()){
+                            return BV_FAILURE;
+                        }
+
+                        // mock RequestMove() calls back before return
+                        // read the result right away like bvflat stage, otherwise it takes one more tick
+                        nStage.assign<bvres_t>(BV_PENDING);
+                        RequestMove([nStage]() mutable
+                        {
+                            nStage.assign<bvres_t>(BV_SUCCESS);
+                        },
+
+                        [nStage]() mutable
+                        {
+                            nStage.assign<bvres_t>(BV_FAILURE);
+                        });
+                    }
+                    return nStage.as<bvres_t>();
+                };
+
+                return bvtree::if_branch
+                (
+                    bvtree::lambda(fnReset, fnUpdate),
+                    benchDelay(now, 1000),
+                    benchDelay(now, 200)
+                );
+            };
+
+            return bvtree::if_branch
+            (
+                bvtree::lambda_stage([this, nTargetUID](bvarg_ref nStage) mutable
+                {
+                    GetProperTarget([nTargetUID, nStage](uint64_t nUID) mutable
+                    {
+                        nTargetUID.assign<uint64_t>(nUID);
+                        nStage.assign<bvres_t>(nUID ? BV_SUCCESS : BV_FAILURE);
+                    });
+                }),
+
+                bvtree::if_branch
+                (
+                    bvtree::lambda_stage([this, nTargetUID](bvarg_ref nStage) mutable
+                    {
+                        TrackAttackUID(nTargetUID.as<uint64_t>(), [nStage]() mutable
+                        {
+                            nStage.assign<bvres_t>(BV_SUCCESS);
+                        },
+
+                        [nStage]() mutable
+                        {
+                            nStage.assign<bvres_t>(BV_FAILURE);
+                        });
+                    }),
+
+                    benchDelay(now, 1000),
+                    benchDelay(now, 200)
+                ),
+
+                bvtree::if_branch
+                (
+                    bvtree::lambda_bool([this]() -> bool
+                    {
+                        return masterUID();
+                    }),
+
+                    fnFollowMaster(),
+                    bvtree::random
+                    (
+                        fnRandomTurn(),
+                        fnMoveForward(),
+                        fnMoveForward(),
+                        fnMoveForward(),
+                        fnMoveForward(),
+                        fnMoveForward(),
+                        fnMoveForward(),
+                        fnMoveForward()
+                    )
+                )
+            );
+        }
+
+    public:
+        // same leaves as Monster::BvLeaf_*
+        bool BvLeaf_HasMaster(bvflat::state &, uint32_t)
+        {
+            return masterUID();
+        }
+
+        bvres_t BvLeaf_RandomTurn(bvflat::state &, uint32_t)
+        {
+            return RandomTurn() ? BV_SUCCESS : BV_FAILURE;
+        }
+
+        void BvLeaf_FollowMaster(bvflat::stage stStage, uint32_t)
+        {
+            FollowMaster([stStage]() mutable { stStage.done(BV_SUCCESS); }, [stStage]() mutable { stStage.done(BV_FAILURE); });
+        }
+
+        void BvLeaf_MoveForward(bvflat::stage stStage, uint32_t)
+        {
+            if(!CanMoveForward()){
+                stStage.done(BV_FAILURE);
+                return;
+            }
+            RequestMove([stStage]() mutable { stStage.done(BV_SUCCESS); }, [stStage]() mutable { stStage.done(BV_FAILURE); });
+        }
+
+        void BvLeaf_GetProperTarget(bvflat::stage stStage, uint32_t)
+        {
+            GetProperTarget([stStage](uint64_t nUID) mutable
+            {
+                stStage.set(stStage.arg(), nUID);
+                stStage.done(nUID ? BV_SUCCESS : BV_FAILURE);
+            });
+        }
+
+        void BvLeaf_TrackAttackUID(bvflat::stage stStage, uint32_t nTargetUID)
+        {
+            TrackAttackUID(stStage.get(nTargetUID), [stStage]() mutable { stStage.done(BV_SUCCESS); }, [stStage]() mutable { stStage.done(BV_FAILURE); });
+        }
+
+    public:
+        // same tree as Monster::BvTree()
+        static bvflat::tree<Agent> CreateBvFlat()
+        {
+            bvflat::tree<Agent> stTree;
+            const auto nTargetUID = stTree.var();
+
+            const auto nMoveForward = stTree.if_branch
+            (
+                stTree.lambda_stage(&Agent::BvLeaf_MoveForward),
+                stTree.op_delay(1000),
+                stTree.op_delay( 200)
+            );
+
+            const auto nRandomTurn = stTree.if_branch
+            (
+                stTree.action(&Agent::BvLeaf_RandomTurn),
+                stTree.op_delay(200),
+                stTree.op_abort()
+            );
+
+            stTree.root(stTree.if_branch
+            (
+                stTree.lambda_stage(&Agent::BvLeaf_GetProperTarget, nTargetUID),
+                stTree.if_branch
+                (
+                    stTree.lambda_stage(&Agent::BvLeaf_TrackAttackUID, nTargetUID),
+                    stTree.op_delay(1000),
+                    stTree.op_delay( 200)
+                ),
+
+                stTree.if_branch
+                (
+                    stTree.check(&Agent::BvLeaf_HasMaster),
+                    stTree.if_branch
+                    (
+                        stTree.lambda_stage(&Agent::BvLeaf_FollowMaster),
+                        stTree.op_delay(1000),
+                        stTree.op_delay( 200)
+                    ),
+
+                    stTree.random({nRandomTurn, nMoveForward, nMoveForward, nMoveForward, nMoveForward, nMoveForward, nMoveForward, nMoveForward})
+                )
+            ));
+            return stTree;
+        }
+};
+
+struct BenchResult
+{
+    double buildMS   = 0.0;
+    double nsPerTick = 0.0;     // per agent
+
+    uint64_t buildAlloc = 0;
+    uint64_t buildBytes = 0;
+
+    uint64_t tickAlloc = 0;
+    uint64_t tickBytes = 0;
+
+    uint64_t leafCount = 0;
+};
+
+static int cmd_help()
+{
+    std::printf("--help\n");
+    std::printf("--count          number of agents, default 100000\n");
+    std::printf("--tick           number of ticks, default 100\n");
+    return 0;
+}
+
+// tick i runs at simulated time (i * BENCH_TICKMS) in both runs
+template<typename F> static void runTicks(BenchResult &result, size_t agentCount, size_t tickCount, F &&fnTickAll)
+{
+    const auto allocCount = g_allocCount;
+    const auto allocBytes = g_allocBytes;
+
+    hres_timer timer;
+    for(size_t i = 0; i < tickCount; ++i){
+        fnTickAll(i * BENCH_TICKMS);
+    }
+
+    result.nsPerTick = 1.0 * timer.diff_nsec() / tickCount / agentCount;
+    result.tickAlloc = g_allocCount - allocCount;
+    result.tickBytes = g_allocBytes - allocBytes;
+}
+
+static BenchResult benchBvTree(size_t agentCount, size_t tickCount)
+{
+    BenchResult result;
+    uint64_t now = 0;
+    std::vector<Agent> agentList;
+    std::vector<bvnode_ptr> treeList;
+
+    agentList.reserve(agentCount);
+    treeList.reserve(agentCount);
+
+    std::srand(1);
+    for(size_t i = 0; i < agentCount; ++i){
+        agentList.emplace_back((uint32_t)(i + 1));
+    }
+
+    {
+        const auto allocCount = g_allocCount;
+        const auto allocBytes = g_allocBytes;
+
+        hres_timer timer;
+        for(auto &agent: agentList){
+            treeList.push_back(agent.CreateBvTree(now));
+            treeList.back()->reset();
+        }
+
+        result.buildMS    = timer.diff_nsec() / 1000000.0;
+        result.buildAlloc = g_allocCount - allocCount;
+        result.buildBytes = g_allocBytes - allocBytes;
+    }
+
+    runTicks(result, agentCount, tickCount, [&treeList, &now](uint64_t tickTime)
+    {
+        now = tickTime;
+        for(auto &tree: treeList){
+            if(tree->update() != BV_PENDING){
+                tree->reset();
+            }
+        }
+    });
+
+    for(const auto &agent: agentList){
+        result.leafCount += agent.leafCount;
+    }
+    return result;
+}
+
+static BenchResult benchBvFlat(size_t agentCount, size_t tickCount)
+{
+    BenchResult result;
+    std::vector<Agent> agentList;
+    std::vector<bvflat::state> stateList;
+
+    agentList.reserve(agentCount);
+    stateList.reserve(agentCount);
+
+    std::srand(1);
+    for(size_t i = 0; i < agentCount; ++i){
+        agentList.emplace_back((uint32_t)(i + 1));
+    }
+
+    const auto allocCount = g_allocCount;
+    const auto allocBytes = g_allocBytes;
+
+    hres_timer timer;
+    const auto tree = Agent::CreateBvFlat();
+
+    for(size_t i = 0; i < agentCount; ++i){
+        stateList.emplace_back(tree);
+    }
+
+    result.buildMS    = timer.diff_nsec() / 1000000.0;
+    result.buildAlloc = g_allocCount - allocCount;
+    result.buildBytes = g_allocBytes - allocBytes;
+
+    runTicks(result, agentCount, tickCount, [&tree, &agentList, &stateList](uint64_t now)
+    {
+        for(size_t i = 0; i < agentList.size(); ++i){
+            if(tree.update(agentList[i], stateList[i], now) != BV_PENDING){
+                tree.reset(stateList[i]);
+            }
+        }
+    });
+
+    for(const auto &agent: agentList){
+        result.leafCount += agent.leafCount;
+    }
+    return result;
+}
+
+static size_t parseSize(const arg_parser &cmd, const char *opt, size_t defVal)
+{
+    if(!cmd.has_option(opt)){
+        return defVal;
+    }
+
+    if(cmd[opt] || cmd(opt).str().empty()){
+        throw fflerror("option --%s requires an argument", opt);
+    }
+
+    const auto val = std::stoull(cmd(opt).str());
+    if(val == 0){
+        throw fflerror("option --%s requires a positive number", opt);
+    }
+    return (size_t)(val);
+}
+
+static int cmd_bench(const arg_parser &cmd)
+{
+    const auto agentCount = parseSize(cmd, "count", 100000);
+    const auto tickCount  = parseSize(cmd, "tick" ,    100);
+
+    std::printf("agent: %zu, tick: %zu\n", agentCount, tickCount);
+    std::printf("%-8s %10s %12s %14s %12s %12s %14s %12s\n", "tree", "build ms", "build alloc", "build bytes", "ns/update", "tick alloc", "tick bytes", "leaf");
+
+    const auto fnPrint = [](const char *name, const BenchResult &result)
+    {
+        std::printf("%-8s %10.2f %12" PRIu64 " %14" PRIu64 " %12.2f %12" PRIu64 " %14" PRIu64 " %12" PRIu64 "\n", name,
+                result.buildMS, result.buildAlloc, result.buildBytes,
+                result.nsPerTick, result.tickAlloc, result.tickBytes,
+                result.leafCount);
+    };
+
+    fnPrint("bvtree", benchBvTree(agentCount, tickCount));
+    fnPrint("bvflat", benchBvFlat(agentCount, tickCount));
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        arg_parser cmd(argc, argv);
+        if(cmd.has_option("help")){
+            return cmd_help();
+        }
+        return cmd_bench(cmd);
+    }catch(std::exception &e){
+        std::printf("%s\n", e.what());
+        return -1;
+    }
+    return 0;
+}
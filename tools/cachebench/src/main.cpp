@@ -0,0 +1,221 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: main.cpp
+ *        Created: 10/19/2026 22:14:50
+ *    Description: replay recorded key traces against ShardCache
+ *
+ *                 trace file is recorded by innDB::RecordTrace(), e.g. client --record-cache-trace
+ *                 it's a binary file of uint64_t keys in native byte order
+ *
+ *                 also replays the trace against the old innDB policy, which is an exact LRU
+ *                 that drains to half of the capacity when it's full, to compare hit ratio and
+ *                 the max number of entries evicted by a single insert
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <list>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include <cinttypes>
+#include <algorithm>
+#include <unordered_map>
+
+#include "fileptr.hpp"
+#include "argparser.hpp"
+#include "raiitimer.hpp"
+#include "shardcache.hpp"
+
+struct BenchResult
+{
+    double hitRatio = 0.0;
+    double mops     = 0.0;
+
+    uint64_t evict    = 0;
+    uint64_t maxBurst = 0;
+};
+
+static int cmd_help()
+{
+    std::printf("--help\n");
+    std::printf("--trace          trace file recorded by innDB::RecordTrace()\n");
+    std::printf("--capacity       cache capacity, default 1024\n");
+    std::printf("--shard          shard number, default 8\n");
+    std::printf("--thread         replay threads, default 1\n");
+    return 0;
+}
+
+static std::vector<uint64_t> loadTrace(const std::string &fileName)
+{
+    auto fp = make_fileptr(fileName.c_str(), "rb");
+
+    std::fseek(fp.get(), 0, SEEK_END);
+    const auto fileLen = std::ftell(fp.get());
+    std::fseek(fp.get(), 0, SEEK_SET);
+
+    if(fileLen <= 0 || fileLen % sizeof(uint64_t)){
+        throw fflerror("invalid trace file: %s", fileName.c_str());
+    }
+
+    std::vector<uint64_t> keyList(fileLen / sizeof(uint64_t));
+    if(std::fread(keyList.data(), sizeof(uint64_t), keyList.size(), fp.get()) != keyList.size()){
+        throw fflerror("failed to read trace file: %s", fileName.c_str());
+    }
+    return keyList;
+}
+
+static BenchResult replayBurstLRU(const std::vector<uint64_t> &keyList, size_t capacity)
+{
+    // same policy as the old innDB
+    // exact LRU, evicts down to capacity / 2 when total weight exceeds capacity
+    std::list<uint64_t> lruList;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> cache;
+
+    uint64_t hit = 0;
+    BenchResult result;
+    const hres_timer timer;
+
+    for(const auto key: keyList){
+        if(auto p = cache.find(key); p != cache.end()){
+            lruList.splice(lruList.begin(), lruList, p->second);
+            hit++;
+            continue;
+        }
+
+        lruList.push_front(key);
+        cache[key] = lruList.begin();
+
+        if(cache.size() > capacity){
+            uint64_t burst = 0;
+            while(cache.size() > capacity / 2){
+                cache.erase(lruList.back());
+                lruList.pop_back();
+                burst++;
+            }
+
+            result.evict += burst;
+            result.maxBurst = std::max<uint64_t>(result.maxBurst, burst);
+        }
+    }
+
+    result.hitRatio = 1.0 * hit / keyList.size();
+    result.mops     = keyList.size() / std::max<double>(timer.diff_nsec() / 1000.0, 1.0);
+    return result;
+}
+
+static BenchResult replayShardCache(const std::vector<uint64_t> &keyList, size_t capacity, size_t shardNum, size_t threadNum)
+{
+    // free callback runs in the thread which inserts
+    // count evictions of one insert to get the max burst
+    thread_local uint64_t t_burst = 0;
+    ShardCache<uint64_t, uint64_t> cache(capacity, shardNum, [](uint64_t &)
+    {
+        t_burst++;
+    });
+
+    std::vector<uint64_t> maxBurstList(threadNum, 0);
+    std::vector<std::thread> threadList;
+    const hres_timer timer;
+
+    for(size_t threadIndex = 0; threadIndex < threadNum; ++threadIndex){
+        threadList.emplace_back([&cache, &keyList, &maxBurstList, threadIndex, threadNum]()
+        {
+            for(size_t i = threadIndex; i < keyList.size(); i += threadNum){
+                if(cache.find(keyList[i], nullptr)){
+                    continue;
+                }
+
+                t_burst = 0;
+                cache.insert(keyList[i], keyList[i], 1);
+                maxBurstList[threadIndex] = std::max<uint64_t>(maxBurstList[threadIndex], t_burst);
+            }
+        });
+    }
+
+    for(auto &t: threadList){
+        t.join();
+    }
+
+    const auto elapsedUS = std::max<double>(timer.diff_nsec() / 1000.0, 1.0);
+    const auto cacheStat = cache.stat();
+
+    BenchResult result;
+    result.hitRatio = cacheStat.hitRatio();
+    result.mops     = keyList.size() / elapsedUS;
+    result.evict    = cacheStat.Evict;
+    result.maxBurst = *std::max_element(maxBurstList.begin(), maxBurstList.end());
+    return result;
+}
+
+static size_t parseSize(const arg_parser &cmd, const char *opt, size_t defVal)
+{
+    if(!cmd.has_option(opt)){
+        return defVal;
+    }
+
+    if(cmd[opt] || cmd(opt).str().empty()){
+        throw fflerror("option --%s requires an argument", opt);
+    }
+
+    const auto val = std::stoull(cmd(opt).str());
+    if(val == 0){
+        throw fflerror("option --%s requires a positive number", opt);
+    }
+    return (size_t)(val);
+}
+
+static int cmd_bench(const arg_parser &cmd)
+{
+    if(cmd["trace"] || cmd("trace").str().empty()){
+        throw fflerror("option --trace requires an argument");
+    }
+
+    const auto keyList   = loadTrace(cmd("trace").str());
+    const auto capacity  = parseSize(cmd, "capacity", 1024);
+    const auto shardNum  = parseSize(cmd, "shard"   ,    8);
+    const auto threadNum = parseSize(cmd, "thread"  ,    1);
+
+    std::printf("trace: %zu keys, capacity: %zu, shard: %zu, thread: %zu\n", keyList.size(), capacity, shardNum, threadNum);
+    std::printf("%-16s %10s %10s %12s %10s\n", "policy", "hit", "Mops/s", "evict", "maxburst");
+
+    const auto fnPrint = [](const char *policy, const BenchResult &result)
+    {
+        std::printf("%-16s %9.2f%% %10.2f %12" PRIu64 " %10" PRIu64 "\n", policy, result.hitRatio * 100.0, result.mops, result.evict, result.maxBurst);
+    };
+
+    fnPrint("innDB-burst-LRU", replayBurstLRU(keyList, capacity));
+    fnPrint("ShardCache",      replayShardCache(keyList, capacity, shardNum, threadNum));
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        arg_parser cmd(argc, argv);
+        if(cmd.has_option("help")){
+            return cmd_help();
+        }
+
+        if(cmd.has_option("trace")){
+            return cmd_bench(cmd);
+        }
+
+        return cmd_help();
+    }catch(std::exception &e){
+        std::printf("%s\n", e.what());
+        return -1;
+    }
+    return 0;
+}
@@ -34,6 +34,7 @@
  * =====================================================================================
  */
 
+#include <atomic>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -45,6 +46,7 @@
 #include "pngf.hpp"
 #include "filesys.hpp"
 #include "shadow.hpp"
+#include "threadpool.hpp"
 #include "wilimagepackage.hpp"
 
 void printUsage()
@@ -115,20 +117,40 @@ bool heroWil2PNG(bool bGender,
         return false;
     }
 
-    std::vector<uint32_t> stPNGBuf;
-    std::vector<uint32_t> stPNGBufShadow;
+    // package is mapped read-only, DecodeImage() is thread-safe
+    // every frame is an independent task, each thread reuses its own buffers
+    std::atomic<bool> bFailed = false;
+    const size_t nThreadCount = ThreadPool::getThreadCount(0);
+
+    std::vector<std::vector<uint32_t>> stPNGBufList(nThreadCount + 1);
+    std::vector<std::vector<uint32_t>> stPNGBufShadowList(nThreadCount + 1);
+
+    // declared after everything the tasks reference
+    // if the submit loop throws, the pool gets finished before they are destroyed
+    ThreadPool stPool(nThreadCount);
+
     for(int nDress = 0; nDress < 8; ++nDress){
         for(int nMotion = 0; nMotion < 33; ++nMotion){
             for(int nDirection = 0; nDirection < 8; ++nDirection){
                 for(int nFrame = 0; nFrame < 10; ++nFrame){
                     int nBaseIndex = nDress * 3000 + nMotion * 80 + nDirection * 10 + nFrame + 1;
-                    if(true
-                            && stPackage.SetIndex(nBaseIndex)
-                            && stPackage.CurrentImageValid()){
+                    stPool.addTask([&stPackage, &bFailed, &stPNGBufList, &stPNGBufShadowList, bGender, szOutDir, nDress, nMotion, nDirection, nFrame, nBaseIndex](int nThreadID)
+                    {
+                        if(bFailed){
+                            return;
+                        }
+
+                        const auto stInfoOpt = stPackage.ImageInfo(nBaseIndex);
+                        if(!stInfoOpt.has_value()){
+                            return;
+                        }
+
+                        const auto &stInfo = stInfoOpt.value();
+                        auto &stPNGBuf = stPNGBufList.at(nThreadID);
+                        auto &stPNGBufShadow = stPNGBufShadowList.at(nThreadID);
 
-                        auto stInfo = stPackage.CurrentImageInfo();
                         stPNGBuf.resize(stInfo.shWidth * stInfo.shHeight);
-                        stPackage.Decode(&(stPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+                        stPackage.DecodeImage(nBaseIndex, &(stPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
 
                         // export for HumanGfxDBN
                         char szSaveFileName[128];
@@ -145,7 +167,8 @@ bool heroWil2PNG(bool bGender,
 
                         if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBuf[0])), stInfo.shWidth, stInfo.shHeight, szSaveFileName)){
                             std::printf("save PNG failed: %s", szSaveFileName);
-                            return false;
+                            bFailed = true;
+                            return;
                         }
 
                         // make a big buffer to hold the shadow as needed
@@ -183,15 +206,18 @@ bool heroWil2PNG(bool bGender,
 
                             if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBufShadow[0])), nShadowW, nShadowH, szSaveFileName)){
                                 std::printf("save shadow PNG failed: %s", szSaveFileName);
-                                return false;
+                                bFailed = true;
+                                return;
                             }
                         }
-                    }
+                    });
                 }
             }
         }
     }
-    return true;
+
+    stPool.finish();
+    return !bFailed;
 }
 
 int main(int argc, char *argv[])
@@ -36,6 +36,7 @@
  * =====================================================================================
  */
 
+#include <atomic>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -47,6 +48,7 @@
 #include "shadow.hpp"
 #include "pngf.hpp"
 #include "filesys.hpp"
+#include "threadpool.hpp"
 #include "wilimagepackage.hpp"
 
 int g_MonWilFileIndex []
@@ -137,8 +139,17 @@ bool monsterWil2PNG(int nMonsterFileIndex,
         return false;
     }
 
-    std::vector<uint32_t> stPNGBuf;
-    std::vector<uint32_t> stPNGBufShadow;
+    // packages are mapped read-only, ImageInfo() and DecodeImage() are thread-safe
+    // every frame is an independent task, each thread reuses its own buffers
+    std::atomic<bool> bFailed = false;
+    const size_t nThreadCount = ThreadPool::getThreadCount(0);
+
+    std::vector<std::vector<uint32_t>> stPNGBufList(nThreadCount + 1);
+    std::vector<std::vector<uint32_t>> stPNGBufShadowList(nThreadCount + 1);
+
+    // declared after everything the tasks reference
+    // if the submit loop throws, the pool gets finished before they are destroyed
+    ThreadPool stPool(nThreadCount);
 
     for(int nInnMonID = 0; nInnMonID < 10; ++nInnMonID){
         for(int nMotion = 0; nMotion < 10; ++nMotion){
@@ -185,13 +196,23 @@ bool monsterWil2PNG(int nMonsterFileIndex,
                 for(int nFrame = 0; nFrame < nMaxFrameCount; ++nFrame){
                     int nBaseIndex = nInnMonID * 1000 + nMotion * 80 + nDirection * 10 + nFrame + g_MonWilFileIndex[nMonsterFileIndex];
 
-                    if(true
-                            && stPackageBody.SetIndex(nBaseIndex)
-                            && stPackageBody.CurrentImageValid()){
+                    stPool.addTask([&stPackageBody, &stPackageShadow, &bFailed, &stPNGBufList, &stPNGBufShadowList, szOutDir, nGlobalMonID, nMotion, nDirection, nFrame, nBaseIndex](int nThreadID)
+                    {
+                        if(bFailed){
+                            return;
+                        }
+
+                        const auto stInfoOpt = stPackageBody.ImageInfo(nBaseIndex);
+                        if(!stInfoOpt.has_value()){
+                            return;
+                        }
+
+                        const auto &stInfo = stInfoOpt.value();
+                        auto &stPNGBuf = stPNGBufList.at(nThreadID);
+                        auto &stPNGBufShadow = stPNGBufShadowList.at(nThreadID);
 
-                        auto stInfo = stPackageBody.CurrentImageInfo();
                         stPNGBuf.resize(stInfo.shWidth * stInfo.shHeight);
-                        stPackageBody.Decode(&(stPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+                        stPackageBody.DecodeImage(nBaseIndex, &(stPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
 
                         // export for MonsterDBN
                         char szSaveFileName[128];
@@ -207,18 +228,16 @@ bool monsterWil2PNG(int nMonsterFileIndex,
 
                         if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBuf[0])), stInfo.shWidth, stInfo.shHeight, szSaveFileName)){
                             std::printf("save PNG failed: %s", szSaveFileName);
-                            return false;
+                            bFailed = true;
+                            return;
                         }
 
                         // to save shadow png file
                         // try shadow file first, failed then try to make a dynamically one
-                        if(true
-                                && stPackageShadow.SetIndex(nBaseIndex)
-                                && stPackageShadow.CurrentImageValid()){
-
-                            auto stShadowInfo = stPackageShadow.CurrentImageInfo();
+                        if(const auto stShadowInfoOpt = stPackageShadow.ImageInfo(nBaseIndex); stShadowInfoOpt.has_value()){
+                            const auto &stShadowInfo = stShadowInfoOpt.value();
                             stPNGBufShadow.resize(stShadowInfo.shWidth * stShadowInfo.shHeight);
-                            stPackageShadow.Decode(&(stPNGBufShadow[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+                            stPackageShadow.DecodeImage(nBaseIndex, &(stPNGBufShadow[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
 
                             // export for MonsterDBN
                             char szSaveShadowFileName[128];
@@ -234,7 +253,8 @@ bool monsterWil2PNG(int nMonsterFileIndex,
 
                             if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBufShadow[0])), stShadowInfo.shWidth, stShadowInfo.shHeight, szSaveShadowFileName)){
                                 std::printf("save PNG failed: %s", szSaveShadowFileName);
-                                return false;
+                                bFailed = true;
+                                return;
                             }
 
                         }else{
@@ -299,17 +319,19 @@ bool monsterWil2PNG(int nMonsterFileIndex,
 
                                 if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBufShadow[0])), nShadowW, nShadowH, szSaveShadowFileName)){
                                     std::printf("save shadow PNG failed: %s", szSaveShadowFileName);
-                                    return false;
+                                    bFailed = true;
+                                    return;
                                 }
                             }
                         }
-                    }
+                    });
                 }
             }
         }
     }
 
-    return true;
+    stPool.finish();
+    return !bFailed;
 }
 
 int main(int argc, char *argv[])
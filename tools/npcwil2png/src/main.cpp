@@ -33,6 +33,7 @@
 
 #include <map>
 #include <array>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <cstdio>
@@ -46,6 +47,7 @@
 #include "shadow.hpp"
 #include "motion.hpp"
 #include "filesys.hpp"
+#include "threadpool.hpp"
 #include "protocoldef.hpp"
 #include "wilimagepackage.hpp"
 
@@ -95,8 +97,20 @@ void npcWil2PNG(const char *path, const char *baseName, const char *fileExt, con
         throw fflerror("Load wil file failed: %s/%s/%s", path, baseName, fileExt);
     }
 
-    std::vector<uint32_t> pngBuf;
-    std::vector<uint32_t> pngBufShadow;
+    // package is mapped read-only, ImageInfo() and DecodeImage() are thread-safe
+    // every frame is an independent task, each thread reuses its own buffers
+    const size_t threadCount = ThreadPool::getThreadCount(0);
+    std::vector<std::vector<uint32_t>> pngBufList(threadCount + 1);
+    std::vector<std::vector<uint32_t>> pngBufShadowList(threadCount + 1);
+
+    // thread pool doesn't forward exceptions
+    // keep the first error and throw it after all tasks are done
+    std::mutex errorLock;
+    std::string errorMsg;
+
+    // declared after everything the tasks refer to
+    // if the submit loop throws, the pool gets finished before they are destroyed
+    ThreadPool pool(threadCount);
 
     struct frameSeq
     {
@@ -320,62 +334,81 @@ void npcWil2PNG(const char *path, const char *baseName, const char *fileExt, con
 
             for(int frame = 0; frame < frameCount; ++frame){
                 const int gfxId = lookId * 100 + frameStart + frame;
-                if(!(package.SetIndex(gfxId) && package.CurrentImageValid())){
+                const auto imgInfoOpt = package.ImageInfo(gfxId);
+                if(!imgInfoOpt.has_value()){
                     throw fflerror("gfx table is wrong");
                 }
 
-                const auto imgInfo = package.CurrentImageInfo();
-                pngBuf.resize(imgInfo.shWidth * imgInfo.shHeight);
-                package.Decode(&(pngBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
-
                 const int dir = dirMap.at(p.first.at(0));
-                const auto fileName = createOffsetFileName(outDir, false, lookId, encodeMotion, dir, frame, imgInfo.shPX, imgInfo.shPY);
-                pngf::saveRGBABuffer(reinterpret_cast<const uint8_t *>(pngBuf.data()), imgInfo.shWidth, imgInfo.shHeight, fileName.c_str());
-
-                const auto [needShadow, projectShadow] = [lookId]() -> std::tuple<bool, bool>
+                pool.addTask([&package, &pngBufList, &pngBufShadowList, &errorLock, &errorMsg, imgInfo = imgInfoOpt.value(), outDir, lookId, encodeMotion, dir, frame, gfxId](int threadId)
                 {
-                    switch(lookId){
-                        case 51:
-                        case 52:
-                        case 55:
-                        case 56:
-                        case 59: return {false, false};
-                        case 71:
-                        case 72:
-                        case 73: return {true , false};
-                        default: return {true , true };
+                    try{
+                        auto &pngBuf = pngBufList.at(threadId);
+                        auto &pngBufShadow = pngBufShadowList.at(threadId);
+
+                        pngBuf.resize(imgInfo.shWidth * imgInfo.shHeight);
+                        package.DecodeImage(gfxId, &(pngBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+
+                        const auto fileName = createOffsetFileName(outDir, false, lookId, encodeMotion, dir, frame, imgInfo.shPX, imgInfo.shPY);
+                        pngf::saveRGBABuffer(reinterpret_cast<const uint8_t *>(pngBuf.data()), imgInfo.shWidth, imgInfo.shHeight, fileName.c_str());
+
+                        const auto [needShadow, projectShadow] = [lookId]() -> std::tuple<bool, bool>
+                        {
+                            switch(lookId){
+                                case 51:
+                                case 52:
+                                case 55:
+                                case 56:
+                                case 59: return {false, false};
+                                case 71:
+                                case 72:
+                                case 73: return {true , false};
+                                default: return {true , true };
+                            }
+                        }();
+
+                        if(!needShadow){
+                            return;
+                        }
+
+                        // make a big buffer to hold the shadow as needed
+                        // shadow buffer size depends on do project or not
+                        //
+                        //  project :  (nW + nH / 2) x (nH / 2 + 1)
+                        //          :  (nW x nH)
+
+                        const int maxShadowW = (std::max<int>)(imgInfo.shWidth + imgInfo.shHeight / 2, imgInfo.shWidth ) + 20;
+                        const int maxShadowH = (std::max<int>)(             1 + imgInfo.shHeight / 2, imgInfo.shHeight) + 20;
+                        pngBufShadow.resize(maxShadowW * maxShadowH);
+
+                        int nShadowW = 0;
+                        int nShadowH = 0;
+                        Shadow::MakeShadow(&(pngBufShadow[0]), projectShadow, &(pngBuf[0]), imgInfo.shWidth, imgInfo.shHeight, &nShadowW, &nShadowH, 0XFF000000);
+
+                        if(nShadowW <= 0 || nShadowH <= 0){
+                            throw fflerror("create shadow image failed");
+                        }
+
+                        const auto shadowFileName = createOffsetFileName(outDir, true, lookId, encodeMotion, dir, frame,
+                                projectShadow ? imgInfo.shShadowPX : (imgInfo.shPX + 3),
+                                projectShadow ? imgInfo.shShadowPY : (imgInfo.shPY + 2));
+                        pngf::saveRGBABuffer(reinterpret_cast<const uint8_t *>(pngBufShadow.data()), nShadowW, nShadowH, shadowFileName.c_str());
                     }
-                }();
-
-                if(!needShadow){
-                    continue;
-                }
-
-                // make a big buffer to hold the shadow as needed
-                // shadow buffer size depends on do project or not
-                //
-                //  project :  (nW + nH / 2) x (nH / 2 + 1)
-                //          :  (nW x nH)
-
-                const int maxShadowW = (std::max<int>)(imgInfo.shWidth + imgInfo.shHeight / 2, imgInfo.shWidth ) + 20;
-                const int maxShadowH = (std::max<int>)(             1 + imgInfo.shHeight / 2, imgInfo.shHeight) + 20;
-                pngBufShadow.resize(maxShadowW * maxShadowH);
-
-                int nShadowW = 0;
-                int nShadowH = 0;
-                Shadow::MakeShadow(&(pngBufShadow[0]), projectShadow, &(pngBuf[0]), imgInfo.shWidth, imgInfo.shHeight, &nShadowW, &nShadowH, 0XFF000000);
-
-                if(nShadowW <= 0 || nShadowH <= 0){
-                    throw fflerror("create shadow image failed");
-                }
-
-                const auto shadowFileName = createOffsetFileName(outDir, true, lookId, encodeMotion, dir, frame, 
-                        projectShadow ? imgInfo.shShadowPX : (imgInfo.shPX + 3),
-                        projectShadow ? imgInfo.shShadowPY : (imgInfo.shPY + 2));
-                pngf::saveRGBABuffer(reinterpret_cast<const uint8_t *>(pngBufShadow.data()), nShadowW, nShadowH, shadowFileName.c_str());
+                    catch(const std::exception &e){
+                        std::lock_guard<std::mutex> lockGuard(errorLock);
+                        if(errorMsg.empty()){
+                            errorMsg = e.what();
+                        }
+                    }
+                });
             }
         }
     }
+
+    pool.finish();
+    if(!errorMsg.empty()){
+        throw fflerror("%s", errorMsg.c_str());
+    }
 }
 
 int main(int argc, char *argv[])
@@ -0,0 +1,242 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: main.cpp
+ *        Created: 10/20/2026 02:41:17
+ *    Description: check Shadow::MakeShadow() against the per-pixel implementation and
+ *                 measure its throughput
+ *
+ *                 frames are random sprites: an opaque ellipse with transparent holes,
+ *                 similar to body frames decoded from WIL packages
+ *
+ *                 any difference to the reference output is reported and fails the run
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "shadow.hpp"
+#include "argparser.hpp"
+#include "raiitimer.hpp"
+
+struct SpriteFrame
+{
+    int w = 0;
+    int h = 0;
+    bool project = true;
+    std::vector<uint32_t> data;
+};
+
+static int cmd_help()
+{
+    std::printf("--help\n");
+    std::printf("--frame          frame count, default 800\n");
+    std::printf("--max-size       max frame width and height, default 160\n");
+    std::printf("--repeat         repeat count of each benchmark, default 20\n");
+    std::printf("--seed           random seed, default 0\n");
+    return 0;
+}
+
+static int intParam(const arg_parser &cmd, const char *opt, int defVal)
+{
+    if(const auto val = cmd.has_param(opt); !val.empty()){
+        return std::stoi(val);
+    }
+    return defVal;
+}
+
+// per-pixel implementation before vectorization
+// kept here as the reference of the expected output
+static void makeShadowRef(uint32_t *pDst, bool bProject, const uint32_t *pData, int nW, int nH, int *pSW, int *pSH, uint32_t nShadowColor)
+{
+    int nNewW = bProject ? (nW + nH / 2) : nW;
+    int nNewH = bProject ? ( 1 + nH / 2) : nH;
+
+    std::memset(pDst, 0, nNewW * nNewH * sizeof(uint32_t));
+    for(int nY = 0; nY < nH; ++nY){
+        for(int nX = 0; nX < nW; ++nX){
+            if(pData[nY * nW + nX] & 0XFF000000){
+                if(bProject){
+                    pDst[(nY - nY / 2) * nNewW + nX + (nH - nY) / 2] = nShadowColor;
+                }
+                else{
+                    pDst[nY * nW + nX] = nShadowColor;
+                }
+            }
+        }
+    }
+
+    *pSW = nNewW;
+    *pSH = nNewH;
+}
+
+static std::vector<SpriteFrame> makeFrameList(int frameCount, int maxSize, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<SpriteFrame> frameList(frameCount);
+
+    for(auto &frame: frameList){
+        frame.w = 1 + (int)(rng() % maxSize);
+        frame.h = 1 + (int)(rng() % maxSize);
+        frame.project = (rng() % 8) != 0;
+        frame.data.resize((size_t)(frame.w) * frame.h);
+
+        const double cx = frame.w / 2.0;
+        const double cy = frame.h / 2.0;
+
+        for(int y = 0; y < frame.h; ++y){
+            for(int x = 0; x < frame.w; ++x){
+                const double dx = (x - cx) / std::max<double>(cx, 1.0);
+                const double dy = (y - cy) / std::max<double>(cy, 1.0);
+
+                const bool opaque = (dx * dx + dy * dy <= 1.0) && (rng() % 16 != 0);
+                frame.data[y * frame.w + x] = (opaque ? 0XFF000000 : (rng() % 2) * 0X00FFFFFF) | (rng() & 0X00FFFFFF);
+            }
+        }
+    }
+    return frameList;
+}
+
+static size_t shadowSize(const SpriteFrame &frame)
+{
+    return frame.project ? (size_t)(frame.w + frame.h / 2) * (1 + frame.h / 2) : (size_t)(frame.w) * frame.h;
+}
+
+static bool checkFrameList(const std::vector<SpriteFrame> &frameList, uint32_t color)
+{
+    std::vector<uint32_t> refBuf;
+    std::vector<uint32_t> outBuf;
+
+    for(size_t i = 0; i < frameList.size(); ++i){
+        const auto &frame = frameList[i];
+
+        // fill garbage to catch pixels not written
+        refBuf.assign(shadowSize(frame), 0XDEADBEEF);
+        outBuf.assign(shadowSize(frame), 0XDEADBEEF);
+
+        int refW = 0, refH = 0;
+        int outW = 0, outH = 0;
+
+        makeShadowRef(refBuf.data(), frame.project, frame.data.data(), frame.w, frame.h, &refW, &refH, color);
+        Shadow::MakeShadow(outBuf.data(), frame.project, frame.data.data(), frame.w, frame.h, &outW, &outH, color);
+
+        if(refW != outW || refH != outH || refBuf != outBuf){
+            std::printf("frame %zu mismatch: %dx%d, project = %d\n", i, frame.w, frame.h, (int)(frame.project));
+            return false;
+        }
+    }
+
+    std::vector<Shadow::ShadowFrame> batchList;
+    for(const auto &frame: frameList){
+        batchList.push_back({frame.data.data(), frame.w, frame.h, frame.project});
+    }
+
+    std::vector<uint32_t> batchBuf;
+    const auto imageList = Shadow::MakeShadowBatch(batchBuf, batchList.data(), batchList.size(), color);
+
+    for(size_t i = 0; i < frameList.size(); ++i){
+        const auto &frame = frameList[i];
+        refBuf.assign(shadowSize(frame), 0);
+
+        int refW = 0, refH = 0;
+        makeShadowRef(refBuf.data(), frame.project, frame.data.data(), frame.w, frame.h, &refW, &refH, color);
+
+        if(imageList[i].W != refW || imageList[i].H != refH || !std::equal(refBuf.begin(), refBuf.end(), imageList[i].Data)){
+            std::printf("batch frame %zu mismatch: %dx%d, project = %d\n", i, frame.w, frame.h, (int)(frame.project));
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename F> static double benchFrameList(const std::vector<SpriteFrame> &frameList, int repeat, F func)
+{
+    size_t pixelCount = 0;
+    for(const auto &frame: frameList){
+        pixelCount += frame.data.size();
+    }
+
+    hres_timer timer;
+    for(int r = 0; r < repeat; ++r){
+        func();
+    }
+    return 1000.0 * pixelCount * repeat / std::max<uint64_t>(timer.diff_nsec(), 1);
+}
+
+int main(int argc, char *argv[])
+{
+    arg_parser cmd(argc, argv);
+    if(cmd.has_option("help")){
+        return cmd_help();
+    }
+
+    const int frameCount = intParam(cmd, "frame", 800);
+    const int maxSize    = intParam(cmd, "max-size", 160);
+    const int repeat     = intParam(cmd, "repeat", 20);
+    const int seed       = intParam(cmd, "seed", 0);
+
+    if(frameCount <= 0 || maxSize <= 0 || repeat <= 0){
+        std::printf("invalid parameters\n");
+        return 1;
+    }
+
+    const auto frameList = makeFrameList(frameCount, maxSize, (unsigned)(seed));
+    for(const uint32_t color: {0XFF000000, 0X80123456}){
+        if(!checkFrameList(frameList, color)){
+            return 1;
+        }
+    }
+    std::printf("check: %d frames match the reference\n", frameCount);
+
+    size_t maxShadowSize = 0;
+    std::vector<Shadow::ShadowFrame> batchList;
+
+    for(const auto &frame: frameList){
+        maxShadowSize = std::max<size_t>(maxShadowSize, shadowSize(frame));
+        batchList.push_back({frame.data.data(), frame.w, frame.h, frame.project});
+    }
+
+    std::vector<uint32_t> dstBuf(maxShadowSize);
+    std::vector<uint32_t> batchBuf;
+
+    const auto refMpix = benchFrameList(frameList, repeat, [&frameList, &dstBuf]()
+    {
+        int w = 0, h = 0;
+        for(const auto &frame: frameList){
+            makeShadowRef(dstBuf.data(), frame.project, frame.data.data(), frame.w, frame.h, &w, &h, 0XFF000000);
+        }
+    });
+
+    const auto simdMpix = benchFrameList(frameList, repeat, [&frameList, &dstBuf]()
+    {
+        int w = 0, h = 0;
+        for(const auto &frame: frameList){
+            Shadow::MakeShadow(dstBuf.data(), frame.project, frame.data.data(), frame.w, frame.h, &w, &h, 0XFF000000);
+        }
+    });
+
+    const auto batchMpix = benchFrameList(frameList, repeat, [&batchList, &batchBuf]()
+    {
+        Shadow::MakeShadowBatch(batchBuf, batchList.data(), batchList.size(), 0XFF000000);
+    });
+
+    std::printf("per-pixel : %8.2f Mpix/s\n", refMpix);
+    std::printf("MakeShadow: %8.2f Mpix/s, %.2fx\n", simdMpix, simdMpix / std::max<double>(refMpix, 0.000001));
+    std::printf("batch     : %8.2f Mpix/s, %.2fx\n", batchMpix, batchMpix / std::max<double>(refMpix, 0.000001));
+    return 0;
+}
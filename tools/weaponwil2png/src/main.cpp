@@ -46,6 +46,7 @@
  * =====================================================================================
  */
 
+#include <atomic>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -57,6 +58,7 @@
 #include "pngf.hpp"
 #include "filesys.hpp"
 #include "shadow.hpp"
+#include "threadpool.hpp"
 #include "wilimagepackage.hpp"
 
 void printUsage()
@@ -147,8 +149,17 @@ bool weaponWil2PNG(bool bGender, int nIndex,
         return false;
     }
 
-    std::vector<uint32_t> stWeaponPNGBuf;
-    std::vector<uint32_t> stWeaponPNGBufShadow;
+    // packages are mapped read-only, ImageInfo() and DecodeImage() are thread-safe
+    // every frame is an independent task, each thread reuses its own buffers
+    std::atomic<bool> bFailed = false;
+    const size_t nThreadCount = ThreadPool::getThreadCount(0);
+
+    std::vector<std::vector<uint32_t>> stWeaponPNGBufList(nThreadCount + 1);
+    std::vector<std::vector<uint32_t>> stWeaponPNGBufShadowList(nThreadCount + 1);
+
+    // declared after everything the tasks reference
+    // if the submit loop throws, the pool gets finished before they are destroyed
+    ThreadPool stPool(nThreadCount);
 
     for(int nWeapon = 0; nWeapon < 10; ++nWeapon){
         for(int nMotion = 0; nMotion < 33; ++nMotion){
@@ -163,18 +174,27 @@ bool weaponWil2PNG(bool bGender, int nIndex,
                     int   nHeroIndex =       0 * 3000 + nMotion * 80 + nDirection * 10 + nFrame + 1;
                     int nWeaponIndex = nWeapon * 3000 + nMotion * 80 + nDirection * 10 + nFrame + 1;
 
-                    if(true
-                            && stHeroWilPackage.SetIndex(nHeroIndex)
-                            && stHeroWilPackage.CurrentImageValid()
+                    stPool.addTask([&stHeroWilPackage, &stWeaponWilPackage, &bFailed, &stWeaponPNGBufList, &stWeaponPNGBufShadowList, bGender, nIndex, szOutDir, nWeapon, nMotion, nDirection, nFrame, bProject, nHeroIndex, nWeaponIndex](int nThreadID)
+                    {
+                        if(bFailed){
+                            return;
+                        }
 
-                            && stWeaponWilPackage.SetIndex(nWeaponIndex)
-                            && stWeaponWilPackage.CurrentImageValid()){
+                        const auto stHeroInfoOpt   =   stHeroWilPackage.ImageInfo(nHeroIndex);
+                        const auto stWeaponInfoOpt = stWeaponWilPackage.ImageInfo(nWeaponIndex);
 
-                        auto stHeroInfo   =   stHeroWilPackage.CurrentImageInfo();
-                        auto stWeaponInfo = stWeaponWilPackage.CurrentImageInfo();
+                        if(!stHeroInfoOpt.has_value() || !stWeaponInfoOpt.has_value()){
+                            return;
+                        }
+
+                        const auto &stHeroInfo   =   stHeroInfoOpt.value();
+                        const auto &stWeaponInfo = stWeaponInfoOpt.value();
+
+                        auto &stWeaponPNGBuf       = stWeaponPNGBufList.at(nThreadID);
+                        auto &stWeaponPNGBufShadow = stWeaponPNGBufShadowList.at(nThreadID);
 
                         stWeaponPNGBuf.resize(stWeaponInfo.shWidth * stWeaponInfo.shHeight);
-                        stWeaponWilPackage.Decode(&(stWeaponPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+                        stWeaponWilPackage.DecodeImage(nWeaponIndex, &(stWeaponPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
 
                         // make a buffer to hold the shadow as needed
                         // shadow buffer size depends on do project or not
@@ -213,7 +233,8 @@ bool weaponWil2PNG(bool bGender, int nIndex,
 
                         if(!pngf::saveRGBABuffer((uint8_t *)(&(stWeaponPNGBuf[0])), stWeaponInfo.shWidth, stWeaponInfo.shHeight, szSaveFileName)){
                             std::printf("save weapon PNG failed: %s", szSaveFileName);
-                            return false;
+                            bFailed = true;
+                            return;
                         }
 
                         // understand how I get it:
@@ -257,15 +278,18 @@ bool weaponWil2PNG(bool bGender, int nIndex,
 
                             if(!pngf::saveRGBABuffer((uint8_t *)(&(stWeaponPNGBufShadow[0])), nShadowW, nShadowH, szSaveFileName)){
                                 std::printf("save shadow PNG failed: %s", szSaveFileName);
-                                return false;
+                                bFailed = true;
+                                return;
                             }
                         }
-                    }
+                    });
                 }
             }
         }
     }
-    return true;
+
+    stPool.finish();
+    return !bFailed;
 }
 
 int main(int argc, char *argv[])
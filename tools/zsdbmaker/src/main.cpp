@@ -15,10 +15,13 @@
  * =====================================================================================
  */
 #include <regex>
+#include <mutex>
 #include <cstdio>
 #include <fstream>
 #include <cinttypes>
+#include <algorithm>
 #include "zsdb.hpp"
+#include "threadpool.hpp"
 #include "argparser.hpp"
 
 static int cmd_help()
@@ -29,6 +32,15 @@ static int cmd_help()
     std::printf("--decomp-db\n");
     std::printf("--input-data-dir\n");
     std::printf("--input-dict\n");
+    std::printf("--thread-count\n");
+    std::printf("--train-dict[=dict-size]\n");
+    std::printf("--train-sample-size\n");
+    std::printf("--output-dict\n");
+    std::printf("--patch-db\n");
+    std::printf("--remove-file-name-regex\n");
+    std::printf("--compact-db\n");
+    std::printf("--compact-threshold\n");
+    std::printf("--output-db\n");
 
     return 0;
 }
@@ -110,18 +122,152 @@ static int cmd_create_db(const argh::parser &cmd)
         return fCompressThreshold;
     }();
 
-    if(ZSDB::BuildDB(
-                szDBOutputName.c_str(),
-                szFileNameRegex.empty() ? nullptr : szFileNameRegex.c_str(),
-                szDBInputDirName.c_str(),
-                szDictInputName.empty() ? nullptr : szDictInputName.c_str(),
-                fCompressThreshold
-                )){
-        return 0;
+    const auto fnSizeParam = [&cmd](const char *szOption, size_t nDefault) -> size_t
+    {
+        if(!has_option(cmd, szOption) || cmd[szOption]){
+            return nDefault;
+        }
+
+        size_t nValue = 0;
+        if(!(cmd(szOption) >> nValue)){
+            throw std::invalid_argument(std::string(szOption) + " requires a number");
+        }
+        return nValue;
+    };
+
+    auto szDictOutputName = [&cmd]() -> std::string
+    {
+        if(!has_option(cmd, "output-dict")){
+            return "";
+        }
+
+        if(cmd["output-dict"] || cmd("output-dict").str().empty()){
+            throw std::invalid_argument("output-dict requires an argument");
+        }
+
+        return cmd("output-dict").str();
+    }();
+
+    ZSDB::BuildOption stOption;
+    stOption.FileNameRegex = szFileNameRegex.empty() ? nullptr : szFileNameRegex.c_str();
+    stOption.DictPath      = szDictInputName.empty() ? nullptr : szDictInputName.c_str();
+    stOption.SaveDictPath  = szDictOutputName.empty() ? nullptr : szDictOutputName.c_str();
+    stOption.CompRatio     = fCompressThreshold;
+    stOption.ThreadCount   = fnSizeParam("thread-count", 0);
+
+    // 110KB is the default dictionary size of zstd command line
+    stOption.TrainDictSize   = has_option(cmd, "train-dict") ? fnSizeParam("train-dict", 112640) : 0;
+    stOption.TrainSampleSize = fnSizeParam("train-sample-size", 0);
+
+    const auto stReport = ZSDB::BuildDB(szDBOutputName.c_str(), szDBInputDirName.c_str(), stOption);
+    if(!stReport.has_value()){
+        std::printf("build zsdb failed...\n");
+        return -1;
+    }
+
+    if(stOption.TrainDictSize && !stOption.DictPath){
+        if(stReport->DictTrained){
+            std::printf("trained dictionary: %" PRIu64 " bytes in %.2fs\n", stReport->DictBytes, stReport->TrainTime);
+        }
+        else{
+            std::printf("dictionary training failed, built without dictionary\n");
+        }
+    }
+
+    const double fMBytes = stReport->SrcBytes / (1024.0 * 1024.0);
+    std::printf("entries   : %zu, compressed %zu, skipped %zu\n", stReport->FileCount, stReport->CompressedCount, stReport->SkippedCount);
+    std::printf("size      : %" PRIu64 " -> %" PRIu64 " [%3d%%]\n", stReport->SrcBytes, stReport->DstBytes, (int)(stReport->DstBytes * 100 / std::max<uint64_t>(stReport->SrcBytes, 1)));
+    std::printf("throughput: %.2fMB in %.2fs, %.2fMB/s\n", fMBytes, stReport->BuildTime, fMBytes / std::max<double>(stReport->BuildTime, 0.000001));
+    return 0;
+}
+
+static int cmd_patch_db(const argh::parser &cmd)
+{
+    auto szDBFileName = [&cmd]() -> std::string
+    {
+        if(cmd["patch-db"] || cmd("patch-db").str().empty()){
+            throw std::invalid_argument("option --patch-db requires an argument");
+        }
+        return cmd("patch-db").str();
+    }();
+
+    const auto fnStrParam = [&cmd](const char *szOption) -> std::string
+    {
+        if(!has_option(cmd, szOption)){
+            return "";
+        }
+
+        if(cmd[szOption] || cmd(szOption).str().empty()){
+            throw std::invalid_argument(std::string(szOption) + " requires an argument");
+        }
+        return cmd(szOption).str();
+    };
+
+    const auto szDBInputDirName  = fnStrParam("input-data-dir");
+    const auto szFileNameRegex   = fnStrParam("input-file-name-regex");
+    const auto szRemoveNameRegex = fnStrParam("remove-file-name-regex");
+
+    ZSDB::PatchOption stOption;
+    stOption.FileNameRegex = szFileNameRegex.empty() ? nullptr : szFileNameRegex.c_str();
+    stOption.RemoveRegex   = szRemoveNameRegex.empty() ? nullptr : szRemoveNameRegex.c_str();
+
+    if(has_option(cmd, "compress-threshold")){
+        cmd("compress-threshold", 0.90) >> stOption.CompRatio;
+    }
+
+    const auto stReport = ZSDB::PatchDB(szDBFileName.c_str(), szDBInputDirName.empty() ? nullptr : szDBInputDirName.c_str(), stOption);
+    if(!stReport.has_value()){
+        std::printf("patch zsdb failed...\n");
+        return -1;
+    }
+
+    std::printf("entries: added %zu, replaced %zu, removed %zu in %.2fs\n", stReport->AddCount, stReport->ReplaceCount, stReport->RemoveCount, stReport->PatchTime);
+    std::printf("stream : live %" PRIu64 ", dead %" PRIu64 ", file %" PRIu64 "\n", stReport->LiveBytes, stReport->DeadBytes, stReport->FileBytes);
+
+    // compact when garbage takes more than the threshold of the file
+    // 0 means never compact automatically
+    double fCompactThreshold = 0.0;
+    if(has_option(cmd, "compact-threshold")){
+        cmd("compact-threshold", 0.0) >> fCompactThreshold;
     }
 
-    std::printf("build zsdb failed...\n");
-    return -1;
+    if(fCompactThreshold > 0.0 && stReport->DeadBytes > fCompactThreshold * stReport->FileBytes){
+        if(!ZSDB::CompactDB(szDBFileName.c_str(), nullptr)){
+            std::printf("compact zsdb failed...\n");
+            return -1;
+        }
+        std::printf("compacted: %s\n", szDBFileName.c_str());
+    }
+    return 0;
+}
+
+static int cmd_compact_db(const argh::parser &cmd)
+{
+    auto szDBFileName = [&cmd]() -> std::string
+    {
+        if(cmd["compact-db"] || cmd("compact-db").str().empty()){
+            throw std::invalid_argument("option --compact-db requires an argument");
+        }
+        return cmd("compact-db").str();
+    }();
+
+    auto szDBOutputName = [&cmd]() -> std::string
+    {
+        if(!has_option(cmd, "output-db")){
+            return "";
+        }
+
+        if(cmd["output-db"] || cmd("output-db").str().empty()){
+            throw std::invalid_argument("output-db requires an argument");
+        }
+        return cmd("output-db").str();
+    }();
+
+    if(!ZSDB::CompactDB(szDBFileName.c_str(), szDBOutputName.empty() ? nullptr : szDBOutputName.c_str())){
+        std::printf("compact zsdb failed...\n");
+        return -1;
+    }
+    return 0;
 }
 
 static int cmd_list(const argh::parser &cmd)
@@ -184,17 +330,36 @@ static int cmd_uncomp_db(const argh::parser &cmd)
     }();
 
 
-    ZSDB stZSDB(szDBFileName.c_str());
+    // mmap mode is thread-safe
+    // decompress and dump entries in parallel
+    ZSDB stZSDB(szDBFileName.c_str(), true);
     auto stEntryList = stZSDB.GetEntryList();
 
-    for(auto rstEntry: stEntryList){
-        std::vector<uint8_t> stReadBuf;
-        if(stZSDB.Decomp(rstEntry.FileName, 0, &stReadBuf)){
-            std::ofstream f(rstEntry.FileName, std::ios::out | std::ios::binary);
-            f.write((const char *)(stReadBuf.data()), stReadBuf.size());
-            std::printf("%32s %8zu -> %8zu [%3d%%] %8" PRIu64 "\n", rstEntry.FileName, rstEntry.Length, stReadBuf.size(), (int)(rstEntry.Length * 100 / stReadBuf.size()), rstEntry.Attribute);
-        }
+    std::mutex stPrintLock;
+
+    // one reusable buffer per worker thread
+    const size_t nThreadCount = ThreadPool::getThreadCount(0);
+    std::vector<std::vector<uint8_t>> stReadBufList(nThreadCount + 1);
+
+    // declared after everything the tasks refer to
+    // if the submit loop throws, the pool gets finished before they are destroyed
+    ThreadPool stPool(nThreadCount);
+
+    for(const auto &rstEntry: stEntryList){
+        stPool.addTask([&stZSDB, &stPrintLock, &stReadBufList, rstEntry](int nThreadID)
+        {
+            auto &stReadBuf = stReadBufList.at(nThreadID);
+            if(stZSDB.Decomp(rstEntry.FileName, 0, &stReadBuf)){
+                std::ofstream f(rstEntry.FileName, std::ios::out | std::ios::binary);
+                f.write((const char *)(stReadBuf.data()), stReadBuf.size());
+
+                std::lock_guard<std::mutex> stLockGuard(stPrintLock);
+                std::printf("%32s %8zu -> %8zu [%3d%%] %8" PRIu64 "\n", rstEntry.FileName, rstEntry.Length, stReadBuf.size(), (int)(rstEntry.Length * 100 / std::max<size_t>(stReadBuf.size(), 1)), rstEntry.Attribute);
+            }
+        });
     }
+
+    stPool.finish();
     return 0;
 }
 
@@ -210,6 +375,14 @@ int main(int argc, char *argv[])
             return cmd_create_db(cmd);
         }
 
+        if(has_option(cmd, "patch-db")){
+            return cmd_patch_db(cmd);
+        }
+
+        if(has_option(cmd, "compact-db")){
+            return cmd_compact_db(cmd);
+        }
+
         if(cmd.has_option("list")){
             return cmd_list(cmd);
         }